@@ -0,0 +1,136 @@
+#!/usr/bin/env bash
+#
+# Usage: scripts/bench.sh [--save] [--compare] [--threshold PCT] [--max-size N]
+#                         [--filter PATTERN] [name...]
+#
+# Builds and runs the BENCH programs in src/bench (or only the named ones)
+# one at a time, so they don't compete for cores.
+#   --save          store each program's JSON results as the baseline in
+#                   $BENCH_BASELINES (default: bench_baselines/)
+#   --compare       compare median times with the baselines and fail when
+#                   any bench is slower by more than the threshold
+#   --threshold PCT allowed slowdown in percent (default: $BENCH_THRESHOLD or 10)
+#   --max-size N    largest size for BENCH_RANGE benches (default 10^6; the
+#                   container benches go up to 10^8)
+
+find_root_from_cwd() {
+    local dir=$1
+    if [ -d "$dir/src/bench" ]; then
+        echo "$dir"
+    else
+        cd ..
+        dir=$(pwd)
+        find_root_from_cwd $dir
+    fi
+}
+
+save=false
+compare=false
+threshold=${BENCH_THRESHOLD:-10}
+names=()
+while [ $# -gt 0 ]; do
+    case $1 in
+    --save)
+        save=true
+        ;;
+    --compare)
+        compare=true
+        ;;
+    --threshold)
+        threshold=$2
+        shift
+        ;;
+    --max-size)
+        export BENCH_MAX_ARG=$2
+        shift
+        ;;
+    --filter)
+        export BENCH_FILTER=$2
+        shift
+        ;;
+    *)
+        names+=("${1%.c}")
+        ;;
+    esac
+    shift
+done
+
+root=$(find_root_from_cwd $(pwd))
+baselines=${BENCH_BASELINES:-$root/bench_baselines}
+if [ ${#names[@]} -eq 0 ]; then
+    # Only programs built on the BENCH runner produce comparable results
+    for file in $(grep -l "run_benches" $root/src/bench/*.c); do
+        names+=("$(basename ${file%.c})")
+    done
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# Print one line per bench whose median is more than $threshold% above the baseline
+compare_results() {
+    awk -v threshold=$threshold '
+        # A string value keeps its JSON escapes, which is enough to use it as a key
+        function field(line, key,    m) {
+            if (match(line, "\"" key "\": \"([^\"\\\\]|\\\\.)*\"") ||
+                match(line, "\"" key "\": [^,}]*")) {
+                m = substr(line, RSTART, RLENGTH)
+                sub("^\"" key "\": ", "", m)
+                return m ~ /^"/ ? substr(m, 2, length(m) - 2) : m
+            }
+            return ""
+        }
+        FNR == 1 { file++ }
+        /"name":/ {
+            name = field($0, "name")
+            median = field($0, "median_ns") + 0
+            if (file == 1) {
+                base[name] = median
+            } else if (name in base && base[name] > 0) {
+                change = (median - base[name]) / base[name] * 100
+                status = change > threshold ? "REGRESSION" : (change < -threshold ? "faster" : "ok")
+                printf "%-12s %-32s %12.2f ns -> %12.2f ns  %+7.1f%%\n", status, name, base[name], median, change
+                if (change > threshold) {
+                    regressions++
+                }
+            }
+        }
+        END { exit regressions > 0 ? 1 : 0 }
+    ' "$1" "$2"
+}
+
+any_fails=false
+for name in "${names[@]}"; do
+    bin=$work/bench_$name
+    if ! gcc -O2 -pthread $root/src/bench/$name.c -o $bin; then
+        any_fails=true
+        continue
+    fi
+    if ! $bin --json $work/$name.json; then
+        any_fails=true
+        continue
+    fi
+    if $save; then
+        mkdir -p $baselines
+        cp $work/$name.json $baselines/$name.json
+        echo "Saved baseline $baselines/$name.json"
+    fi
+    if $compare; then
+        if [ -f $baselines/$name.json ]; then
+            echo "Compared with $baselines/$name.json (threshold $threshold%):"
+            if ! compare_results $baselines/$name.json $work/$name.json; then
+                any_fails=true
+            fi
+            echo
+        else
+            echo "No baseline for $name; run with --save first"
+        fi
+    fi
+done
+
+if [ $any_fails == false ]; then
+    echo "No regressions"
+else
+    echo "Some benchmarks regressed or failed"
+    exit 1
+fi
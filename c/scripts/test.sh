@@ -1,4 +1,13 @@
 #!/usr/bin/env bash
+#
+# Usage: scripts/test.sh [-j N] [--filter PATTERN] [--isolate] [--json FILE] [name...]
+#
+# Compiles and runs every file in src/tests (or only the named ones) with
+# up to N files in flight at once (default: number of cores). Output is
+# printed per file in order. --filter and --isolate are passed to the test
+# runner as TEST_FILTER and TEST_ISOLATE; --json writes one summary per
+# file, merged into a JSON array. A test src/tests/NAME.c is linked with
+# any extra translation units in src/tests/NAME/.
 
 find_tests_folder_from_cwd() {
     local dir=$1
@@ -11,37 +20,108 @@ find_tests_folder_from_cwd() {
     fi
 }
 
+jobs=$(nproc 2>/dev/null || echo 4)
+json=""
+names=()
+while [ $# -gt 0 ]; do
+    case $1 in
+    -j)
+        jobs=$2
+        shift
+        ;;
+    -j*)
+        jobs=${1#-j}
+        ;;
+    --filter)
+        export TEST_FILTER=$2
+        shift
+        ;;
+    --isolate)
+        export TEST_ISOLATE=1
+        ;;
+    --json)
+        json=$2
+        shift
+        ;;
+    *)
+        names+=("${1%.c}")
+        ;;
+    esac
+    shift
+done
+
+tests_folder=$(find_tests_folder_from_cwd $(pwd))
+if [ ${#names[@]} -eq 0 ]; then
+    for file in $tests_folder/*.c; do
+        file=$(basename $file)
+        names+=("${file%.c}")
+    done
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# Build and run one test file, leaving its output and exit status in $work
 run_test() {
-    file=$1
-    tests_folder=$(find_tests_folder_from_cwd $(pwd))
-    gcc $tests_folder/$file -o _internal_test
+    name=$1
+    out=$work/$name
     ret=0
-    ./_internal_test
-    ret=$?
-    rm _internal_test
-    return $ret
+    extra=()
+    if [ -d $tests_folder/$name ]; then
+        extra=($tests_folder/$name/*.c)
+    fi
+    if gcc $tests_folder/$name.c "${extra[@]}" -o $out.bin -pthread >$out.log 2>&1; then
+        if [ -n "$json" ]; then
+            TEST_JSON=$out.json $out.bin >>$out.log 2>&1
+        else
+            $out.bin >>$out.log 2>&1
+        fi
+        ret=$?
+    else
+        ret=1
+    fi
+    echo $ret >$out.status
 }
 
-# if a filename is passed, run only that file
-if [ $# -eq 1 ]; then
-    run_test $1.c
-    exit
-fi
-
-# get all files in the tests directory
-files=$(ls src/tests)
+# Run the files in the background, at most $jobs at a time, printing in order
+for name in "${names[@]}"; do
+    while [ $(jobs -rp | wc -l) -ge $jobs ]; do
+        wait -n
+    done
+    run_test $name &
+done
 
 any_fails=false
-# run each file
-for file in $files; do
-    run_test $file
-    if [ $? -eq 1 ]; then
+for name in "${names[@]}"; do
+    while [ ! -f $work/$name.status ]; do
+        wait -n 2>/dev/null || sleep 0.05
+    done
+    cat $work/$name.log
+    if [ "$(cat $work/$name.status)" != "0" ]; then
         any_fails=true
     fi
 done
+wait
+
+if [ -n "$json" ]; then
+    {
+        echo "["
+        first=true
+        for name in "${names[@]}"; do
+            [ -f $work/$name.json ] || continue
+            $first || echo ","
+            first=false
+            printf '{"file": "%s", "summary": ' "$name"
+            cat $work/$name.json
+            echo "}"
+        done
+        echo "]"
+    } >"$json"
+fi
 
 if [ $any_fails == false ]; then
     echo "All tests passed"
 else
     echo "Some tests failed"
-fi
\ No newline at end of file
+    exit 1
+fi
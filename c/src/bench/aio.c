@@ -0,0 +1,153 @@
+// Build: gcc -O2 -pthread src/bench/aio.c -o bench_aio
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define VECDEQUE_IMPLEMENTATION
+#define AIO_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../modules/aio.h"
+#include "../modules/test.h"
+
+#define READ_SIZE 4096
+#define FILE_MB 256
+#define MAX_DEPTH 64
+#define BENCH_PATH "/tmp/bench_aio.dat"
+
+uint64_t next_random(uint64_t *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 7;
+    *x ^= *x << 17;
+    return *x;
+}
+
+int bench_fd = -1;
+size_t blocks = (size_t)FILE_MB * (1 << 20) / READ_SIZE;
+
+// The data file, written once and shared by every bench
+int bench_file(Bench *b)
+{
+    if (bench_fd < 0)
+    {
+        bench_fd = open(BENCH_PATH, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        char *chunk = malloc(1 << 20);
+        memset(chunk, 'x', 1 << 20);
+        for (size_t i = 0; i < FILE_MB; i++)
+        {
+            ssize_t written = write(bench_fd, chunk, 1 << 20);
+            assert(written == 1 << 20);
+        }
+        free(chunk);
+        fsync(bench_fd);
+    }
+    Bench_set_bytes(b, READ_SIZE);
+    return bench_fd;
+}
+
+// One operation is one random 4 KiB read
+BENCH(Aio_blocking_pread)
+{
+    Bench_pause(b);
+    int fd = bench_file(b);
+    char *buf = malloc(READ_SIZE);
+    uint64_t x = 88172645463325252ull;
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        ssize_t n = pread(fd, buf, READ_SIZE, (off_t)(next_random(&x) % blocks) * READ_SIZE);
+        DO_NOT_OPTIMIZE(n);
+    }
+    Bench_pause(b);
+    free(buf);
+    Bench_resume(b);
+}
+
+typedef struct
+{
+    AioRequest reqs[MAX_DEPTH];
+    Vec bufs[MAX_DEPTH];
+    // Slots whose request has completed, in completion order
+    size_t free[MAX_DEPTH];
+    size_t free_count;
+} Slots;
+
+void slot_done(AioRequest *req, void *arg)
+{
+    Slots *slots = arg;
+    slots->free[slots->free_count++] = (size_t)(req - slots->reqs);
+}
+
+// `arg` reads kept in flight; completed slots are refilled in one batch
+void bench_aio(Bench *b, AioBackend backend)
+{
+    Bench_pause(b);
+    int fd = bench_file(b);
+    size_t depth = (size_t)b->arg;
+    Aio *aio = Aio_new(depth, backend, GLOBAL_ALLOCATOR);
+    if (aio == NULL)
+    {
+        fprintf(stderr, "io_uring not available\n");
+        Bench_resume(b);
+        return;
+    }
+    Slots *slots = malloc(sizeof(Slots));
+    AioRequest *batch[MAX_DEPTH];
+    for (size_t i = 0; i < depth; i++)
+    {
+        slots->bufs[i] = Vec_with_capacity(READ_SIZE, sizeof(char));
+        slots->free[i] = i;
+    }
+    slots->free_count = depth;
+    uint64_t x = 88172645463325252ull;
+    uint64_t submitted = 0;
+    uint64_t done = 0;
+    Bench_resume(b);
+    while (done < b->iterations)
+    {
+        size_t count = 0;
+        while (slots->free_count > 0 && submitted < b->iterations)
+        {
+            size_t slot = slots->free[--slots->free_count];
+            slots->bufs[slot].len = 0;
+            AioRequest_read(&slots->reqs[slot], fd, (off_t)(next_random(&x) % blocks) * READ_SIZE,
+                            &slots->bufs[slot], READ_SIZE, slot_done, slots);
+            batch[count++] = &slots->reqs[slot];
+            submitted++;
+        }
+        Aio_submit(aio, batch, count);
+        done += Aio_poll(aio, 1);
+    }
+    Bench_pause(b);
+    for (size_t i = 0; i < depth; i++)
+    {
+        Vec_drop(&slots->bufs[i]);
+    }
+    free(slots);
+    Aio_drop(aio);
+    Bench_resume(b);
+}
+
+BENCH_RANGE(Aio_threads, 1, MAX_DEPTH, 4)
+{
+    bench_aio(b, AIO_THREADS);
+}
+
+BENCH_RANGE(Aio_uring, 1, MAX_DEPTH, 4)
+{
+    bench_aio(b, AIO_URING);
+}
+
+int main(int argc, char **argv)
+{
+    int ret = run_benches(argc, argv);
+    if (bench_fd >= 0)
+    {
+        close(bench_fd);
+        unlink(BENCH_PATH);
+    }
+    return ret;
+}
@@ -0,0 +1,148 @@
+// Build: gcc -O2 src/bench/bitset.c -o bench_bitset
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define BITSET_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/bitset.h"
+#include "../modules/test.h"
+
+#define BITS (1u << 24)
+
+Bitset random_bitset(uint64_t seed, unsigned one_in)
+{
+    Bitset b = Bitset_with_len(BITS);
+    for (size_t i = 0; i < BITS; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        if ((seed >> 33) % one_in == 0)
+        {
+            Bitset_set(&b, i);
+        }
+    }
+    return b;
+}
+
+BENCH(Bitset_and)
+{
+    Bench_pause(b);
+    Bitset x = random_bitset(1, 2), y = random_bitset(2, 2);
+    Bench_resume(b);
+    Bench_set_bytes(b, BITS / 8);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Bitset_and(&x, &y);
+        CLOBBER_MEMORY();
+    }
+    Bench_pause(b);
+    Bitset_drop(&x);
+    Bitset_drop(&y);
+    Bench_resume(b);
+}
+
+BENCH(Bitset_count)
+{
+    Bench_pause(b);
+    Bitset x = random_bitset(3, 2);
+    Bench_resume(b);
+    Bench_set_bytes(b, BITS / 8);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        size_t count = Bitset_count(&x);
+        DO_NOT_OPTIMIZE(count);
+    }
+    Bench_pause(b);
+    Bitset_drop(&x);
+    Bench_resume(b);
+}
+
+// Visit every set bit of a 1-in-16 sparse set
+BENCH(Bitset_next)
+{
+    Bench_pause(b);
+    Bitset x = random_bitset(4, 16);
+    size_t ones = Bitset_count(&x);
+    Bench_resume(b);
+    Bench_set_items(b, ones);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        size_t sum = 0;
+        for (size_t k = Bitset_next(&x, 0); k != BITSET_NONE; k = Bitset_next(&x, k + 1))
+        {
+            sum += k;
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    Bench_pause(b);
+    Bitset_drop(&x);
+    Bench_resume(b);
+}
+
+BENCH(BitsetRank_rank)
+{
+    Bench_pause(b);
+    Bitset x = random_bitset(5, 2);
+    BitsetRank r = BitsetRank_new(&x);
+    Bench_resume(b);
+    uint64_t seed = 9;
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        size_t rank = BitsetRank_rank(&r, (seed >> 20) % BITS);
+        DO_NOT_OPTIMIZE(rank);
+    }
+    Bench_pause(b);
+    BitsetRank_drop(&r);
+    Bitset_drop(&x);
+    Bench_resume(b);
+}
+
+BENCH(BitsetRank_select)
+{
+    Bench_pause(b);
+    Bitset x = random_bitset(6, 2);
+    BitsetRank r = BitsetRank_new(&x);
+    size_t ones = Bitset_count(&x);
+    Bench_resume(b);
+    uint64_t seed = 11;
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        size_t pos = BitsetRank_select(&r, (seed >> 20) % ones);
+        DO_NOT_OPTIMIZE(pos);
+    }
+    Bench_pause(b);
+    BitsetRank_drop(&r);
+    Bitset_drop(&x);
+    Bench_resume(b);
+}
+
+// Random lookups in a sparse set of 2^16 values spread over 2^32
+BENCH(Roaring_contains)
+{
+    Bench_pause(b);
+    Roaring r = Roaring_new();
+    uint64_t seed = 13;
+    for (int i = 0; i < 65536; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        Roaring_add(&r, (uint32_t)(seed >> 32));
+    }
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        bool hit = Roaring_contains(&r, (uint32_t)(seed >> 32));
+        DO_NOT_OPTIMIZE(hit);
+    }
+    Bench_pause(b);
+    Roaring_drop(&r);
+    Bench_resume(b);
+}
+
+int main(int argc, char **argv)
+{
+    return run_benches(argc, argv);
+}
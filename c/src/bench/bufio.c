@@ -0,0 +1,134 @@
+// Build: gcc -O2 src/bench/bufio.c -o bench_bufio
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define STRING_IMPLEMENTATION
+#define BUFIO_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../modules/bufio.h"
+#include "../modules/test.h"
+
+#define MIN_SIZE 1000
+#define MAX_SIZE 100000000
+#define SIZE_STEP 10
+#define BENCH_PATH "/tmp/bench_bufio.log"
+
+// Write `target` bytes of log-like lines with BufWriter and return the size written
+size_t write_file(const char *path, size_t target)
+{
+    char line[128];
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    BufWriter w = BufWriter_new(fd, 0);
+    size_t written = 0;
+    uint64_t x = 88172645463325252ull;
+    while (written < target)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        int len = snprintf(line, sizeof(line), "2024-01-01T00:00:%02u level=info id=%llu msg=request served in %u us",
+                           (unsigned)(x % 60), (unsigned long long)x, (unsigned)(x % 100000));
+        BufWriter_write_line(&w, (StringView){line, (size_t)len});
+        written += (size_t)len + 1;
+    }
+    BufWriter_drop(&w);
+    close(fd);
+    return written;
+}
+
+size_t file_size = 0;
+size_t file_target = 0;
+
+// The log file for `target` bytes, rewritten only when the size changes
+const char *bench_file(Bench *b, size_t target)
+{
+    if (file_target != target)
+    {
+        file_size = write_file(BENCH_PATH, target);
+        file_target = target;
+    }
+    Bench_set_bytes(b, file_size);
+    return BENCH_PATH;
+}
+
+BENCH_RANGE(BufWriter_write_line, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    file_target = 0;
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        file_size = write_file(BENCH_PATH, b->arg);
+    }
+    Bench_set_bytes(b, file_size);
+}
+
+// Baseline: one heap String per line through stdio
+BENCH_RANGE(getline_String_from, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    const char *path = bench_file(b, b->arg);
+    char *buf = NULL;
+    size_t cap = 0;
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        FILE *f = fopen(path, "r");
+        size_t total = 0;
+        while (getline(&buf, &cap, f) > 0)
+        {
+            String s = String_from(buf);
+            total += String_len(&s);
+            String_drop(&s);
+        }
+        DO_NOT_OPTIMIZE(total);
+        fclose(f);
+    }
+    Bench_pause(b);
+    free(buf);
+    Bench_resume(b);
+}
+
+void bench_reader(Bench *b, const char *delimiters)
+{
+    Bench_pause(b);
+    const char *path = bench_file(b, b->arg);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        int fd = open(path, O_RDONLY);
+        BufReader r = BufReader_new(fd, 0);
+        BufReader_set_delimiters(&r, delimiters);
+        StringView token;
+        size_t total = 0;
+        while (BufReader_next(&r, &token))
+        {
+            total += token.len;
+        }
+        DO_NOT_OPTIMIZE(total);
+        BufReader_drop(&r);
+        close(fd);
+    }
+}
+
+BENCH_RANGE(BufReader_lines, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    bench_reader(b, "\n");
+}
+
+// Two delimiters take the SSE2 scan
+BENCH_RANGE(BufReader_words, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    bench_reader(b, "\n ");
+}
+
+int main(int argc, char **argv)
+{
+    int ret = run_benches(argc, argv);
+    unlink(BENCH_PATH);
+    return ret;
+}
@@ -0,0 +1,126 @@
+// Build: gcc -O2 -pthread src/bench/concurrent_map.c -o bench_concurrent_map
+#define ALLOC_IMPLEMENTATION
+#define CONCURRENT_MAP_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../modules/concurrent_map.h"
+#include "../modules/test.h"
+
+#define KEYS (1 << 20)
+#define MAX_THREADS 64
+
+ConcurrentMap map;
+bool map_ready = false;
+
+// Half of the key space present, built once and shared by every bench
+ConcurrentMap *bench_map(void)
+{
+    if (!map_ready)
+    {
+        map = ConcurrentMap_new(0, sizeof(uint64_t), sizeof(uint64_t), GLOBAL_ALLOCATOR);
+        for (uint64_t key = 0; key < KEYS; key += 2)
+        {
+            ConcurrentMap_insert(&map, &key, &key);
+        }
+        map_ready = true;
+    }
+    return &map;
+}
+
+typedef struct
+{
+    ConcurrentMap *map;
+    uint64_t seed;
+    unsigned write_percent;
+    uint64_t ops;
+} Worker;
+
+void *worker_main(void *arg)
+{
+    Worker *w = arg;
+    uint64_t x = w->seed;
+    for (uint64_t i = 0; i < w->ops; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        uint64_t key = x % KEYS;
+        if (x % 100 < w->write_percent)
+        {
+            ConcurrentMap_insert(w->map, &key, &x);
+        }
+        else
+        {
+            uint64_t value;
+            ConcurrentMap_get(w->map, &key, &value);
+            DO_NOT_OPTIMIZE(value);
+        }
+    }
+    return NULL;
+}
+
+// `arg` threads share the iterations; one operation is one get or insert
+void bench_mix(Bench *b, unsigned write_percent)
+{
+    Bench_pause(b);
+    ConcurrentMap *m = bench_map();
+    size_t threads = (size_t)b->arg;
+    pthread_t ids[MAX_THREADS];
+    Worker workers[MAX_THREADS];
+    for (size_t i = 0; i < threads; i++)
+    {
+        uint64_t ops = b->iterations / threads + (i < b->iterations % threads);
+        workers[i] = (Worker){m, 0x9E3779B97F4A7C15ull * (i + 1), write_percent, ops};
+    }
+    Bench_resume(b);
+    for (size_t i = 0; i < threads; i++)
+    {
+        pthread_create(&ids[i], NULL, worker_main, &workers[i]);
+    }
+    for (size_t i = 0; i < threads; i++)
+    {
+        pthread_join(ids[i], NULL);
+    }
+}
+
+BENCH_RANGE(ConcurrentMap_95read_5write, 1, MAX_THREADS, 2)
+{
+    bench_mix(b, 5);
+}
+
+BENCH_RANGE(ConcurrentMap_50read_50write, 1, MAX_THREADS, 2)
+{
+    bench_mix(b, 50);
+}
+
+// Batched lookups of 1024 keys, half of them present
+BENCH(ConcurrentMap_get_many)
+{
+    Bench_pause(b);
+    ConcurrentMap *m = bench_map();
+    uint64_t keys[1024];
+    uint64_t values[1024];
+    for (size_t i = 0; i < 1024; i++)
+    {
+        keys[i] = (i * 7919) % KEYS;
+    }
+    Bench_set_items(b, 1024);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        size_t hits = ConcurrentMap_get_many(m, keys, 1024, values, NULL);
+        DO_NOT_OPTIMIZE(hits);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int ret = run_benches(argc, argv);
+    if (map_ready)
+    {
+        ConcurrentMap_drop(&map);
+    }
+    return ret;
+}
@@ -0,0 +1,177 @@
+// Build: gcc -O2 src/bench/csv.c -o bench_csv
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define STRING_IMPLEMENTATION
+#define CSV_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/csv.h"
+#include "../modules/test.h"
+
+#define MIN_SIZE 1000
+#define MAX_SIZE 100000000
+#define SIZE_STEP 10
+#define CHUNK (1 << 20)
+
+// Generate `target` bytes of CSV with an int, a double, a quoted text and a plain text column
+char *generate(size_t target, size_t *len)
+{
+    char *data = malloc(target + 256);
+    size_t n = 0;
+    uint64_t x = 88172645463325252ull;
+    while (n < target)
+    {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        n += (size_t)sprintf(data + n, "%llu,%.3f,\"user %u, \"\"vip\"\"\",status-%u\r\n",
+                             (unsigned long long)(x % 1000000), (double)(x % 100000) / 7.0,
+                             (unsigned)(x % 5000), (unsigned)(x % 10));
+    }
+    *len = n;
+    return data;
+}
+
+// Naive per-character state machine for comparison
+size_t scalar_fields(const char *data, size_t len)
+{
+    size_t fields = 0;
+    bool quoted = false;
+    for (size_t i = 0; i < len; i++)
+    {
+        char c = data[i];
+        if (c == '"')
+        {
+            quoted = !quoted;
+        }
+        else if (!quoted && (c == ',' || c == '\n'))
+        {
+            fields++;
+        }
+    }
+    return fields;
+}
+
+char *data = NULL;
+size_t data_len = 0;
+size_t data_target = 0;
+
+// CSV of about `target` bytes, regenerated only when the size changes
+const char *bench_data(Bench *b, size_t target)
+{
+    if (data_target != target)
+    {
+        free(data);
+        data = generate(target, &data_len);
+        data_target = target;
+    }
+    Bench_set_bytes(b, data_len);
+    return data;
+}
+
+BENCH_RANGE(Csv_scalar_state_machine, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    const char *csv = bench_data(b, b->arg);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        size_t fields = scalar_fields(csv, data_len);
+        DO_NOT_OPTIMIZE(fields);
+    }
+}
+
+// A fresh tokenizer per operation, so its field and row buffers grow each time
+BENCH_RANGE(CsvTokenizer_feed, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    const char *csv = bench_data(b, b->arg);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        CsvTokenizer t = CsvTokenizer_new(',');
+        CsvTokenizer_feed(&t, csv, data_len);
+        CsvTokenizer_finish(&t);
+        DO_NOT_OPTIMIZE(t.fields.len);
+        CsvTokenizer_drop(&t);
+    }
+}
+
+// The same with the buffers already allocated
+BENCH_RANGE(CsvTokenizer_feed_reused, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    const char *csv = bench_data(b, b->arg);
+    CsvTokenizer t = CsvTokenizer_new(',');
+    CsvTokenizer_feed(&t, csv, data_len);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        CsvTokenizer_reset(&t);
+        CsvTokenizer_feed(&t, csv, data_len);
+        CsvTokenizer_finish(&t);
+        DO_NOT_OPTIMIZE(t.fields.len);
+    }
+    Bench_pause(b);
+    CsvTokenizer_drop(&t);
+    Bench_resume(b);
+}
+
+// Streaming in 1 MiB chunks, clearing rows as they complete
+BENCH_RANGE(CsvTokenizer_feed_chunked, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    const char *csv = bench_data(b, b->arg);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        CsvTokenizer t = CsvTokenizer_new(',');
+        size_t rows = 0;
+        for (size_t k = 0; k < data_len; k += CHUNK)
+        {
+            CsvTokenizer_feed(&t, csv + k, data_len - k < CHUNK ? data_len - k : CHUNK);
+            rows += CsvTokenizer_row_count(&t);
+            CsvTokenizer_clear_rows(&t);
+        }
+        CsvTokenizer_finish(&t);
+        rows += CsvTokenizer_row_count(&t);
+        DO_NOT_OPTIMIZE(rows);
+        CsvTokenizer_drop(&t);
+    }
+}
+
+// Typed conversion of already tokenized input
+BENCH_RANGE(Csv_parse_columns, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    const char *csv = bench_data(b, b->arg);
+    CsvTokenizer t = CsvTokenizer_new(',');
+    CsvTokenizer_feed(&t, csv, data_len);
+    CsvTokenizer_finish(&t);
+    CsvColumnType types[] = {CSV_INT64, CSV_DOUBLE, CSV_STRING, CSV_STRING};
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Vec columns[4] = {Vec_new(), Vec_new(), Vec_new(), Vec_new()};
+        size_t bad = Csv_parse_columns(&t, csv, 0, types, 4, columns);
+        DO_NOT_OPTIMIZE(bad);
+        Bench_pause(b);
+        for (size_t c = 0; c < 4; c++)
+        {
+            Vec_drop(&columns[c]);
+        }
+        Bench_resume(b);
+    }
+    Bench_pause(b);
+    CsvTokenizer_drop(&t);
+    Bench_resume(b);
+}
+
+int main(int argc, char **argv)
+{
+    int ret = run_benches(argc, argv);
+    free(data);
+    return ret;
+}
@@ -0,0 +1,123 @@
+// Build: gcc -O2 src/bench/pvec.c -o bench_pvec
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define PVEC_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/pvec.h"
+#include "../modules/test.h"
+
+#define MIN_SIZE 1000
+#define MAX_SIZE 10000000
+#define SIZE_STEP 10
+
+PVec filled_pvec(size_t n)
+{
+    PVec empty = PVec_new(sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    PVec t = PVec_transient(&empty);
+    for (uint64_t i = 0; i < n; i++)
+    {
+        PVec_transient_push(&t, &i);
+    }
+    return PVec_persistent(&t);
+}
+
+// Every push keeps the previous version alive until the next one exists
+BENCH_RANGE(PVec_push, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        PVec v = PVec_new(sizeof(uint64_t), GLOBAL_ALLOCATOR);
+        for (uint64_t k = 0; k < b->arg; k++)
+        {
+            PVec next = PVec_push(&v, &k);
+            PVec_drop(&v);
+            v = next;
+        }
+        PVec_drop(&v);
+    }
+}
+
+BENCH_RANGE(PVec_transient_push, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        PVec v = filled_pvec(b->arg);
+        DO_NOT_OPTIMIZE(v.root);
+        PVec_drop(&v);
+    }
+}
+
+BENCH_RANGE(PVec_get, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    PVec v = filled_pvec(b->arg);
+    Bench_resume(b);
+    Bench_set_items(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        uint64_t sum = 0;
+        for (size_t k = 0; k < b->arg; k++)
+        {
+            sum += *(const uint64_t *)PVec_get(&v, k);
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    Bench_pause(b);
+    PVec_drop(&v);
+    Bench_resume(b);
+}
+
+// One update producing a new version while the old one stays readable
+BENCH_RANGE(PVec_set_snapshot, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    PVec v = filled_pvec(b->arg);
+    Bench_resume(b);
+    uint64_t seed = 1;
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        PVec next = PVec_set(&v, (seed >> 20) % b->arg, &seed);
+        DO_NOT_OPTIMIZE(next.root);
+        PVec_drop(&next);
+    }
+    Bench_pause(b);
+    PVec_drop(&v);
+    Bench_resume(b);
+}
+
+// The same update by deep-copying a Vec, which PVec replaces
+BENCH_RANGE(Vec_copy_set_snapshot, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    Vec v = Vec_with_capacity(b->arg, sizeof(uint64_t));
+    for (uint64_t k = 0; k < b->arg; k++)
+    {
+        Vec_push(&v, &k, sizeof(k));
+    }
+    Bench_resume(b);
+    uint64_t seed = 1;
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        Vec next = Vec_with_capacity(v.len, sizeof(uint64_t));
+        memcpy(next.buf.ptr, v.buf.ptr, v.len * sizeof(uint64_t));
+        next.len = v.len;
+        Vec_set(&next, (seed >> 20) % b->arg, &seed, sizeof(seed));
+        DO_NOT_OPTIMIZE(next.buf.ptr);
+        Vec_drop(&next);
+    }
+    Bench_pause(b);
+    Vec_drop(&v);
+    Bench_resume(b);
+}
+
+int main(int argc, char **argv)
+{
+    return run_benches(argc, argv);
+}
@@ -0,0 +1,410 @@
+// Build: gcc -O2 -pthread src/bench/queue.c -o bench_queue
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define QUEUE_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../modules/queue.h"
+#include "../modules/test.h"
+
+#define QUEUE_CAPACITY 1024
+#define MAX_THREADS 4
+// Latency buckets: 32 per power of two, so a reported value is within 1/32 of the true one
+#define LATENCY_SUB_BITS 5
+#define LATENCY_BUCKETS (64 << LATENCY_SUB_BITS)
+#define MAX_HISTOGRAMS 8
+
+typedef struct
+{
+    void *q;
+    uint64_t items;
+} Worker;
+
+/**
+ * Per-message latencies in nanoseconds. The harness's median and p99 are
+ * taken over per-sample averages, which hide the tail of single hand-offs,
+ * so the latency benches also fill one of these and main prints its
+ * percentiles after the run.
+ */
+typedef struct
+{
+    char name[64];
+    uint64_t total;
+    uint64_t counts[LATENCY_BUCKETS];
+} Histogram;
+
+Histogram histograms[MAX_HISTOGRAMS];
+int histogram_count = 0;
+
+// The histogram collecting `name`, created on first use
+Histogram *histogram_for(const char *name, uint64_t arg)
+{
+    char full[64];
+    if (arg > 0)
+    {
+        snprintf(full, sizeof(full), "%s/%llu", name, (unsigned long long)arg);
+    }
+    else
+    {
+        snprintf(full, sizeof(full), "%s", name);
+    }
+    for (int i = 0; i < histogram_count; i++)
+    {
+        if (strcmp(histograms[i].name, full) == 0)
+        {
+            return &histograms[i];
+        }
+    }
+    assert(histogram_count < MAX_HISTOGRAMS);
+    Histogram *h = &histograms[histogram_count++];
+    snprintf(h->name, sizeof(h->name), "%s", full);
+    return h;
+}
+
+static inline void Histogram_record(Histogram *h, uint64_t ns)
+{
+    size_t index = ns;
+    if (ns >= (1u << LATENCY_SUB_BITS))
+    {
+        int shift = 63 - __builtin_clzll(ns) - LATENCY_SUB_BITS;
+        index = ((size_t)(shift + 1) << LATENCY_SUB_BITS) + ((ns >> shift) & ((1u << LATENCY_SUB_BITS) - 1));
+    }
+    h->counts[index]++;
+    h->total++;
+}
+
+void Histogram_merge(Histogram *into, const Histogram *from)
+{
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        into->counts[i] += from->counts[i];
+    }
+    into->total += from->total;
+}
+
+// Lower bound of the bucket holding the `percentile`th value
+uint64_t Histogram_percentile(const Histogram *h, double percentile)
+{
+    uint64_t rank = (uint64_t)(percentile / 100 * (double)h->total);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++)
+    {
+        seen += h->counts[i];
+        if (seen > rank)
+        {
+            if (i < (1u << LATENCY_SUB_BITS))
+            {
+                return i;
+            }
+            int shift = (int)(i >> LATENCY_SUB_BITS) - 1;
+            return ((1ull << LATENCY_SUB_BITS) + (i & ((1u << LATENCY_SUB_BITS) - 1))) << shift;
+        }
+    }
+    return 0;
+}
+
+void *spsc_producer(void *arg)
+{
+    Worker *w = arg;
+    for (uint64_t i = 0; i < w->items; i++)
+    {
+        SpscQueue_push(w->q, &i);
+    }
+    return NULL;
+}
+
+// One operation is one message through a 1P1C queue
+BENCH(SpscQueue_1P1C)
+{
+    Bench_pause(b);
+    SpscQueue q = SpscQueue_new(QUEUE_CAPACITY, sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    Worker w = {&q, b->iterations};
+    Bench_resume(b);
+    pthread_t producer;
+    pthread_create(&producer, NULL, spsc_producer, &w);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        uint64_t value;
+        SpscQueue_pop(&q, &value);
+        DO_NOT_OPTIMIZE(value);
+    }
+    pthread_join(producer, NULL);
+    Bench_pause(b);
+    SpscQueue_drop(&q);
+    Bench_resume(b);
+}
+
+void *spsc_batch_producer(void *arg)
+{
+    Worker *w = arg;
+    uint64_t values[64];
+    size_t rounds = 0;
+    for (uint64_t i = 0; i < w->items;)
+    {
+        size_t count = w->items - i < 64 ? (size_t)(w->items - i) : 64;
+        for (size_t j = 0; j < count; j++)
+        {
+            values[j] = i + j;
+        }
+        size_t pushed = 0;
+        while (pushed < count)
+        {
+            size_t n = SpscQueue_push_batch(w->q, values + pushed, count - pushed);
+            if (n == 0)
+            {
+                Queue_backoff_(&rounds);
+            }
+            pushed += n;
+        }
+        i += count;
+    }
+    return NULL;
+}
+
+// Batches of 64 on both sides; one operation is still one message
+BENCH(SpscQueue_1P1C_batch64)
+{
+    Bench_pause(b);
+    SpscQueue q = SpscQueue_new(QUEUE_CAPACITY, sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    Worker w = {&q, b->iterations};
+    Bench_resume(b);
+    pthread_t producer;
+    pthread_create(&producer, NULL, spsc_batch_producer, &w);
+    uint64_t values[64];
+    size_t rounds = 0;
+    for (uint64_t received = 0; received < b->iterations;)
+    {
+        size_t n = SpscQueue_pop_batch(&q, values, 64);
+        if (n == 0)
+        {
+            Queue_backoff_(&rounds);
+        }
+        received += n;
+    }
+    DO_NOT_OPTIMIZE(values[0]);
+    pthread_join(producer, NULL);
+    Bench_pause(b);
+    SpscQueue_drop(&q);
+    Bench_resume(b);
+}
+
+typedef struct
+{
+    SpscQueue *ping;
+    SpscQueue *pong;
+    uint64_t items;
+} Echo;
+
+void *spsc_echo(void *arg)
+{
+    Echo *e = arg;
+    for (uint64_t i = 0; i < e->items; i++)
+    {
+        uint64_t value;
+        SpscQueue_pop(e->ping, &value);
+        SpscQueue_push(e->pong, &value);
+    }
+    return NULL;
+}
+
+// Hand-off latency: one operation is a round trip through two queues
+BENCH(SpscQueue_round_trip)
+{
+    Bench_pause(b);
+    SpscQueue ping = SpscQueue_new(QUEUE_CAPACITY, sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    SpscQueue pong = SpscQueue_new(QUEUE_CAPACITY, sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    Echo e = {&ping, &pong, b->iterations};
+    Histogram *h = histogram_for("SpscQueue_round_trip", 0);
+    Bench_resume(b);
+    pthread_t echo;
+    pthread_create(&echo, NULL, spsc_echo, &e);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        uint64_t value;
+        uint64_t start = now_monotonic_ns();
+        SpscQueue_push(&ping, &i);
+        SpscQueue_pop(&pong, &value);
+        Histogram_record(h, now_monotonic_ns() - start);
+        DO_NOT_OPTIMIZE(value);
+    }
+    pthread_join(echo, NULL);
+    Bench_pause(b);
+    SpscQueue_drop(&ping);
+    SpscQueue_drop(&pong);
+    Bench_resume(b);
+}
+
+void *mpmc_producer(void *arg)
+{
+    Worker *w = arg;
+    for (uint64_t i = 0; i < w->items; i++)
+    {
+        MpmcQueue_push(w->q, &i);
+    }
+    return NULL;
+}
+
+void *mpmc_consumer(void *arg)
+{
+    Worker *w = arg;
+    for (uint64_t i = 0; i < w->items; i++)
+    {
+        uint64_t value;
+        MpmcQueue_pop(w->q, &value);
+        DO_NOT_OPTIMIZE(value);
+    }
+    return NULL;
+}
+
+// `arg` producers and `arg` consumers; one operation is one message
+BENCH_RANGE(MpmcQueue_NPNC, 1, MAX_THREADS, 2)
+{
+    Bench_pause(b);
+    size_t n = (size_t)b->arg;
+    MpmcQueue q = MpmcQueue_new(QUEUE_CAPACITY, sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    uint64_t per_thread = (b->iterations + n - 1) / n;
+    Worker w = {&q, per_thread};
+    pthread_t threads[2 * MAX_THREADS];
+    Bench_resume(b);
+    for (size_t i = 0; i < n; i++)
+    {
+        pthread_create(&threads[i], NULL, mpmc_producer, &w);
+        pthread_create(&threads[n + i], NULL, mpmc_consumer, &w);
+    }
+    for (size_t i = 0; i < 2 * n; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    Bench_pause(b);
+    MpmcQueue_drop(&q);
+    Bench_resume(b);
+}
+
+// Messages carry their send time so the consumer can time the hand-off
+typedef struct
+{
+    uint64_t sent;
+    uint64_t seq;
+} Message;
+
+typedef struct
+{
+    void *q;
+    uint64_t items;
+    Histogram latency;
+} LatencyWorker;
+
+void *spsc_stamping_producer(void *arg)
+{
+    LatencyWorker *w = arg;
+    for (uint64_t i = 0; i < w->items; i++)
+    {
+        Message msg = {now_monotonic_ns(), i};
+        SpscQueue_push(w->q, &msg);
+    }
+    return NULL;
+}
+
+// One-way latency with the producer running flat out, so it includes time spent queued
+BENCH(SpscQueue_1P1C_latency)
+{
+    Bench_pause(b);
+    SpscQueue q = SpscQueue_new(QUEUE_CAPACITY, sizeof(Message), GLOBAL_ALLOCATOR);
+    LatencyWorker *w = calloc(1, sizeof(LatencyWorker));
+    *w = (LatencyWorker){.q = &q, .items = b->iterations};
+    Bench_resume(b);
+    pthread_t producer;
+    pthread_create(&producer, NULL, spsc_stamping_producer, w);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Message msg;
+        SpscQueue_pop(&q, &msg);
+        Histogram_record(&w->latency, now_monotonic_ns() - msg.sent);
+    }
+    pthread_join(producer, NULL);
+    Bench_pause(b);
+    Histogram_merge(histogram_for("SpscQueue_1P1C_latency", 0), &w->latency);
+    free(w);
+    SpscQueue_drop(&q);
+    Bench_resume(b);
+}
+
+void *mpmc_stamping_producer(void *arg)
+{
+    LatencyWorker *w = arg;
+    for (uint64_t i = 0; i < w->items; i++)
+    {
+        Message msg = {now_monotonic_ns(), i};
+        MpmcQueue_push(w->q, &msg);
+    }
+    return NULL;
+}
+
+void *mpmc_timing_consumer(void *arg)
+{
+    LatencyWorker *w = arg;
+    for (uint64_t i = 0; i < w->items; i++)
+    {
+        Message msg;
+        MpmcQueue_pop(w->q, &msg);
+        Histogram_record(&w->latency, now_monotonic_ns() - msg.sent);
+    }
+    return NULL;
+}
+
+// `arg` producers and `arg` consumers; each consumer keeps its own histogram
+BENCH_RANGE(MpmcQueue_NPNC_latency, 1, MAX_THREADS, 2)
+{
+    Bench_pause(b);
+    size_t n = (size_t)b->arg;
+    MpmcQueue q = MpmcQueue_new(QUEUE_CAPACITY, sizeof(Message), GLOBAL_ALLOCATOR);
+    uint64_t per_thread = (b->iterations + n - 1) / n;
+    LatencyWorker *consumers = calloc(n, sizeof(LatencyWorker));
+    LatencyWorker producer = {.q = &q, .items = per_thread};
+    for (size_t i = 0; i < n; i++)
+    {
+        consumers[i].q = &q;
+        consumers[i].items = per_thread;
+    }
+    pthread_t threads[2 * MAX_THREADS];
+    Bench_resume(b);
+    for (size_t i = 0; i < n; i++)
+    {
+        pthread_create(&threads[i], NULL, mpmc_stamping_producer, &producer);
+        pthread_create(&threads[n + i], NULL, mpmc_timing_consumer, &consumers[i]);
+    }
+    for (size_t i = 0; i < 2 * n; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    Bench_pause(b);
+    Histogram *h = histogram_for("MpmcQueue_NPNC_latency", b->arg);
+    for (size_t i = 0; i < n; i++)
+    {
+        Histogram_merge(h, &consumers[i].latency);
+    }
+    free(consumers);
+    MpmcQueue_drop(&q);
+    Bench_resume(b);
+}
+
+int main(int argc, char **argv)
+{
+    int ret = run_benches(argc, argv);
+    if (histogram_count > 0)
+    {
+        printf("\nPer-message latency over every run, calibration included:\n");
+    }
+    for (int i = 0; i < histogram_count; i++)
+    {
+        const Histogram *h = &histograms[i];
+        printf("%-28s p50 %8llu ns   p99 %8llu ns   p99.9 %8llu ns   (%llu messages)\n", h->name,
+               (unsigned long long)Histogram_percentile(h, 50), (unsigned long long)Histogram_percentile(h, 99),
+               (unsigned long long)Histogram_percentile(h, 99.9), (unsigned long long)h->total);
+    }
+    return ret;
+}
@@ -0,0 +1,137 @@
+// Build: gcc -O2 -pthread src/bench/scheduler.c -o bench_scheduler
+#define ALLOC_IMPLEMENTATION
+#define SCHEDULER_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/scheduler.h"
+#include "../modules/test.h"
+
+#define MIN_SIZE 1000
+#define MAX_SIZE 100000000
+#define SIZE_STEP 10
+
+Scheduler *sched = NULL;
+
+// One pool with the default worker count, shared by every bench
+Scheduler *bench_scheduler(void)
+{
+    if (sched == NULL)
+    {
+        sched = Scheduler_new(0, GLOBAL_ALLOCATOR);
+    }
+    return sched;
+}
+
+void noop(void *arg)
+{
+    (void)arg;
+}
+
+typedef struct
+{
+    Scheduler *sched;
+    uint64_t count;
+} SpawnBench;
+
+// Runs on a worker so spawns go through the local deque fast path
+void spawn_many(void *arg)
+{
+    SpawnBench *bench = arg;
+    TaskGroup group;
+    TaskGroup_init(&group, NULL, NULL);
+    for (uint64_t i = 0; i < bench->count; i++)
+    {
+        Scheduler_spawn(bench->sched, &group, noop, NULL);
+    }
+    Scheduler_wait(bench->sched, &group);
+}
+
+typedef struct
+{
+    Scheduler *sched;
+    unsigned n;
+    unsigned long result;
+} Fib;
+
+void fib_task(void *arg)
+{
+    Fib *fib = arg;
+    if (fib->n < 2)
+    {
+        fib->result = fib->n;
+        return;
+    }
+    Fib a = {fib->sched, fib->n - 1, 0};
+    Fib b = {fib->sched, fib->n - 2, 0};
+    TaskGroup group;
+    TaskGroup_init(&group, NULL, NULL);
+    Scheduler_spawn(fib->sched, &group, fib_task, &a);
+    fib_task(&b);
+    Scheduler_wait(fib->sched, &group);
+    fib->result = a.result + b.result;
+}
+
+void scale_range(size_t begin, size_t end, void *arg)
+{
+    double *values = arg;
+    for (size_t i = begin; i < end; i++)
+    {
+        values[i] = values[i] * 0.5 + 1.0;
+    }
+}
+
+void run_on_pool(Scheduler *sched, TaskFunc func, void *arg)
+{
+    TaskGroup group;
+    TaskGroup_init(&group, NULL, NULL);
+    Scheduler_spawn(sched, &group, func, arg);
+    Scheduler_wait(sched, &group);
+}
+
+// One operation is spawning and running one empty task
+BENCH(Scheduler_spawn)
+{
+    SpawnBench spawn = {bench_scheduler(), b->iterations};
+    run_on_pool(spawn.sched, spawn_many, &spawn);
+}
+
+// Recursive fork-join: one task per call of fib(arg)
+BENCH_RANGE(Scheduler_fib, 15, 30, 2)
+{
+    Scheduler *s = bench_scheduler();
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Fib fib = {s, (unsigned)b->arg, 0};
+        run_on_pool(s, fib_task, &fib);
+        DO_NOT_OPTIMIZE(fib.result);
+    }
+}
+
+BENCH_RANGE(Scheduler_parallel_for, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    Scheduler *s = bench_scheduler();
+    double *values = calloc(b->arg, sizeof(double));
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(double));
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Scheduler_parallel_for(s, 0, b->arg, 0, scale_range, values);
+        CLOBBER_MEMORY();
+    }
+    Bench_pause(b);
+    free(values);
+    Bench_resume(b);
+}
+
+int main(int argc, char **argv)
+{
+    int ret = run_benches(argc, argv);
+    if (sched != NULL)
+    {
+        Scheduler_drop(sched);
+    }
+    return ret;
+}
@@ -0,0 +1,163 @@
+// Build: gcc -O2 src/bench/search.c -o bench_search
+// Sizes above BENCH_MAX_ARG are skipped; the 1G-key run needs about 12 GB.
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define SEARCH_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/search.h"
+#include "../modules/test.h"
+
+#define MIN_KEYS 1000000
+#define MAX_KEYS 1000000000
+#define KEYS_STEP 10
+#define QUERIES 4096
+
+// Keys 0, 4, 8, ... and QUERIES of them picked at random
+Vec make_keys(size_t count)
+{
+    Vec keys = Vec_with_capacity(count, sizeof(uint32_t));
+    uint32_t *k = keys.buf.ptr;
+    for (size_t i = 0; i < count; i++)
+    {
+        k[i] = (uint32_t)(i * 4);
+    }
+    keys.len = count;
+    return keys;
+}
+
+void make_queries(uint32_t *queries, size_t count)
+{
+    uint64_t seed = 99;
+    for (size_t i = 0; i < QUERIES; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        queries[i] = (uint32_t)((seed >> 24) % count * 4);
+    }
+}
+
+int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+BENCH_RANGE(bsearch, MIN_KEYS, MAX_KEYS, KEYS_STEP)
+{
+    Bench_pause(b);
+    Vec keys = make_keys(b->arg);
+    uint32_t queries[QUERIES];
+    make_queries(queries, b->arg);
+    Bench_resume(b);
+    Bench_set_items(b, QUERIES);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        size_t sum = 0;
+        for (size_t q = 0; q < QUERIES; q++)
+        {
+            const uint32_t *hit = bsearch(&queries[q], keys.buf.ptr, keys.len, sizeof(uint32_t), compare_u32);
+            sum += (size_t)(hit - (const uint32_t *)keys.buf.ptr);
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    Bench_pause(b);
+    Vec_drop(&keys);
+    Bench_resume(b);
+}
+
+BENCH_RANGE(Eytzinger_lower_bound, MIN_KEYS, MAX_KEYS, KEYS_STEP)
+{
+    Bench_pause(b);
+    Vec keys = make_keys(b->arg);
+    Eytzinger e = Eytzinger_new(&keys, GLOBAL_ALLOCATOR);
+    Vec_drop(&keys);
+    uint32_t queries[QUERIES];
+    make_queries(queries, b->arg);
+    Bench_resume(b);
+    Bench_set_items(b, QUERIES);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        size_t sum = 0;
+        for (size_t q = 0; q < QUERIES; q++)
+        {
+            sum += Eytzinger_lower_bound(&e, queries[q]);
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    Bench_pause(b);
+    Eytzinger_drop(&e);
+    Bench_resume(b);
+}
+
+BENCH_RANGE(Eytzinger_lower_bound_batch, MIN_KEYS, MAX_KEYS, KEYS_STEP)
+{
+    Bench_pause(b);
+    Vec keys = make_keys(b->arg);
+    Eytzinger e = Eytzinger_new(&keys, GLOBAL_ALLOCATOR);
+    Vec_drop(&keys);
+    uint32_t queries[QUERIES];
+    size_t out[QUERIES];
+    make_queries(queries, b->arg);
+    Bench_resume(b);
+    Bench_set_items(b, QUERIES);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Eytzinger_lower_bound_batch(&e, queries, QUERIES, out);
+        CLOBBER_MEMORY();
+    }
+    Bench_pause(b);
+    Eytzinger_drop(&e);
+    Bench_resume(b);
+}
+
+BENCH_RANGE(STree_lower_bound, MIN_KEYS, MAX_KEYS, KEYS_STEP)
+{
+    Bench_pause(b);
+    Vec keys = make_keys(b->arg);
+    STree t = STree_new(&keys, GLOBAL_ALLOCATOR);
+    Vec_drop(&keys);
+    uint32_t queries[QUERIES];
+    make_queries(queries, b->arg);
+    Bench_resume(b);
+    Bench_set_items(b, QUERIES);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        size_t sum = 0;
+        for (size_t q = 0; q < QUERIES; q++)
+        {
+            sum += STree_lower_bound(&t, queries[q]);
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    Bench_pause(b);
+    STree_drop(&t);
+    Bench_resume(b);
+}
+
+BENCH_RANGE(STree_lower_bound_batch, MIN_KEYS, MAX_KEYS, KEYS_STEP)
+{
+    Bench_pause(b);
+    Vec keys = make_keys(b->arg);
+    STree t = STree_new(&keys, GLOBAL_ALLOCATOR);
+    Vec_drop(&keys);
+    uint32_t queries[QUERIES];
+    size_t out[QUERIES];
+    make_queries(queries, b->arg);
+    Bench_resume(b);
+    Bench_set_items(b, QUERIES);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        STree_lower_bound_batch(&t, queries, QUERIES, out);
+        CLOBBER_MEMORY();
+    }
+    Bench_pause(b);
+    STree_drop(&t);
+    Bench_resume(b);
+}
+
+int main(int argc, char **argv)
+{
+    return run_benches(argc, argv);
+}
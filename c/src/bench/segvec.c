@@ -0,0 +1,122 @@
+// Build: gcc -O2 src/bench/segvec.c -o bench_segvec
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define SEGVEC_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/segvec.h"
+#include "../modules/vec.h"
+#include "../modules/test.h"
+
+#define MIN_SIZE 1000
+#define MAX_SIZE 100000000
+#define SIZE_STEP 10
+
+BENCH_RANGE(Vec_push, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Vec vec = Vec_new();
+        for (uint64_t k = 0; k < b->arg; k++)
+        {
+            Vec_push(&vec, &k, sizeof(k));
+        }
+        DO_NOT_OPTIMIZE(vec.buf.ptr);
+        Vec_drop(&vec);
+    }
+}
+
+// Growth allocates a new chunk instead of copying everything so far
+BENCH_RANGE(SegVec_push, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        SegVec vec = SegVec_new(sizeof(uint64_t), GLOBAL_ALLOCATOR);
+        for (uint64_t k = 0; k < b->arg; k++)
+        {
+            SegVec_push(&vec, &k);
+        }
+        DO_NOT_OPTIMIZE(vec.chunks[0]);
+        SegVec_drop(&vec);
+    }
+}
+
+// Typed stores into place, as an arena or log would append
+BENCH_RANGE(SegVec_push_uninit, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        SegVec vec = SegVec_new(sizeof(uint64_t), GLOBAL_ALLOCATOR);
+        for (uint64_t k = 0; k < b->arg; k++)
+        {
+            *(uint64_t *)SegVec_push_uninit(&vec) = k;
+        }
+        DO_NOT_OPTIMIZE(vec.chunks[0]);
+        SegVec_drop(&vec);
+    }
+}
+
+BENCH_RANGE(SegVec_get, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    SegVec vec = SegVec_new(sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    for (uint64_t k = 0; k < b->arg; k++)
+    {
+        SegVec_push(&vec, &k);
+    }
+    Bench_resume(b);
+    Bench_set_items(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        uint64_t sum = 0;
+        for (size_t k = 0; k < b->arg; k++)
+        {
+            sum += *(uint64_t *)SegVec_get(&vec, k);
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    Bench_pause(b);
+    SegVec_drop(&vec);
+    Bench_resume(b);
+}
+
+// The same sum one chunk at a time: a plain loop over each contiguous run
+BENCH_RANGE(SegVec_chunk_scan, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    SegVec vec = SegVec_new(sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    for (uint64_t k = 0; k < b->arg; k++)
+    {
+        SegVec_push(&vec, &k);
+    }
+    Bench_resume(b);
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(uint64_t));
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        uint64_t sum = 0;
+        for (size_t c = 0; c < SegVec_chunk_count(&vec); c++)
+        {
+            SegVecChunk chunk = SegVec_chunk(&vec, c);
+            const uint64_t *values = chunk.ptr;
+            for (size_t k = 0; k < chunk.len; k++)
+            {
+                sum += values[k];
+            }
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    Bench_pause(b);
+    SegVec_drop(&vec);
+    Bench_resume(b);
+}
+
+int main(int argc, char **argv)
+{
+    return run_benches(argc, argv);
+}
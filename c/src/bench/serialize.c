@@ -0,0 +1,349 @@
+// Build: gcc -O2 src/bench/serialize.c -o bench_serialize
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define STRING_IMPLEMENTATION
+#define SERIALIZE_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/serialize.h"
+#include "../modules/test.h"
+
+#define MIN_SIZE 1000
+#define MAX_SIZE 100000000
+#define SIZE_STEP 10
+
+Vec doubles;
+size_t doubles_count = 0;
+
+// `count` doubles, rebuilt only when the count changes
+const Vec *bench_doubles(Bench *b, size_t count)
+{
+    if (doubles_count != count)
+    {
+        if (doubles_count != 0)
+        {
+            Vec_drop(&doubles);
+        }
+        doubles = Vec_with_capacity(count, sizeof(double));
+        for (size_t i = 0; i < count; i++)
+        {
+            double x = (double)i * 1.0001;
+            Vec_push(&doubles, &x, sizeof(double));
+        }
+        doubles_count = count;
+    }
+    Bench_set_items(b, count);
+    Bench_set_bytes(b, count * sizeof(double));
+    return &doubles;
+}
+
+Vec strings;
+size_t strings_count = 0;
+size_t strings_bytes = 0;
+
+const Vec *bench_strings(Bench *b, size_t count)
+{
+    if (strings_count != count)
+    {
+        String *owned = Vec_as_mut_slice(&strings);
+        for (size_t i = 0; i < strings_count; i++)
+        {
+            String_drop(&owned[i]);
+        }
+        if (strings_count != 0)
+        {
+            Vec_drop(&strings);
+        }
+        strings = Vec_with_capacity(count, sizeof(String));
+        strings_bytes = 0;
+        char buf[64];
+        for (size_t i = 0; i < count; i++)
+        {
+            snprintf(buf, sizeof(buf), "item-%zu-%zx", i, i * 2654435761u);
+            String s = String_from(buf);
+            strings_bytes += String_len(&s) + 1;
+            Vec_push(&strings, &s, sizeof(String));
+        }
+        strings_count = count;
+    }
+    Bench_set_items(b, count);
+    Bench_set_bytes(b, strings_bytes);
+    return &strings;
+}
+
+// Text baseline: one value per line
+char *doubles_to_text(const Vec *vec, size_t *size)
+{
+    char *text = NULL;
+    FILE *f = open_memstream(&text, size);
+    const double *items = Vec_as_slice(vec);
+    for (size_t i = 0; i < vec->len; i++)
+    {
+        fprintf(f, "%.17g\n", items[i]);
+    }
+    fclose(f);
+    return text;
+}
+
+char *serialize_doubles(const Vec *vec, uint32_t flags, size_t *size)
+{
+    char *data = NULL;
+    FILE *f = open_memstream(&data, size);
+    Vec_serialize(vec, sizeof(double), f, flags);
+    fclose(f);
+    return data;
+}
+
+BENCH_RANGE(Serialize_doubles_text_write, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    const Vec *vec = bench_doubles(b, b->arg);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        size_t size;
+        char *text = doubles_to_text(vec, &size);
+        DO_NOT_OPTIMIZE(text);
+        Bench_pause(b);
+        free(text);
+        Bench_resume(b);
+    }
+}
+
+BENCH_RANGE(Serialize_doubles_text_read, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    size_t size;
+    char *text = doubles_to_text(bench_doubles(b, b->arg), &size);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Vec parsed = Vec_with_capacity(b->arg, sizeof(double));
+        for (char *p = text; *p != '\0';)
+        {
+            char *end;
+            double x = strtod(p, &end);
+            Vec_push(&parsed, &x, sizeof(double));
+            p = end + 1;
+        }
+        DO_NOT_OPTIMIZE(parsed.len);
+        Vec_drop(&parsed);
+    }
+    Bench_pause(b);
+    free(text);
+    Bench_resume(b);
+}
+
+void bench_write(Bench *b, uint32_t flags)
+{
+    Bench_pause(b);
+    const Vec *vec = bench_doubles(b, b->arg);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        size_t size;
+        char *data = serialize_doubles(vec, flags, &size);
+        DO_NOT_OPTIMIZE(data);
+        Bench_pause(b);
+        free(data);
+        Bench_resume(b);
+    }
+}
+
+void bench_view(Bench *b, uint32_t flags)
+{
+    Bench_pause(b);
+    size_t size;
+    char *data = serialize_doubles(bench_doubles(b, b->arg), flags, &size);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        VecView view;
+        bool ok = Vec_view_serialized(data, size, sizeof(double), &view, NULL);
+        DO_NOT_OPTIMIZE(ok);
+    }
+    Bench_pause(b);
+    free(data);
+    Bench_resume(b);
+}
+
+void bench_load(Bench *b, uint32_t flags)
+{
+    Bench_pause(b);
+    size_t size;
+    char *data = serialize_doubles(bench_doubles(b, b->arg), flags, &size);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Vec copy;
+        Vec_deserialize(data, size, sizeof(double), &copy, NULL);
+        DO_NOT_OPTIMIZE(copy.len);
+        Vec_drop(&copy);
+    }
+    Bench_pause(b);
+    free(data);
+    Bench_resume(b);
+}
+
+BENCH_RANGE(Vec_serialize, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    bench_write(b, 0);
+}
+
+BENCH_RANGE(Vec_serialize_xxh64, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    bench_write(b, SERIAL_CHECKSUM);
+}
+
+BENCH_RANGE(Vec_view_serialized, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    bench_view(b, 0);
+}
+
+BENCH_RANGE(Vec_view_serialized_xxh64, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    bench_view(b, SERIAL_CHECKSUM);
+}
+
+BENCH_RANGE(Vec_deserialize, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    bench_load(b, 0);
+}
+
+BENCH_RANGE(Vec_deserialize_xxh64, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    bench_load(b, SERIAL_CHECKSUM);
+}
+
+BENCH_RANGE(Serialize_strings_text_write, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    const Vec *vec = bench_strings(b, b->arg);
+    const String *items = Vec_as_slice(vec);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        char *text = NULL;
+        size_t size;
+        FILE *f = open_memstream(&text, &size);
+        for (size_t k = 0; k < vec->len; k++)
+        {
+            fputs(String_as_str(&items[k]), f);
+            fputc('\n', f);
+        }
+        fclose(f);
+        DO_NOT_OPTIMIZE(text);
+        Bench_pause(b);
+        free(text);
+        Bench_resume(b);
+    }
+}
+
+// One heap String per line, as a text format would have to
+BENCH_RANGE(Serialize_strings_text_read, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    const Vec *vec = bench_strings(b, b->arg);
+    const String *items = Vec_as_slice(vec);
+    char *text = NULL;
+    size_t size;
+    FILE *f = open_memstream(&text, &size);
+    for (size_t k = 0; k < vec->len; k++)
+    {
+        fputs(String_as_str(&items[k]), f);
+        fputc('\n', f);
+    }
+    fclose(f);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Vec parsed = Vec_with_capacity(b->arg, sizeof(String));
+        for (char *p = text; *p != '\0';)
+        {
+            char *nl = strchr(p, '\n');
+            *nl = '\0';
+            String s = String_from(p);
+            Vec_push(&parsed, &s, sizeof(String));
+            *nl = '\n';
+            p = nl + 1;
+        }
+        Bench_pause(b);
+        String *parsed_items = Vec_as_mut_slice(&parsed);
+        for (size_t k = 0; k < parsed.len; k++)
+        {
+            String_drop(&parsed_items[k]);
+        }
+        Vec_drop(&parsed);
+        Bench_resume(b);
+    }
+    Bench_pause(b);
+    free(text);
+    Bench_resume(b);
+}
+
+BENCH_RANGE(Vec_serialize_strings, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    const Vec *vec = bench_strings(b, b->arg);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        char *data = NULL;
+        size_t size;
+        FILE *f = open_memstream(&data, &size);
+        Vec_serialize_strings(vec, f, 0);
+        fclose(f);
+        DO_NOT_OPTIMIZE(data);
+        Bench_pause(b);
+        free(data);
+        Bench_resume(b);
+    }
+}
+
+// Viewing the table and touching every entry
+BENCH_RANGE(StringTable_view_serialized, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    const Vec *vec = bench_strings(b, b->arg);
+    char *data = NULL;
+    size_t size;
+    FILE *f = open_memstream(&data, &size);
+    Vec_serialize_strings(vec, f, 0);
+    fclose(f);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        StringTable table;
+        StringTable_view_serialized(data, size, &table, NULL);
+        size_t total = 0;
+        for (size_t k = 0; k < table.len; k++)
+        {
+            total += StringTable_get(&table, k).len + 1;
+        }
+        DO_NOT_OPTIMIZE(total);
+    }
+    Bench_pause(b);
+    free(data);
+    Bench_resume(b);
+}
+
+int main(int argc, char **argv)
+{
+    int ret = run_benches(argc, argv);
+    if (doubles_count != 0)
+    {
+        Vec_drop(&doubles);
+    }
+    String *owned = Vec_as_mut_slice(&strings);
+    for (size_t i = 0; i < strings_count; i++)
+    {
+        String_drop(&owned[i]);
+    }
+    if (strings_count != 0)
+    {
+        Vec_drop(&strings);
+    }
+    return ret;
+}
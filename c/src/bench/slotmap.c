@@ -0,0 +1,127 @@
+// Build: gcc -O2 src/bench/slotmap.c -o bench_slotmap
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define SLOTMAP_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/slotmap.h"
+#include "../modules/test.h"
+
+#define MIN_VALUES 1000
+#define MAX_VALUES 10000000
+#define VALUES_STEP 10
+
+SlotMap filled_map(size_t count, SlotMapHandle *handles)
+{
+    SlotMap map = SlotMap_new(sizeof(uint64_t));
+    for (uint64_t i = 0; i < count; i++)
+    {
+        handles[i] = SlotMap_insert(&map, &i);
+    }
+    return map;
+}
+
+BENCH_RANGE(SlotMap_insert, MIN_VALUES, MAX_VALUES, VALUES_STEP)
+{
+    Bench_set_items(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        SlotMap map = SlotMap_new(sizeof(uint64_t));
+        for (uint64_t k = 0; k < b->arg; k++)
+        {
+            SlotMapHandle h = SlotMap_insert(&map, &k);
+            DO_NOT_OPTIMIZE(h);
+        }
+        SlotMap_drop(&map);
+    }
+}
+
+// Look up every handle in a random order
+BENCH_RANGE(SlotMap_get, MIN_VALUES, MAX_VALUES, VALUES_STEP)
+{
+    Bench_pause(b);
+    SlotMapHandle *handles = malloc(b->arg * sizeof(SlotMapHandle));
+    SlotMap map = filled_map(b->arg, handles);
+    uint64_t seed = 3;
+    for (size_t k = b->arg; k > 1; k--)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        size_t j = (seed >> 33) % k;
+        SlotMapHandle t = handles[k - 1];
+        handles[k - 1] = handles[j];
+        handles[j] = t;
+    }
+    Bench_resume(b);
+    Bench_set_items(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        uint64_t sum = 0;
+        for (size_t k = 0; k < b->arg; k++)
+        {
+            sum += *(uint64_t *)SlotMap_get(&map, handles[k]);
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    Bench_pause(b);
+    SlotMap_drop(&map);
+    free(handles);
+    Bench_resume(b);
+}
+
+// Remove and reinsert one value: the freed slot comes straight back
+BENCH(SlotMap_remove_insert)
+{
+    Bench_pause(b);
+    SlotMapHandle *handles = malloc(MIN_VALUES * sizeof(SlotMapHandle));
+    SlotMap map = filled_map(MIN_VALUES, handles);
+    Bench_resume(b);
+    uint64_t seed = 5;
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        size_t k = (seed >> 33) % MIN_VALUES;
+        uint64_t value;
+        SlotMap_remove(&map, handles[k], &value);
+        handles[k] = SlotMap_insert(&map, &value);
+    }
+    Bench_pause(b);
+    SlotMap_drop(&map);
+    free(handles);
+    Bench_resume(b);
+}
+
+// Sum every value through the dense array
+BENCH_RANGE(SlotMap_iterate, MIN_VALUES, MAX_VALUES, VALUES_STEP)
+{
+    Bench_pause(b);
+    SlotMapHandle *handles = malloc(b->arg * sizeof(SlotMapHandle));
+    SlotMap map = filled_map(b->arg, handles);
+    for (size_t k = 0; k < b->arg; k += 2)
+    {
+        SlotMap_remove(&map, handles[k], NULL);
+    }
+    Bench_resume(b);
+    Bench_set_items(b, SlotMap_len(&map));
+    Bench_set_bytes(b, SlotMap_len(&map) * sizeof(uint64_t));
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        const uint64_t *values = SlotMap_values(&map);
+        uint64_t sum = 0;
+        for (size_t k = 0; k < SlotMap_len(&map); k++)
+        {
+            sum += values[k];
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    Bench_pause(b);
+    SlotMap_drop(&map);
+    free(handles);
+    Bench_resume(b);
+}
+
+int main(int argc, char **argv)
+{
+    return run_benches(argc, argv);
+}
@@ -0,0 +1,105 @@
+// Build: gcc -O2 src/bench/soa.c -o bench_soa
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/soa.h"
+#include "../modules/test.h"
+
+#define MIN_ROWS 1000
+#define MAX_ROWS 10000000
+#define ROWS_STEP 10
+
+typedef char RecordName[48];
+
+// An 80-byte record, of which the scan reads 8
+typedef struct
+{
+    int64_t id;
+    RecordName name;
+    double score;
+    int64_t age;
+    int64_t flags;
+} Record;
+
+define_SoA(Records, Record, (int64_t, id), (RecordName, name), (double, score), (int64_t, age), (int64_t, flags));
+
+Record *make_rows(size_t count)
+{
+    Record *rows = malloc(count * sizeof(Record));
+    for (size_t i = 0; i < count; i++)
+    {
+        rows[i] = (Record){.id = (int64_t)i, .score = (double)(i % 100), .age = (int64_t)(i % 90)};
+    }
+    return rows;
+}
+
+// Sum one field of an array of structs: every cache line brings in one score
+BENCH_RANGE(scan_aos, MIN_ROWS, MAX_ROWS, ROWS_STEP)
+{
+    Bench_pause(b);
+    Record *rows = make_rows(b->arg);
+    Bench_resume(b);
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(double));
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        double total = 0;
+        for (size_t k = 0; k < b->arg; k++)
+        {
+            total += rows[k].score;
+        }
+        DO_NOT_OPTIMIZE(total);
+    }
+    Bench_pause(b);
+    free(rows);
+    Bench_resume(b);
+}
+
+// The same sum over the score column: eight scores per cache line
+BENCH_RANGE(scan_soa, MIN_ROWS, MAX_ROWS, ROWS_STEP)
+{
+    Bench_pause(b);
+    Record *rows = make_rows(b->arg);
+    Records records = Records_new(GLOBAL_ALLOCATOR);
+    Records_extend_from_rows(&records, rows, b->arg);
+    free(rows);
+    Bench_resume(b);
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(double));
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        const double *scores = Records_column_score(&records);
+        double total = 0;
+        for (size_t k = 0; k < b->arg; k++)
+        {
+            total += scores[k];
+        }
+        DO_NOT_OPTIMIZE(total);
+    }
+    Bench_pause(b);
+    Records_drop(&records);
+    Bench_resume(b);
+}
+
+BENCH_RANGE(Records_push, MIN_ROWS, MAX_ROWS, ROWS_STEP)
+{
+    Bench_set_items(b, b->arg);
+    Record row = {.id = 1, .score = 2.0};
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Records records = Records_new(GLOBAL_ALLOCATOR);
+        for (size_t k = 0; k < b->arg; k++)
+        {
+            Records_push(&records, &row);
+        }
+        DO_NOT_OPTIMIZE(records.id.ptr);
+        Records_drop(&records);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    return run_benches(argc, argv);
+}
@@ -0,0 +1,108 @@
+// Build: gcc -O2 src/bench/string.c -o bench_string
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define STRING_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "../modules/string.h"
+#include "../modules/test.h"
+
+#define MIN_SIZE 8
+#define MAX_SIZE 100000000
+#define SIZE_STEP 10
+
+// A String of `len` lowercase letters
+String make_string(size_t len)
+{
+    String s = String_with_capacity(len + 1);
+    char *p = s.vec.buf.ptr;
+    for (size_t i = 0; i < len; i++)
+    {
+        p[i] = (char)('a' + i % 26);
+    }
+    p[len] = '\0';
+    s.vec.len = len;
+    return s;
+}
+
+BENCH_RANGE(String_push, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        String s = String_new();
+        for (uint64_t k = 0; k < b->arg; k++)
+        {
+            String_push(&s, (char)('a' + k % 26));
+        }
+        DO_NOT_OPTIMIZE(s.vec.buf.ptr);
+        String_drop(&s);
+    }
+}
+
+// Build a String of `arg` bytes from 16-byte pieces
+BENCH_RANGE(String_push_str, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    const char *piece = "0123456789abcdef";
+    size_t pieces = b->arg / 16 > 0 ? b->arg / 16 : 1;
+    Bench_set_items(b, pieces);
+    Bench_set_bytes(b, pieces * 16);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        String s = String_new();
+        for (size_t k = 0; k < pieces; k++)
+        {
+            String_push_str(&s, piece);
+        }
+        DO_NOT_OPTIMIZE(s.vec.buf.ptr);
+        String_drop(&s);
+    }
+}
+
+// One insert in the middle of an `arg`-byte String, which moves the back half
+BENCH_RANGE(String_insert, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    String s = make_string(b->arg);
+    Bench_resume(b);
+    Bench_set_bytes(b, b->arg / 2);
+    size_t mid = b->arg / 2;
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        String_insert(&s, mid, 'x');
+        // Constant time, so it stays inside the timed region
+        String_truncate(&s, b->arg);
+    }
+    DO_NOT_OPTIMIZE(s.vec.buf.ptr);
+    Bench_pause(b);
+    String_drop(&s);
+    Bench_resume(b);
+}
+
+// Copy out the middle half of an `arg`-byte String
+BENCH_RANGE(String_substring, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_pause(b);
+    String s = make_string(b->arg);
+    Bench_resume(b);
+    size_t start = b->arg / 4, end = b->arg - b->arg / 4;
+    Bench_set_bytes(b, end - start);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        String sub = String_substring(&s, start, end);
+        DO_NOT_OPTIMIZE(sub.vec.buf.ptr);
+        String_drop(&sub);
+    }
+    Bench_pause(b);
+    String_drop(&s);
+    Bench_resume(b);
+}
+
+int main(int argc, char **argv)
+{
+    return run_benches(argc, argv);
+}
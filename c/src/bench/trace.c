@@ -0,0 +1,61 @@
+// Build: gcc -O2 -pthread src/bench/trace.c -o bench_trace
+#define TRACE_ENABLED
+#define TRACE_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/trace.h"
+#include "../modules/test.h"
+
+// Cost of one begin/end pair, i.e. two events
+BENCH(trace_scope)
+{
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        TRACE_SCOPE("scope");
+    }
+}
+
+BENCH(trace_counter)
+{
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        TRACE_COUNTER("counter", i);
+    }
+}
+
+// The check done by every event while recording is switched off
+BENCH(trace_inactive)
+{
+    Trace_set_active(false);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        TRACE_COUNTER("counter", i);
+    }
+    Trace_set_active(true);
+}
+
+BENCH(trace_write_chrome)
+{
+    Bench_pause(b);
+    Trace_clear();
+    for (int i = 0; i < 10000; i++)
+    {
+        TRACE_COUNTER("counter", i);
+    }
+    FILE *out = fopen("/dev/null", "w");
+    Bench_resume(b);
+    Bench_set_items(b, 10000);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Trace_write_chrome(out);
+    }
+    Bench_pause(b);
+    fclose(out);
+    Bench_resume(b);
+}
+
+int main(int argc, char **argv)
+{
+    return run_benches(argc, argv);
+}
@@ -0,0 +1,109 @@
+// Build: gcc -O2 src/bench/vec.c -o bench_vec
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/vec.h"
+#include "../modules/test.h"
+
+#define MIN_SIZE 8
+#define MAX_SIZE 100000000
+#define SIZE_STEP 10
+
+// Amortized cost of growing one element at a time, without writing elements
+BENCH_RANGE(RawVec_grow, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        RawVec raw = RawVec_new(GLOBAL_ALLOCATOR);
+        for (size_t len = 0; len < b->arg; len++)
+        {
+            RawVec_reserve(&raw, len, 1, sizeof(uint64_t));
+        }
+        DO_NOT_OPTIMIZE(raw.ptr);
+        RawVec_drop(&raw);
+    }
+}
+
+BENCH_RANGE(Vec_push, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(uint64_t));
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Vec vec = Vec_new();
+        for (uint64_t k = 0; k < b->arg; k++)
+        {
+            Vec_push(&vec, &k, sizeof(k));
+        }
+        DO_NOT_OPTIMIZE(vec.buf.ptr);
+        Vec_drop(&vec);
+    }
+}
+
+BENCH_RANGE(Vec_pop, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(uint64_t));
+    uint64_t zero = 0;
+    Vec vec = Vec_new();
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Bench_pause(b);
+        Vec_resize(&vec, b->arg, &zero, sizeof(zero));
+        Bench_resume(b);
+        uint64_t out, sum = 0;
+        while (Vec_pop(&vec, &out, sizeof(out)))
+        {
+            sum += out;
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    Vec_drop(&vec);
+}
+
+BENCH_RANGE(Vec_get, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(uint64_t));
+    Bench_pause(b);
+    uint64_t one = 1;
+    Vec vec = Vec_new();
+    Vec_resize(&vec, b->arg, &one, sizeof(one));
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        uint64_t sum = 0;
+        for (size_t k = 0; k < b->arg; k++)
+        {
+            sum += *(uint64_t *)Vec_get(&vec, k, sizeof(uint64_t));
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    Bench_pause(b);
+    Vec_drop(&vec);
+    Bench_resume(b);
+}
+
+// Fill from empty to `arg` copies of a value, including the one reservation
+BENCH_RANGE(Vec_resize, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(uint64_t));
+    uint64_t value = 0x5555;
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Vec vec = Vec_new();
+        Vec_resize(&vec, b->arg, &value, sizeof(value));
+        DO_NOT_OPTIMIZE(vec.buf.ptr);
+        Vec_drop(&vec);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    return run_benches(argc, argv);
+}
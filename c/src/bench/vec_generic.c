@@ -0,0 +1,148 @@
+// Build: gcc -O2 src/bench/vec_generic.c -o bench_vec_generic
+//
+// The same operations as bench/vec.c over define_RawVec_of(uint64_t), so the
+// element size is a compile-time constant and elements are assigned rather
+// than memcpy'd. rawvec_generic.h and rawvec.h define the same function
+// names, so the two variants live in separate programs.
+#define ALLOC_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/rawvec_generic.h"
+#include "../modules/test.h"
+
+#define MIN_SIZE 8
+#define MAX_SIZE 100000000
+#define SIZE_STEP 10
+
+define_RawVec_of(uint64_t);
+
+typedef struct
+{
+    RawVec_of_uint64_t buf;
+    size_t len;
+} VecOfU64;
+
+static inline void VecOfU64_push(VecOfU64 *vec, uint64_t value)
+{
+    if (vec->len == vec->buf.cap)
+    {
+        RawVec_reserve(&vec->buf, vec->len, 1, sizeof(uint64_t));
+    }
+    vec->buf.ptr[vec->len++] = value;
+}
+
+static inline bool VecOfU64_pop(VecOfU64 *vec, uint64_t *out)
+{
+    if (vec->len == 0)
+    {
+        return false;
+    }
+    *out = vec->buf.ptr[--vec->len];
+    return true;
+}
+
+static inline void VecOfU64_resize(VecOfU64 *vec, size_t new_len, uint64_t value)
+{
+    if (new_len > vec->len)
+    {
+        RawVec_reserve(&vec->buf, vec->len, new_len - vec->len, sizeof(uint64_t));
+        for (size_t i = vec->len; i < new_len; i++)
+        {
+            vec->buf.ptr[i] = value;
+        }
+    }
+    vec->len = new_len;
+}
+
+BENCH_RANGE(RawVec_of_grow, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        RawVec_of_uint64_t raw = RawVec_new(GLOBAL_ALLOCATOR);
+        for (size_t len = 0; len < b->arg; len++)
+        {
+            RawVec_reserve(&raw, len, 1, sizeof(uint64_t));
+        }
+        DO_NOT_OPTIMIZE(raw.ptr);
+        RawVec_drop(&raw);
+    }
+}
+
+BENCH_RANGE(VecOf_push, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(uint64_t));
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        VecOfU64 vec = {.buf = RawVec_new(GLOBAL_ALLOCATOR), .len = 0};
+        for (uint64_t k = 0; k < b->arg; k++)
+        {
+            VecOfU64_push(&vec, k);
+        }
+        DO_NOT_OPTIMIZE(vec.buf.ptr);
+        RawVec_drop(&vec.buf);
+    }
+}
+
+BENCH_RANGE(VecOf_pop, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(uint64_t));
+    VecOfU64 vec = {.buf = RawVec_new(GLOBAL_ALLOCATOR), .len = 0};
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        Bench_pause(b);
+        VecOfU64_resize(&vec, b->arg, 0);
+        Bench_resume(b);
+        uint64_t out, sum = 0;
+        while (VecOfU64_pop(&vec, &out))
+        {
+            sum += out;
+        }
+        DO_NOT_OPTIMIZE(sum);
+    }
+    RawVec_drop(&vec.buf);
+}
+
+BENCH_RANGE(VecOf_get, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(uint64_t));
+    Bench_pause(b);
+    VecOfU64 vec = {.buf = RawVec_new(GLOBAL_ALLOCATOR), .len = 0};
+    VecOfU64_resize(&vec, b->arg, 1);
+    Bench_resume(b);
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        uint64_t sum = 0;
+        for (size_t k = 0; k < vec.len; k++)
+        {
+            sum += vec.buf.ptr[k];
+            // Keep the loop scalar like the erased Vec_get loop
+            DO_NOT_OPTIMIZE(sum);
+        }
+    }
+    Bench_pause(b);
+    RawVec_drop(&vec.buf);
+    Bench_resume(b);
+}
+
+BENCH_RANGE(VecOf_resize, MIN_SIZE, MAX_SIZE, SIZE_STEP)
+{
+    Bench_set_items(b, b->arg);
+    Bench_set_bytes(b, b->arg * sizeof(uint64_t));
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        VecOfU64 vec = {.buf = RawVec_new(GLOBAL_ALLOCATOR), .len = 0};
+        VecOfU64_resize(&vec, b->arg, 0x5555);
+        DO_NOT_OPTIMIZE(vec.buf.ptr);
+        RawVec_drop(&vec.buf);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    return run_benches(argc, argv);
+}
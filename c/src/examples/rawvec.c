@@ -1,3 +1,5 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
 #include "../modules/rawvec.h"
 
 // Example struct to store in our RawVec
@@ -14,7 +16,7 @@ void print_people(RawVec *vec, size_t len)
     {
         printf("Person %zu: ID = %d, Name = %s\n", i, people[i].id, people[i].name);
     }
-    printf("Capacity: %zu\n\n", RawVec_capacity(vec, sizeof(Person)));
+    printf("Capacity: %zu\n\n", RawVec_capacity(vec));
 }
 
 #define print_type(x) _Generic((x), \
@@ -63,7 +65,7 @@ int main()
     RawVec_drop(&vec);
     printf("RawVec dropped\n");
 
-    print_type(vec);
+    printf("vec is %s\n", print_type(vec));
 
     return 0;
 }
\ No newline at end of file
@@ -1,3 +1,4 @@
+#define ALLOC_IMPLEMENTATION
 #include "../modules/rawvec_generic.h"
 
 // Example struct to store in our RawVec
@@ -59,7 +60,7 @@ int main()
     RawVec_drop(&vec);
     printf("RawVec dropped\n");
 
-    print_type(vec);
+    printf("vec is %s\n", print_type(vec));
 
     return 0;
 }
\ No newline at end of file
@@ -1,3 +1,7 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define STRING_IMPLEMENTATION
 #include <stdio.h>
 #include "../modules/string.h"
 
@@ -9,16 +13,16 @@ int main()
 
     // Create a String with initial capacity
     String s2 = String_with_capacity(10);
-    printf("s2 capacity: %zu\n", s2);
+    printf("s2 capacity: %zu\n", String_capacity(&s2));
 
     // Create a String from a C string
     String s3 = String_from("Hello, ");
-    printf("s3 content: %s\n", s3);
+    printf("s3 content: %s\n", String_as_str(&s3));
     printf("s3 length: %zu\n", String_len(&s3));
 
     // Append to the String
     String_push_str(&s3, "world!");
-    printf("s3 after push: %s\n", s3);
+    printf("s3 after push: %s\n", String_as_str(&s3));
     printf("s3 new length: %zu\n", String_len(&s3));
 
     // Clear the String
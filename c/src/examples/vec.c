@@ -1,3 +1,6 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
@@ -14,7 +17,7 @@ void free_wrapper(void *ptr)
     free(ptr);
 }
 
-void *realloc_wrapper(void *ptr, size_t old_size, size_t new_size)
+void *realloc_sized(void *ptr, size_t old_size, size_t new_size)
 {
     (void)old_size; // Unused parameter
     return realloc(ptr, new_size);
@@ -23,11 +26,11 @@ void *realloc_wrapper(void *ptr, size_t old_size, size_t new_size)
 Allocator global_allocator = {
     .allocate = malloc_wrapper,
     .deallocate = free_wrapper,
-    .reallocate = realloc_wrapper};
+    .reallocate = realloc_sized};
 
 void print_vec(Vec *vec)
 {
-    printf("Vec (len: %zu, capacity: %zu): [", Vec_len(vec), Vec_capacity(vec, sizeof(int)));
+    printf("Vec (len: %zu, capacity: %zu): [", Vec_len(vec), Vec_capacity(vec));
     for (size_t i = 0; i < Vec_len(vec); i++)
     {
         int *value = Vec_get(vec, i, sizeof(int));
@@ -50,8 +53,8 @@ void print_vec(Vec *vec)
 
 int main()
 {
-    // Create a new Vec
-    Vec vec = Vec_new(global_allocator);
+    // Create a new Vec; Vec_new uses GLOBAL_ALLOCATOR, so build one on our allocator directly
+    Vec vec = {.buf = RawVec_new(global_allocator), .len = 0};
     printf("Created a new Vec\n");
     print_vec(&vec);
 
@@ -0,0 +1,621 @@
+#ifndef _AIO_H_INCLUDED_
+#define _AIO_H_INCLUDED_
+
+/**
+ * Request setup is static inline; the executor is emitted by the unit
+ * that defines AIO_IMPLEMENTATION. One unit also defines ALLOC_,
+ * RAWVEC_, VEC_ and VECDEQUE_IMPLEMENTATION.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include "vec.h"
+#include "vecdeque.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#define AIO_HAVE_URING 1
+#else
+#define AIO_HAVE_URING 0
+#endif
+
+#define AIO_DEFAULT_THREADS 8
+
+typedef enum
+{
+    // io_uring if the kernel supports it, otherwise the thread pool
+    AIO_AUTO,
+    AIO_URING,
+    AIO_THREADS,
+} AioBackend;
+
+typedef enum
+{
+    AIO_READ,
+    AIO_WRITE,
+} AioOp;
+
+typedef struct AioRequest AioRequest;
+typedef void (*AioCallback)(AioRequest *req, void *arg);
+
+/**
+ * One pread or pwrite. The request and its buffer belong to the caller and
+ * must stay put until the request completes. A read appends up to `len`
+ * bytes to `buf` (a Vec of bytes, reserved at submission); a write sends
+ * the first `len` bytes of `buf`. Both backends retry short transfers, so
+ * `result` is `len` unless end of file or an error stopped the transfer:
+ * then it is the byte count so far, or -errno if nothing was transferred.
+ */
+struct AioRequest
+{
+    AioOp op;
+    int fd;
+    off_t offset;
+    Vec *buf;
+    size_t len;
+    ssize_t result;
+    AioCallback callback;
+    void *arg;
+    size_t done; // bytes transferred so far, while in flight
+};
+
+// Prepare a read of `len` bytes at `offset`, appended to `buf` on completion
+static inline void AioRequest_read(AioRequest *req, int fd, off_t offset, Vec *buf, size_t len, AioCallback callback, void *arg)
+{
+    *req = (AioRequest){
+        .op = AIO_READ, .fd = fd, .offset = offset, .buf = buf, .len = len, .callback = callback, .arg = arg};
+}
+
+// Prepare a write of the contents of `buf` at `offset`
+static inline void AioRequest_write(AioRequest *req, int fd, off_t offset, Vec *buf, AioCallback callback, void *arg)
+{
+    *req = (AioRequest){
+        .op = AIO_WRITE, .fd = fd, .offset = offset, .buf = buf, .len = buf->len, .callback = callback, .arg = arg};
+}
+
+#if AIO_HAVE_URING
+typedef struct
+{
+    int fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    void *ring_map;
+    size_t ring_map_size;
+    size_t sqes_map_size;
+    unsigned to_submit;
+} AioUring;
+#endif
+
+typedef struct
+{
+    pthread_t *threads;
+    size_t count;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+    VecDeque queue;
+    Vec completed;
+    bool stop;
+    Allocator alloc;
+} AioPool;
+
+/**
+ * Batched file I/O. Requests are submitted in groups and completed on the
+ * thread that calls Aio_poll, which runs the callbacks, whichever backend
+ * does the work: io_uring where available, otherwise a pool of threads
+ * doing blocking pread/pwrite. At most `depth` requests are in flight;
+ * submitting more waits for earlier ones and queues their completions.
+ */
+typedef struct
+{
+    AioBackend backend;
+    size_t depth;
+    size_t in_flight;
+    Vec ready;
+#if AIO_HAVE_URING
+    AioUring uring;
+#endif
+    AioPool pool;
+    Allocator alloc;
+} Aio;
+
+/**
+ * Create an executor allowing `depth` requests in flight (0 for 64). The
+ * executor and its queues are allocated from `alloc`. With AIO_URING,
+ * returns NULL if io_uring is not available.
+ */
+Aio *Aio_new(size_t depth, AioBackend backend, Allocator alloc);
+
+// Get the backend in use (AIO_URING or AIO_THREADS)
+static inline AioBackend Aio_backend(const Aio *aio)
+{
+    return aio->backend;
+}
+
+// Get the number of submitted requests that have not been delivered by Aio_poll
+static inline size_t Aio_pending(const Aio *aio)
+{
+    return aio->in_flight + aio->ready.len;
+}
+
+/**
+ * Submit a batch of prepared requests. Read buffers are reserved here. If
+ * the executor is at its depth limit, this waits for earlier requests to
+ * finish; their callbacks still run only from Aio_poll.
+ */
+void Aio_submit(Aio *aio, AioRequest **reqs, size_t count);
+
+// Submit a single request
+static inline void Aio_submit_one(Aio *aio, AioRequest *req)
+{
+    Aio_submit(aio, &req, 1);
+}
+
+/**
+ * Deliver finished requests: grow read buffers by the bytes read and run
+ * callbacks. Waits until at least `min_complete` requests have been
+ * delivered by this call (0 never blocks). Returns the number delivered.
+ */
+size_t Aio_poll(Aio *aio, size_t min_complete);
+
+// Deliver every outstanding request
+void Aio_wait_all(Aio *aio);
+
+// Wait for outstanding requests, then release the ring or stop the pool
+void Aio_drop(Aio *aio);
+
+#endif // _AIO_H_INCLUDED_
+
+#if defined(AIO_IMPLEMENTATION) && !defined(_AIO_IMPLEMENTATION_INCLUDED_)
+#define _AIO_IMPLEMENTATION_INCLUDED_
+
+// Perform a request with blocking calls, retrying short transfers
+void Aio_perform_(AioRequest *req)
+{
+    char *base = req->op == AIO_READ ? (char *)req->buf->buf.ptr + req->buf->len : req->buf->buf.ptr;
+    size_t done = 0;
+    while (done < req->len)
+    {
+        ssize_t n = req->op == AIO_READ
+                        ? pread(req->fd, base + done, req->len - done, req->offset + (off_t)done)
+                        : pwrite(req->fd, base + done, req->len - done, req->offset + (off_t)done);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0)
+        {
+            req->result = done > 0 ? (ssize_t)done : -errno;
+            return;
+        }
+        if (n == 0)
+        {
+            break;
+        }
+        done += (size_t)n;
+    }
+    req->result = (ssize_t)done;
+}
+
+void *AioPool_main_(void *arg)
+{
+    AioPool *pool = arg;
+    pthread_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        AioRequest *req;
+        while (!VecDeque_pop_front(&pool->queue, &req, sizeof(AioRequest *)))
+        {
+            if (pool->stop)
+            {
+                pthread_mutex_unlock(&pool->lock);
+                return NULL;
+            }
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+        Aio_perform_(req);
+        pthread_mutex_lock(&pool->lock);
+        Vec_push(&pool->completed, &req, sizeof(AioRequest *));
+        pthread_cond_signal(&pool->done);
+    }
+}
+
+void AioPool_start_(AioPool *pool, size_t threads, Allocator alloc)
+{
+    pool->alloc = alloc;
+    pool->count = threads;
+    pool->threads = alloc.allocate(threads * sizeof(pthread_t));
+    assert(pool->threads != NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->queue = (VecDeque){.buf = RawVec_new(alloc), .head = 0, .len = 0};
+    pool->completed = (Vec){.buf = RawVec_new(alloc), .len = 0};
+    pool->stop = false;
+    for (size_t i = 0; i < threads; i++)
+    {
+        pthread_create(&pool->threads[i], NULL, AioPool_main_, pool);
+    }
+}
+
+void AioPool_stop_(AioPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (size_t i = 0; i < pool->count; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pool->alloc.deallocate(pool->threads);
+    VecDeque_drop(&pool->queue);
+    Vec_drop(&pool->completed);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work);
+    pthread_cond_destroy(&pool->done);
+}
+
+#if AIO_HAVE_URING
+// Set up a ring and map its queues; false if io_uring is unavailable or too old
+bool AioUring_init_(AioUring *ring, unsigned entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0)
+    {
+        return false;
+    }
+    // IORING_OP_READ/WRITE arrived with RW_CUR_POS (5.6); one mapping covers both rings since 5.4
+    if (!(params.features & IORING_FEAT_RW_CUR_POS) || !(params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        close(fd);
+        return false;
+    }
+    size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    size_t ring_size = sq_size > cq_size ? sq_size : cq_size;
+    char *map = mmap(NULL, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (map == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+    size_t sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void *sqes = mmap(NULL, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        munmap(map, ring_size);
+        close(fd);
+        return false;
+    }
+    *ring = (AioUring){
+        .fd = fd,
+        .sq_head = (unsigned *)(map + params.sq_off.head),
+        .sq_tail = (unsigned *)(map + params.sq_off.tail),
+        .sq_mask = (unsigned *)(map + params.sq_off.ring_mask),
+        .sq_array = (unsigned *)(map + params.sq_off.array),
+        .sqes = sqes,
+        .cq_head = (unsigned *)(map + params.cq_off.head),
+        .cq_tail = (unsigned *)(map + params.cq_off.tail),
+        .cq_mask = (unsigned *)(map + params.cq_off.ring_mask),
+        .cqes = (struct io_uring_cqe *)(map + params.cq_off.cqes),
+        .ring_map = map,
+        .ring_map_size = ring_size,
+        .sqes_map_size = sqes_size,
+        .to_submit = 0};
+    return true;
+}
+
+// Queue one request in the submission ring (the caller keeps it below capacity)
+void AioUring_push_(AioUring *ring, AioRequest *req)
+{
+    unsigned tail = *ring->sq_tail;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = req->op == AIO_READ ? IORING_OP_READ : IORING_OP_WRITE;
+    sqe->fd = req->fd;
+    sqe->off = (uint64_t)(req->offset + (off_t)req->done);
+    char *addr = req->op == AIO_READ ? (char *)req->buf->buf.ptr + req->buf->len : req->buf->buf.ptr;
+    sqe->addr = (uint64_t)(uintptr_t)(addr + req->done);
+    sqe->len = (uint32_t)(req->len - req->done);
+    sqe->user_data = (uint64_t)(uintptr_t)req;
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+}
+
+// Submit queued entries and optionally wait for `wait_for` completions
+bool AioUring_enter_(AioUring *ring, unsigned wait_for)
+{
+    for (;;)
+    {
+        long n = syscall(__NR_io_uring_enter, ring->fd, ring->to_submit, wait_for,
+                         wait_for > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        if (n >= 0)
+        {
+            ring->to_submit -= (unsigned)n;
+            return true;
+        }
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+            return false;
+        }
+    }
+}
+
+/**
+ * Move completed entries to `ready`; returns how many. A short transfer is
+ * queued again for the remainder, like the retry loop of Aio_perform_, and
+ * only completes at end of file, on an error or once `len` bytes are done.
+ */
+size_t AioUring_reap_(AioUring *ring, Vec *ready)
+{
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    size_t count = 0;
+    for (; head != tail; head++)
+    {
+        struct io_uring_cqe *cqe = &ring->cqes[head & *ring->cq_mask];
+        AioRequest *req = (AioRequest *)(uintptr_t)cqe->user_data;
+        if (cqe->res == -EINTR)
+        {
+            AioUring_push_(ring, req);
+            continue;
+        }
+        if (cqe->res > 0)
+        {
+            req->done += (size_t)cqe->res;
+            if (req->done < req->len)
+            {
+                AioUring_push_(ring, req);
+                continue;
+            }
+        }
+        req->result = cqe->res < 0 && req->done == 0 ? cqe->res : (ssize_t)req->done;
+        Vec_push(ready, &req, sizeof(AioRequest *));
+        count++;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    return count;
+}
+
+/**
+ * Take back the entries queued since the last successful enter and
+ * complete them with `-err` (or the bytes already moved, for a requeued
+ * remainder). The kernel only reads the submission ring inside enter, so
+ * the entries can be unqueued by moving the tail back. Returns how many.
+ */
+size_t AioUring_fail_unsubmitted_(AioUring *ring, int err, Vec *ready)
+{
+    unsigned tail = *ring->sq_tail;
+    unsigned first = tail - ring->to_submit;
+    for (unsigned i = first; i != tail; i++)
+    {
+        struct io_uring_sqe *sqe = &ring->sqes[ring->sq_array[i & *ring->sq_mask]];
+        AioRequest *req = (AioRequest *)(uintptr_t)sqe->user_data;
+        req->result = req->done == 0 ? -err : (ssize_t)req->done;
+        Vec_push(ready, &req, sizeof(AioRequest *));
+    }
+    __atomic_store_n(ring->sq_tail, first, __ATOMIC_RELEASE);
+    ring->to_submit = 0;
+    return tail - first;
+}
+
+void AioUring_drop_(AioUring *ring)
+{
+    munmap(ring->sqes, ring->sqes_map_size);
+    munmap(ring->ring_map, ring->ring_map_size);
+    close(ring->fd);
+}
+
+#endif
+Aio *Aio_new(size_t depth, AioBackend backend, Allocator alloc)
+{
+    Aio *aio = alloc.allocate(sizeof(Aio));
+    assert(aio != NULL);
+    aio->alloc = alloc;
+    aio->depth = depth == 0 ? 64 : depth;
+    aio->in_flight = 0;
+    aio->ready = (Vec){.buf = RawVec_new(alloc), .len = 0};
+    aio->backend = AIO_THREADS;
+#if AIO_HAVE_URING
+    if (backend != AIO_THREADS && AioUring_init_(&aio->uring, (unsigned)aio->depth))
+    {
+        aio->backend = AIO_URING;
+        return aio;
+    }
+#endif
+    if (backend == AIO_URING)
+    {
+        Vec_drop(&aio->ready);
+        alloc.deallocate(aio);
+        return NULL;
+    }
+    AioPool_start_(&aio->pool, aio->depth < AIO_DEFAULT_THREADS ? aio->depth : AIO_DEFAULT_THREADS, alloc);
+    return aio;
+}
+
+// Collect finished requests into `ready`, blocking for at least one if `wait`
+void Aio_reap_(Aio *aio, bool wait)
+{
+#if AIO_HAVE_URING
+    if (aio->backend == AIO_URING)
+    {
+        size_t got = AioUring_reap_(&aio->uring, &aio->ready);
+        // Submit requeued remainders, and block until one request really finishes if asked to
+        for (;;)
+        {
+            bool block = wait && got == 0;
+            if (!block && aio->uring.to_submit == 0)
+            {
+                break;
+            }
+            if (!AioUring_enter_(&aio->uring, block ? 1 : 0))
+            {
+                // Requests that never reached the kernel fail here instead of waiting forever
+                got += AioUring_fail_unsubmitted_(&aio->uring, errno, &aio->ready);
+                break;
+            }
+            got += AioUring_reap_(&aio->uring, &aio->ready);
+            if (!block)
+            {
+                break;
+            }
+        }
+        aio->in_flight -= got;
+        return;
+    }
+#endif
+    AioPool *pool = &aio->pool;
+    pthread_mutex_lock(&pool->lock);
+    while (wait && pool->completed.len == 0)
+    {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    AioRequest **done = Vec_as_mut_slice(&pool->completed);
+    for (size_t i = 0; i < pool->completed.len; i++)
+    {
+        Vec_push(&aio->ready, &done[i], sizeof(AioRequest *));
+    }
+    aio->in_flight -= pool->completed.len;
+    Vec_clear(&pool->completed);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void Aio_submit(Aio *aio, AioRequest **reqs, size_t count)
+{
+    size_t i = 0;
+    while (i < count)
+    {
+        while (aio->in_flight == aio->depth)
+        {
+            Aio_reap_(aio, true);
+        }
+        size_t batch = count - i < aio->depth - aio->in_flight ? count - i : aio->depth - aio->in_flight;
+        for (size_t j = i; j < i + batch; j++)
+        {
+            reqs[j]->done = 0;
+            if (reqs[j]->op == AIO_READ)
+            {
+                Vec_reserve(reqs[j]->buf, reqs[j]->len, sizeof(char));
+            }
+        }
+#if AIO_HAVE_URING
+        if (aio->backend == AIO_URING)
+        {
+            for (size_t j = i; j < i + batch; j++)
+            {
+                AioUring_push_(&aio->uring, reqs[j]);
+            }
+            aio->in_flight += batch;
+            if (!AioUring_enter_(&aio->uring, 0))
+            {
+                aio->in_flight -= AioUring_fail_unsubmitted_(&aio->uring, errno, &aio->ready);
+            }
+            i += batch;
+            continue;
+        }
+#endif
+        AioPool *pool = &aio->pool;
+        pthread_mutex_lock(&pool->lock);
+        VecDeque_push_back_n(&pool->queue, reqs + i, batch, sizeof(AioRequest *));
+        aio->in_flight += batch;
+        if (batch == 1)
+        {
+            pthread_cond_signal(&pool->work);
+        }
+        else
+        {
+            pthread_cond_broadcast(&pool->work);
+        }
+        pthread_mutex_unlock(&pool->lock);
+        i += batch;
+    }
+}
+
+size_t Aio_poll(Aio *aio, size_t min_complete)
+{
+    size_t delivered = 0;
+    bool first = true;
+    for (;;)
+    {
+        bool must_wait = delivered < min_complete && aio->ready.len == 0 && aio->in_flight > 0;
+        if (first || must_wait)
+        {
+            Aio_reap_(aio, must_wait);
+        }
+        first = false;
+        if (aio->ready.len == 0)
+        {
+            if (delivered >= min_complete || aio->in_flight == 0)
+            {
+                return delivered;
+            }
+            continue;
+        }
+        // Callbacks may submit more requests, which can grow `ready`
+        AioRequest *req;
+        Vec_pop(&aio->ready, &req, sizeof(AioRequest *));
+        if (req->op == AIO_READ && req->result > 0)
+        {
+            req->buf->len += (size_t)req->result;
+        }
+        delivered++;
+        if (req->callback != NULL)
+        {
+            req->callback(req, req->arg);
+        }
+    }
+}
+
+void Aio_wait_all(Aio *aio)
+{
+    while (Aio_pending(aio) > 0)
+    {
+        Aio_poll(aio, Aio_pending(aio));
+    }
+}
+
+void Aio_drop(Aio *aio)
+{
+    Aio_wait_all(aio);
+#if AIO_HAVE_URING
+    if (aio->backend == AIO_URING)
+    {
+        AioUring_drop_(&aio->uring);
+    }
+#endif
+    if (aio->backend == AIO_THREADS)
+    {
+        AioPool_stop_(&aio->pool);
+    }
+    Vec_drop(&aio->ready);
+    aio->alloc.deallocate(aio);
+}
+
+#endif // AIO_IMPLEMENTATION
@@ -1,18 +1,43 @@
 #ifndef _ALLOC_H_INCLUDED_
 #define _ALLOC_H_INCLUDED_
 
+/**
+ * Declarations only. Exactly one translation unit of a program defines
+ * ALLOC_IMPLEMENTATION before including this header, which emits the
+ * out-of-line functions and GLOBAL_ALLOCATOR there:
+ *
+ *     #define ALLOC_IMPLEMENTATION
+ *     #include "alloc.h"
+ *
+ * With TRACE_PROBES the probes record through trace.h, so one unit must
+ * also define TRACE_IMPLEMENTATION.
+ */
+
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#ifdef TRACE_PROBES
+#include "trace.h"
+#endif
 
 typedef struct
 {
     void *(*allocate)(size_t size);
     void (*deallocate)(void *ptr);
     void *(*reallocate)(void *ptr, size_t old_size, size_t new_size);
+    // Optional: memory aligned to a power of two, released with deallocate
+    void *(*allocate_aligned)(size_t size, size_t align);
+    void *(*reallocate_aligned)(void *ptr, size_t old_size, size_t new_size, size_t align);
 } Allocator;
 
+// Alignment every allocate/reallocate result already satisfies
+#define ALLOC_DEFAULT_ALIGN _Alignof(max_align_t)
+
 // Function to create a custom allocator
-Allocator create_allocator(
+static inline Allocator create_allocator(
     void *(*allocate_func)(size_t),
     void (*deallocate_func)(void *),
     void *(*reallocate_func)(void *, size_t, size_t))
@@ -23,15 +48,151 @@ Allocator create_allocator(
         .reallocate = reallocate_func};
 }
 
+// realloc with the Allocator signature
+void *realloc_wrapper(void *ptr, size_t old_size, size_t new_size);
+
+// posix_memalign with the allocate_aligned signature
+void *aligned_alloc_wrapper(size_t size, size_t align);
+
+// realloc, moving the block to a fresh aligned one if realloc lost the alignment
+void *aligned_realloc_wrapper(void *ptr, size_t old_size, size_t new_size, size_t align);
+
+/**
+ * Allocate size bytes aligned to align. Alignments up to ALLOC_DEFAULT_ALIGN
+ * go through plain allocate; larger ones need allocate_aligned.
+ */
+static inline void *Allocator_allocate_aligned(const Allocator *alloc, size_t size, size_t align)
+{
+    if (align <= ALLOC_DEFAULT_ALIGN)
+    {
+        return alloc->allocate(size);
+    }
+    assert(alloc->allocate_aligned != NULL);
+    return alloc->allocate_aligned(size, align);
+}
+
+/**
+ * Resize a block from Allocator_allocate_aligned, keeping its alignment.
+ * Allocators without reallocate_aligned fall back to allocate, copy and free.
+ */
+static inline void *Allocator_reallocate_aligned(const Allocator *alloc, void *ptr, size_t old_size, size_t new_size,
+                                                 size_t align)
+{
+    if (align <= ALLOC_DEFAULT_ALIGN)
+    {
+        return alloc->reallocate(ptr, old_size, new_size);
+    }
+    if (alloc->reallocate_aligned != NULL)
+    {
+        return alloc->reallocate_aligned(ptr, old_size, new_size, align);
+    }
+    void *new_ptr = Allocator_allocate_aligned(alloc, new_size, align);
+    if (new_ptr != NULL)
+    {
+        memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+        alloc->deallocate(ptr);
+    }
+    return new_ptr;
+}
+
+#ifdef TRACE_PROBES
+// Allocation probes: each call records an instant event carrying the size
+void *traced_malloc(size_t size);
+void traced_free(void *ptr);
+void *traced_realloc_wrapper(void *ptr, size_t old_size, size_t new_size);
+void *traced_aligned_alloc_wrapper(size_t size, size_t align);
+void *traced_aligned_realloc_wrapper(void *ptr, size_t old_size, size_t new_size, size_t align);
+#endif
+
+// malloc, free and realloc (through the traced probes under TRACE_PROBES)
+extern Allocator GLOBAL_ALLOCATOR;
+
+#endif // _ALLOC_H_INCLUDED_
+
+#if defined(ALLOC_IMPLEMENTATION) && !defined(_ALLOC_IMPLEMENTATION_INCLUDED_)
+#define _ALLOC_IMPLEMENTATION_INCLUDED_
+
 void *realloc_wrapper(void *ptr, size_t old_size, size_t new_size)
 {
     (void)old_size; // Unused parameter
     return realloc(ptr, new_size);
 }
 
+void *aligned_alloc_wrapper(size_t size, size_t align)
+{
+    void *ptr;
+    if (align < sizeof(void *))
+    {
+        align = sizeof(void *);
+    }
+    if (posix_memalign(&ptr, align, size) != 0)
+    {
+        return NULL;
+    }
+    return ptr;
+}
+
+void *aligned_realloc_wrapper(void *ptr, size_t old_size, size_t new_size, size_t align)
+{
+    void *new_ptr = realloc(ptr, new_size);
+    if (new_ptr == NULL || ((uintptr_t)new_ptr & (align - 1)) == 0)
+    {
+        return new_ptr;
+    }
+    // realloc kept only the default alignment; move to an aligned block
+    void *aligned = aligned_alloc_wrapper(new_size, align);
+    if (aligned != NULL)
+    {
+        memcpy(aligned, new_ptr, old_size < new_size ? old_size : new_size);
+    }
+    free(new_ptr);
+    return aligned;
+}
+
+#ifdef TRACE_PROBES
+void *traced_malloc(size_t size)
+{
+    TRACE_INSTANT("allocate", size);
+    return malloc(size);
+}
+
+void traced_free(void *ptr)
+{
+    TRACE_INSTANT("deallocate", 0);
+    free(ptr);
+}
+
+void *traced_realloc_wrapper(void *ptr, size_t old_size, size_t new_size)
+{
+    TRACE_INSTANT("reallocate", new_size);
+    return realloc_wrapper(ptr, old_size, new_size);
+}
+
+void *traced_aligned_alloc_wrapper(size_t size, size_t align)
+{
+    TRACE_INSTANT("allocate_aligned", size);
+    return aligned_alloc_wrapper(size, align);
+}
+
+void *traced_aligned_realloc_wrapper(void *ptr, size_t old_size, size_t new_size, size_t align)
+{
+    TRACE_INSTANT("reallocate_aligned", new_size);
+    return aligned_realloc_wrapper(ptr, old_size, new_size, align);
+}
+
+Allocator GLOBAL_ALLOCATOR = {
+    .allocate = traced_malloc,
+    .deallocate = traced_free,
+    .reallocate = traced_realloc_wrapper,
+    .allocate_aligned = traced_aligned_alloc_wrapper,
+    .reallocate_aligned = traced_aligned_realloc_wrapper};
+#else
 Allocator GLOBAL_ALLOCATOR = {
     .allocate = malloc,
     .deallocate = free,
-    .reallocate = realloc_wrapper};
+    .reallocate = realloc_wrapper,
+    .allocate_aligned = aligned_alloc_wrapper,
+    .reallocate_aligned = aligned_realloc_wrapper};
+#endif
 
-#endif // _ALLOC_H_INCLUDED_
+#endif // ALLOC_IMPLEMENTATION
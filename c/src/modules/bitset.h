@@ -0,0 +1,968 @@
+#ifndef _BITSET_H_INCLUDED_
+#define _BITSET_H_INCLUDED_
+
+/**
+ * Bit access, Bitset_count and Roaring_contains are static inline. The
+ * rest is emitted where BITSET_IMPLEMENTATION is defined; one unit also
+ * defines ALLOC_, RAWVEC_ and VEC_IMPLEMENTATION.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "rawvec.h"
+#include "vec.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define BITSET_WORD_BITS 64
+#define BITSET_NONE SIZE_MAX
+
+/**
+ * A growable bit vector packed into 64-bit words held by a RawVec. Bits at
+ * positions >= len in the last word are always zero, so counts and bulk
+ * operations can work on whole words.
+ */
+typedef struct
+{
+    RawVec words;
+    size_t len;
+} Bitset;
+
+static inline size_t Bitset_words_for_(size_t bits)
+{
+    return (bits + BITSET_WORD_BITS - 1) / BITSET_WORD_BITS;
+}
+
+static inline uint64_t *Bitset_words_(const Bitset *b)
+{
+    return b->words.ptr;
+}
+
+// Create an empty Bitset
+static inline Bitset Bitset_new()
+{
+    return (Bitset){.words = RawVec_new(GLOBAL_ALLOCATOR), .len = 0};
+}
+
+// Create a Bitset of `len` bits, all clear
+Bitset Bitset_with_len(size_t len);
+
+// Get the number of bits
+static inline size_t Bitset_len(const Bitset *b)
+{
+    return b->len;
+}
+
+// Zero the unused bits of the last word
+static inline void Bitset_trim_(Bitset *b)
+{
+    if (b->len % BITSET_WORD_BITS != 0)
+    {
+        Bitset_words_(b)[b->len / BITSET_WORD_BITS] &= (1ull << (b->len % BITSET_WORD_BITS)) - 1;
+    }
+}
+
+// Grow or shrink to `len` bits; new bits are set to `value`
+void Bitset_resize(Bitset *b, size_t len, bool value);
+
+// Append one bit
+void Bitset_push(Bitset *b, bool value);
+
+static inline bool Bitset_test(const Bitset *b, size_t index)
+{
+    assert(index < b->len);
+    return (Bitset_words_(b)[index / BITSET_WORD_BITS] >> (index % BITSET_WORD_BITS)) & 1;
+}
+
+static inline void Bitset_set(Bitset *b, size_t index)
+{
+    assert(index < b->len);
+    Bitset_words_(b)[index / BITSET_WORD_BITS] |= 1ull << (index % BITSET_WORD_BITS);
+}
+
+static inline void Bitset_clear(Bitset *b, size_t index)
+{
+    assert(index < b->len);
+    Bitset_words_(b)[index / BITSET_WORD_BITS] &= ~(1ull << (index % BITSET_WORD_BITS));
+}
+
+static inline void Bitset_assign(Bitset *b, size_t index, bool value)
+{
+    assert(index < b->len);
+    uint64_t *word = &Bitset_words_(b)[index / BITSET_WORD_BITS];
+    uint64_t mask = 1ull << (index % BITSET_WORD_BITS);
+    *word = (*word & ~mask) | (-(uint64_t)value & mask);
+}
+
+// Set every bit to `value`
+void Bitset_fill(Bitset *b, bool value);
+
+// Free the memory used by the Bitset
+void Bitset_drop(Bitset *b);
+
+Bitset Bitset_clone(const Bitset *b);
+
+// Count the set bits in `count` words, with POPCNT when the CPU has it
+size_t Bitset_popcount_words(const uint64_t *words, size_t count);
+
+// Count the set bits
+static inline size_t Bitset_count(const Bitset *b)
+{
+    return Bitset_popcount_words(Bitset_words_(b), Bitset_words_for_(b->len));
+}
+
+/**
+ * Find the first set bit at or after `from`, or BITSET_NONE. Iterate over
+ * all set bits with
+ *
+ *     for (size_t i = Bitset_next(&b, 0); i != BITSET_NONE; i = Bitset_next(&b, i + 1))
+ */
+size_t Bitset_next(const Bitset *b, size_t from);
+
+typedef enum
+{
+    BITSET_AND,
+    BITSET_OR,
+    BITSET_XOR,
+    BITSET_ANDNOT,
+} BitsetOp;
+
+/**
+ * In-place set operations. OR and XOR first grow `dst` to `src`'s length;
+ * AND clears the bits of `dst` past the end of `src`; ANDNOT leaves them.
+ */
+void Bitset_combine(Bitset *dst, const Bitset *src, BitsetOp op);
+
+static inline void Bitset_and(Bitset *dst, const Bitset *src)
+{
+    Bitset_combine(dst, src, BITSET_AND);
+}
+
+static inline void Bitset_or(Bitset *dst, const Bitset *src)
+{
+    Bitset_combine(dst, src, BITSET_OR);
+}
+
+static inline void Bitset_xor(Bitset *dst, const Bitset *src)
+{
+    Bitset_combine(dst, src, BITSET_XOR);
+}
+
+static inline void Bitset_andnot(Bitset *dst, const Bitset *src)
+{
+    Bitset_combine(dst, src, BITSET_ANDNOT);
+}
+
+// Position of the k-th (0-based) set bit of a word that has more than k set bits
+static inline unsigned Bitset_select_word_(uint64_t word, unsigned k)
+{
+    // Skip whole bytes using their popcounts, then finish bit by bit
+    unsigned base = 0;
+    for (;;)
+    {
+        unsigned in_byte = (unsigned)__builtin_popcount((unsigned)(word & 0xff));
+        if (k < in_byte)
+        {
+            break;
+        }
+        k -= in_byte;
+        word >>= 8;
+        base += 8;
+    }
+    for (; k > 0; k--)
+    {
+        word &= word - 1;
+    }
+    return base + (unsigned)__builtin_ctzll(word);
+}
+
+#define BITSET_RANK_BLOCK_WORDS 8
+
+/**
+ * A rank/select index over a Bitset: the number of set bits before each
+ * 512-bit block, 1/8 extra space. rank looks up a block and counts at most
+ * seven words within it, so it is O(1); select binary-searches the blocks.
+ * The index describes the Bitset at build time and must be rebuilt after
+ * the bits change.
+ */
+typedef struct
+{
+    const Bitset *bits;
+    Vec blocks;
+    size_t ones;
+} BitsetRank;
+
+BitsetRank BitsetRank_new(const Bitset *b);
+
+// Number of set bits in positions [0, index)
+size_t BitsetRank_rank(const BitsetRank *r, size_t index);
+
+// Position of the k-th (0-based) set bit, or BITSET_NONE if there are k or fewer
+size_t BitsetRank_select(const BitsetRank *r, size_t k);
+
+void BitsetRank_drop(BitsetRank *r);
+
+/**
+ * A compressed bitmap of 32-bit values in the style of Roaring bitmaps.
+ * Values are split on their high 16 bits into containers kept sorted by
+ * key. A container holds a sorted array of the low 16 bits while it has
+ * at most ROARING_ARRAY_MAX values and a 65536-bit bitmap once it is
+ * denser, so sparse sets cost about two bytes per value and dense ones an
+ * eighth of a byte.
+ */
+#define ROARING_ARRAY_MAX 4096
+#define ROARING_BITMAP_WORDS (65536 / BITSET_WORD_BITS)
+
+typedef struct
+{
+    uint16_t key;
+    bool is_bitmap;
+    uint32_t count;
+    // uint16_t values while an array, ROARING_BITMAP_WORDS uint64_t words as a bitmap
+    Vec data;
+} RoaringContainer;
+
+typedef struct
+{
+    Vec containers;
+} Roaring;
+
+static inline Roaring Roaring_new()
+{
+    return (Roaring){.containers = Vec_new()};
+}
+
+static inline RoaringContainer *Roaring_containers_(const Roaring *r)
+{
+    return r->containers.buf.ptr;
+}
+
+// Index of the container for `key`, or where it would be inserted
+size_t Roaring_find_(const Roaring *r, uint16_t key, bool *found);
+
+bool RoaringContainer_contains_(const RoaringContainer *c, uint16_t low);
+
+// Add a value; returns false if it was already present
+bool Roaring_add(Roaring *r, uint32_t value);
+
+// Remove a value; returns false if it was not present
+bool Roaring_remove(Roaring *r, uint32_t value);
+
+static inline bool Roaring_contains(const Roaring *r, uint32_t value)
+{
+    bool found;
+    size_t at = Roaring_find_(r, (uint16_t)(value >> 16), &found);
+    return found && RoaringContainer_contains_(&Roaring_containers_(r)[at], (uint16_t)value);
+}
+
+// Number of values in the set
+size_t Roaring_count(const Roaring *r);
+
+// Smallest value >= from, or false if there is none
+bool Roaring_next(const Roaring *r, uint64_t from, uint32_t *out);
+
+// Add every value of `src` to `dst`
+void Roaring_or(Roaring *dst, const Roaring *src);
+
+// Keep only the values of `dst` that are also in `src`
+void Roaring_and(Roaring *dst, const Roaring *src);
+
+// Bytes used by the containers' data
+size_t Roaring_size_in_bytes(const Roaring *r);
+
+void Roaring_drop(Roaring *r);
+
+#endif // _BITSET_H_INCLUDED_
+
+#if defined(BITSET_IMPLEMENTATION) && !defined(_BITSET_IMPLEMENTATION_INCLUDED_)
+#define _BITSET_IMPLEMENTATION_INCLUDED_
+
+Bitset Bitset_with_len(size_t len)
+{
+    size_t words = Bitset_words_for_(len);
+    Bitset b = {.words = RawVec_with_capacity(words, sizeof(uint64_t), GLOBAL_ALLOCATOR), .len = len};
+    if (words > 0)
+    {
+        memset(b.words.ptr, 0, words * sizeof(uint64_t));
+    }
+    return b;
+}
+
+void Bitset_resize(Bitset *b, size_t len, bool value)
+{
+    size_t old_words = Bitset_words_for_(b->len);
+    size_t new_words = Bitset_words_for_(len);
+    if (new_words > old_words)
+    {
+        RawVec_reserve(&b->words, old_words, new_words - old_words, sizeof(uint64_t));
+        memset(Bitset_words_(b) + old_words, value ? 0xff : 0, (new_words - old_words) * sizeof(uint64_t));
+    }
+    if (value && len > b->len && b->len % BITSET_WORD_BITS != 0)
+    {
+        Bitset_words_(b)[b->len / BITSET_WORD_BITS] |= ~0ull << (b->len % BITSET_WORD_BITS);
+    }
+    b->len = len;
+    Bitset_trim_(b);
+}
+
+void Bitset_push(Bitset *b, bool value)
+{
+    if (b->len % BITSET_WORD_BITS == 0)
+    {
+        RawVec_reserve(&b->words, b->len / BITSET_WORD_BITS, 1, sizeof(uint64_t));
+        Bitset_words_(b)[b->len / BITSET_WORD_BITS] = 0;
+    }
+    Bitset_words_(b)[b->len / BITSET_WORD_BITS] |= (uint64_t)value << (b->len % BITSET_WORD_BITS);
+    b->len++;
+}
+
+void Bitset_fill(Bitset *b, bool value)
+{
+    memset(b->words.ptr, value ? 0xff : 0, Bitset_words_for_(b->len) * sizeof(uint64_t));
+    Bitset_trim_(b);
+}
+
+void Bitset_drop(Bitset *b)
+{
+    RawVec_drop(&b->words);
+    b->len = 0;
+}
+
+Bitset Bitset_clone(const Bitset *b)
+{
+    Bitset copy = Bitset_with_len(b->len);
+    memcpy(copy.words.ptr, b->words.ptr, Bitset_words_for_(b->len) * sizeof(uint64_t));
+    return copy;
+}
+
+size_t Bitset_popcount_portable_(const uint64_t *words, size_t count)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        total += (size_t)__builtin_popcountll(words[i]);
+    }
+    return total;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// The same loop, compiled to the POPCNT instruction
+__attribute__((target("popcnt"))) size_t Bitset_popcount_hw_(const uint64_t *words, size_t count)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        total += (size_t)__builtin_popcountll(words[i]);
+    }
+    return total;
+}
+
+#endif
+size_t Bitset_popcount_words(const uint64_t *words, size_t count)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    static int has_popcnt = -1;
+    if (has_popcnt < 0)
+    {
+        __builtin_cpu_init();
+        has_popcnt = __builtin_cpu_supports("popcnt") ? 1 : 0;
+    }
+    if (has_popcnt)
+    {
+        return Bitset_popcount_hw_(words, count);
+    }
+#endif
+    return Bitset_popcount_portable_(words, count);
+}
+
+size_t Bitset_next(const Bitset *b, size_t from)
+{
+    if (from >= b->len)
+    {
+        return BITSET_NONE;
+    }
+    const uint64_t *words = Bitset_words_(b);
+    size_t count = Bitset_words_for_(b->len);
+    size_t w = from / BITSET_WORD_BITS;
+    uint64_t word = words[w] & (~0ull << (from % BITSET_WORD_BITS));
+    for (;;)
+    {
+        if (word != 0)
+        {
+            return w * BITSET_WORD_BITS + (size_t)__builtin_ctzll(word);
+        }
+        if (++w == count)
+        {
+            return BITSET_NONE;
+        }
+        word = words[w];
+    }
+}
+
+// Apply `op` to `count` words of dst and src, two words per SSE2 instruction
+void Bitset_apply_(uint64_t *dst, const uint64_t *src, size_t count, BitsetOp op)
+{
+    size_t i = 0;
+#ifdef __SSE2__
+    for (size_t end = count & ~(size_t)3; i < end; i += 4)
+    {
+        __m128i a0 = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i a1 = _mm_loadu_si128((const __m128i *)(dst + i + 2));
+        __m128i b0 = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i b1 = _mm_loadu_si128((const __m128i *)(src + i + 2));
+        switch (op)
+        {
+        case BITSET_AND:
+            a0 = _mm_and_si128(a0, b0);
+            a1 = _mm_and_si128(a1, b1);
+            break;
+        case BITSET_OR:
+            a0 = _mm_or_si128(a0, b0);
+            a1 = _mm_or_si128(a1, b1);
+            break;
+        case BITSET_XOR:
+            a0 = _mm_xor_si128(a0, b0);
+            a1 = _mm_xor_si128(a1, b1);
+            break;
+        case BITSET_ANDNOT:
+            // _mm_andnot_si128 negates its first operand
+            a0 = _mm_andnot_si128(b0, a0);
+            a1 = _mm_andnot_si128(b1, a1);
+            break;
+        }
+        _mm_storeu_si128((__m128i *)(dst + i), a0);
+        _mm_storeu_si128((__m128i *)(dst + i + 2), a1);
+    }
+#endif
+    for (; i < count; i++)
+    {
+        switch (op)
+        {
+        case BITSET_AND:
+            dst[i] &= src[i];
+            break;
+        case BITSET_OR:
+            dst[i] |= src[i];
+            break;
+        case BITSET_XOR:
+            dst[i] ^= src[i];
+            break;
+        case BITSET_ANDNOT:
+            dst[i] &= ~src[i];
+            break;
+        }
+    }
+}
+
+void Bitset_combine(Bitset *dst, const Bitset *src, BitsetOp op)
+{
+    if ((op == BITSET_OR || op == BITSET_XOR) && src->len > dst->len)
+    {
+        Bitset_resize(dst, src->len, false);
+    }
+    size_t dst_words = Bitset_words_for_(dst->len);
+    size_t src_words = Bitset_words_for_(src->len);
+    size_t common = dst_words < src_words ? dst_words : src_words;
+    Bitset_apply_(Bitset_words_(dst), Bitset_words_(src), common, op);
+    if (op == BITSET_AND && dst_words > common)
+    {
+        memset(Bitset_words_(dst) + common, 0, (dst_words - common) * sizeof(uint64_t));
+    }
+    Bitset_trim_(dst);
+}
+
+BitsetRank BitsetRank_new(const Bitset *b)
+{
+    size_t words = Bitset_words_for_(b->len);
+    size_t block_count = words / BITSET_RANK_BLOCK_WORDS + 1;
+    BitsetRank r = {.bits = b, .blocks = Vec_with_capacity(block_count, sizeof(uint64_t)), .ones = 0};
+    uint64_t *blocks = r.blocks.buf.ptr;
+    const uint64_t *w = Bitset_words_(b);
+    uint64_t total = 0;
+    for (size_t i = 0; i < block_count; i++)
+    {
+        blocks[i] = total;
+        size_t start = i * BITSET_RANK_BLOCK_WORDS;
+        size_t end = start + BITSET_RANK_BLOCK_WORDS < words ? start + BITSET_RANK_BLOCK_WORDS : words;
+        if (start < end)
+        {
+            total += Bitset_popcount_words(w + start, end - start);
+        }
+    }
+    r.blocks.len = block_count;
+    r.ones = total;
+    return r;
+}
+
+size_t BitsetRank_rank(const BitsetRank *r, size_t index)
+{
+    assert(index <= r->bits->len);
+    const uint64_t *w = Bitset_words_(r->bits);
+    size_t word = index / BITSET_WORD_BITS;
+    size_t block = word / BITSET_RANK_BLOCK_WORDS;
+    size_t rank = ((const uint64_t *)r->blocks.buf.ptr)[block];
+    for (size_t i = block * BITSET_RANK_BLOCK_WORDS; i < word; i++)
+    {
+        rank += (size_t)__builtin_popcountll(w[i]);
+    }
+    if (index % BITSET_WORD_BITS != 0)
+    {
+        rank += (size_t)__builtin_popcountll(w[word] & ((1ull << (index % BITSET_WORD_BITS)) - 1));
+    }
+    return rank;
+}
+
+size_t BitsetRank_select(const BitsetRank *r, size_t k)
+{
+    if (k >= r->ones)
+    {
+        return BITSET_NONE;
+    }
+    const uint64_t *blocks = r->blocks.buf.ptr;
+    // Last block with fewer than k + 1 ones before it
+    size_t lo = 0, hi = r->blocks.len - 1;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        if (blocks[mid] <= k)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    k -= blocks[lo];
+    const uint64_t *w = Bitset_words_(r->bits);
+    for (size_t i = lo * BITSET_RANK_BLOCK_WORDS;; i++)
+    {
+        size_t ones = (size_t)__builtin_popcountll(w[i]);
+        if (k < ones)
+        {
+            return i * BITSET_WORD_BITS + Bitset_select_word_(w[i], (unsigned)k);
+        }
+        k -= ones;
+    }
+}
+
+void BitsetRank_drop(BitsetRank *r)
+{
+    Vec_drop(&r->blocks);
+}
+
+size_t Roaring_find_(const Roaring *r, uint16_t key, bool *found)
+{
+    const RoaringContainer *c = Roaring_containers_(r);
+    size_t lo = 0, hi = r->containers.len;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (c[mid].key < key)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    *found = lo < r->containers.len && c[lo].key == key;
+    return lo;
+}
+
+// Index of the first array value >= low
+size_t RoaringContainer_lower_bound_(const RoaringContainer *c, uint16_t low)
+{
+    const uint16_t *values = c->data.buf.ptr;
+    size_t lo = 0, hi = c->data.len;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (values[mid] < low)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool RoaringContainer_contains_(const RoaringContainer *c, uint16_t low)
+{
+    if (c->is_bitmap)
+    {
+        return (((const uint64_t *)c->data.buf.ptr)[low / BITSET_WORD_BITS] >> (low % BITSET_WORD_BITS)) & 1;
+    }
+    size_t i = RoaringContainer_lower_bound_(c, low);
+    return i < c->data.len && ((const uint16_t *)c->data.buf.ptr)[i] == low;
+}
+
+// Switch a full array container to a bitmap
+void RoaringContainer_to_bitmap_(RoaringContainer *c)
+{
+    Vec bitmap = Vec_with_capacity(ROARING_BITMAP_WORDS, sizeof(uint64_t));
+    uint64_t *words = bitmap.buf.ptr;
+    memset(words, 0, ROARING_BITMAP_WORDS * sizeof(uint64_t));
+    const uint16_t *values = c->data.buf.ptr;
+    for (size_t i = 0; i < c->data.len; i++)
+    {
+        words[values[i] / BITSET_WORD_BITS] |= 1ull << (values[i] % BITSET_WORD_BITS);
+    }
+    bitmap.len = ROARING_BITMAP_WORDS;
+    Vec_drop(&c->data);
+    c->data = bitmap;
+    c->is_bitmap = true;
+}
+
+// Switch a bitmap container that has become sparse back to an array
+void RoaringContainer_to_array_(RoaringContainer *c)
+{
+    Vec array = Vec_with_capacity(c->count, sizeof(uint16_t));
+    uint16_t *values = array.buf.ptr;
+    const uint64_t *words = c->data.buf.ptr;
+    size_t n = 0;
+    for (size_t w = 0; w < ROARING_BITMAP_WORDS; w++)
+    {
+        for (uint64_t word = words[w]; word != 0; word &= word - 1)
+        {
+            values[n++] = (uint16_t)(w * BITSET_WORD_BITS + (size_t)__builtin_ctzll(word));
+        }
+    }
+    array.len = n;
+    Vec_drop(&c->data);
+    c->data = array;
+    c->is_bitmap = false;
+}
+
+bool Roaring_add(Roaring *r, uint32_t value)
+{
+    uint16_t key = (uint16_t)(value >> 16), low = (uint16_t)value;
+    bool found;
+    size_t at = Roaring_find_(r, key, &found);
+    if (!found)
+    {
+        RoaringContainer fresh = {.key = key, .is_bitmap = false, .count = 0, .data = Vec_new()};
+        Vec_push(&r->containers, &fresh, sizeof(fresh));
+        RoaringContainer *c = Roaring_containers_(r);
+        memmove(c + at + 1, c + at, (r->containers.len - 1 - at) * sizeof(RoaringContainer));
+        c[at] = fresh;
+    }
+    RoaringContainer *c = &Roaring_containers_(r)[at];
+    if (c->is_bitmap)
+    {
+        uint64_t *word = &((uint64_t *)c->data.buf.ptr)[low / BITSET_WORD_BITS];
+        uint64_t bit = 1ull << (low % BITSET_WORD_BITS);
+        if (*word & bit)
+        {
+            return false;
+        }
+        *word |= bit;
+        c->count++;
+        return true;
+    }
+    size_t i = RoaringContainer_lower_bound_(c, low);
+    if (i < c->data.len && ((uint16_t *)c->data.buf.ptr)[i] == low)
+    {
+        return false;
+    }
+    if (c->data.len == ROARING_ARRAY_MAX)
+    {
+        RoaringContainer_to_bitmap_(c);
+        ((uint64_t *)c->data.buf.ptr)[low / BITSET_WORD_BITS] |= 1ull << (low % BITSET_WORD_BITS);
+        c->count++;
+        return true;
+    }
+    Vec_push(&c->data, &low, sizeof(low));
+    uint16_t *values = c->data.buf.ptr;
+    memmove(values + i + 1, values + i, (c->data.len - 1 - i) * sizeof(uint16_t));
+    values[i] = low;
+    c->count++;
+    return true;
+}
+
+bool Roaring_remove(Roaring *r, uint32_t value)
+{
+    uint16_t key = (uint16_t)(value >> 16), low = (uint16_t)value;
+    bool found;
+    size_t at = Roaring_find_(r, key, &found);
+    if (!found)
+    {
+        return false;
+    }
+    RoaringContainer *c = &Roaring_containers_(r)[at];
+    if (c->is_bitmap)
+    {
+        uint64_t *word = &((uint64_t *)c->data.buf.ptr)[low / BITSET_WORD_BITS];
+        uint64_t bit = 1ull << (low % BITSET_WORD_BITS);
+        if (!(*word & bit))
+        {
+            return false;
+        }
+        *word &= ~bit;
+        if (--c->count <= ROARING_ARRAY_MAX / 2)
+        {
+            // Convert back with some hysteresis so add/remove at the boundary doesn't thrash
+            RoaringContainer_to_array_(c);
+        }
+    }
+    else
+    {
+        size_t i = RoaringContainer_lower_bound_(c, low);
+        uint16_t *values = c->data.buf.ptr;
+        if (i == c->data.len || values[i] != low)
+        {
+            return false;
+        }
+        memmove(values + i, values + i + 1, (c->data.len - i - 1) * sizeof(uint16_t));
+        c->data.len--;
+        c->count--;
+    }
+    if (c->count == 0)
+    {
+        Vec_drop(&c->data);
+        RoaringContainer *all = Roaring_containers_(r);
+        memmove(all + at, all + at + 1, (r->containers.len - at - 1) * sizeof(RoaringContainer));
+        r->containers.len--;
+    }
+    return true;
+}
+
+size_t Roaring_count(const Roaring *r)
+{
+    size_t total = 0;
+    for (size_t i = 0; i < r->containers.len; i++)
+    {
+        total += Roaring_containers_(r)[i].count;
+    }
+    return total;
+}
+
+bool Roaring_next(const Roaring *r, uint64_t from, uint32_t *out)
+{
+    if (from > UINT32_MAX)
+    {
+        return false;
+    }
+    bool found;
+    size_t at = Roaring_find_(r, (uint16_t)(from >> 16), &found);
+    for (; at < r->containers.len; at++)
+    {
+        const RoaringContainer *c = &Roaring_containers_(r)[at];
+        // Inside the container `from` falls in, start from its low bits; later ones from 0
+        uint32_t low = (uint32_t)c->key == (from >> 16) ? (uint32_t)(from & 0xffff) : 0;
+        if (c->is_bitmap)
+        {
+            const uint64_t *words = c->data.buf.ptr;
+            size_t w = low / BITSET_WORD_BITS;
+            uint64_t word = words[w] & (~0ull << (low % BITSET_WORD_BITS));
+            for (;;)
+            {
+                if (word != 0)
+                {
+                    *out = ((uint32_t)c->key << 16) | (uint32_t)(w * BITSET_WORD_BITS + (size_t)__builtin_ctzll(word));
+                    return true;
+                }
+                if (++w == ROARING_BITMAP_WORDS)
+                {
+                    break;
+                }
+                word = words[w];
+            }
+        }
+        else
+        {
+            size_t i = RoaringContainer_lower_bound_(c, (uint16_t)low);
+            if (i < c->data.len)
+            {
+                *out = ((uint32_t)c->key << 16) | ((const uint16_t *)c->data.buf.ptr)[i];
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+RoaringContainer RoaringContainer_clone_(const RoaringContainer *c)
+{
+    size_t elem_size = c->is_bitmap ? sizeof(uint64_t) : sizeof(uint16_t);
+    RoaringContainer copy = *c;
+    copy.data = Vec_with_capacity(c->data.len, elem_size);
+    memcpy(copy.data.buf.ptr, c->data.buf.ptr, c->data.len * elem_size);
+    copy.data.len = c->data.len;
+    return copy;
+}
+
+// Merge `src`'s values into `dst`, both from the same key
+void RoaringContainer_or_(RoaringContainer *dst, const RoaringContainer *src)
+{
+    if (src->is_bitmap || dst->is_bitmap)
+    {
+        if (!dst->is_bitmap)
+        {
+            RoaringContainer_to_bitmap_(dst);
+        }
+        uint64_t *words = dst->data.buf.ptr;
+        if (src->is_bitmap)
+        {
+            Bitset_apply_(words, src->data.buf.ptr, ROARING_BITMAP_WORDS, BITSET_OR);
+        }
+        else
+        {
+            const uint16_t *values = src->data.buf.ptr;
+            for (size_t i = 0; i < src->data.len; i++)
+            {
+                words[values[i] / BITSET_WORD_BITS] |= 1ull << (values[i] % BITSET_WORD_BITS);
+            }
+        }
+        dst->count = (uint32_t)Bitset_popcount_words(words, ROARING_BITMAP_WORDS);
+        return;
+    }
+    // Two sorted arrays: merge, then switch to a bitmap if the result is too big
+    const uint16_t *a = dst->data.buf.ptr, *b = src->data.buf.ptr;
+    size_t na = dst->data.len, nb = src->data.len, i = 0, j = 0, n = 0;
+    Vec merged = Vec_with_capacity(na + nb, sizeof(uint16_t));
+    uint16_t *out = merged.buf.ptr;
+    while (i < na || j < nb)
+    {
+        if (j == nb || (i < na && a[i] < b[j]))
+        {
+            out[n++] = a[i++];
+        }
+        else
+        {
+            if (i < na && a[i] == b[j])
+            {
+                i++;
+            }
+            out[n++] = b[j++];
+        }
+    }
+    merged.len = n;
+    Vec_drop(&dst->data);
+    dst->data = merged;
+    dst->count = (uint32_t)n;
+    if (n > ROARING_ARRAY_MAX)
+    {
+        RoaringContainer_to_bitmap_(dst);
+    }
+}
+
+void Roaring_or(Roaring *dst, const Roaring *src)
+{
+    for (size_t i = 0; i < src->containers.len; i++)
+    {
+        const RoaringContainer *c = &Roaring_containers_(src)[i];
+        bool found;
+        size_t at = Roaring_find_(dst, c->key, &found);
+        if (found)
+        {
+            RoaringContainer_or_(&Roaring_containers_(dst)[at], c);
+            continue;
+        }
+        RoaringContainer copy = RoaringContainer_clone_(c);
+        Vec_push(&dst->containers, &copy, sizeof(copy));
+        RoaringContainer *all = Roaring_containers_(dst);
+        memmove(all + at + 1, all + at, (dst->containers.len - 1 - at) * sizeof(RoaringContainer));
+        all[at] = copy;
+    }
+}
+
+void Roaring_and(Roaring *dst, const Roaring *src)
+{
+    size_t kept = 0;
+    RoaringContainer *all = Roaring_containers_(dst);
+    for (size_t i = 0; i < dst->containers.len; i++)
+    {
+        RoaringContainer c = all[i];
+        bool found;
+        size_t at = Roaring_find_(src, c.key, &found);
+        if (found)
+        {
+            const RoaringContainer *s = &Roaring_containers_(src)[at];
+            if (c.is_bitmap && s->is_bitmap)
+            {
+                Bitset_apply_(c.data.buf.ptr, s->data.buf.ptr, ROARING_BITMAP_WORDS, BITSET_AND);
+                c.count = (uint32_t)Bitset_popcount_words(c.data.buf.ptr, ROARING_BITMAP_WORDS);
+                if (c.count <= ROARING_ARRAY_MAX)
+                {
+                    RoaringContainer_to_array_(&c);
+                }
+            }
+            else if (!c.is_bitmap)
+            {
+                // Filter the array in place
+                uint16_t *values = c.data.buf.ptr;
+                size_t n = 0;
+                for (size_t k = 0; k < c.data.len; k++)
+                {
+                    if (RoaringContainer_contains_(s, values[k]))
+                    {
+                        values[n++] = values[k];
+                    }
+                }
+                c.data.len = n;
+                c.count = (uint32_t)n;
+            }
+            else
+            {
+                // Bitmap & array: the result is at most the array's size
+                Vec array = Vec_with_capacity(s->data.len, sizeof(uint16_t));
+                const uint16_t *values = s->data.buf.ptr;
+                for (size_t k = 0; k < s->data.len; k++)
+                {
+                    if (RoaringContainer_contains_(&c, values[k]))
+                    {
+                        Vec_push(&array, &values[k], sizeof(uint16_t));
+                    }
+                }
+                Vec_drop(&c.data);
+                c = (RoaringContainer){.key = c.key, .is_bitmap = false, .count = (uint32_t)array.len, .data = array};
+            }
+        }
+        else
+        {
+            c.count = 0;
+        }
+        if (c.count > 0)
+        {
+            all[kept++] = c;
+        }
+        else
+        {
+            Vec_drop(&c.data);
+        }
+    }
+    dst->containers.len = kept;
+}
+
+size_t Roaring_size_in_bytes(const Roaring *r)
+{
+    size_t total = r->containers.len * sizeof(RoaringContainer);
+    for (size_t i = 0; i < r->containers.len; i++)
+    {
+        const RoaringContainer *c = &Roaring_containers_(r)[i];
+        total += c->is_bitmap ? ROARING_BITMAP_WORDS * sizeof(uint64_t) : c->data.len * sizeof(uint16_t);
+    }
+    return total;
+}
+
+void Roaring_drop(Roaring *r)
+{
+    for (size_t i = 0; i < r->containers.len; i++)
+    {
+        Vec_drop(&Roaring_containers_(r)[i].data);
+    }
+    Vec_drop(&r->containers);
+}
+
+#endif // BITSET_IMPLEMENTATION
@@ -0,0 +1,408 @@
+#ifndef _BUFIO_H_INCLUDED_
+#define _BUFIO_H_INCLUDED_
+
+/**
+ * The delimiter scan and the read and write loops are emitted by the
+ * unit that defines BUFIO_IMPLEMENTATION. One unit also defines ALLOC_,
+ * RAWVEC_, VEC_ and STRING_IMPLEMENTATION.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include "vec.h"
+#include "string.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define BUFIO_DEFAULT_CAPACITY (1 << 20)
+// The SIMD search compares against each delimiter, so the set is kept small
+#define BUFIO_MAX_DELIMITERS 4
+
+/**
+ * Reads a file descriptor in large blocks into one reusable buffer and
+ * splits it into records ending in any of a small set of delimiters.
+ * Records are handed out as views into the buffer, so no per-line
+ * allocation happens; a record that straddles two blocks is moved to the
+ * front of the buffer before the next block is read behind it.
+ */
+typedef struct
+{
+    int fd;
+    Vec buf;
+    size_t start;
+    size_t end;
+    off_t offset;
+    bool use_pread;
+    bool eof;
+    int error;
+    size_t delimiter_count;
+    char delimiters[BUFIO_MAX_DELIMITERS];
+} BufReader;
+
+BufReader BufReader_init_(int fd, size_t capacity, off_t offset, bool use_pread);
+
+// Create a reader over `fd` with a `capacity`-byte buffer (0 for the default 1 MiB)
+static inline BufReader BufReader_new(int fd, size_t capacity)
+{
+    return BufReader_init_(fd, capacity, 0, false);
+}
+
+/**
+ * Create a reader that uses pread starting at `offset`, leaving the file
+ * position untouched. Several readers can share one descriptor this way,
+ * e.g. one per thread over disjoint ranges.
+ */
+static inline BufReader BufReader_at(int fd, size_t capacity, off_t offset)
+{
+    return BufReader_init_(fd, capacity, offset, true);
+}
+
+// Split on any of the characters in `delimiters` (1 to BUFIO_MAX_DELIMITERS of them)
+void BufReader_set_delimiters(BufReader *r, const char *delimiters);
+
+/**
+ * Get the next record, without its delimiter. The view points into the
+ * reader's buffer and is valid until the next call. A final record with
+ * no trailing delimiter is returned too. Returns false at end of input or
+ * on a read error, in which case `error` holds the errno value.
+ */
+bool BufReader_next(BufReader *r, StringView *line);
+
+/**
+ * Read up to `len` raw bytes, serving buffered bytes first. Returns the
+ * number of bytes copied, 0 at end of input, or -1 on error.
+ */
+ssize_t BufReader_read(BufReader *r, void *dst, size_t len);
+
+// Free the reader's buffer; the descriptor is left open
+void BufReader_drop(BufReader *r);
+
+/**
+ * Batches small writes into one buffer and issues large write/writev
+ * calls. A write bigger than the free space goes out together with the
+ * buffered bytes in a single writev instead of being copied.
+ */
+typedef struct
+{
+    int fd;
+    Vec buf;
+    int error;
+} BufWriter;
+
+// Create a writer over `fd` with a `capacity`-byte buffer (0 for the default 1 MiB)
+BufWriter BufWriter_new(int fd, size_t capacity);
+
+// Write out the buffered bytes
+bool BufWriter_flush(BufWriter *w);
+
+// Append bytes; returns false once a write has failed (see `error`)
+bool BufWriter_write(BufWriter *w, const void *data, size_t len);
+
+// Append the contents of a StringView
+static inline bool BufWriter_write_view(BufWriter *w, StringView view)
+{
+    return BufWriter_write(w, view.ptr, view.len);
+}
+
+// Append the contents of a String
+static inline bool BufWriter_write_string(BufWriter *w, const String *s)
+{
+    return BufWriter_write_view(w, String_as_view(s));
+}
+
+// Append a StringView followed by a newline
+bool BufWriter_write_line(BufWriter *w, StringView view);
+
+// Flush and free the writer's buffer; the descriptor is left open
+bool BufWriter_drop(BufWriter *w);
+
+#endif // _BUFIO_H_INCLUDED_
+
+#if defined(BUFIO_IMPLEMENTATION) && !defined(_BUFIO_IMPLEMENTATION_INCLUDED_)
+#define _BUFIO_IMPLEMENTATION_INCLUDED_
+
+BufReader BufReader_init_(int fd, size_t capacity, off_t offset, bool use_pread)
+{
+    capacity = capacity == 0 ? BUFIO_DEFAULT_CAPACITY : capacity;
+    BufReader r = {
+        .fd = fd,
+        .buf = Vec_with_capacity(capacity, sizeof(char)),
+        .start = 0,
+        .end = 0,
+        .offset = offset,
+        .use_pread = use_pread,
+        .eof = false,
+        .error = 0,
+        .delimiter_count = 1,
+        .delimiters = {'\n'}};
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, offset, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    return r;
+}
+
+void BufReader_set_delimiters(BufReader *r, const char *delimiters)
+{
+    size_t count = strlen(delimiters);
+    assert(count > 0 && count <= BUFIO_MAX_DELIMITERS);
+    memcpy(r->delimiters, delimiters, count);
+    r->delimiter_count = count;
+}
+
+// Find the first byte in [p, p + len) that is one of the delimiters
+const char *BufReader_find_(const BufReader *r, const char *p, size_t len)
+{
+    if (r->delimiter_count == 1)
+    {
+        return memchr(p, r->delimiters[0], len);
+    }
+    size_t i = 0;
+#ifdef __SSE2__
+    __m128i d[BUFIO_MAX_DELIMITERS];
+    for (size_t k = 0; k < BUFIO_MAX_DELIMITERS; k++)
+    {
+        // Unused slots repeat the first delimiter
+        d[k] = _mm_set1_epi8(r->delimiters[k < r->delimiter_count ? k : 0]);
+    }
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, d[0]), _mm_cmpeq_epi8(block, d[1])),
+            _mm_or_si128(_mm_cmpeq_epi8(block, d[2]), _mm_cmpeq_epi8(block, d[3])));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask != 0)
+        {
+            return p + i + __builtin_ctz((unsigned)mask);
+        }
+    }
+#endif
+    for (; i < len; i++)
+    {
+        for (size_t k = 0; k < r->delimiter_count; k++)
+        {
+            if (p[i] == r->delimiters[k])
+            {
+                return p + i;
+            }
+        }
+    }
+    return NULL;
+}
+
+// Move the unconsumed tail to the front, grow if it fills the buffer, and read a block behind it
+bool BufReader_fill_(BufReader *r)
+{
+    char *base = r->buf.buf.ptr;
+    size_t pending = r->end - r->start;
+    if (r->start > 0)
+    {
+        memmove(base, base + r->start, pending);
+        r->start = 0;
+        r->end = pending;
+    }
+    if (r->end == Vec_capacity(&r->buf))
+    {
+        // A single record longer than the buffer
+        Vec_reserve(&r->buf, Vec_capacity(&r->buf), sizeof(char));
+        base = r->buf.buf.ptr;
+    }
+    size_t room = Vec_capacity(&r->buf) - r->end;
+    ssize_t n;
+    do
+    {
+        n = r->use_pread ? pread(r->fd, base + r->end, room, r->offset) : read(r->fd, base + r->end, room);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0)
+    {
+        r->error = errno;
+        return false;
+    }
+    if (n == 0)
+    {
+        r->eof = true;
+        return false;
+    }
+    r->end += (size_t)n;
+    r->offset += n;
+    r->buf.len = r->end;
+    return true;
+}
+
+bool BufReader_next(BufReader *r, StringView *line)
+{
+    size_t scanned = r->start;
+    for (;;)
+    {
+        const char *base = r->buf.buf.ptr;
+        const char *hit = BufReader_find_(r, base + scanned, r->end - scanned);
+        if (hit != NULL)
+        {
+            *line = (StringView){.ptr = base + r->start, .len = (size_t)(hit - base) - r->start};
+            r->start = (size_t)(hit - base) + 1;
+            return true;
+        }
+        if (r->eof || r->error != 0)
+        {
+            break;
+        }
+        // Don't rescan the bytes already searched once they move to the front
+        size_t searched = r->end - r->start;
+        if (!BufReader_fill_(r))
+        {
+            break;
+        }
+        scanned = searched;
+    }
+    if (r->error == 0 && r->end > r->start)
+    {
+        *line = (StringView){.ptr = (const char *)r->buf.buf.ptr + r->start, .len = r->end - r->start};
+        r->start = r->end;
+        return true;
+    }
+    return false;
+}
+
+ssize_t BufReader_read(BufReader *r, void *dst, size_t len)
+{
+    if (r->start == r->end && !r->eof && r->error == 0)
+    {
+        BufReader_fill_(r);
+    }
+    if (r->error != 0)
+    {
+        return -1;
+    }
+    size_t n = r->end - r->start < len ? r->end - r->start : len;
+    memcpy(dst, (const char *)r->buf.buf.ptr + r->start, n);
+    r->start += n;
+    return (ssize_t)n;
+}
+
+void BufReader_drop(BufReader *r)
+{
+    Vec_drop(&r->buf);
+    r->start = r->end = 0;
+}
+
+BufWriter BufWriter_new(int fd, size_t capacity)
+{
+    capacity = capacity == 0 ? BUFIO_DEFAULT_CAPACITY : capacity;
+    return (BufWriter){
+        .fd = fd,
+        .buf = Vec_with_capacity(capacity, sizeof(char)),
+        .error = 0};
+}
+
+// Write every byte described by `iov`, retrying short writes
+bool BufWriter_writev_(BufWriter *w, struct iovec *iov, int count)
+{
+    while (count > 0)
+    {
+        ssize_t n = writev(w->fd, iov, count);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            w->error = errno;
+            return false;
+        }
+        size_t done = (size_t)n;
+        while (count > 0 && done >= iov->iov_len)
+        {
+            done -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+    return true;
+}
+
+bool BufWriter_flush(BufWriter *w)
+{
+    if (w->error != 0)
+    {
+        return false;
+    }
+    struct iovec iov = {w->buf.buf.ptr, w->buf.len};
+    bool ok = w->buf.len == 0 || BufWriter_writev_(w, &iov, 1);
+    w->buf.len = 0;
+    return ok;
+}
+
+bool BufWriter_write(BufWriter *w, const void *data, size_t len)
+{
+    if (w->error != 0)
+    {
+        return false;
+    }
+    size_t room = Vec_capacity(&w->buf) - w->buf.len;
+    if (len <= room)
+    {
+        memcpy((char *)w->buf.buf.ptr + w->buf.len, data, len);
+        w->buf.len += len;
+        return true;
+    }
+    if (len < Vec_capacity(&w->buf))
+    {
+        // Fill the buffer, write it, and keep the rest for later
+        memcpy((char *)w->buf.buf.ptr + w->buf.len, data, room);
+        w->buf.len += room;
+        if (!BufWriter_flush(w))
+        {
+            return false;
+        }
+        memcpy(w->buf.buf.ptr, (const char *)data + room, len - room);
+        w->buf.len = len - room;
+        return true;
+    }
+    struct iovec iov[2] = {{w->buf.buf.ptr, w->buf.len}, {(void *)data, len}};
+    bool ok = BufWriter_writev_(w, w->buf.len > 0 ? iov : iov + 1, w->buf.len > 0 ? 2 : 1);
+    w->buf.len = 0;
+    return ok;
+}
+
+bool BufWriter_write_line(BufWriter *w, StringView view)
+{
+    if (view.len + 1 <= Vec_capacity(&w->buf) - w->buf.len)
+    {
+        char *dst = (char *)w->buf.buf.ptr + w->buf.len;
+        memcpy(dst, view.ptr, view.len);
+        dst[view.len] = '\n';
+        w->buf.len += view.len + 1;
+        return w->error == 0;
+    }
+    return BufWriter_write(w, view.ptr, view.len) && BufWriter_write(w, "\n", 1);
+}
+
+bool BufWriter_drop(BufWriter *w)
+{
+    bool ok = BufWriter_flush(w);
+    Vec_drop(&w->buf);
+    return ok;
+}
+
+#endif // BUFIO_IMPLEMENTATION
@@ -0,0 +1,449 @@
+#ifndef _CONCURRENT_MAP_H_INCLUDED_
+#define _CONCURRENT_MAP_H_INCLUDED_
+
+/**
+ * Probing helpers and ConcurrentMap_get are static inline; the rest is
+ * emitted where CONCURRENT_MAP_IMPLEMENTATION is defined, with
+ * ALLOC_IMPLEMENTATION in the same or another unit.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "alloc.h"
+
+#define CONCURRENT_MAP_CACHE_LINE 64
+#define CONCURRENT_MAP_DEFAULT_SHARDS 64
+#define CONCURRENT_MAP_INITIAL_SLOTS 16
+#define CONCURRENT_MAP_BATCH 16
+
+/**
+ * One open-addressing table (linear probing). Each slot is
+ * [hash word | key | value], padded to a multiple of 8 bytes; a hash word of
+ * 0 marks an empty slot.
+ */
+typedef struct MapTable
+{
+    size_t cap;
+    struct MapTable *retired;
+    uint64_t slots[];
+} MapTable;
+
+/**
+ * A shard is guarded by a seqlock. Writers serialize on `lock` and make
+ * `seq` odd while they modify the table; readers never write shared memory,
+ * they retry if `seq` was odd or changed during the lookup. Tables replaced by
+ * a resize are kept on the `retired` chain until the map is dropped, since an
+ * optimistic reader may still be probing them.
+ */
+typedef union
+{
+    struct
+    {
+        atomic_size_t seq;
+        _Atomic(MapTable *) table;
+        size_t len;
+        pthread_mutex_t lock;
+    };
+    char pad[2 * CONCURRENT_MAP_CACHE_LINE];
+} MapShard;
+
+static inline void ConcurrentMap_cpu_relax_(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+typedef struct
+{
+    MapShard *shards;
+    size_t shard_mask;
+    size_t key_size;
+    size_t value_size;
+    size_t stride;
+    Allocator alloc;
+} ConcurrentMap;
+
+// Hash `len` bytes 8 at a time with a multiply-xorshift mix
+uint64_t ConcurrentMap_hash_bytes(const void *data, size_t len);
+
+static inline _Atomic uint64_t *MapTable_slot_(const ConcurrentMap *map, const MapTable *table, size_t index)
+{
+    return (_Atomic uint64_t *)((char *)table->slots + index * map->stride);
+}
+
+static inline void *MapTable_key_(const ConcurrentMap *map, const MapTable *table, size_t index)
+{
+    return (char *)table->slots + index * map->stride + sizeof(uint64_t);
+}
+
+static inline void *MapTable_value_(const ConcurrentMap *map, const MapTable *table, size_t index)
+{
+    return (char *)table->slots + index * map->stride + sizeof(uint64_t) + map->key_size;
+}
+
+MapTable *MapTable_new(const ConcurrentMap *map, size_t cap);
+
+static inline MapShard *ConcurrentMap_shard_(const ConcurrentMap *map, uint64_t hash)
+{
+    // High bits pick the shard, low bits pick the slot
+    return &map->shards[(hash >> 48) & map->shard_mask];
+}
+
+/**
+ * Create a map with `num_shards` shards (rounded up to a power of two, 0 for
+ * the default) storing keys of `key_size` bytes and values of `value_size`
+ * bytes. Keys are compared bytewise.
+ */
+ConcurrentMap ConcurrentMap_new(size_t num_shards, size_t key_size, size_t value_size, Allocator alloc);
+
+// Probe `table` for `key`; returns the slot index or SIZE_MAX
+static inline size_t ConcurrentMap_find_(const ConcurrentMap *map, const MapTable *table, uint64_t hash, const void *key)
+{
+    size_t mask = table->cap - 1;
+    size_t index = hash & mask;
+    for (size_t probes = 0; probes < table->cap; probes++)
+    {
+        uint64_t slot_hash = atomic_load_explicit(MapTable_slot_(map, table, index), memory_order_relaxed);
+        if (slot_hash == 0)
+        {
+            return SIZE_MAX;
+        }
+        if (slot_hash == hash && memcmp(MapTable_key_(map, table, index), key, map->key_size) == 0)
+        {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+    return SIZE_MAX;
+}
+
+// Optimistic lookup in one shard with a precomputed hash
+bool ConcurrentMap_get_hashed_(const ConcurrentMap *map, uint64_t hash, const void *key, void *out_value);
+
+// Look up `key`, copying its value to `out_value` (which may be NULL)
+static inline bool ConcurrentMap_get(const ConcurrentMap *map, const void *key, void *out_value)
+{
+    return ConcurrentMap_get_hashed_(map, ConcurrentMap_hash_bytes(key, map->key_size), key, out_value);
+}
+
+// Check whether `key` is present
+static inline bool ConcurrentMap_contains(const ConcurrentMap *map, const void *key)
+{
+    return ConcurrentMap_get(map, key, NULL);
+}
+
+/**
+ * Look up `count` keys laid out back to back in `keys`. Values go to the
+ * matching positions of `out_values` and `found[i]` (if not NULL) tells
+ * whether key i was present. Keys are hashed and their home slots prefetched
+ * a batch at a time so the cache misses overlap. Returns the number found.
+ */
+size_t ConcurrentMap_get_many(const ConcurrentMap *map, const void *keys, size_t count, void *out_values, bool *found);
+
+// Make a locked shard's sequence odd before modifying its table
+static inline void MapShard_write_begin_(MapShard *shard)
+{
+    size_t seq = atomic_load_explicit(&shard->seq, memory_order_relaxed);
+    atomic_store_explicit(&shard->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+// Make the sequence even again, publishing the modification
+static inline void MapShard_write_end_(MapShard *shard)
+{
+    size_t seq = atomic_load_explicit(&shard->seq, memory_order_relaxed);
+    atomic_store_explicit(&shard->seq, seq + 1, memory_order_release);
+}
+
+/**
+ * Insert or overwrite `key`. Returns true if the key was new, false if an
+ * existing value was replaced.
+ */
+bool ConcurrentMap_insert(ConcurrentMap *map, const void *key, const void *value);
+
+/**
+ * Remove `key`, copying its value to `out_value` if not NULL. Uses
+ * backward-shift deletion so lookups never need tombstones.
+ */
+bool ConcurrentMap_remove(ConcurrentMap *map, const void *key, void *out_value);
+
+// Get the number of entries (a snapshot when called concurrently)
+size_t ConcurrentMap_len(const ConcurrentMap *map);
+
+// Free the map, its tables and every retired table
+void ConcurrentMap_drop(ConcurrentMap *map);
+
+#endif // _CONCURRENT_MAP_H_INCLUDED_
+
+#if defined(CONCURRENT_MAP_IMPLEMENTATION) && !defined(_CONCURRENT_MAP_IMPLEMENTATION_INCLUDED_)
+#define _CONCURRENT_MAP_IMPLEMENTATION_INCLUDED_
+
+uint64_t ConcurrentMap_hash_bytes(const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ (len * 0xC2B2AE3D27D4EB4Full);
+    while (len >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        h = (h ^ word) * 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 31;
+        p += 8;
+        len -= 8;
+    }
+    if (len > 0)
+    {
+        uint64_t word = 0;
+        memcpy(&word, p, len);
+        h = (h ^ word) * 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 31;
+    }
+    h *= 0x94D049BB133111EBull;
+    h ^= h >> 29;
+    // Never 0, which marks an empty slot; the low bits stay intact for the slot index
+    return h == 0 ? 1 : h;
+}
+
+MapTable *MapTable_new(const ConcurrentMap *map, size_t cap)
+{
+    size_t size = sizeof(MapTable) + cap * map->stride;
+    MapTable *table = map->alloc.allocate(size);
+    assert(table != NULL);
+    memset(table, 0, size);
+    table->cap = cap;
+    table->retired = NULL;
+    return table;
+}
+
+ConcurrentMap ConcurrentMap_new(size_t num_shards, size_t key_size, size_t value_size, Allocator alloc)
+{
+    size_t shards = 1;
+    num_shards = num_shards == 0 ? CONCURRENT_MAP_DEFAULT_SHARDS : num_shards;
+    while (shards < num_shards)
+    {
+        shards *= 2;
+    }
+    size_t stride = (sizeof(uint64_t) + key_size + value_size + 7) / 8 * 8;
+    ConcurrentMap map = {
+        .shards = alloc.allocate(shards * sizeof(MapShard)),
+        .shard_mask = shards - 1,
+        .key_size = key_size,
+        .value_size = value_size,
+        .stride = stride,
+        .alloc = alloc};
+    assert(map.shards != NULL);
+    for (size_t i = 0; i < shards; i++)
+    {
+        MapShard *shard = &map.shards[i];
+        atomic_init(&shard->seq, 0);
+        atomic_init(&shard->table, MapTable_new(&map, CONCURRENT_MAP_INITIAL_SLOTS));
+        shard->len = 0;
+        pthread_mutex_init(&shard->lock, NULL);
+    }
+    return map;
+}
+
+bool ConcurrentMap_get_hashed_(const ConcurrentMap *map, uint64_t hash, const void *key, void *out_value)
+{
+    MapShard *shard = ConcurrentMap_shard_(map, hash);
+    for (;;)
+    {
+        size_t seq = atomic_load_explicit(&shard->seq, memory_order_acquire);
+        if (seq & 1)
+        {
+            ConcurrentMap_cpu_relax_();
+            continue;
+        }
+        MapTable *table = atomic_load_explicit(&shard->table, memory_order_acquire);
+        size_t index = ConcurrentMap_find_(map, table, hash, key);
+        if (index != SIZE_MAX && out_value != NULL)
+        {
+            memcpy(out_value, MapTable_value_(map, table, index), map->value_size);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&shard->seq, memory_order_relaxed) == seq)
+        {
+            return index != SIZE_MAX;
+        }
+    }
+}
+
+size_t ConcurrentMap_get_many(const ConcurrentMap *map, const void *keys, size_t count, void *out_values, bool *found)
+{
+    uint64_t hashes[CONCURRENT_MAP_BATCH];
+    size_t hits = 0;
+    for (size_t base = 0; base < count; base += CONCURRENT_MAP_BATCH)
+    {
+        size_t n = count - base < CONCURRENT_MAP_BATCH ? count - base : CONCURRENT_MAP_BATCH;
+        for (size_t i = 0; i < n; i++)
+        {
+            const void *key = (const char *)keys + (base + i) * map->key_size;
+            hashes[i] = ConcurrentMap_hash_bytes(key, map->key_size);
+            MapTable *table = atomic_load_explicit(&ConcurrentMap_shard_(map, hashes[i])->table, memory_order_relaxed);
+            __builtin_prefetch(MapTable_slot_(map, table, hashes[i] & (table->cap - 1)));
+        }
+        for (size_t i = 0; i < n; i++)
+        {
+            const void *key = (const char *)keys + (base + i) * map->key_size;
+            void *out = (char *)out_values + (base + i) * map->value_size;
+            bool hit = ConcurrentMap_get_hashed_(map, hashes[i], key, out);
+            if (found != NULL)
+            {
+                found[base + i] = hit;
+            }
+            hits += hit;
+        }
+    }
+    return hits;
+}
+
+// Place an entry in a table known not to contain its key (used by resize)
+void MapTable_place_(const ConcurrentMap *map, MapTable *table, uint64_t hash, const void *entry)
+{
+    size_t mask = table->cap - 1;
+    size_t index = hash & mask;
+    while (atomic_load_explicit(MapTable_slot_(map, table, index), memory_order_relaxed) != 0)
+    {
+        index = (index + 1) & mask;
+    }
+    memcpy((char *)MapTable_slot_(map, table, index) + sizeof(uint64_t), entry, map->key_size + map->value_size);
+    atomic_store_explicit(MapTable_slot_(map, table, index), hash, memory_order_relaxed);
+}
+
+/**
+ * Double one shard's table. Only this shard's lock is held; the new table is
+ * built off to the side while readers keep using the old one.
+ */
+void MapShard_grow_(const ConcurrentMap *map, MapShard *shard)
+{
+    MapTable *old = atomic_load_explicit(&shard->table, memory_order_relaxed);
+    MapTable *table = MapTable_new(map, old->cap * 2);
+    for (size_t i = 0; i < old->cap; i++)
+    {
+        uint64_t hash = atomic_load_explicit(MapTable_slot_(map, old, i), memory_order_relaxed);
+        if (hash != 0)
+        {
+            MapTable_place_(map, table, hash, MapTable_key_(map, old, i));
+        }
+    }
+    table->retired = old;
+    atomic_store_explicit(&shard->table, table, memory_order_release);
+}
+
+bool ConcurrentMap_insert(ConcurrentMap *map, const void *key, const void *value)
+{
+    uint64_t hash = ConcurrentMap_hash_bytes(key, map->key_size);
+    MapShard *shard = ConcurrentMap_shard_(map, hash);
+    pthread_mutex_lock(&shard->lock);
+    MapTable *table = atomic_load_explicit(&shard->table, memory_order_relaxed);
+    if ((shard->len + 1) * 4 > table->cap * 3)
+    {
+        // Readers keep using the old table while the new one is built
+        MapShard_grow_(map, shard);
+        table = atomic_load_explicit(&shard->table, memory_order_relaxed);
+    }
+    MapShard_write_begin_(shard);
+    size_t index = ConcurrentMap_find_(map, table, hash, key);
+    bool inserted = index == SIZE_MAX;
+    if (inserted)
+    {
+        size_t mask = table->cap - 1;
+        index = hash & mask;
+        while (atomic_load_explicit(MapTable_slot_(map, table, index), memory_order_relaxed) != 0)
+        {
+            index = (index + 1) & mask;
+        }
+        memcpy(MapTable_key_(map, table, index), key, map->key_size);
+        atomic_store_explicit(MapTable_slot_(map, table, index), hash, memory_order_relaxed);
+        shard->len++;
+    }
+    memcpy(MapTable_value_(map, table, index), value, map->value_size);
+    MapShard_write_end_(shard);
+    pthread_mutex_unlock(&shard->lock);
+    return inserted;
+}
+
+bool ConcurrentMap_remove(ConcurrentMap *map, const void *key, void *out_value)
+{
+    uint64_t hash = ConcurrentMap_hash_bytes(key, map->key_size);
+    MapShard *shard = ConcurrentMap_shard_(map, hash);
+    pthread_mutex_lock(&shard->lock);
+    MapTable *table = atomic_load_explicit(&shard->table, memory_order_relaxed);
+    size_t index = ConcurrentMap_find_(map, table, hash, key);
+    if (index == SIZE_MAX)
+    {
+        pthread_mutex_unlock(&shard->lock);
+        return false;
+    }
+    MapShard_write_begin_(shard);
+    if (out_value != NULL)
+    {
+        memcpy(out_value, MapTable_value_(map, table, index), map->value_size);
+    }
+    size_t mask = table->cap - 1;
+    size_t hole = index;
+    size_t next = (hole + 1) & mask;
+    for (;;)
+    {
+        uint64_t next_hash = atomic_load_explicit(MapTable_slot_(map, table, next), memory_order_relaxed);
+        if (next_hash == 0)
+        {
+            break;
+        }
+        size_t home = next_hash & mask;
+        // Shift back unless the entry's home lies cyclically in (hole, next]
+        bool stays = hole <= next ? (home > hole && home <= next) : (home > hole || home <= next);
+        if (!stays)
+        {
+            memcpy((char *)MapTable_slot_(map, table, hole), MapTable_slot_(map, table, next), map->stride);
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    atomic_store_explicit(MapTable_slot_(map, table, hole), 0, memory_order_relaxed);
+    shard->len--;
+    MapShard_write_end_(shard);
+    pthread_mutex_unlock(&shard->lock);
+    return true;
+}
+
+size_t ConcurrentMap_len(const ConcurrentMap *map)
+{
+    size_t len = 0;
+    for (size_t i = 0; i <= map->shard_mask; i++)
+    {
+        pthread_mutex_lock(&map->shards[i].lock);
+        len += map->shards[i].len;
+        pthread_mutex_unlock(&map->shards[i].lock);
+    }
+    return len;
+}
+
+void ConcurrentMap_drop(ConcurrentMap *map)
+{
+    for (size_t i = 0; i <= map->shard_mask; i++)
+    {
+        MapShard *shard = &map->shards[i];
+        MapTable *table = atomic_load_explicit(&shard->table, memory_order_relaxed);
+        while (table != NULL)
+        {
+            MapTable *retired = table->retired;
+            map->alloc.deallocate(table);
+            table = retired;
+        }
+        pthread_mutex_destroy(&shard->lock);
+    }
+    map->alloc.deallocate(map->shards);
+    map->shards = NULL;
+}
+
+#endif // CONCURRENT_MAP_IMPLEMENTATION
@@ -0,0 +1,189 @@
+#ifndef _CONCURRENT_VEC_H_INCLUDED_
+#define _CONCURRENT_VEC_H_INCLUDED_
+
+/**
+ * ConcurrentVec_get and the accessors are static inline; the rest is
+ * emitted where CONCURRENT_VEC_IMPLEMENTATION is defined. One unit also
+ * defines ALLOC_, RAWVEC_, VEC_ and EBR_IMPLEMENTATION.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "ebr.h"
+
+typedef struct
+{
+    size_t cap;
+    max_align_t data[];
+} ConcurrentVecBuf;
+
+/**
+ * An append-only growable vector that readers access without locks. Writers
+ * serialize on `lock`. Growing allocates a new buffer, copies, publishes it
+ * and retires the old one through EBR instead of calling `reallocate`, so a
+ * reader that is still copying out of the old buffer is never left with a
+ * dangling pointer and never waits for the resize.
+ */
+typedef struct
+{
+    _Atomic(ConcurrentVecBuf *) buf;
+    atomic_size_t len;
+    size_t elem_size;
+    pthread_mutex_t lock;
+    Ebr *ebr;
+} ConcurrentVec;
+
+/**
+ * Initialize an empty ConcurrentVec in place; its buffers are reclaimed
+ * through `ebr`. The vector holds a mutex, so it must not be copied or
+ * moved once initialized.
+ */
+void ConcurrentVec_init(ConcurrentVec *vec, size_t elem_size, Ebr *ebr);
+
+// Get the length of the ConcurrentVec
+static inline size_t ConcurrentVec_len(const ConcurrentVec *vec)
+{
+    return atomic_load_explicit(&vec->len, memory_order_acquire);
+}
+
+// Get the capacity of the current buffer
+static inline size_t ConcurrentVec_capacity(const ConcurrentVec *vec)
+{
+    ConcurrentVecBuf *buf = atomic_load_explicit(&vec->buf, memory_order_acquire);
+    return buf == NULL ? 0 : buf->cap;
+}
+
+// Reserve room for `additional` more elements
+void ConcurrentVec_reserve(ConcurrentVec *vec, EbrThread *t, size_t additional);
+
+// Append an element; returns its index
+size_t ConcurrentVec_push(ConcurrentVec *vec, EbrThread *t, const void *value);
+
+/**
+ * Copy the element at `index` into `out`. Lock-free: the length is read
+ * before the buffer, so the buffer is always at least as new as the length.
+ */
+static inline bool ConcurrentVec_get(const ConcurrentVec *vec, EbrThread *t, size_t index, void *out)
+{
+    Ebr_pin(t);
+    size_t len = atomic_load_explicit(&vec->len, memory_order_acquire);
+    bool found = index < len;
+    if (found)
+    {
+        ConcurrentVecBuf *buf = atomic_load_explicit(&vec->buf, memory_order_acquire);
+        memcpy(out, (char *)buf->data + index * vec->elem_size, vec->elem_size);
+    }
+    Ebr_unpin(t);
+    return found;
+}
+
+/**
+ * Borrow the current contents. The returned pointer and `*len` stay valid
+ * until the caller unpins `t`, which must be pinned across the call.
+ */
+const void *ConcurrentVec_as_slice(const ConcurrentVec *vec, EbrThread *t, size_t *len);
+
+// Free the current buffer. No other thread may be using the vector.
+void ConcurrentVec_drop(ConcurrentVec *vec);
+
+#endif // _CONCURRENT_VEC_H_INCLUDED_
+
+#if defined(CONCURRENT_VEC_IMPLEMENTATION) && !defined(_CONCURRENT_VEC_IMPLEMENTATION_INCLUDED_)
+#define _CONCURRENT_VEC_IMPLEMENTATION_INCLUDED_
+
+ConcurrentVecBuf *ConcurrentVecBuf_new_(Allocator alloc, size_t cap, size_t elem_size)
+{
+    ConcurrentVecBuf *buf = alloc.allocate(sizeof(ConcurrentVecBuf) + cap * elem_size);
+    assert(buf != NULL);
+    buf->cap = cap;
+    return buf;
+}
+
+void ConcurrentVec_init(ConcurrentVec *vec, size_t elem_size, Ebr *ebr)
+{
+    atomic_init(&vec->buf, NULL);
+    atomic_init(&vec->len, 0);
+    vec->elem_size = elem_size;
+    vec->ebr = ebr;
+    pthread_mutex_init(&vec->lock, NULL);
+}
+
+// Replace the buffer with a larger one (writer lock held)
+void ConcurrentVec_grow_(ConcurrentVec *vec, EbrThread *t, size_t needed_cap)
+{
+    ConcurrentVecBuf *old = atomic_load_explicit(&vec->buf, memory_order_relaxed);
+    size_t old_cap = old == NULL ? 0 : old->cap;
+    size_t new_cap = old_cap == 0 ? 1 : old_cap * 2;
+    while (new_cap < needed_cap)
+    {
+        new_cap *= 2;
+    }
+    ConcurrentVecBuf *buf = ConcurrentVecBuf_new_(vec->ebr->alloc, new_cap, vec->elem_size);
+    size_t len = atomic_load_explicit(&vec->len, memory_order_relaxed);
+    if (old != NULL)
+    {
+        memcpy(buf->data, old->data, len * vec->elem_size);
+    }
+    atomic_store_explicit(&vec->buf, buf, memory_order_release);
+    if (old != NULL)
+    {
+        Ebr_pin(t);
+        Ebr_retire(t, old);
+        Ebr_unpin(t);
+    }
+}
+
+void ConcurrentVec_reserve(ConcurrentVec *vec, EbrThread *t, size_t additional)
+{
+    pthread_mutex_lock(&vec->lock);
+    size_t needed = atomic_load_explicit(&vec->len, memory_order_relaxed) + additional;
+    if (needed > ConcurrentVec_capacity(vec))
+    {
+        ConcurrentVec_grow_(vec, t, needed);
+    }
+    pthread_mutex_unlock(&vec->lock);
+}
+
+size_t ConcurrentVec_push(ConcurrentVec *vec, EbrThread *t, const void *value)
+{
+    pthread_mutex_lock(&vec->lock);
+    size_t len = atomic_load_explicit(&vec->len, memory_order_relaxed);
+    ConcurrentVecBuf *buf = atomic_load_explicit(&vec->buf, memory_order_relaxed);
+    if (buf == NULL || len == buf->cap)
+    {
+        ConcurrentVec_grow_(vec, t, len + 1);
+        buf = atomic_load_explicit(&vec->buf, memory_order_relaxed);
+    }
+    memcpy((char *)buf->data + len * vec->elem_size, value, vec->elem_size);
+    // Publishes both the element and the buffer it lives in
+    atomic_store_explicit(&vec->len, len + 1, memory_order_release);
+    pthread_mutex_unlock(&vec->lock);
+    return len;
+}
+
+const void *ConcurrentVec_as_slice(const ConcurrentVec *vec, EbrThread *t, size_t *len)
+{
+    assert(Ebr_is_pinned(t));
+    *len = atomic_load_explicit(&vec->len, memory_order_acquire);
+    ConcurrentVecBuf *buf = atomic_load_explicit(&vec->buf, memory_order_acquire);
+    return buf == NULL ? NULL : buf->data;
+}
+
+void ConcurrentVec_drop(ConcurrentVec *vec)
+{
+    ConcurrentVecBuf *buf = atomic_load_explicit(&vec->buf, memory_order_relaxed);
+    if (buf != NULL)
+    {
+        vec->ebr->alloc.deallocate(buf);
+    }
+    atomic_store_explicit(&vec->buf, NULL, memory_order_relaxed);
+    atomic_store_explicit(&vec->len, 0, memory_order_relaxed);
+    pthread_mutex_destroy(&vec->lock);
+}
+
+#endif // CONCURRENT_VEC_IMPLEMENTATION
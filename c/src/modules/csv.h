@@ -0,0 +1,447 @@
+#ifndef _CSV_H_INCLUDED_
+#define _CSV_H_INCLUDED_
+
+/**
+ * The block classifier and row access are static inline; the rest is
+ * emitted where CSV_IMPLEMENTATION is defined. One unit also defines
+ * ALLOC_, RAWVEC_, VEC_ and STRING_IMPLEMENTATION.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "vec.h"
+#include "string.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define CSV_BLOCK 64
+
+// A field as [start, end) byte offsets from the start of the stream
+typedef struct
+{
+    uint64_t start;
+    uint64_t end;
+} CsvField;
+
+/**
+ * Streaming CSV/TSV tokenizer. Input is classified 64 bytes at a time into
+ * quote, delimiter, newline and carriage-return bitmasks. A prefix XOR over
+ * the quote mask marks the bytes inside quoted fields, so delimiters and
+ * newlines there are ignored without a per-byte state machine. Doubled
+ * quotes inside a quoted field toggle twice and need no special case.
+ *
+ * Every field found becomes a CsvField in `fields`, with a trailing CR
+ * before the newline already excluded; `rows` holds, for each complete
+ * row, the index one past its last field. Blank lines are skipped.
+ * Offsets count from the first byte ever fed, so a caller that feeds a
+ * file in chunks can clear completed rows and keep going.
+ */
+typedef struct
+{
+    char delimiter;
+    uint64_t in_quote;
+    bool prev_cr;
+    bool row_has_delimiter;
+    uint64_t pos;
+    uint64_t field_start;
+    size_t row_first_field;
+    Vec fields;
+    Vec rows;
+} CsvTokenizer;
+
+// Create a tokenizer splitting on `delimiter` (',' for CSV, '\t' for TSV)
+CsvTokenizer CsvTokenizer_new(char delimiter);
+
+typedef struct
+{
+    uint64_t quote;
+    uint64_t delimiter;
+    uint64_t newline;
+    uint64_t cr;
+} CsvMasks;
+
+// Classify one 64-byte block into bitmasks, bit i for byte i
+static inline CsvMasks Csv_classify_(const char *block, char delimiter)
+{
+    CsvMasks m = {0, 0, 0, 0};
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i delim = _mm_set1_epi8(delimiter);
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    for (int i = 0; i < 4; i++)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(block + 16 * i));
+        int shift = 16 * i;
+        m.quote |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << shift;
+        m.delimiter |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, delim)) << shift;
+        m.newline |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)) << shift;
+        m.cr |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, cr)) << shift;
+    }
+#else
+    for (int i = 0; i < CSV_BLOCK; i++)
+    {
+        uint64_t bit = 1ull << i;
+        m.quote |= block[i] == '"' ? bit : 0;
+        m.delimiter |= block[i] == delimiter ? bit : 0;
+        m.newline |= block[i] == '\n' ? bit : 0;
+        m.cr |= block[i] == '\r' ? bit : 0;
+    }
+#endif
+    return m;
+}
+
+// Bit i of the result is the XOR of bits 0..i of x
+static inline uint64_t Csv_prefix_xor_(uint64_t x)
+{
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+// Tokenize one block of `len` <= 64 valid bytes
+static inline void CsvTokenizer_block_(CsvTokenizer *t, const char *block, size_t len)
+{
+    CsvMasks m = Csv_classify_(block, t->delimiter);
+    if (len < CSV_BLOCK)
+    {
+        uint64_t valid = (1ull << len) - 1;
+        m.quote &= valid;
+        m.delimiter &= valid;
+        m.newline &= valid;
+        m.cr &= valid;
+    }
+    uint64_t inside = Csv_prefix_xor_(m.quote) ^ t->in_quote;
+    t->in_quote = (uint64_t)((int64_t)inside >> 63);
+    uint64_t newlines = m.newline & ~inside;
+    uint64_t separators = (m.delimiter & ~inside) | newlines;
+    // Bit i set when byte i - 1 is a CR
+    uint64_t cr_before = (m.cr << 1) | (uint64_t)t->prev_cr;
+    t->prev_cr = len > 0 && (m.cr >> (len - 1)) & 1;
+    if (separators == 0)
+    {
+        t->pos += len;
+        return;
+    }
+
+    Vec_reserve(&t->fields, (size_t)__builtin_popcountll(separators), sizeof(CsvField));
+    Vec_reserve(&t->rows, (size_t)__builtin_popcountll(newlines), sizeof(size_t));
+    // Work on locals so the stores below don't force reloads through `t`
+    CsvField *fields = t->fields.buf.ptr;
+    size_t *rows = t->rows.buf.ptr;
+    size_t field_count = t->fields.len;
+    size_t row_count = t->rows.len;
+    size_t row_first = t->row_first_field;
+    bool row_has_delimiter = t->row_has_delimiter;
+    uint64_t field_start = t->field_start;
+    do
+    {
+        int bit = __builtin_ctzll(separators);
+        uint64_t offset = t->pos + (uint64_t)bit;
+        if (!((newlines >> bit) & 1))
+        {
+            fields[field_count++] = (CsvField){field_start, offset};
+            row_has_delimiter = true;
+        }
+        else
+        {
+            uint64_t end = offset - (((cr_before >> bit) & 1) && offset > field_start ? 1 : 0);
+            // A lone empty field on its line is a blank line and is skipped
+            if (row_has_delimiter || end > field_start)
+            {
+                fields[field_count++] = (CsvField){field_start, end};
+                rows[row_count++] = field_count;
+                row_first = field_count;
+            }
+            row_has_delimiter = false;
+        }
+        field_start = offset + 1;
+        separators &= separators - 1;
+    } while (separators != 0);
+    t->fields.len = field_count;
+    t->rows.len = row_count;
+    t->row_first_field = row_first;
+    t->row_has_delimiter = row_has_delimiter;
+    t->field_start = field_start;
+    t->pos += len;
+}
+
+/**
+ * Tokenize the next `len` bytes of the stream. Whole 64-byte blocks are
+ * read in place; a short tail is copied into a padded block first.
+ */
+void CsvTokenizer_feed(CsvTokenizer *t, const char *data, size_t len);
+
+// Emit the last row when the input does not end in a newline
+void CsvTokenizer_finish(CsvTokenizer *t);
+
+// Get the number of complete rows
+static inline size_t CsvTokenizer_row_count(const CsvTokenizer *t)
+{
+    return t->rows.len;
+}
+
+// Get the fields of a complete row; returns the field count
+static inline size_t CsvTokenizer_row(const CsvTokenizer *t, size_t row, const CsvField **fields)
+{
+    assert(row < t->rows.len);
+    const size_t *ends = Vec_as_slice(&t->rows);
+    size_t first = row == 0 ? 0 : ends[row - 1];
+    *fields = (const CsvField *)t->fields.buf.ptr + first;
+    return ends[row] - first;
+}
+
+/**
+ * Drop every complete row, keeping the fields of a row still in progress.
+ * Offsets stay relative to the start of the stream.
+ */
+void CsvTokenizer_clear_rows(CsvTokenizer *t);
+
+// Start a new stream, keeping the buffers' capacity
+void CsvTokenizer_reset(CsvTokenizer *t);
+
+// Free the tokenizer's buffers
+void CsvTokenizer_drop(CsvTokenizer *t);
+
+/**
+ * Borrow a field's text, where `data` holds the stream starting at offset
+ * `base`. Surrounding quotes are removed; doubled quotes inside are left
+ * as they are (see Csv_unescape).
+ */
+StringView Csv_field_view(const char *data, uint64_t base, CsvField field);
+
+// Copy a field view into `out`, collapsing doubled quotes
+void Csv_unescape(StringView view, String *out);
+
+typedef enum
+{
+    CSV_SKIP,
+    CSV_INT64,
+    CSV_DOUBLE,
+    CSV_STRING,
+} CsvColumnType;
+
+/**
+ * Parse the complete rows into one typed Vec per column: int64_t for
+ * CSV_INT64, double for CSV_DOUBLE and StringView (borrowing `data`) for
+ * CSV_STRING; CSV_SKIP columns are left untouched. `columns` must hold
+ * `column_count` initialized Vecs, which are appended to. Missing or
+ * unparsable values are stored as 0 and counted in the return value.
+ */
+size_t Csv_parse_columns(const CsvTokenizer *t, const char *data, uint64_t base,
+                         const CsvColumnType *types, size_t column_count, Vec *columns);
+
+#endif // _CSV_H_INCLUDED_
+
+#if defined(CSV_IMPLEMENTATION) && !defined(_CSV_IMPLEMENTATION_INCLUDED_)
+#define _CSV_IMPLEMENTATION_INCLUDED_
+
+CsvTokenizer CsvTokenizer_new(char delimiter)
+{
+    return (CsvTokenizer){
+        .delimiter = delimiter,
+        .in_quote = 0,
+        .prev_cr = false,
+        .row_has_delimiter = false,
+        .pos = 0,
+        .field_start = 0,
+        .row_first_field = 0,
+        .fields = Vec_new(),
+        .rows = Vec_new()};
+}
+
+void CsvTokenizer_feed(CsvTokenizer *t, const char *data, size_t len)
+{
+    size_t i = 0;
+    for (; i + CSV_BLOCK <= len; i += CSV_BLOCK)
+    {
+        CsvTokenizer_block_(t, data + i, CSV_BLOCK);
+    }
+    if (i < len)
+    {
+        char tail[CSV_BLOCK] = {0};
+        memcpy(tail, data + i, len - i);
+        CsvTokenizer_block_(t, tail, len - i);
+    }
+}
+
+void CsvTokenizer_finish(CsvTokenizer *t)
+{
+    uint64_t end = t->pos - (t->prev_cr && t->pos > t->field_start ? 1 : 0);
+    if (end > t->field_start || t->row_has_delimiter)
+    {
+        CsvField field = {t->field_start, end};
+        Vec_push(&t->fields, &field, sizeof(CsvField));
+        Vec_push(&t->rows, &t->fields.len, sizeof(size_t));
+        t->row_first_field = t->fields.len;
+    }
+    t->field_start = t->pos;
+    t->row_has_delimiter = false;
+}
+
+void CsvTokenizer_clear_rows(CsvTokenizer *t)
+{
+    size_t keep = t->fields.len - t->row_first_field;
+    CsvField *fields = Vec_as_mut_slice(&t->fields);
+    memmove(fields, fields + t->row_first_field, keep * sizeof(CsvField));
+    t->fields.len = keep;
+    t->row_first_field = 0;
+    Vec_clear(&t->rows);
+}
+
+void CsvTokenizer_reset(CsvTokenizer *t)
+{
+    Vec fields = t->fields;
+    Vec rows = t->rows;
+    Vec_clear(&fields);
+    Vec_clear(&rows);
+    *t = CsvTokenizer_new(t->delimiter);
+    t->fields = fields;
+    t->rows = rows;
+}
+
+void CsvTokenizer_drop(CsvTokenizer *t)
+{
+    Vec_drop(&t->fields);
+    Vec_drop(&t->rows);
+}
+
+StringView Csv_field_view(const char *data, uint64_t base, CsvField field)
+{
+    const char *p = data + (field.start - base);
+    size_t len = (size_t)(field.end - field.start);
+    if (len >= 2 && p[0] == '"' && p[len - 1] == '"')
+    {
+        p++;
+        len -= 2;
+    }
+    return (StringView){p, len};
+}
+
+void Csv_unescape(StringView view, String *out)
+{
+    String_clear(out);
+    Vec_reserve(&out->vec, view.len + 1, sizeof(char));
+    char *dst = out->vec.buf.ptr;
+    size_t n = 0;
+    for (size_t i = 0; i < view.len; i++)
+    {
+        dst[n++] = view.ptr[i];
+        if (view.ptr[i] == '"' && i + 1 < view.len && view.ptr[i + 1] == '"')
+        {
+            i++;
+        }
+    }
+    dst[n] = '\0';
+    out->vec.len = n;
+}
+
+// Parse an optionally signed decimal integer that fills the whole view
+bool Csv_parse_int64_(StringView v, int64_t *out)
+{
+    size_t i = 0;
+    bool negative = false;
+    if (v.len > 0 && (v.ptr[0] == '-' || v.ptr[0] == '+'))
+    {
+        negative = v.ptr[0] == '-';
+        i = 1;
+    }
+    if (i == v.len || v.len - i > 19)
+    {
+        return false;
+    }
+    uint64_t value = 0;
+    for (; i < v.len; i++)
+    {
+        unsigned digit = (unsigned)(v.ptr[i] - '0');
+        if (digit > 9)
+        {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    // 19 digits fit in uint64_t; the magnitude may still be out of int64_t range
+    if (value > (uint64_t)INT64_MAX + negative)
+    {
+        return false;
+    }
+    *out = negative ? (int64_t)(0 - value) : (int64_t)value;
+    return true;
+}
+
+// Parse a floating point number that fills the whole view
+bool Csv_parse_double_(StringView v, double *out)
+{
+    char buf[64];
+    if (v.len == 0 || v.len >= sizeof(buf))
+    {
+        return false;
+    }
+    memcpy(buf, v.ptr, v.len);
+    buf[v.len] = '\0';
+    char *end;
+    *out = strtod(buf, &end);
+    return end == buf + v.len;
+}
+
+size_t Csv_parse_columns(const CsvTokenizer *t, const char *data, uint64_t base,
+                         const CsvColumnType *types, size_t column_count, Vec *columns)
+{
+    size_t bad = 0;
+    size_t rows = t->rows.len;
+    for (size_t c = 0; c < column_count; c++)
+    {
+        size_t elem_size = types[c] == CSV_STRING ? sizeof(StringView) : sizeof(int64_t);
+        if (types[c] != CSV_SKIP)
+        {
+            Vec_reserve(&columns[c], rows, elem_size);
+        }
+    }
+    for (size_t r = 0; r < rows; r++)
+    {
+        const CsvField *fields;
+        size_t count = CsvTokenizer_row(t, r, &fields);
+        for (size_t c = 0; c < column_count; c++)
+        {
+            StringView view = c < count ? Csv_field_view(data, base, fields[c]) : (StringView){"", 0};
+            bool ok = c < count;
+            switch (types[c])
+            {
+            case CSV_INT64:
+            {
+                int64_t value = 0;
+                ok = ok && Csv_parse_int64_(view, &value);
+                ((int64_t *)columns[c].buf.ptr)[columns[c].len++] = ok ? value : 0;
+                break;
+            }
+            case CSV_DOUBLE:
+            {
+                double value = 0;
+                ok = ok && Csv_parse_double_(view, &value);
+                ((double *)columns[c].buf.ptr)[columns[c].len++] = ok ? value : 0;
+                break;
+            }
+            case CSV_STRING:
+                ((StringView *)columns[c].buf.ptr)[columns[c].len++] = view;
+                break;
+            default:
+                ok = true;
+                break;
+            }
+            bad += ok ? 0 : 1;
+        }
+    }
+    return bad;
+}
+
+#endif // CSV_IMPLEMENTATION
@@ -0,0 +1,318 @@
+#ifndef _EBR_H_INCLUDED_
+#define _EBR_H_INCLUDED_
+
+/**
+ * Ebr_pin and Ebr_unpin are static inline; registration, retirement and
+ * collection are emitted where EBR_IMPLEMENTATION is defined. One unit
+ * also defines ALLOC_, RAWVEC_ and VEC_IMPLEMENTATION.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "vec.h"
+
+#define EBR_CACHE_LINE 64
+// Number of retired pointers a thread buffers before trying to advance the epoch
+#define EBR_RETIRE_BATCH 64
+
+typedef struct Ebr Ebr;
+
+/**
+ * Per-thread reclamation state. `local` is 0 while the thread is outside a
+ * critical section, and (epoch << 1) | 1 while it is pinned. Retired
+ * pointers are kept in three buckets keyed by the global epoch at retire
+ * time; a bucket is freed once the global epoch is two steps past it.
+ */
+typedef struct EbrThread
+{
+    atomic_uint_fast64_t local;
+    atomic_bool in_use;
+    char pad[EBR_CACHE_LINE - sizeof(atomic_uint_fast64_t) - sizeof(atomic_bool)];
+    Ebr *domain;
+    size_t depth;
+    size_t retired_count;
+    Vec retired[3];
+    uint64_t retired_epoch[3];
+    struct EbrThread *next;
+} EbrThread;
+
+typedef struct
+{
+    void *ptr;
+    uint64_t epoch;
+} EbrOrphan;
+
+/**
+ * A reclamation domain shared by every thread that touches a given set of
+ * lock-free structures. Retired memory is returned through `alloc`.
+ */
+struct Ebr
+{
+    atomic_uint_fast64_t epoch;
+    _Atomic(EbrThread *) threads;
+    Allocator alloc;
+    pthread_mutex_t orphan_lock;
+    Vec orphans;
+};
+
+// Create a reclamation domain that frees retired memory through `alloc`
+Ebr *Ebr_new(Allocator alloc);
+
+// Get the current global epoch
+static inline uint64_t Ebr_epoch(const Ebr *ebr)
+{
+    return atomic_load_explicit(&ebr->epoch, memory_order_acquire);
+}
+
+/**
+ * Register the calling thread with the domain. Slots released by
+ * Ebr_unregister are reused; new slots are pushed onto a lock-free list that
+ * only grows until the domain is dropped.
+ */
+EbrThread *Ebr_register(Ebr *ebr);
+
+/**
+ * Advance the global epoch if every pinned thread has observed the current
+ * one. Returns true if this call (or a concurrent one) moved it forward.
+ */
+bool Ebr_try_advance(Ebr *ebr);
+
+// Free every retire bucket of `t` that no pinned thread can still reach
+void Ebr_collect(EbrThread *t);
+
+// Enter a critical section; pointers loaded inside stay valid until Ebr_unpin
+static inline void Ebr_pin(EbrThread *t)
+{
+    if (t->depth++ > 0)
+    {
+        return;
+    }
+    uint64_t epoch = atomic_load_explicit(&t->domain->epoch, memory_order_relaxed);
+    atomic_store_explicit(&t->local, (epoch << 1) | 1, memory_order_relaxed);
+    // Publish the pin before any shared pointer is loaded
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+// Leave a critical section
+static inline void Ebr_unpin(EbrThread *t)
+{
+    assert(t->depth > 0);
+    if (--t->depth == 0)
+    {
+        atomic_store_explicit(&t->local, 0, memory_order_release);
+    }
+}
+
+// Check whether the thread is inside a critical section
+static inline bool Ebr_is_pinned(const EbrThread *t)
+{
+    return t->depth > 0;
+}
+
+/**
+ * Hand over memory that has already been unlinked from every shared
+ * structure. It is freed through the domain's allocator once no thread that
+ * might have loaded it is still pinned. Frees happen in batches.
+ */
+void Ebr_retire(EbrThread *t, void *ptr);
+
+/**
+ * Release the calling thread's slot. Pointers it retired that are not yet
+ * safe to free move to the domain's orphan list.
+ */
+void Ebr_unregister(EbrThread *t);
+
+// Free every retired pointer and the domain. No thread may be pinned.
+void Ebr_drop(Ebr *ebr);
+
+#endif // _EBR_H_INCLUDED_
+
+#if defined(EBR_IMPLEMENTATION) && !defined(_EBR_IMPLEMENTATION_INCLUDED_)
+#define _EBR_IMPLEMENTATION_INCLUDED_
+
+Ebr *Ebr_new(Allocator alloc)
+{
+    Ebr *ebr = alloc.allocate(sizeof(Ebr));
+    assert(ebr != NULL);
+    atomic_init(&ebr->epoch, 0);
+    atomic_init(&ebr->threads, NULL);
+    ebr->alloc = alloc;
+    pthread_mutex_init(&ebr->orphan_lock, NULL);
+    ebr->orphans = Vec_new();
+    return ebr;
+}
+
+EbrThread *Ebr_register(Ebr *ebr)
+{
+    for (EbrThread *t = atomic_load_explicit(&ebr->threads, memory_order_acquire); t != NULL; t = t->next)
+    {
+        bool expected = false;
+        if (!atomic_load_explicit(&t->in_use, memory_order_relaxed) &&
+            atomic_compare_exchange_strong_explicit(&t->in_use, &expected, true, memory_order_acquire, memory_order_relaxed))
+        {
+            return t;
+        }
+    }
+    EbrThread *t = ebr->alloc.allocate(sizeof(EbrThread));
+    assert(t != NULL);
+    atomic_init(&t->local, 0);
+    atomic_init(&t->in_use, true);
+    t->domain = ebr;
+    t->depth = 0;
+    t->retired_count = 0;
+    for (size_t i = 0; i < 3; i++)
+    {
+        t->retired[i] = Vec_new();
+        t->retired_epoch[i] = 0;
+    }
+    EbrThread *head = atomic_load_explicit(&ebr->threads, memory_order_relaxed);
+    do
+    {
+        t->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&ebr->threads, &head, t, memory_order_release, memory_order_relaxed));
+    return t;
+}
+
+// Free every pointer in one of a thread's retire buckets
+void EbrThread_free_bucket_(EbrThread *t, size_t bucket)
+{
+    Vec *list = &t->retired[bucket];
+    void **ptrs = Vec_as_mut_slice(list);
+    for (size_t i = 0; i < list->len; i++)
+    {
+        t->domain->alloc.deallocate(ptrs[i]);
+    }
+    t->retired_count -= list->len;
+    Vec_clear(list);
+}
+
+bool Ebr_try_advance(Ebr *ebr)
+{
+    uint64_t epoch = atomic_load_explicit(&ebr->epoch, memory_order_seq_cst);
+    for (EbrThread *t = atomic_load_explicit(&ebr->threads, memory_order_acquire); t != NULL; t = t->next)
+    {
+        uint64_t local = atomic_load_explicit(&t->local, memory_order_seq_cst);
+        if ((local & 1) && (local >> 1) != epoch)
+        {
+            return false;
+        }
+    }
+    // A failed exchange means another thread advanced it first
+    atomic_compare_exchange_strong_explicit(&ebr->epoch, &epoch, epoch + 1, memory_order_seq_cst, memory_order_relaxed);
+    return true;
+}
+
+// Free orphaned pointers that are old enough, if the orphan list is not busy
+void Ebr_collect_orphans_(Ebr *ebr, uint64_t epoch)
+{
+    if (pthread_mutex_trylock(&ebr->orphan_lock) != 0)
+    {
+        return;
+    }
+    EbrOrphan *orphans = Vec_as_mut_slice(&ebr->orphans);
+    size_t kept = 0;
+    for (size_t i = 0; i < ebr->orphans.len; i++)
+    {
+        if (orphans[i].epoch + 2 <= epoch)
+        {
+            ebr->alloc.deallocate(orphans[i].ptr);
+        }
+        else
+        {
+            orphans[kept++] = orphans[i];
+        }
+    }
+    ebr->orphans.len = kept;
+    pthread_mutex_unlock(&ebr->orphan_lock);
+}
+
+void Ebr_collect(EbrThread *t)
+{
+    uint64_t epoch = atomic_load_explicit(&t->domain->epoch, memory_order_seq_cst);
+    for (size_t bucket = 0; bucket < 3; bucket++)
+    {
+        if (t->retired[bucket].len > 0 && t->retired_epoch[bucket] + 2 <= epoch)
+        {
+            EbrThread_free_bucket_(t, bucket);
+        }
+    }
+    Ebr_collect_orphans_(t->domain, epoch);
+}
+
+void Ebr_retire(EbrThread *t, void *ptr)
+{
+    // Must be read after the unlink that made `ptr` unreachable
+    uint64_t epoch = atomic_load_explicit(&t->domain->epoch, memory_order_seq_cst);
+    size_t bucket = epoch % 3;
+    if (t->retired_epoch[bucket] != epoch)
+    {
+        // Anything still here was retired at least three epochs ago
+        if (t->retired[bucket].len > 0)
+        {
+            EbrThread_free_bucket_(t, bucket);
+        }
+        t->retired_epoch[bucket] = epoch;
+    }
+    Vec_push(&t->retired[bucket], &ptr, sizeof(void *));
+    t->retired_count++;
+    if (t->retired_count >= EBR_RETIRE_BATCH)
+    {
+        Ebr_try_advance(t->domain);
+        Ebr_collect(t);
+    }
+}
+
+void Ebr_unregister(EbrThread *t)
+{
+    assert(t->depth == 0);
+    Ebr *ebr = t->domain;
+    Ebr_try_advance(ebr);
+    Ebr_collect(t);
+    pthread_mutex_lock(&ebr->orphan_lock);
+    for (size_t bucket = 0; bucket < 3; bucket++)
+    {
+        void **ptrs = Vec_as_mut_slice(&t->retired[bucket]);
+        for (size_t i = 0; i < t->retired[bucket].len; i++)
+        {
+            EbrOrphan orphan = {ptrs[i], t->retired_epoch[bucket]};
+            Vec_push(&ebr->orphans, &orphan, sizeof(EbrOrphan));
+        }
+        Vec_clear(&t->retired[bucket]);
+    }
+    pthread_mutex_unlock(&ebr->orphan_lock);
+    t->retired_count = 0;
+    atomic_store_explicit(&t->in_use, false, memory_order_release);
+}
+
+void Ebr_drop(Ebr *ebr)
+{
+    EbrThread *t = atomic_load_explicit(&ebr->threads, memory_order_acquire);
+    while (t != NULL)
+    {
+        EbrThread *next = t->next;
+        assert(t->depth == 0);
+        for (size_t bucket = 0; bucket < 3; bucket++)
+        {
+            EbrThread_free_bucket_(t, bucket);
+            Vec_drop(&t->retired[bucket]);
+        }
+        ebr->alloc.deallocate(t);
+        t = next;
+    }
+    EbrOrphan *orphans = Vec_as_mut_slice(&ebr->orphans);
+    for (size_t i = 0; i < ebr->orphans.len; i++)
+    {
+        ebr->alloc.deallocate(orphans[i].ptr);
+    }
+    Vec_drop(&ebr->orphans);
+    pthread_mutex_destroy(&ebr->orphan_lock);
+    ebr->alloc.deallocate(ebr);
+}
+
+#endif // EBR_IMPLEMENTATION
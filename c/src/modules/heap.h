@@ -0,0 +1,426 @@
+#ifndef _HEAP_H_INCLUDED_
+#define _HEAP_H_INCLUDED_
+
+/**
+ * Heap_push, Heap_peek and the accessors are static inline, as is
+ * everything define_Heap generates. The rest is emitted where
+ * HEAP_IMPLEMENTATION is defined; one unit also defines ALLOC_, RAWVEC_
+ * and VEC_IMPLEMENTATION.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "vec.h"
+
+// qsort-style comparator: negative, zero or positive
+typedef int (*HeapCompare)(const void *a, const void *b);
+
+/**
+ * A d-ary heap stored in a Vec. `arity` is 2 (binary heap) or 4 (4-ary heap,
+ * shallower and with all children of a node in one cache line for small
+ * elements); any power of two works. The top is the greatest element by `cmp`
+ * for a max-heap, the smallest for a min-heap.
+ */
+typedef struct
+{
+    Vec vec;
+    size_t elem_size;
+    size_t shift;
+    HeapCompare cmp;
+    int sign;
+    void *tmp;
+} Heap;
+
+Heap Heap_with_sign_(size_t elem_size, size_t arity, HeapCompare cmp, int sign);
+
+// Create an empty max-heap with the given arity
+static inline Heap Heap_new(size_t elem_size, size_t arity, HeapCompare cmp)
+{
+    return Heap_with_sign_(elem_size, arity, cmp, 1);
+}
+
+// Create an empty min-heap with the given arity
+static inline Heap Heap_new_min(size_t elem_size, size_t arity, HeapCompare cmp)
+{
+    return Heap_with_sign_(elem_size, arity, cmp, -1);
+}
+
+static inline char *Heap_at_(const Heap *heap, size_t index)
+{
+    return (char *)heap->vec.buf.ptr + index * heap->elem_size;
+}
+
+// True if `a` belongs above `b`
+static inline bool Heap_above_(const Heap *heap, const void *a, const void *b)
+{
+    return heap->sign * heap->cmp(a, b) > 0;
+}
+
+// Move the hole at `index` up until `value` fits, then store it there
+void Heap_sift_up_(Heap *heap, size_t index, const void *value);
+
+// Restore the heap property over the whole Vec in O(n)
+void Heap_heapify(Heap *heap);
+
+// Build a max-heap from a slice of `count` elements in O(n)
+Heap Heap_from_slice(const void *values, size_t count, size_t elem_size, size_t arity, HeapCompare cmp);
+
+// Get the number of elements in the heap
+static inline size_t Heap_len(const Heap *heap)
+{
+    return heap->vec.len;
+}
+
+// Check if the heap is empty
+static inline bool Heap_is_empty(const Heap *heap)
+{
+    return heap->vec.len == 0;
+}
+
+// Get a pointer to the top element, or NULL if empty
+static inline void *Heap_peek(const Heap *heap)
+{
+    return heap->vec.len == 0 ? NULL : heap->vec.buf.ptr;
+}
+
+// Push an element onto the heap
+static inline void Heap_push(Heap *heap, const void *value)
+{
+    Vec_reserve(&heap->vec, 1, heap->elem_size);
+    size_t index = heap->vec.len++;
+    Heap_sift_up_(heap, index, value);
+}
+
+// Pop the top element into `out`
+bool Heap_pop(Heap *heap, void *out);
+
+/**
+ * Push `value` and pop the top into `out`, with at most one sift. If `value`
+ * would be the new top it is returned straight away without touching the heap.
+ */
+void Heap_push_pop(Heap *heap, const void *value, void *out);
+
+// Pop the top into `out` and push `value` with a single sift. The heap must not be empty.
+void Heap_replace_top(Heap *heap, const void *value, void *out);
+
+// Clear the heap
+static inline void Heap_clear(Heap *heap)
+{
+    heap->vec.len = 0;
+}
+
+// Free the memory used by the heap
+void Heap_drop(Heap *heap);
+
+/**
+ * Stream through `src` keeping the `k` greatest elements by `cmp` in a
+ * bounded 4-ary min-heap, then write them to `out` in descending order.
+ * Runs in O(n log k) time and O(k) extra space.
+ */
+void Heap_top_k(const Vec *src, size_t k, size_t elem_size, HeapCompare cmp, Vec *out);
+
+/**
+ * Typed heap with an inlined comparison. `define_Heap(Name, T, ARITY, ABOVE)`
+ * declares `Name` holding `T` values, where `ABOVE(a, b)` is a macro or
+ * function that is true when `a` belongs closer to the top than `b`.
+ */
+#define define_Heap(Name, T, ARITY, ABOVE)                                            \
+    typedef struct                                                                    \
+    {                                                                                 \
+        Vec vec;                                                                      \
+    } Name;                                                                           \
+    static inline Name Name##_new(void)                                               \
+    {                                                                                 \
+        return (Name){.vec = Vec_new()};                                              \
+    }                                                                                 \
+    static inline size_t Name##_len(const Name *heap)                                 \
+    {                                                                                 \
+        return heap->vec.len;                                                         \
+    }                                                                                 \
+    static inline T *Name##_peek(const Name *heap)                                    \
+    {                                                                                 \
+        return heap->vec.len == 0 ? NULL : (T *)heap->vec.buf.ptr;                    \
+    }                                                                                 \
+    static inline void Name##_sift_up_(T *items, size_t index, T value)               \
+    {                                                                                 \
+        while (index > 0)                                                             \
+        {                                                                             \
+            size_t parent = (index - 1) / (ARITY);                                    \
+            if (!(ABOVE(value, items[parent])))                                       \
+            {                                                                         \
+                break;                                                                \
+            }                                                                         \
+            items[index] = items[parent];                                             \
+            index = parent;                                                           \
+        }                                                                             \
+        items[index] = value;                                                         \
+    }                                                                                 \
+    static inline void Name##_sift_down_(T *items, size_t len, size_t index, T value) \
+    {                                                                                 \
+        for (;;)                                                                      \
+        {                                                                             \
+            size_t first = index * (ARITY) + 1;                                       \
+            if (first >= len)                                                         \
+            {                                                                         \
+                break;                                                                \
+            }                                                                         \
+            size_t last = first + (ARITY) < len ? first + (ARITY) : len;              \
+            size_t best = first;                                                      \
+            for (size_t child = first + 1; child < last; child++)                     \
+            {                                                                         \
+                if (ABOVE(items[child], items[best]))                                 \
+                {                                                                     \
+                    best = child;                                                     \
+                }                                                                     \
+            }                                                                         \
+            if (!(ABOVE(items[best], value)))                                         \
+            {                                                                         \
+                break;                                                                \
+            }                                                                         \
+            items[index] = items[best];                                               \
+            index = best;                                                             \
+        }                                                                             \
+        items[index] = value;                                                         \
+    }                                                                                 \
+    static inline Name Name##_from_slice(const T *values, size_t count)               \
+    {                                                                                 \
+        Name heap = Name##_new();                                                     \
+        Vec_reserve(&heap.vec, count, sizeof(T));                                     \
+        T *items = (T *)heap.vec.buf.ptr;                                             \
+        for (size_t i = 0; i < count; i++)                                            \
+        {                                                                             \
+            items[i] = values[i];                                                     \
+        }                                                                             \
+        heap.vec.len = count;                                                         \
+        for (size_t i = count > 1 ? (count - 2) / (ARITY) + 1 : 0; i-- > 0;)          \
+        {                                                                             \
+            Name##_sift_down_(items, count, i, items[i]);                             \
+        }                                                                             \
+        return heap;                                                                  \
+    }                                                                                 \
+    static inline void Name##_push(Name *heap, T value)                               \
+    {                                                                                 \
+        Vec_reserve(&heap->vec, 1, sizeof(T));                                        \
+        size_t index = heap->vec.len++;                                               \
+        Name##_sift_up_((T *)heap->vec.buf.ptr, index, value);                        \
+    }                                                                                 \
+    static inline bool Name##_pop(Name *heap, T *out)                                 \
+    {                                                                                 \
+        if (heap->vec.len == 0)                                                       \
+        {                                                                             \
+            return false;                                                             \
+        }                                                                             \
+        T *items = (T *)heap->vec.buf.ptr;                                            \
+        *out = items[0];                                                              \
+        size_t len = --heap->vec.len;                                                 \
+        if (len > 0)                                                                  \
+        {                                                                             \
+            Name##_sift_down_(items, len, 0, items[len]);                             \
+        }                                                                             \
+        return true;                                                                  \
+    }                                                                                 \
+    static inline T Name##_push_pop(Name *heap, T value)                              \
+    {                                                                                 \
+        T *items = (T *)heap->vec.buf.ptr;                                            \
+        if (heap->vec.len == 0 || !(ABOVE(items[0], value)))                          \
+        {                                                                             \
+            return value;                                                             \
+        }                                                                             \
+        T top = items[0];                                                             \
+        Name##_sift_down_(items, heap->vec.len, 0, value);                            \
+        return top;                                                                   \
+    }                                                                                 \
+    static inline T Name##_replace_top(Name *heap, T value)                           \
+    {                                                                                 \
+        assert(heap->vec.len > 0);                                                    \
+        T *items = (T *)heap->vec.buf.ptr;                                            \
+        T top = items[0];                                                             \
+        Name##_sift_down_(items, heap->vec.len, 0, value);                            \
+        return top;                                                                   \
+    }                                                                                 \
+    static inline void Name##_drop(Name *heap)                                        \
+    {                                                                                 \
+        Vec_drop(&heap->vec);                                                         \
+    }
+
+#endif // _HEAP_H_INCLUDED_
+
+#if defined(HEAP_IMPLEMENTATION) && !defined(_HEAP_IMPLEMENTATION_INCLUDED_)
+#define _HEAP_IMPLEMENTATION_INCLUDED_
+
+size_t Heap_arity_shift_(size_t arity)
+{
+    assert(arity >= 2 && (arity & (arity - 1)) == 0);
+    size_t shift = 0;
+    while (((size_t)1 << shift) < arity)
+    {
+        shift++;
+    }
+    return shift;
+}
+
+Heap Heap_with_sign_(size_t elem_size, size_t arity, HeapCompare cmp, int sign)
+{
+    void *tmp = GLOBAL_ALLOCATOR.allocate(elem_size);
+    assert(tmp != NULL);
+    return (Heap){
+        .vec = Vec_new(),
+        .elem_size = elem_size,
+        .shift = Heap_arity_shift_(arity),
+        .cmp = cmp,
+        .sign = sign,
+        .tmp = tmp};
+}
+
+void Heap_sift_up_(Heap *heap, size_t index, const void *value)
+{
+    while (index > 0)
+    {
+        size_t parent = (index - 1) >> heap->shift;
+        if (!Heap_above_(heap, value, Heap_at_(heap, parent)))
+        {
+            break;
+        }
+        memcpy(Heap_at_(heap, index), Heap_at_(heap, parent), heap->elem_size);
+        index = parent;
+    }
+    memcpy(Heap_at_(heap, index), value, heap->elem_size);
+}
+
+// Move the hole at `index` down until `value` fits, then store it there
+void Heap_sift_down_(Heap *heap, size_t index, const void *value)
+{
+    size_t len = heap->vec.len;
+    size_t arity = (size_t)1 << heap->shift;
+    for (;;)
+    {
+        size_t first = (index << heap->shift) + 1;
+        if (first >= len)
+        {
+            break;
+        }
+        size_t last = first + arity < len ? first + arity : len;
+        size_t best = first;
+        for (size_t child = first + 1; child < last; child++)
+        {
+            if (Heap_above_(heap, Heap_at_(heap, child), Heap_at_(heap, best)))
+            {
+                best = child;
+            }
+        }
+        if (!Heap_above_(heap, Heap_at_(heap, best), value))
+        {
+            break;
+        }
+        memcpy(Heap_at_(heap, index), Heap_at_(heap, best), heap->elem_size);
+        index = best;
+    }
+    memcpy(Heap_at_(heap, index), value, heap->elem_size);
+}
+
+void Heap_heapify(Heap *heap)
+{
+    size_t len = heap->vec.len;
+    if (len < 2)
+    {
+        return;
+    }
+    for (size_t i = ((len - 2) >> heap->shift) + 1; i-- > 0;)
+    {
+        memcpy(heap->tmp, Heap_at_(heap, i), heap->elem_size);
+        Heap_sift_down_(heap, i, heap->tmp);
+    }
+}
+
+Heap Heap_from_slice(const void *values, size_t count, size_t elem_size, size_t arity, HeapCompare cmp)
+{
+    Heap heap = Heap_new(elem_size, arity, cmp);
+    Vec_reserve(&heap.vec, count, elem_size);
+    if (count > 0)
+    {
+        memcpy(heap.vec.buf.ptr, values, count * elem_size);
+    }
+    heap.vec.len = count;
+    Heap_heapify(&heap);
+    return heap;
+}
+
+bool Heap_pop(Heap *heap, void *out)
+{
+    if (heap->vec.len == 0)
+    {
+        return false;
+    }
+    memcpy(out, heap->vec.buf.ptr, heap->elem_size);
+    heap->vec.len--;
+    if (heap->vec.len > 0)
+    {
+        memcpy(heap->tmp, Heap_at_(heap, heap->vec.len), heap->elem_size);
+        Heap_sift_down_(heap, 0, heap->tmp);
+    }
+    return true;
+}
+
+void Heap_push_pop(Heap *heap, const void *value, void *out)
+{
+    if (heap->vec.len == 0 || !Heap_above_(heap, heap->vec.buf.ptr, value))
+    {
+        memmove(out, value, heap->elem_size);
+        return;
+    }
+    memcpy(heap->tmp, value, heap->elem_size);
+    memcpy(out, heap->vec.buf.ptr, heap->elem_size);
+    Heap_sift_down_(heap, 0, heap->tmp);
+}
+
+void Heap_replace_top(Heap *heap, const void *value, void *out)
+{
+    assert(heap->vec.len > 0);
+    memcpy(heap->tmp, value, heap->elem_size);
+    memcpy(out, heap->vec.buf.ptr, heap->elem_size);
+    Heap_sift_down_(heap, 0, heap->tmp);
+}
+
+void Heap_drop(Heap *heap)
+{
+    Vec_drop(&heap->vec);
+    GLOBAL_ALLOCATOR.deallocate(heap->tmp);
+    heap->tmp = NULL;
+}
+
+void Heap_top_k(const Vec *src, size_t k, size_t elem_size, HeapCompare cmp, Vec *out)
+{
+    Vec_clear(out);
+    if (k == 0)
+    {
+        return;
+    }
+    Heap heap = Heap_new_min(elem_size, 4, cmp);
+    Vec_reserve(&heap.vec, k, elem_size);
+    for (size_t i = 0; i < src->len; i++)
+    {
+        const char *value = (const char *)src->buf.ptr + i * elem_size;
+        if (heap.vec.len < k)
+        {
+            Heap_push(&heap, value);
+        }
+        else if (cmp(value, heap.vec.buf.ptr) > 0)
+        {
+            memcpy(heap.tmp, value, elem_size);
+            Heap_sift_down_(&heap, 0, heap.tmp);
+        }
+    }
+    size_t n = heap.vec.len;
+    Vec_reserve(out, n, elem_size);
+    out->len = n;
+    for (size_t i = n; i-- > 0;)
+    {
+        Heap_pop(&heap, (char *)out->buf.ptr + i * elem_size);
+    }
+    Heap_drop(&heap);
+}
+
+#endif // HEAP_IMPLEMENTATION
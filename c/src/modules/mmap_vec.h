@@ -0,0 +1,416 @@
+#ifndef _MMAP_VEC_H_INCLUDED_
+#define _MMAP_VEC_H_INCLUDED_
+
+/**
+ * MmapVec_len and MmapVec_capacity are static inline. The rest and
+ * MMAP_VEC_ALLOCATOR are emitted where MMAP_VEC_IMPLEMENTATION is
+ * defined; one unit also defines ALLOC_, RAWVEC_ and VEC_IMPLEMENTATION.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vec.h"
+
+/**
+ * Growing a mapping uses mremap on Linux. glibc only declares it under
+ * _GNU_SOURCE, which has no effect unless it comes before the first system
+ * header, so the raw syscall is used instead and does not depend on include
+ * order. Elsewhere the file is unmapped and mapped again.
+ */
+#ifdef __linux__
+#include <sys/syscall.h>
+#define MMAP_VEC_HAVE_MREMAP 1
+#define MMAP_VEC_MREMAP_MAYMOVE 1 // MREMAP_MAYMOVE from <linux/mman.h>
+#else
+#define MMAP_VEC_HAVE_MREMAP 0
+#endif
+
+#define MMAP_VEC_MAGIC 0x434556504D4D5654ull // "TVMMPVEC"
+#define MMAP_VEC_VERSION 1
+#define MMAP_VEC_INITIAL_BYTES 4096
+
+/**
+ * On-disk header. Elements start right after it, so with a 64-byte header
+ * the data is cache-line aligned within the mapping.
+ */
+typedef struct
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t elem_size;
+    uint64_t len;
+    uint64_t cap;
+    uint64_t reserved[4];
+} MmapVecHeader;
+
+typedef enum
+{
+    MMAP_VEC_NORMAL,
+    MMAP_VEC_SEQUENTIAL,
+    MMAP_VEC_RANDOM,
+    MMAP_VEC_WILLNEED,
+} MmapVecAdvice;
+
+/**
+ * A Vec whose buffer is a shared mapping of a file. `vec` can be used with
+ * the read-side Vec functions (Vec_get, Vec_len, Vec_as_slice, ...) and with
+ * Vec_set on writable mappings; growth must go through MmapVec_reserve or
+ * MmapVec_push. The embedded RawVec uses an allocator that refuses to
+ * allocate, so a stray Vec_push past capacity asserts instead of calling
+ * realloc on the mapping.
+ */
+typedef struct
+{
+    Vec vec;
+    MmapVecHeader *header;
+    size_t map_size;
+    size_t elem_size;
+    int fd;
+    bool read_only;
+} MmapVec;
+
+extern Allocator MMAP_VEC_ALLOCATOR;
+
+/**
+ * Open (creating if needed) a file-backed Vec of `elem_size`-byte elements
+ * for reading and writing. Returns false and sets errno on failure,
+ * including EINVAL when the file exists but was written with a different
+ * element size or format version.
+ */
+bool MmapVec_open(MmapVec *m, const char *path, size_t elem_size);
+
+/**
+ * Open an existing file-backed Vec with a read-only shared mapping. Any
+ * number of processes can do this while one writer appends; call
+ * MmapVec_refresh to pick up new elements.
+ */
+bool MmapVec_open_read_only(MmapVec *m, const char *path, size_t elem_size);
+
+// Get the length of the MmapVec
+static inline size_t MmapVec_len(const MmapVec *m)
+{
+    return m->vec.len;
+}
+
+// Get the capacity of the MmapVec
+static inline size_t MmapVec_capacity(const MmapVec *m)
+{
+    return m->vec.buf.cap;
+}
+
+/**
+ * Reserve room for `additional` more elements by growing the file with
+ * ftruncate and remapping it. Capacity doubles like RawVec_grow. Pointers
+ * into the old mapping are invalidated.
+ */
+bool MmapVec_reserve(MmapVec *m, size_t additional);
+
+// Append an element, growing the file if needed; the header length is updated in place
+bool MmapVec_push(MmapVec *m, const void *value);
+
+// Append `count` elements with one reserve and one copy
+bool MmapVec_extend(MmapVec *m, const void *values, size_t count);
+
+/**
+ * Write the length back to the header (in case the Vec was changed through
+ * `vec` directly) and flush dirty pages. `async` schedules the write-back
+ * without waiting for it.
+ */
+bool MmapVec_sync(MmapVec *m, bool async);
+
+/**
+ * Reader side: pick up elements appended by a writer since the file was
+ * opened, remapping if the file has grown.
+ */
+bool MmapVec_refresh(MmapVec *m);
+
+// Tell the kernel how the elements will be accessed
+bool MmapVec_advise(MmapVec *m, MmapVecAdvice advice);
+
+// Flush, unmap and close the file
+bool MmapVec_close(MmapVec *m);
+
+#endif // _MMAP_VEC_H_INCLUDED_
+
+#if defined(MMAP_VEC_IMPLEMENTATION) && !defined(_MMAP_VEC_IMPLEMENTATION_INCLUDED_)
+#define _MMAP_VEC_IMPLEMENTATION_INCLUDED_
+
+#ifdef __linux__
+#else
+#endif
+void *MmapVec_no_allocate_(size_t size)
+{
+    (void)size;
+    return NULL;
+}
+
+void MmapVec_no_deallocate_(void *ptr)
+{
+    (void)ptr;
+}
+
+void *MmapVec_no_reallocate_(void *ptr, size_t old_size, size_t new_size)
+{
+    (void)ptr;
+    (void)old_size;
+    (void)new_size;
+    return NULL;
+}
+
+Allocator MMAP_VEC_ALLOCATOR = {
+    .allocate = MmapVec_no_allocate_,
+    .deallocate = MmapVec_no_deallocate_,
+    .reallocate = MmapVec_no_reallocate_};
+
+// Point the embedded Vec at the current mapping
+void MmapVec_bind_(MmapVec *m)
+{
+    m->vec.buf.ptr = (char *)m->header + sizeof(MmapVecHeader);
+    m->vec.buf.alloc = MMAP_VEC_ALLOCATOR;
+    size_t len = __atomic_load_n(&m->header->len, __ATOMIC_ACQUIRE);
+    // A reader can see a length published after the file grew past its mapping
+    size_t mapped = (m->map_size - sizeof(MmapVecHeader)) / m->elem_size;
+    m->vec.len = len < mapped ? len : mapped;
+    m->vec.buf.cap = m->read_only ? m->vec.len : m->header->cap;
+}
+
+// Map `size` bytes of the file, replacing the current mapping if there is one
+bool MmapVec_map_(MmapVec *m, size_t size)
+{
+    void *map;
+    int prot = m->read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+    if (m->header == NULL)
+    {
+        map = mmap(NULL, size, prot, MAP_SHARED, m->fd, 0);
+    }
+    else
+    {
+#if MMAP_VEC_HAVE_MREMAP
+        map = (void *)syscall(SYS_mremap, m->header, m->map_size, size, MMAP_VEC_MREMAP_MAYMOVE);
+#else
+        munmap(m->header, m->map_size);
+        map = mmap(NULL, size, prot, MAP_SHARED, m->fd, 0);
+        if (map == MAP_FAILED)
+        {
+            // The old mapping is gone; leave nothing that points into it
+            m->header = NULL;
+            m->map_size = 0;
+            m->vec = (Vec){.buf = RawVec_new(MMAP_VEC_ALLOCATOR), .len = 0};
+        }
+#endif
+    }
+    if (map == MAP_FAILED)
+    {
+        return false;
+    }
+    m->header = map;
+    m->map_size = size;
+    MmapVec_bind_(m);
+    return true;
+}
+
+bool MmapVec_open_fd_(MmapVec *m, int fd, size_t elem_size, bool read_only)
+{
+    *m = (MmapVec){.fd = fd, .elem_size = elem_size, .read_only = read_only};
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        return false;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size == 0 && !read_only)
+    {
+        // New file: write a header and room for a page worth of elements
+        size_t cap = MMAP_VEC_INITIAL_BYTES / elem_size;
+        cap = cap == 0 ? 1 : cap;
+        size = sizeof(MmapVecHeader) + cap * elem_size;
+        if (ftruncate(fd, (off_t)size) != 0 || !MmapVec_map_(m, size))
+        {
+            return false;
+        }
+        *m->header = (MmapVecHeader){
+            .magic = MMAP_VEC_MAGIC,
+            .version = MMAP_VEC_VERSION,
+            .elem_size = (uint32_t)elem_size,
+            .len = 0,
+            .cap = cap};
+        MmapVec_bind_(m);
+        return true;
+    }
+    if (size < sizeof(MmapVecHeader) || !MmapVec_map_(m, size))
+    {
+        errno = size < sizeof(MmapVecHeader) ? EINVAL : errno;
+        return false;
+    }
+    MmapVecHeader *h = m->header;
+    if (h->magic != MMAP_VEC_MAGIC || h->version != MMAP_VEC_VERSION || h->elem_size != elem_size ||
+        h->cap > (size - sizeof(MmapVecHeader)) / elem_size || h->len > h->cap)
+    {
+        munmap(m->header, m->map_size);
+        m->header = NULL;
+        errno = EINVAL;
+        return false;
+    }
+    return true;
+}
+
+bool MmapVec_open(MmapVec *m, const char *path, size_t elem_size)
+{
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (!MmapVec_open_fd_(m, fd, elem_size, false))
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return false;
+    }
+    return true;
+}
+
+bool MmapVec_open_read_only(MmapVec *m, const char *path, size_t elem_size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (!MmapVec_open_fd_(m, fd, elem_size, true))
+    {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return false;
+    }
+    return true;
+}
+
+bool MmapVec_reserve(MmapVec *m, size_t additional)
+{
+    assert(!m->read_only && m->header != NULL);
+    size_t needed = m->vec.len + additional;
+    size_t cap = m->header->cap;
+    if (needed <= cap)
+    {
+        return true;
+    }
+    while (cap < needed)
+    {
+        cap *= 2;
+    }
+    size_t size = sizeof(MmapVecHeader) + cap * m->elem_size;
+    if (ftruncate(m->fd, (off_t)size) != 0)
+    {
+        return false;
+    }
+    size_t len = m->vec.len;
+    if (!MmapVec_map_(m, size))
+    {
+        return false;
+    }
+    m->header->cap = cap;
+    m->vec.len = len;
+    m->vec.buf.cap = cap;
+    return true;
+}
+
+bool MmapVec_push(MmapVec *m, const void *value)
+{
+    if (m->vec.len == m->vec.buf.cap && !MmapVec_reserve(m, 1))
+    {
+        return false;
+    }
+    memcpy((char *)m->vec.buf.ptr + m->vec.len * m->elem_size, value, m->elem_size);
+    m->vec.len++;
+    __atomic_store_n(&m->header->len, m->vec.len, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool MmapVec_extend(MmapVec *m, const void *values, size_t count)
+{
+    if (!MmapVec_reserve(m, count))
+    {
+        return false;
+    }
+    memcpy((char *)m->vec.buf.ptr + m->vec.len * m->elem_size, values, count * m->elem_size);
+    m->vec.len += count;
+    __atomic_store_n(&m->header->len, m->vec.len, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool MmapVec_sync(MmapVec *m, bool async)
+{
+    if (m->read_only)
+    {
+        return true;
+    }
+    __atomic_store_n(&m->header->len, m->vec.len, __ATOMIC_RELEASE);
+    return msync(m->header, m->map_size, async ? MS_ASYNC : MS_SYNC) == 0;
+}
+
+bool MmapVec_refresh(MmapVec *m)
+{
+    struct stat st;
+    if (fstat(m->fd, &st) != 0)
+    {
+        return false;
+    }
+    if ((size_t)st.st_size != m->map_size)
+    {
+        return MmapVec_map_(m, (size_t)st.st_size);
+    }
+    MmapVec_bind_(m);
+    return true;
+}
+
+bool MmapVec_advise(MmapVec *m, MmapVecAdvice advice)
+{
+    int flag = MADV_NORMAL;
+    switch (advice)
+    {
+    case MMAP_VEC_SEQUENTIAL:
+        flag = MADV_SEQUENTIAL;
+        break;
+    case MMAP_VEC_RANDOM:
+        flag = MADV_RANDOM;
+        break;
+    case MMAP_VEC_WILLNEED:
+        flag = MADV_WILLNEED;
+        break;
+    default:
+        break;
+    }
+    return madvise(m->header, m->map_size, flag) == 0;
+}
+
+bool MmapVec_close(MmapVec *m)
+{
+    bool ok = true;
+    if (m->header != NULL)
+    {
+        ok = MmapVec_sync(m, false);
+        ok = munmap(m->header, m->map_size) == 0 && ok;
+        m->header = NULL;
+    }
+    if (m->fd >= 0)
+    {
+        ok = close(m->fd) == 0 && ok;
+        m->fd = -1;
+    }
+    m->vec = (Vec){.buf = RawVec_new(MMAP_VEC_ALLOCATOR), .len = 0};
+    return ok;
+}
+
+#endif // MMAP_VEC_IMPLEMENTATION
@@ -1,10 +1,442 @@
 #ifndef _PTR_H_INCLUDED_
 #define _PTR_H_INCLUDED_
 
+/**
+ * Getters, clones and reference counts are static inline. The rest is
+ * emitted by the translation unit that defines PTR_IMPLEMENTATION; the
+ * program also needs ALLOC_IMPLEMENTATION in one unit.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include "alloc.h"
+
+// A typed owning pointer with no operations; see Box for one that allocates and drops
 #define Unique(T)             \
     typedef struct Unique_##T \
     {                         \
         T *ptr;               \
-    };
+    } Unique_##T;
+
+/**
+ * How to drop and clone a pointee. `drop` releases whatever the value owns
+ * (not the value's own storage); `clone` writes a deep copy of `src` into
+ * `dst`. A NULL `ops`, or a NULL member, means the value owns nothing and is
+ * copied with memcpy.
+ */
+typedef struct
+{
+    void (*drop)(void *value);
+    void (*clone)(void *dst, const void *src);
+} PtrOps;
+
+static inline void Ptr_drop_value_(const PtrOps *ops, void *value)
+{
+    if (ops != NULL && ops->drop != NULL)
+    {
+        ops->drop(value);
+    }
+}
+
+static inline void Ptr_clone_value_(const PtrOps *ops, void *dst, const void *src, size_t size)
+{
+    if (ops != NULL && ops->clone != NULL)
+    {
+        ops->clone(dst, src);
+    }
+    else
+    {
+        memcpy(dst, src, size);
+    }
+}
+
+// Round a header size up so the value after it is suitably aligned for any type
+#define PTR_VALUE_OFFSET_(header) \
+    ((sizeof(header) + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1))
+
+/**
+ * A uniquely owned heap value. Box_new moves `size` bytes into one
+ * allocation from `alloc`; Box_drop runs the value's drop and frees it.
+ */
+typedef struct
+{
+    void *ptr;
+    size_t size;
+    const PtrOps *ops;
+    Allocator alloc;
+} Box;
+
+// Move `size` bytes at `value` into a new Box
+Box Box_new(const void *value, size_t size, const PtrOps *ops, Allocator alloc);
+
+// Get a pointer to the boxed value
+static inline void *Box_get(const Box *box)
+{
+    return box->ptr;
+}
+
+// Deep-copy the value into a new Box
+Box Box_clone(const Box *box);
+
+// Drop the value and free its storage
+void Box_drop(Box *box);
+
+/**
+ * Rc and Arc keep their counts in a header placed in the same allocation
+ * as the value. `weak` counts weak references plus one shared by all
+ * strong references, so the allocation is freed when it reaches zero and
+ * the value is dropped when `strong` does.
+ */
+typedef struct
+{
+    size_t strong;
+    size_t weak;
+    size_t size;
+    const PtrOps *ops;
+    Allocator alloc;
+} RcInner;
+
+// A single-threaded reference-counted pointer
+typedef struct
+{
+    RcInner *inner;
+} Rc;
+
+// A non-owning reference to an Rc's value; upgrade it to use the value
+typedef struct
+{
+    RcInner *inner;
+} RcWeak;
+
+static inline void *RcInner_value_(const RcInner *inner)
+{
+    return (char *)inner + PTR_VALUE_OFFSET_(RcInner);
+}
+
+// Move `size` bytes at `value` into a new Rc with a strong count of one
+Rc Rc_new(const void *value, size_t size, const PtrOps *ops, Allocator alloc);
+
+// Get a pointer to the shared value
+static inline void *Rc_get(const Rc *rc)
+{
+    return RcInner_value_(rc->inner);
+}
+
+// Share the value: another strong reference
+static inline Rc Rc_clone(const Rc *rc)
+{
+    rc->inner->strong++;
+    return *rc;
+}
+
+static inline size_t Rc_strong_count(const Rc *rc)
+{
+    return rc->inner->strong;
+}
+
+static inline size_t Rc_weak_count(const Rc *rc)
+{
+    return rc->inner->weak - 1;
+}
+
+void RcWeak_drop(RcWeak *weak);
+
+// Release a strong reference, dropping the value with the last one
+void Rc_drop(Rc *rc);
+
+// Make a weak reference that does not keep the value alive
+static inline RcWeak Rc_downgrade(const Rc *rc)
+{
+    rc->inner->weak++;
+    return (RcWeak){rc->inner};
+}
+
+// Get a strong reference if the value is still alive
+bool RcWeak_upgrade(const RcWeak *weak, Rc *out);
+
+/**
+ * Get a mutable pointer to the value, cloning it into a fresh Rc first if
+ * other strong references share it. With only weak references left the
+ * value is moved out instead, and those weak references stop upgrading.
+ */
+void *Rc_make_mut(Rc *rc);
+
+// The atomic counterpart of RcInner
+typedef struct
+{
+    atomic_size_t strong;
+    atomic_size_t weak;
+    size_t size;
+    const PtrOps *ops;
+    Allocator alloc;
+} ArcInner;
+
+/**
+ * A reference-counted pointer that can be shared between threads. Count
+ * increments are relaxed, since a thread can only clone a reference it
+ * already holds; decrements are release, and the thread that drops the
+ * last reference then does an acquire load so every other thread's use of
+ * the value happens before it is dropped.
+ */
+typedef struct
+{
+    ArcInner *inner;
+} Arc;
+
+typedef struct
+{
+    ArcInner *inner;
+} ArcWeak;
+
+static inline void *ArcInner_value_(const ArcInner *inner)
+{
+    return (char *)inner + PTR_VALUE_OFFSET_(ArcInner);
+}
+
+// Move `size` bytes at `value` into a new Arc with a strong count of one
+Arc Arc_new(const void *value, size_t size, const PtrOps *ops, Allocator alloc);
+
+// Get a pointer to the shared value
+static inline void *Arc_get(const Arc *arc)
+{
+    return ArcInner_value_(arc->inner);
+}
+
+// Share the value: another strong reference
+static inline Arc Arc_clone(const Arc *arc)
+{
+    size_t old = atomic_fetch_add_explicit(&arc->inner->strong, 1, memory_order_relaxed);
+    assert(old > 0 && old < SIZE_MAX / 2);
+    (void)old;
+    return *arc;
+}
+
+static inline size_t Arc_strong_count(const Arc *arc)
+{
+    return atomic_load_explicit(&arc->inner->strong, memory_order_acquire);
+}
+
+static inline size_t Arc_weak_count(const Arc *arc)
+{
+    return atomic_load_explicit(&arc->inner->weak, memory_order_acquire) - 1;
+}
+
+void ArcWeak_drop(ArcWeak *weak);
+
+// Release a strong reference, dropping the value with the last one
+void Arc_drop(Arc *arc);
+
+// Make a weak reference that does not keep the value alive
+static inline ArcWeak Arc_downgrade(const Arc *arc)
+{
+    atomic_fetch_add_explicit(&arc->inner->weak, 1, memory_order_relaxed);
+    return (ArcWeak){arc->inner};
+}
+
+// Get a strong reference if the value is still alive
+bool ArcWeak_upgrade(const ArcWeak *weak, Arc *out);
+
+/**
+ * Get a mutable pointer to the value, cloning it into a fresh Arc only if
+ * other strong references share it. A sole owner gets the value in place;
+ * if weak references remain the value is moved to a new allocation so they
+ * can no longer upgrade and observe the writes.
+ */
+void *Arc_make_mut(Arc *arc);
 
 #endif // _PTR_H_INCLUDED_
+
+#if defined(PTR_IMPLEMENTATION) && !defined(_PTR_IMPLEMENTATION_INCLUDED_)
+#define _PTR_IMPLEMENTATION_INCLUDED_
+
+Box Box_new(const void *value, size_t size, const PtrOps *ops, Allocator alloc)
+{
+    void *ptr = alloc.allocate(size > 0 ? size : 1);
+    assert(ptr != NULL);
+    memcpy(ptr, value, size);
+    return (Box){.ptr = ptr, .size = size, .ops = ops, .alloc = alloc};
+}
+
+Box Box_clone(const Box *box)
+{
+    void *ptr = box->alloc.allocate(box->size > 0 ? box->size : 1);
+    assert(ptr != NULL);
+    Ptr_clone_value_(box->ops, ptr, box->ptr, box->size);
+    return (Box){.ptr = ptr, .size = box->size, .ops = box->ops, .alloc = box->alloc};
+}
+
+void Box_drop(Box *box)
+{
+    if (box->ptr != NULL)
+    {
+        Ptr_drop_value_(box->ops, box->ptr);
+        box->alloc.deallocate(box->ptr);
+        box->ptr = NULL;
+    }
+}
+
+Rc Rc_new(const void *value, size_t size, const PtrOps *ops, Allocator alloc)
+{
+    RcInner *inner = alloc.allocate(PTR_VALUE_OFFSET_(RcInner) + size);
+    assert(inner != NULL);
+    *inner = (RcInner){.strong = 1, .weak = 1, .size = size, .ops = ops, .alloc = alloc};
+    memcpy(RcInner_value_(inner), value, size);
+    return (Rc){inner};
+}
+
+void RcWeak_drop(RcWeak *weak)
+{
+    if (weak->inner != NULL && --weak->inner->weak == 0)
+    {
+        weak->inner->alloc.deallocate(weak->inner);
+    }
+    weak->inner = NULL;
+}
+
+void Rc_drop(Rc *rc)
+{
+    RcInner *inner = rc->inner;
+    if (inner == NULL)
+    {
+        return;
+    }
+    rc->inner = NULL;
+    if (--inner->strong == 0)
+    {
+        Ptr_drop_value_(inner->ops, RcInner_value_(inner));
+        RcWeak_drop(&(RcWeak){inner});
+    }
+}
+
+bool RcWeak_upgrade(const RcWeak *weak, Rc *out)
+{
+    if (weak->inner == NULL || weak->inner->strong == 0)
+    {
+        return false;
+    }
+    weak->inner->strong++;
+    *out = (Rc){weak->inner};
+    return true;
+}
+
+void *Rc_make_mut(Rc *rc)
+{
+    RcInner *inner = rc->inner;
+    if (inner->strong > 1)
+    {
+        RcInner *copy = inner->alloc.allocate(PTR_VALUE_OFFSET_(RcInner) + inner->size);
+        assert(copy != NULL);
+        *copy = (RcInner){.strong = 1, .weak = 1, .size = inner->size, .ops = inner->ops, .alloc = inner->alloc};
+        Ptr_clone_value_(inner->ops, RcInner_value_(copy), RcInner_value_(inner), inner->size);
+        inner->strong--;
+        rc->inner = copy;
+    }
+    else if (inner->weak > 1)
+    {
+        Rc moved = Rc_new(RcInner_value_(inner), inner->size, inner->ops, inner->alloc);
+        inner->strong = 0;
+        RcWeak_drop(&(RcWeak){inner});
+        *rc = moved;
+    }
+    return Rc_get(rc);
+}
+
+ArcInner *ArcInner_new_(size_t size, const PtrOps *ops, Allocator alloc)
+{
+    ArcInner *inner = alloc.allocate(PTR_VALUE_OFFSET_(ArcInner) + size);
+    assert(inner != NULL);
+    atomic_init(&inner->strong, 1);
+    atomic_init(&inner->weak, 1);
+    inner->size = size;
+    inner->ops = ops;
+    inner->alloc = alloc;
+    return inner;
+}
+
+Arc Arc_new(const void *value, size_t size, const PtrOps *ops, Allocator alloc)
+{
+    ArcInner *inner = ArcInner_new_(size, ops, alloc);
+    memcpy(ArcInner_value_(inner), value, size);
+    return (Arc){inner};
+}
+
+void ArcWeak_drop(ArcWeak *weak)
+{
+    ArcInner *inner = weak->inner;
+    weak->inner = NULL;
+    if (inner != NULL && atomic_fetch_sub_explicit(&inner->weak, 1, memory_order_release) == 1)
+    {
+        // An acquire load rather than a fence, which ThreadSanitizer does not model
+        (void)atomic_load_explicit(&inner->weak, memory_order_acquire);
+        inner->alloc.deallocate(inner);
+    }
+}
+
+void Arc_drop(Arc *arc)
+{
+    ArcInner *inner = arc->inner;
+    if (inner == NULL)
+    {
+        return;
+    }
+    arc->inner = NULL;
+    if (atomic_fetch_sub_explicit(&inner->strong, 1, memory_order_release) == 1)
+    {
+        (void)atomic_load_explicit(&inner->strong, memory_order_acquire);
+        Ptr_drop_value_(inner->ops, ArcInner_value_(inner));
+        ArcWeak_drop(&(ArcWeak){inner});
+    }
+}
+
+bool ArcWeak_upgrade(const ArcWeak *weak, Arc *out)
+{
+    if (weak->inner == NULL)
+    {
+        return false;
+    }
+    size_t strong = atomic_load_explicit(&weak->inner->strong, memory_order_relaxed);
+    do
+    {
+        if (strong == 0)
+        {
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&weak->inner->strong, &strong, strong + 1,
+                                                    memory_order_acquire, memory_order_relaxed));
+    *out = (Arc){weak->inner};
+    return true;
+}
+
+void *Arc_make_mut(Arc *arc)
+{
+    ArcInner *inner = arc->inner;
+    size_t one = 1;
+    if (!atomic_compare_exchange_strong_explicit(&inner->strong, &one, 0, memory_order_acquire, memory_order_relaxed))
+    {
+        // Shared: clone, then release our reference to the original
+        ArcInner *copy = ArcInner_new_(inner->size, inner->ops, inner->alloc);
+        Ptr_clone_value_(inner->ops, ArcInner_value_(copy), ArcInner_value_(inner), inner->size);
+        Arc_drop(arc);
+        arc->inner = copy;
+        return ArcInner_value_(copy);
+    }
+    // Strong count is now 0, so no weak reference can upgrade
+    if (atomic_load_explicit(&inner->weak, memory_order_acquire) == 1)
+    {
+        atomic_store_explicit(&inner->strong, 1, memory_order_release);
+        return ArcInner_value_(inner);
+    }
+    ArcInner *moved = ArcInner_new_(inner->size, inner->ops, inner->alloc);
+    memcpy(ArcInner_value_(moved), ArcInner_value_(inner), inner->size);
+    ArcWeak_drop(&(ArcWeak){inner});
+    arc->inner = moved;
+    return ArcInner_value_(moved);
+}
+
+#endif // PTR_IMPLEMENTATION
@@ -0,0 +1,542 @@
+#ifndef _PVEC_H_INCLUDED_
+#define _PVEC_H_INCLUDED_
+
+/**
+ * Reads and the transient wrappers are static inline; path copying and
+ * the rest are emitted where PVEC_IMPLEMENTATION is defined. One unit
+ * also defines ALLOC_, RAWVEC_ and VEC_IMPLEMENTATION.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdalign.h>
+#include "alloc.h"
+#include "vec.h"
+
+#define PVEC_BITS 5
+#define PVEC_WIDTH (1u << PVEC_BITS)
+#define PVEC_MASK (PVEC_WIDTH - 1)
+
+/**
+ * A trie node, shared between versions and freed when its last reference
+ * goes. Internal nodes hold PVEC_WIDTH child pointers (NULL where absent);
+ * leaves hold PVEC_WIDTH elements. Reference counts are not atomic, so
+ * versions that share nodes must stay on one thread.
+ */
+typedef struct
+{
+    size_t refs;
+} PVecNode;
+
+// Offset of a node's children or elements, aligned for any element type
+#define PVEC_DATA_OFFSET_ \
+    ((sizeof(PVecNode) + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1))
+
+/**
+ * A persistent vector: a 32-way radix trie of full leaves plus a tail leaf
+ * holding the last 1 to 32 elements. PVec_push, PVec_set and PVec_pop
+ * leave their input untouched and return a new version that shares every
+ * node off the modified path; both versions must be dropped.
+ *
+ * For bulk edits, PVec_transient returns a version whose transient_*
+ * operations modify it in place: a node is copied the first time it is
+ * written while shared, and from then on written directly. PVec_persistent
+ * ends the batch.
+ */
+typedef struct
+{
+    PVecNode *root;
+    PVecNode *tail;
+    size_t len;
+    // Bit position of the root's index digit; PVEC_BITS when its children are leaves
+    unsigned shift;
+    bool transient;
+    size_t elem_size;
+    Allocator alloc;
+} PVec;
+
+// The nodes and bytes in a version, and how many of them another version shares
+typedef struct
+{
+    size_t nodes;
+    size_t bytes;
+    size_t shared_nodes;
+    size_t shared_bytes;
+} PVecMemory;
+
+static inline char *PVec_data_(const PVecNode *node)
+{
+    return (char *)node + PVEC_DATA_OFFSET_;
+}
+
+static inline PVecNode **PVec_children_(const PVecNode *node)
+{
+    return (PVecNode **)PVec_data_(node);
+}
+
+// Size of a node; level 0 is a leaf
+static inline size_t PVec_node_bytes_(const PVec *v, unsigned level)
+{
+    return PVEC_DATA_OFFSET_ + PVEC_WIDTH * (level == 0 ? v->elem_size : sizeof(PVecNode *));
+}
+
+static inline size_t PVec_tail_offset_(size_t len)
+{
+    return len == 0 ? 0 : ((len - 1) >> PVEC_BITS) << PVEC_BITS;
+}
+
+// Create an empty PVec of `elem_size`-byte elements
+PVec PVec_new(size_t elem_size, Allocator alloc);
+
+static inline size_t PVec_len(const PVec *v)
+{
+    return v->len;
+}
+
+static inline bool PVec_is_empty(const PVec *v)
+{
+    return v->len == 0;
+}
+
+// The leaf holding the element at `index`
+static inline PVecNode *PVec_leaf_(const PVec *v, size_t index)
+{
+    if (index >= PVec_tail_offset_(v->len))
+    {
+        return v->tail;
+    }
+    PVecNode *node = v->root;
+    for (unsigned level = v->shift; level > 0; level -= PVEC_BITS)
+    {
+        node = PVec_children_(node)[(index >> level) & PVEC_MASK];
+    }
+    return node;
+}
+
+// Get a pointer to the element at the given index; it must not be written through
+static inline const void *PVec_get(const PVec *v, size_t index)
+{
+    assert(index < v->len);
+    return PVec_data_(PVec_leaf_(v, index)) + (index & PVEC_MASK) * v->elem_size;
+}
+
+// Another version sharing every node with `v`
+PVec PVec_clone(const PVec *v);
+
+void PVec_push_(PVec *v, const void *value);
+
+void PVec_set_(PVec *v, size_t index, const void *value);
+
+bool PVec_pop_(PVec *v, void *out);
+
+// A new version with `value` appended
+PVec PVec_push(const PVec *v, const void *value);
+
+// A new version with the element at `index` replaced by `value`
+PVec PVec_set(const PVec *v, size_t index, const void *value);
+
+// A new version without the last element, which is copied to `out` if that is not NULL
+PVec PVec_pop(const PVec *v, void *out);
+
+// Start a batch of in-place edits on a new version of `v`
+PVec PVec_transient(const PVec *v);
+
+static inline void PVec_transient_push(PVec *t, const void *value)
+{
+    assert(t->transient);
+    PVec_push_(t, value);
+}
+
+static inline void PVec_transient_set(PVec *t, size_t index, const void *value)
+{
+    assert(t->transient);
+    PVec_set_(t, index, value);
+}
+
+static inline bool PVec_transient_pop(PVec *t, void *out)
+{
+    assert(t->transient);
+    return PVec_pop_(t, out);
+}
+
+// End a batch of edits; the result is an ordinary persistent version
+PVec PVec_persistent(PVec *t);
+
+// Copy every element into a new Vec
+Vec PVec_to_vec(const PVec *v);
+
+/**
+ * Count the nodes and bytes making up `v`, and how many of them are also
+ * part of `other` (which may be NULL) and so are not paid for twice.
+ */
+PVecMemory PVec_memory(const PVec *v, const PVec *other);
+
+// Drop this version's references; nodes still used by other versions survive
+void PVec_drop(PVec *v);
+
+#endif // _PVEC_H_INCLUDED_
+
+#if defined(PVEC_IMPLEMENTATION) && !defined(_PVEC_IMPLEMENTATION_INCLUDED_)
+#define _PVEC_IMPLEMENTATION_INCLUDED_
+
+PVec PVec_new(size_t elem_size, Allocator alloc)
+{
+    return (PVec){
+        .root = NULL,
+        .tail = NULL,
+        .len = 0,
+        .shift = PVEC_BITS,
+        .transient = false,
+        .elem_size = elem_size,
+        .alloc = alloc};
+}
+
+PVecNode *PVec_node_new_(const PVec *v, unsigned level)
+{
+    size_t bytes = PVec_node_bytes_(v, level);
+    PVecNode *node = v->alloc.allocate(bytes);
+    assert(node != NULL);
+    node->refs = 1;
+    if (level > 0)
+    {
+        memset(PVec_data_(node), 0, bytes - PVEC_DATA_OFFSET_);
+    }
+    return node;
+}
+
+// Drop one reference to `node`, freeing the subtree when it was the last
+void PVec_node_release_(const PVec *v, PVecNode *node, unsigned level)
+{
+    if (node == NULL || --node->refs > 0)
+    {
+        return;
+    }
+    if (level > 0)
+    {
+        PVecNode **children = PVec_children_(node);
+        for (unsigned i = 0; i < PVEC_WIDTH; i++)
+        {
+            PVec_node_release_(v, children[i], level - PVEC_BITS);
+        }
+    }
+    v->alloc.deallocate(node);
+}
+
+/**
+ * Make `node` safe to write: return it as is when this reference is the
+ * only one, otherwise give up the reference and return a private copy.
+ */
+PVecNode *PVec_node_own_(const PVec *v, PVecNode *node, unsigned level)
+{
+    if (node->refs == 1)
+    {
+        return node;
+    }
+    PVecNode *copy = PVec_node_new_(v, level);
+    memcpy(PVec_data_(copy), PVec_data_(node), PVec_node_bytes_(v, level) - PVEC_DATA_OFFSET_);
+    if (level > 0)
+    {
+        PVecNode **children = PVec_children_(copy);
+        for (unsigned i = 0; i < PVEC_WIDTH; i++)
+        {
+            if (children[i] != NULL)
+            {
+                children[i]->refs++;
+            }
+        }
+    }
+    node->refs--;
+    return copy;
+}
+
+PVec PVec_clone(const PVec *v)
+{
+    if (v->root != NULL)
+    {
+        v->root->refs++;
+    }
+    if (v->tail != NULL)
+    {
+        v->tail->refs++;
+    }
+    PVec copy = *v;
+    copy.transient = false;
+    return copy;
+}
+
+// A chain of single-child nodes from `level` down to `leaf`
+PVecNode *PVec_new_path_(const PVec *v, unsigned level, PVecNode *leaf)
+{
+    if (level == 0)
+    {
+        return leaf;
+    }
+    PVecNode *node = PVec_node_new_(v, level);
+    PVec_children_(node)[0] = PVec_new_path_(v, level - PVEC_BITS, leaf);
+    return node;
+}
+
+// Hang the full tail under `node` (NULL for a new node) at the position for index len - 1
+PVecNode *PVec_push_tail_(const PVec *v, PVecNode *node, unsigned level, PVecNode *tail)
+{
+    node = node == NULL ? PVec_node_new_(v, level) : PVec_node_own_(v, node, level);
+    PVecNode **children = PVec_children_(node);
+    size_t i = ((v->len - 1) >> level) & PVEC_MASK;
+    if (level == PVEC_BITS)
+    {
+        children[i] = tail;
+    }
+    else if (children[i] != NULL)
+    {
+        children[i] = PVec_push_tail_(v, children[i], level - PVEC_BITS, tail);
+    }
+    else
+    {
+        children[i] = PVec_new_path_(v, level - PVEC_BITS, tail);
+    }
+    return node;
+}
+
+// Detach the last leaf below `node`, returning the node or NULL if it became empty
+PVecNode *PVec_pop_tail_(const PVec *v, PVecNode *node, unsigned level)
+{
+    node = PVec_node_own_(v, node, level);
+    PVecNode **children = PVec_children_(node);
+    size_t i = ((v->len - 2) >> level) & PVEC_MASK;
+    if (level > PVEC_BITS)
+    {
+        children[i] = PVec_pop_tail_(v, children[i], level - PVEC_BITS);
+    }
+    else
+    {
+        PVec_node_release_(v, children[i], 0);
+        children[i] = NULL;
+    }
+    if (i == 0 && children[0] == NULL)
+    {
+        v->alloc.deallocate(node);
+        return NULL;
+    }
+    return node;
+}
+
+void PVec_push_(PVec *v, const void *value)
+{
+    size_t in_tail = v->len - PVec_tail_offset_(v->len);
+    if (v->tail != NULL && in_tail == PVEC_WIDTH)
+    {
+        // Move the full tail into the trie, growing a level when the root is full
+        if ((v->len >> PVEC_BITS) > ((size_t)1 << v->shift))
+        {
+            PVecNode *root = PVec_node_new_(v, v->shift + PVEC_BITS);
+            PVec_children_(root)[0] = v->root;
+            PVec_children_(root)[1] = PVec_new_path_(v, v->shift, v->tail);
+            v->root = root;
+            v->shift += PVEC_BITS;
+        }
+        else
+        {
+            v->root = PVec_push_tail_(v, v->root, v->shift, v->tail);
+        }
+        v->tail = NULL;
+        in_tail = 0;
+    }
+    if (v->tail == NULL)
+    {
+        v->tail = PVec_node_new_(v, 0);
+        in_tail = 0;
+    }
+    else
+    {
+        v->tail = PVec_node_own_(v, v->tail, 0);
+    }
+    memcpy(PVec_data_(v->tail) + in_tail * v->elem_size, value, v->elem_size);
+    v->len++;
+}
+
+void PVec_set_(PVec *v, size_t index, const void *value)
+{
+    assert(index < v->len);
+    PVecNode **slot = &v->tail;
+    unsigned level = 0;
+    if (index < PVec_tail_offset_(v->len))
+    {
+        slot = &v->root;
+        for (level = v->shift; level > 0; level -= PVEC_BITS)
+        {
+            *slot = PVec_node_own_(v, *slot, level);
+            slot = &PVec_children_(*slot)[(index >> level) & PVEC_MASK];
+        }
+    }
+    *slot = PVec_node_own_(v, *slot, 0);
+    memcpy(PVec_data_(*slot) + (index & PVEC_MASK) * v->elem_size, value, v->elem_size);
+}
+
+bool PVec_pop_(PVec *v, void *out)
+{
+    if (v->len == 0)
+    {
+        return false;
+    }
+    if (out != NULL)
+    {
+        memcpy(out, PVec_get(v, v->len - 1), v->elem_size);
+    }
+    if (v->len == 1)
+    {
+        PVec_node_release_(v, v->tail, 0);
+        v->tail = NULL;
+    }
+    else if (v->len - PVec_tail_offset_(v->len) == 1)
+    {
+        // The tail empties: the last leaf of the trie becomes the tail
+        PVecNode *leaf = PVec_leaf_(v, v->len - 2);
+        leaf->refs++;
+        PVec_node_release_(v, v->tail, 0);
+        v->tail = leaf;
+        v->root = PVec_pop_tail_(v, v->root, v->shift);
+        if (v->root != NULL && v->shift > PVEC_BITS && PVec_children_(v->root)[1] == NULL)
+        {
+            PVecNode *child = PVec_children_(v->root)[0];
+            child->refs++;
+            PVec_node_release_(v, v->root, v->shift);
+            v->root = child;
+            v->shift -= PVEC_BITS;
+        }
+        if (v->root == NULL)
+        {
+            v->shift = PVEC_BITS;
+        }
+    }
+    v->len--;
+    return true;
+}
+
+PVec PVec_push(const PVec *v, const void *value)
+{
+    PVec next = PVec_clone(v);
+    PVec_push_(&next, value);
+    return next;
+}
+
+PVec PVec_set(const PVec *v, size_t index, const void *value)
+{
+    PVec next = PVec_clone(v);
+    PVec_set_(&next, index, value);
+    return next;
+}
+
+PVec PVec_pop(const PVec *v, void *out)
+{
+    PVec next = PVec_clone(v);
+    PVec_pop_(&next, out);
+    return next;
+}
+
+PVec PVec_transient(const PVec *v)
+{
+    PVec t = PVec_clone(v);
+    t.transient = true;
+    return t;
+}
+
+PVec PVec_persistent(PVec *t)
+{
+    assert(t->transient);
+    t->transient = false;
+    return *t;
+}
+
+Vec PVec_to_vec(const PVec *v)
+{
+    Vec out = Vec_with_capacity(v->len, v->elem_size);
+    size_t tail_offset = PVec_tail_offset_(v->len);
+    for (size_t i = 0; i < tail_offset; i += PVEC_WIDTH)
+    {
+        memcpy((char *)out.buf.ptr + i * v->elem_size, PVec_data_(PVec_leaf_(v, i)), PVEC_WIDTH * v->elem_size);
+    }
+    if (v->tail != NULL)
+    {
+        memcpy((char *)out.buf.ptr + tail_offset * v->elem_size, PVec_data_(v->tail),
+               (v->len - tail_offset) * v->elem_size);
+    }
+    out.len = v->len;
+    return out;
+}
+
+static int PVec_compare_ptr_(const void *a, const void *b)
+{
+    uintptr_t x = *(const uintptr_t *)a, y = *(const uintptr_t *)b;
+    return (x > y) - (x < y);
+}
+
+void PVec_collect_nodes_(const PVec *v, PVecNode *node, unsigned level, Vec *out)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+    Vec_push(out, &node, sizeof(node));
+    if (level > 0)
+    {
+        for (unsigned i = 0; i < PVEC_WIDTH; i++)
+        {
+            PVec_collect_nodes_(v, PVec_children_(node)[i], level - PVEC_BITS, out);
+        }
+    }
+}
+
+void PVec_count_nodes_(const PVec *v, PVecNode *node, unsigned level, const Vec *shared, PVecMemory *m)
+{
+    if (node == NULL)
+    {
+        return;
+    }
+    size_t bytes = PVec_node_bytes_(v, level);
+    m->nodes++;
+    m->bytes += bytes;
+    if (shared->len > 0 && bsearch(&node, shared->buf.ptr, shared->len, sizeof(node), PVec_compare_ptr_) != NULL)
+    {
+        m->shared_nodes++;
+        m->shared_bytes += bytes;
+    }
+    if (level > 0)
+    {
+        for (unsigned i = 0; i < PVEC_WIDTH; i++)
+        {
+            PVec_count_nodes_(v, PVec_children_(node)[i], level - PVEC_BITS, shared, m);
+        }
+    }
+}
+
+PVecMemory PVec_memory(const PVec *v, const PVec *other)
+{
+    Vec shared = Vec_new();
+    if (other != NULL)
+    {
+        PVec_collect_nodes_(other, other->root, other->shift, &shared);
+        PVec_collect_nodes_(other, other->tail, 0, &shared);
+        qsort(shared.buf.ptr, shared.len, sizeof(PVecNode *), PVec_compare_ptr_);
+    }
+    PVecMemory m = {0, 0, 0, 0};
+    PVec_count_nodes_(v, v->root, v->shift, &shared, &m);
+    PVec_count_nodes_(v, v->tail, 0, &shared, &m);
+    Vec_drop(&shared);
+    return m;
+}
+
+void PVec_drop(PVec *v)
+{
+    PVec_node_release_(v, v->root, v->shift);
+    PVec_node_release_(v, v->tail, 0);
+    v->root = NULL;
+    v->tail = NULL;
+    v->len = 0;
+    v->shift = PVEC_BITS;
+}
+
+#endif // PVEC_IMPLEMENTATION
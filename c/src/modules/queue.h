@@ -0,0 +1,485 @@
+#ifndef _QUEUE_H_INCLUDED_
+#define _QUEUE_H_INCLUDED_
+
+/**
+ * Push and pop are static inline. Construction and the batch
+ * operations are emitted where QUEUE_IMPLEMENTATION is defined; one unit
+ * also defines ALLOC_ and RAWVEC_IMPLEMENTATION.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "rawvec.h"
+
+#define QUEUE_CACHE_LINE 64
+#define QUEUE_SPIN_ROUNDS 128
+
+static inline void Queue_cpu_relax_(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Back off while a blocking push/pop waits: spin first, then yield the CPU
+static inline void Queue_backoff_(size_t *rounds)
+{
+    if (++*rounds < QUEUE_SPIN_ROUNDS)
+    {
+        Queue_cpu_relax_();
+    }
+    else
+    {
+        sched_yield();
+    }
+}
+
+// Round a requested capacity up to a power of two (at least 2)
+size_t Queue_round_capacity(size_t capacity);
+
+/**
+ * Wait-free single-producer/single-consumer ring buffer. The producer and
+ * consumer indices sit on their own cache lines, and each side keeps a cached
+ * copy of the other side's index so the shared line is only read when the
+ * queue looks full (or empty). The struct is aligned to the cache line so the
+ * read-only fields after the padding never share a line with `head`; place
+ * heap copies with aligned_alloc.
+ */
+typedef struct
+{
+    _Alignas(QUEUE_CACHE_LINE) atomic_size_t tail;
+    size_t cached_head;
+    char pad_producer[QUEUE_CACHE_LINE - 2 * sizeof(size_t)];
+    atomic_size_t head;
+    size_t cached_tail;
+    char pad_consumer[QUEUE_CACHE_LINE - 2 * sizeof(size_t)];
+    RawVec buf;
+    size_t mask;
+    size_t elem_size;
+} SpscQueue;
+
+// Create an SPSC queue holding at least `capacity` elements of `elem_size` bytes
+SpscQueue SpscQueue_new(size_t capacity, size_t elem_size, Allocator alloc);
+
+// Get the capacity of the queue
+static inline size_t SpscQueue_capacity(const SpscQueue *q)
+{
+    return q->mask + 1;
+}
+
+// Get the number of queued elements (a snapshot when called concurrently)
+static inline size_t SpscQueue_len(SpscQueue *q)
+{
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&q->head, memory_order_acquire);
+    return tail - head;
+}
+
+/**
+ * Push up to `count` elements (producer only) and publish them with a single
+ * release store. Returns the number of elements pushed.
+ */
+size_t SpscQueue_push_batch(SpscQueue *q, const void *values, size_t count);
+
+/**
+ * Pop up to `max` elements into `out` (consumer only) and release their slots
+ * with a single store. Returns the number of elements popped.
+ */
+size_t SpscQueue_pop_batch(SpscQueue *q, void *out, size_t max);
+
+// Push one element if there is room (producer only)
+static inline bool SpscQueue_try_push(SpscQueue *q, const void *value)
+{
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (tail - q->cached_head > q->mask)
+    {
+        q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (tail - q->cached_head > q->mask)
+        {
+            return false;
+        }
+    }
+    memcpy((char *)q->buf.ptr + (tail & q->mask) * q->elem_size, value, q->elem_size);
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// Pop one element if the queue is not empty (consumer only)
+static inline bool SpscQueue_try_pop(SpscQueue *q, void *out)
+{
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (head == q->cached_tail)
+    {
+        q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (head == q->cached_tail)
+        {
+            return false;
+        }
+    }
+    memcpy(out, (char *)q->buf.ptr + (head & q->mask) * q->elem_size, q->elem_size);
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return true;
+}
+
+// Push one element, waiting while the queue is full
+static inline void SpscQueue_push(SpscQueue *q, const void *value)
+{
+    size_t rounds = 0;
+    while (!SpscQueue_try_push(q, value))
+    {
+        Queue_backoff_(&rounds);
+    }
+}
+
+// Pop one element, waiting while the queue is empty
+static inline void SpscQueue_pop(SpscQueue *q, void *out)
+{
+    size_t rounds = 0;
+    while (!SpscQueue_try_pop(q, out))
+    {
+        Queue_backoff_(&rounds);
+    }
+}
+
+// Free the memory used by the queue
+void SpscQueue_drop(SpscQueue *q);
+
+/**
+ * Bounded multi-producer/multi-consumer queue (Vyukov). Every slot carries a
+ * sequence number that tells producers and consumers whose turn it is, so a
+ * push or pop costs one CAS on the shared index plus one release store.
+ * Slots are laid out as [sequence | element] with `stride` bytes each. Aligned
+ * to the cache line like SpscQueue.
+ */
+typedef struct
+{
+    _Alignas(QUEUE_CACHE_LINE) atomic_size_t enqueue_pos;
+    char pad_enqueue[QUEUE_CACHE_LINE - sizeof(size_t)];
+    atomic_size_t dequeue_pos;
+    char pad_dequeue[QUEUE_CACHE_LINE - sizeof(size_t)];
+    RawVec buf;
+    size_t mask;
+    size_t elem_size;
+    size_t stride;
+} MpmcQueue;
+
+static inline atomic_size_t *MpmcQueue_seq_(const MpmcQueue *q, size_t pos)
+{
+    return (atomic_size_t *)((char *)q->buf.ptr + (pos & q->mask) * q->stride);
+}
+
+static inline void *MpmcQueue_slot_(const MpmcQueue *q, size_t pos)
+{
+    return (char *)q->buf.ptr + (pos & q->mask) * q->stride + sizeof(atomic_size_t);
+}
+
+// Create an MPMC queue holding at least `capacity` elements of `elem_size` bytes
+MpmcQueue MpmcQueue_new(size_t capacity, size_t elem_size, Allocator alloc);
+
+// Get the capacity of the queue
+static inline size_t MpmcQueue_capacity(const MpmcQueue *q)
+{
+    return q->mask + 1;
+}
+
+// Get the number of queued elements (a snapshot when called concurrently)
+static inline size_t MpmcQueue_len(MpmcQueue *q)
+{
+    size_t enqueue = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    size_t dequeue = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    return enqueue > dequeue ? enqueue - dequeue : 0;
+}
+
+// Push one element if there is room
+static inline bool MpmcQueue_try_push(MpmcQueue *q, const void *value)
+{
+    size_t pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+    for (;;)
+    {
+        size_t seq = atomic_load_explicit(MpmcQueue_seq_(q, pos), memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&q->enqueue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (dif < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&q->enqueue_pos, memory_order_relaxed);
+        }
+    }
+    memcpy(MpmcQueue_slot_(q, pos), value, q->elem_size);
+    atomic_store_explicit(MpmcQueue_seq_(q, pos), pos + 1, memory_order_release);
+    return true;
+}
+
+// Pop one element if the queue is not empty
+static inline bool MpmcQueue_try_pop(MpmcQueue *q, void *out)
+{
+    size_t pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+    for (;;)
+    {
+        size_t seq = atomic_load_explicit(MpmcQueue_seq_(q, pos), memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (dif == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&q->dequeue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (dif < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&q->dequeue_pos, memory_order_relaxed);
+        }
+    }
+    memcpy(out, MpmcQueue_slot_(q, pos), q->elem_size);
+    atomic_store_explicit(MpmcQueue_seq_(q, pos), pos + q->mask + 1, memory_order_release);
+    return true;
+}
+
+// Push one element, waiting while the queue is full
+static inline void MpmcQueue_push(MpmcQueue *q, const void *value)
+{
+    size_t rounds = 0;
+    while (!MpmcQueue_try_push(q, value))
+    {
+        Queue_backoff_(&rounds);
+    }
+}
+
+// Pop one element, waiting while the queue is empty
+static inline void MpmcQueue_pop(MpmcQueue *q, void *out)
+{
+    size_t rounds = 0;
+    while (!MpmcQueue_try_pop(q, out))
+    {
+        Queue_backoff_(&rounds);
+    }
+}
+
+// Free the memory used by the queue
+void MpmcQueue_drop(MpmcQueue *q);
+
+/**
+ * Typed wrappers: `define_SpscQueue_of(T)` declares `SpscQueue_of_T` with
+ * functions taking and returning `T` directly, so the element size is a
+ * compile-time constant and the copies inline.
+ */
+#define define_SpscQueue_of(T)                                                               \
+    typedef struct                                                                           \
+    {                                                                                        \
+        SpscQueue inner;                                                                     \
+    } SpscQueue_of_##T;                                                                      \
+    static inline SpscQueue_of_##T SpscQueue_of_##T##_new(size_t capacity, Allocator alloc)  \
+    {                                                                                        \
+        return (SpscQueue_of_##T){.inner = SpscQueue_new(capacity, sizeof(T), alloc)};       \
+    }                                                                                        \
+    static inline bool SpscQueue_of_##T##_try_push(SpscQueue_of_##T *q, T value)             \
+    {                                                                                        \
+        SpscQueue *inner = &q->inner;                                                        \
+        size_t tail = atomic_load_explicit(&inner->tail, memory_order_relaxed);              \
+        if (tail - inner->cached_head > inner->mask)                                         \
+        {                                                                                    \
+            inner->cached_head = atomic_load_explicit(&inner->head, memory_order_acquire);   \
+            if (tail - inner->cached_head > inner->mask)                                     \
+            {                                                                                \
+                return false;                                                                \
+            }                                                                                \
+        }                                                                                    \
+        ((T *)inner->buf.ptr)[tail & inner->mask] = value;                                   \
+        atomic_store_explicit(&inner->tail, tail + 1, memory_order_release);                 \
+        return true;                                                                         \
+    }                                                                                        \
+    static inline bool SpscQueue_of_##T##_try_pop(SpscQueue_of_##T *q, T *out)               \
+    {                                                                                        \
+        SpscQueue *inner = &q->inner;                                                        \
+        size_t head = atomic_load_explicit(&inner->head, memory_order_relaxed);              \
+        if (head == inner->cached_tail)                                                      \
+        {                                                                                    \
+            inner->cached_tail = atomic_load_explicit(&inner->tail, memory_order_acquire);   \
+            if (head == inner->cached_tail)                                                  \
+            {                                                                                \
+                return false;                                                                \
+            }                                                                                \
+        }                                                                                    \
+        *out = ((T *)inner->buf.ptr)[head & inner->mask];                                    \
+        atomic_store_explicit(&inner->head, head + 1, memory_order_release);                 \
+        return true;                                                                         \
+    }                                                                                        \
+    static inline void SpscQueue_of_##T##_push(SpscQueue_of_##T *q, T value)                 \
+    {                                                                                        \
+        size_t rounds = 0;                                                                   \
+        while (!SpscQueue_of_##T##_try_push(q, value))                                       \
+        {                                                                                    \
+            Queue_backoff_(&rounds);                                                         \
+        }                                                                                    \
+    }                                                                                        \
+    static inline T SpscQueue_of_##T##_pop(SpscQueue_of_##T *q)                              \
+    {                                                                                        \
+        T value;                                                                             \
+        size_t rounds = 0;                                                                   \
+        while (!SpscQueue_of_##T##_try_pop(q, &value))                                       \
+        {                                                                                    \
+            Queue_backoff_(&rounds);                                                         \
+        }                                                                                    \
+        return value;                                                                        \
+    }                                                                                        \
+    static inline void SpscQueue_of_##T##_drop(SpscQueue_of_##T *q)                          \
+    {                                                                                        \
+        SpscQueue_drop(&q->inner);                                                           \
+    }
+
+// Typed wrappers for MpmcQueue, see define_SpscQueue_of
+#define define_MpmcQueue_of(T)                                                              \
+    typedef struct                                                                          \
+    {                                                                                       \
+        MpmcQueue inner;                                                                    \
+    } MpmcQueue_of_##T;                                                                     \
+    static inline MpmcQueue_of_##T MpmcQueue_of_##T##_new(size_t capacity, Allocator alloc) \
+    {                                                                                       \
+        return (MpmcQueue_of_##T){.inner = MpmcQueue_new(capacity, sizeof(T), alloc)};      \
+    }                                                                                       \
+    static inline bool MpmcQueue_of_##T##_try_push(MpmcQueue_of_##T *q, T value)            \
+    {                                                                                       \
+        return MpmcQueue_try_push(&q->inner, &value);                                       \
+    }                                                                                       \
+    static inline bool MpmcQueue_of_##T##_try_pop(MpmcQueue_of_##T *q, T *out)              \
+    {                                                                                       \
+        return MpmcQueue_try_pop(&q->inner, out);                                           \
+    }                                                                                       \
+    static inline void MpmcQueue_of_##T##_push(MpmcQueue_of_##T *q, T value)                \
+    {                                                                                       \
+        MpmcQueue_push(&q->inner, &value);                                                  \
+    }                                                                                       \
+    static inline T MpmcQueue_of_##T##_pop(MpmcQueue_of_##T *q)                             \
+    {                                                                                       \
+        T value;                                                                            \
+        MpmcQueue_pop(&q->inner, &value);                                                   \
+        return value;                                                                       \
+    }                                                                                       \
+    static inline void MpmcQueue_of_##T##_drop(MpmcQueue_of_##T *q)                         \
+    {                                                                                       \
+        MpmcQueue_drop(&q->inner);                                                          \
+    }
+
+#endif // _QUEUE_H_INCLUDED_
+
+#if defined(QUEUE_IMPLEMENTATION) && !defined(_QUEUE_IMPLEMENTATION_INCLUDED_)
+#define _QUEUE_IMPLEMENTATION_INCLUDED_
+
+size_t Queue_round_capacity(size_t capacity)
+{
+    size_t cap = 2;
+    while (cap < capacity)
+    {
+        cap *= 2;
+    }
+    return cap;
+}
+
+SpscQueue SpscQueue_new(size_t capacity, size_t elem_size, Allocator alloc)
+{
+    size_t cap = Queue_round_capacity(capacity);
+    return (SpscQueue){
+        .tail = 0,
+        .cached_head = 0,
+        .head = 0,
+        .cached_tail = 0,
+        .buf = RawVec_with_capacity(cap, elem_size, alloc),
+        .mask = cap - 1,
+        .elem_size = elem_size};
+}
+
+size_t SpscQueue_push_batch(SpscQueue *q, const void *values, size_t count)
+{
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    size_t cap = q->mask + 1;
+    if (cap - (tail - q->cached_head) < count)
+    {
+        q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+    }
+    size_t free_slots = cap - (tail - q->cached_head);
+    size_t n = count < free_slots ? count : free_slots;
+    if (n == 0)
+    {
+        return 0;
+    }
+    size_t start = tail & q->mask;
+    size_t first = cap - start < n ? cap - start : n;
+    memcpy((char *)q->buf.ptr + start * q->elem_size, values, first * q->elem_size);
+    memcpy(q->buf.ptr, (const char *)values + first * q->elem_size, (n - first) * q->elem_size);
+    atomic_store_explicit(&q->tail, tail + n, memory_order_release);
+    return n;
+}
+
+size_t SpscQueue_pop_batch(SpscQueue *q, void *out, size_t max)
+{
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (q->cached_tail - head < max)
+    {
+        q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    }
+    size_t available = q->cached_tail - head;
+    size_t n = max < available ? max : available;
+    if (n == 0)
+    {
+        return 0;
+    }
+    size_t cap = q->mask + 1;
+    size_t start = head & q->mask;
+    size_t first = cap - start < n ? cap - start : n;
+    memcpy(out, (char *)q->buf.ptr + start * q->elem_size, first * q->elem_size);
+    memcpy((char *)out + first * q->elem_size, q->buf.ptr, (n - first) * q->elem_size);
+    atomic_store_explicit(&q->head, head + n, memory_order_release);
+    return n;
+}
+
+void SpscQueue_drop(SpscQueue *q)
+{
+    RawVec_drop(&q->buf);
+}
+
+MpmcQueue MpmcQueue_new(size_t capacity, size_t elem_size, Allocator alloc)
+{
+    size_t cap = Queue_round_capacity(capacity);
+    size_t align = sizeof(atomic_size_t);
+    size_t stride = (sizeof(atomic_size_t) + elem_size + align - 1) / align * align;
+    MpmcQueue q = {
+        .enqueue_pos = 0,
+        .dequeue_pos = 0,
+        .buf = RawVec_with_capacity(cap, stride, alloc),
+        .mask = cap - 1,
+        .elem_size = elem_size,
+        .stride = stride};
+    for (size_t i = 0; i < cap; i++)
+    {
+        atomic_init(MpmcQueue_seq_(&q, i), i);
+    }
+    return q;
+}
+
+void MpmcQueue_drop(MpmcQueue *q)
+{
+    RawVec_drop(&q->buf);
+}
+
+#endif // QUEUE_IMPLEMENTATION
@@ -1,6 +1,13 @@
 #ifndef _RAWVEC_H_INCLUDED_
 #define _RAWVEC_H_INCLUDED_
 
+/**
+ * The capacity check of RawVec_reserve is inlined at every call site; the
+ * growth it falls back to lives out of line in the one translation unit
+ * that defines RAWVEC_IMPLEMENTATION. One unit also defines
+ * ALLOC_IMPLEMENTATION.
+ */
+
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -8,24 +15,76 @@
 #include <stdio.h>
 #include <assert.h>
 #include "alloc.h"
+#ifdef TRACE_PROBES
+#include "trace.h"
+#endif
 
 typedef struct
 {
     void *ptr;
     size_t cap;
     Allocator alloc;
+    size_t align; // 0 for the allocator's default alignment
+    bool pad;     // keep cap * elem_size a multiple of align
 } RawVec;
 
 // Initialize a new RawVec
-RawVec RawVec_new(Allocator alloc)
+static inline RawVec RawVec_new(Allocator alloc)
 {
     return (RawVec){
         .ptr = NULL,
         .cap = 0,
-        .alloc = alloc};
+        .alloc = alloc,
+        .align = 0,
+        .pad = false};
 }
 
 // Create a RawVec with a given capacity
+RawVec RawVec_with_capacity(size_t capacity, size_t elem_size, Allocator alloc);
+
+/**
+ * Create a RawVec whose buffer is aligned to align (a power of two), through
+ * every later growth and shrink. With pad set the capacity is rounded up so
+ * the buffer is a whole number of align-byte vectors: a SIMD kernel may run
+ * over all cap elements without a scalar tail, as long as it ignores the
+ * lanes past len, which are uninitialized.
+ */
+RawVec RawVec_with_alignment(size_t capacity, size_t elem_size, size_t align, bool pad, Allocator alloc);
+
+// Get the capacity of the RawVec
+static inline size_t RawVec_capacity(const RawVec *vec)
+{
+    return vec->cap;
+}
+
+/** Grow the RawVec to accommodate more elements */
+__attribute__((cold, noinline)) void RawVec_grow(RawVec *vec, size_t needed_cap, size_t elem_size);
+
+// Reserve additional capacity
+static inline void RawVec_reserve(RawVec *vec, size_t len, size_t additional, size_t elem_size)
+{
+    size_t needed_cap = len + additional;
+    if (__builtin_expect(needed_cap > vec->cap, 0))
+    {
+        RawVec_grow(vec, needed_cap, elem_size);
+    }
+}
+
+// Free the memory used by the RawVec
+void RawVec_drop(RawVec *vec);
+
+void RawVec_shrink_to_fit(RawVec *vec, size_t len, size_t elem_size);
+
+static inline void *RawVec_ptr(const RawVec *vec)
+{
+    return vec->ptr;
+}
+
+#endif // _RAWVEC_H_INCLUDED_
+
+#if defined(RAWVEC_IMPLEMENTATION) && !defined(_RAWVEC_IMPLEMENTATION_INCLUDED_)
+#define _RAWVEC_IMPLEMENTATION_INCLUDED_
+
 RawVec RawVec_with_capacity(size_t capacity, size_t elem_size, Allocator alloc)
 {
     void *ptr = NULL;
@@ -37,49 +96,69 @@ RawVec RawVec_with_capacity(size_t capacity, size_t elem_size, Allocator alloc)
     return (RawVec){
         .ptr = ptr,
         .cap = capacity,
-        .alloc = alloc};
+        .alloc = alloc,
+        .align = 0,
+        .pad = false};
 }
 
-// Get the capacity of the RawVec
-size_t RawVec_capacity(const RawVec *vec)
+// Round cap up so that cap * elem_size is a multiple of the alignment
+static size_t RawVec_pad_cap_(const RawVec *vec, size_t cap, size_t elem_size)
 {
-    return vec->cap;
+    if (!vec->pad || cap == 0)
+    {
+        return cap;
+    }
+    // align is a power of two, so gcd(align, elem_size) is elem_size's lowest set bit
+    size_t low = elem_size & -elem_size;
+    size_t step = low >= vec->align ? 1 : vec->align / low;
+    return (cap + step - 1) / step * step;
+}
+
+RawVec RawVec_with_alignment(size_t capacity, size_t elem_size, size_t align, bool pad, Allocator alloc)
+{
+    assert(align != 0 && (align & (align - 1)) == 0);
+    RawVec vec = RawVec_new(alloc);
+    vec.align = align;
+    vec.pad = pad;
+    capacity = RawVec_pad_cap_(&vec, capacity, elem_size);
+    if (capacity > 0)
+    {
+        vec.ptr = Allocator_allocate_aligned(&alloc, capacity * elem_size, align);
+        assert(vec.ptr != NULL);
+        vec.cap = capacity;
+    }
+    return vec;
 }
 
-/** Grow the RawVec to accommodate more elements */
 void RawVec_grow(RawVec *vec, size_t needed_cap, size_t elem_size)
 {
+#ifdef TRACE_PROBES
+    TRACE_SCOPE("RawVec_grow");
+#endif
     size_t new_cap = vec->cap == 0 ? 1 : vec->cap * 2;
     while (new_cap < needed_cap)
     {
         new_cap *= 2;
     }
+    new_cap = RawVec_pad_cap_(vec, new_cap, elem_size);
     size_t new_size = new_cap * elem_size;
     void *new_ptr;
     if (vec->ptr == NULL)
     {
-        new_ptr = vec->alloc.allocate(new_size);
+        new_ptr = Allocator_allocate_aligned(&vec->alloc, new_size, vec->align);
     }
     else
     {
-        new_ptr = vec->alloc.reallocate(vec->ptr, vec->cap * elem_size, new_size);
+        new_ptr = Allocator_reallocate_aligned(&vec->alloc, vec->ptr, vec->cap * elem_size, new_size, vec->align);
     }
     assert(new_ptr != NULL);
     vec->ptr = new_ptr;
     vec->cap = new_cap;
+#ifdef TRACE_PROBES
+    TRACE_COUNTER("RawVec_grow bytes", new_size);
+#endif
 }
 
-// Reserve additional capacity
-void RawVec_reserve(RawVec *vec, size_t len, size_t additional, size_t elem_size)
-{
-    size_t needed_cap = len + additional;
-    if (needed_cap > vec->cap)
-    {
-        RawVec_grow(vec, needed_cap, elem_size);
-    }
-}
-
-// Free the memory used by the RawVec
 void RawVec_drop(RawVec *vec)
 {
     if (vec->ptr != NULL)
@@ -92,9 +171,10 @@ void RawVec_drop(RawVec *vec)
 
 void RawVec_shrink_to_fit(RawVec *vec, size_t len, size_t elem_size)
 {
-    if (len < vec->cap)
+    size_t new_cap = RawVec_pad_cap_(vec, len, elem_size);
+    if (new_cap < vec->cap)
     {
-        if (len == 0)
+        if (new_cap == 0)
         {
             vec->alloc.deallocate(vec->ptr);
             vec->ptr = NULL;
@@ -102,17 +182,14 @@ void RawVec_shrink_to_fit(RawVec *vec, size_t len, size_t elem_size)
         }
         else
         {
-            size_t new_size = len * elem_size;
-            void *new_ptr = vec->alloc.reallocate(vec->ptr, vec->cap * elem_size, new_size);
+            size_t new_size = new_cap * elem_size;
+            void *new_ptr =
+                Allocator_reallocate_aligned(&vec->alloc, vec->ptr, vec->cap * elem_size, new_size, vec->align);
             assert(new_ptr != NULL);
             vec->ptr = new_ptr;
-            vec->cap = len;
+            vec->cap = new_cap;
         }
     }
 }
-void *RawVec_ptr(const RawVec *vec)
-{
-    return vec->ptr;
-}
 
-#endif // _RAWVEC_H_INCLUDED_
+#endif // RAWVEC_IMPLEMENTATION
@@ -0,0 +1,739 @@
+#ifndef _SCHEDULER_H_INCLUDED_
+#define _SCHEDULER_H_INCLUDED_
+
+/**
+ * Only a few accessors are static inline. The deques, the workers and
+ * the current-worker thread-local are emitted where
+ * SCHEDULER_IMPLEMENTATION is defined, with ALLOC_IMPLEMENTATION in the
+ * same or another unit.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "alloc.h"
+
+#define SCHEDULER_CACHE_LINE 64
+#define SCHEDULER_DEQUE_INITIAL_CAP 256
+#define SCHEDULER_SPIN_ROUNDS 64
+
+typedef struct Scheduler Scheduler;
+typedef struct Task Task;
+typedef struct Worker Worker;
+
+typedef void (*TaskFunc)(void *arg);
+typedef void (*RangeFunc)(size_t begin, size_t end, void *arg);
+
+/**
+ * A join counter for a set of forked tasks. The counter starts with one
+ * reference held by the forking code, so the group cannot complete while
+ * tasks are still being spawned. Once that reference is released (by
+ * TaskGroup_close or Scheduler_wait) and the last task finishes, the optional
+ * continuation runs on the thread that finished it.
+ */
+typedef struct
+{
+    atomic_size_t pending;
+    TaskFunc cont;
+    void *cont_arg;
+} TaskGroup;
+
+struct Task
+{
+    void (*run)(Scheduler *sched, Task *task);
+    TaskFunc func;
+    void *arg;
+    TaskGroup *group;
+    size_t begin;
+    size_t end;
+    Task *next;
+};
+
+typedef struct TaskArray
+{
+    int64_t cap;
+    struct TaskArray *retired;
+    _Atomic(Task *) slots[];
+} TaskArray;
+
+/**
+ * Chase-Lev work-stealing deque. The owner pushes and takes at the bottom,
+ * thieves steal from the top. `top` and `bottom` live on separate cache lines.
+ */
+typedef struct
+{
+    _Atomic int64_t top;
+    char pad_top[SCHEDULER_CACHE_LINE - sizeof(int64_t)];
+    _Atomic int64_t bottom;
+    _Atomic(TaskArray *) array;
+    char pad_bottom[SCHEDULER_CACHE_LINE - sizeof(int64_t) - sizeof(void *)];
+} TaskDeque;
+
+struct Worker
+{
+    TaskDeque deque;
+    Scheduler *sched;
+    pthread_t thread;
+    size_t index;
+    uint64_t rng;
+    Task *free_list;
+    char pad[SCHEDULER_CACHE_LINE];
+};
+
+struct Scheduler
+{
+    Worker *workers;
+    size_t num_workers;
+    Allocator alloc;
+    atomic_bool stop;
+    atomic_size_t sleeping;
+    pthread_mutex_t park_lock;
+    pthread_cond_t park_cond;
+    pthread_mutex_t inject_lock;
+    Task *inject_head;
+    Task *inject_tail;
+    atomic_size_t inject_len;
+};
+
+static inline void Scheduler_cpu_relax_(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+static inline uint64_t Scheduler_next_random_(uint64_t *state)
+{
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+// Allocate a ring of task slots for a deque
+TaskArray *TaskArray_new(int64_t cap, Allocator alloc);
+
+// Initialize an empty deque
+void TaskDeque_init(TaskDeque *deque, Allocator alloc);
+
+// Number of tasks currently in the deque (approximate when read by a thief)
+static inline size_t TaskDeque_len(TaskDeque *deque)
+{
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    return b > t ? (size_t)(b - t) : 0;
+}
+
+/**
+ * Double the deque's ring. The old ring stays reachable through `retired`
+ * because a concurrent thief may still be reading from it; retired rings are
+ * freed when the deque is dropped.
+ */
+TaskArray *TaskDeque_grow(TaskDeque *deque, TaskArray *old, int64_t top, int64_t bottom, Allocator alloc);
+
+// Push a task at the bottom (owner only)
+void TaskDeque_push(TaskDeque *deque, Task *task, Allocator alloc);
+
+// Take a task from the bottom (owner only), or NULL if empty
+Task *TaskDeque_take(TaskDeque *deque);
+
+// Steal a task from the top (any thread), or NULL if empty or lost a race
+Task *TaskDeque_steal(TaskDeque *deque);
+
+// Free the deque's ring and every retired ring
+void TaskDeque_drop(TaskDeque *deque, Allocator alloc);
+
+// Initialize a task group with an optional continuation
+void TaskGroup_init(TaskGroup *group, TaskFunc cont, void *cont_arg);
+
+// Check whether every task in the group has finished
+static inline bool TaskGroup_is_done(TaskGroup *group)
+{
+    return atomic_load_explicit(&group->pending, memory_order_acquire) == 0;
+}
+
+/**
+ * Mark one task of the group as finished. The continuation is read before the
+ * counter drops, since a joining thread may release the group right after.
+ */
+void TaskGroup_finish_one(TaskGroup *group);
+
+// Release the forking code's reference; the group completes once its tasks do
+static inline void TaskGroup_close(TaskGroup *group)
+{
+    TaskGroup_finish_one(group);
+}
+
+// Get a task from the current worker's free list, or from the allocator
+Task *Scheduler_task_alloc(Scheduler *sched);
+
+// Return a finished task to the current worker's free list
+void Scheduler_task_free(Scheduler *sched, Task *task);
+
+// Wake one parked worker if any are sleeping
+void Scheduler_notify(Scheduler *sched);
+
+// Make a task runnable on the current worker, or via the injection queue
+void Scheduler_submit(Scheduler *sched, Task *task);
+
+// Pop a task submitted from outside the pool
+Task *Scheduler_take_injected(Scheduler *sched);
+
+// Try to steal from random victims, then from the injection queue
+Task *Scheduler_steal(Scheduler *sched, Worker *self, uint64_t *rng);
+
+// Find the next task for a worker: its own deque first, then steal
+Task *Scheduler_find_task(Scheduler *sched, Worker *worker);
+
+// Run a task and signal its group
+void Scheduler_execute(Scheduler *sched, Task *task);
+
+// Check for work visible to a worker that is about to park
+bool Scheduler_has_work(Scheduler *sched);
+
+// Put an idle worker to sleep until new work is submitted
+void Scheduler_park(Scheduler *sched);
+
+void *Scheduler_worker_main(void *arg);
+
+/**
+ * Create a scheduler with `num_workers` threads (0 picks the number of online
+ * CPUs). The scheduler and all task storage come from `alloc`.
+ */
+Scheduler *Scheduler_new(size_t num_workers, Allocator alloc);
+
+// Get the number of worker threads
+static inline size_t Scheduler_num_workers(const Scheduler *sched)
+{
+    return sched->num_workers;
+}
+
+// Fork `func(arg)` as a task of `group` (which may be NULL for detached tasks)
+void Scheduler_spawn(Scheduler *sched, TaskGroup *group, TaskFunc func, void *arg);
+
+/**
+ * Close and join a group. A worker keeps running tasks (its own first, then
+ * stolen ones) until every task in the group has finished. Threads outside
+ * the pool only wait: a stolen task that forks from there would push into the
+ * injection queue and could nest joins without bound on the caller's stack.
+ */
+void Scheduler_wait(Scheduler *sched, TaskGroup *group);
+
+typedef struct
+{
+    RangeFunc body;
+    void *arg;
+    size_t grain;
+    TaskGroup group;
+} ParallelFor;
+
+/**
+ * Call `body(chunk_begin, chunk_end, arg)` over [begin, end) in parallel and
+ * wait for completion. A `grain` of 0 picks one from the range size and the
+ * number of workers.
+ */
+void Scheduler_parallel_for(Scheduler *sched, size_t begin, size_t end, size_t grain, RangeFunc body, void *arg);
+
+// Stop all workers and free the scheduler. Pending tasks are discarded.
+void Scheduler_drop(Scheduler *sched);
+
+#endif // _SCHEDULER_H_INCLUDED_
+
+#if defined(SCHEDULER_IMPLEMENTATION) && !defined(_SCHEDULER_IMPLEMENTATION_INCLUDED_)
+#define _SCHEDULER_IMPLEMENTATION_INCLUDED_
+
+static _Thread_local Worker *Scheduler_current_worker_ = NULL;
+
+TaskArray *TaskArray_new(int64_t cap, Allocator alloc)
+{
+    TaskArray *array = alloc.allocate(sizeof(TaskArray) + (size_t)cap * sizeof(_Atomic(Task *)));
+    assert(array != NULL);
+    array->cap = cap;
+    array->retired = NULL;
+    return array;
+}
+
+void TaskDeque_init(TaskDeque *deque, Allocator alloc)
+{
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    atomic_init(&deque->array, TaskArray_new(SCHEDULER_DEQUE_INITIAL_CAP, alloc));
+}
+
+TaskArray *TaskDeque_grow(TaskDeque *deque, TaskArray *old, int64_t top, int64_t bottom, Allocator alloc)
+{
+    TaskArray *array = TaskArray_new(old->cap * 2, alloc);
+    for (int64_t i = top; i < bottom; i++)
+    {
+        Task *task = atomic_load_explicit(&old->slots[i & (old->cap - 1)], memory_order_relaxed);
+        atomic_store_explicit(&array->slots[i & (array->cap - 1)], task, memory_order_relaxed);
+    }
+    array->retired = old;
+    atomic_store_explicit(&deque->array, array, memory_order_release);
+    return array;
+}
+
+void TaskDeque_push(TaskDeque *deque, Task *task, Allocator alloc)
+{
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    TaskArray *array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+    if (b - t > array->cap - 1)
+    {
+        array = TaskDeque_grow(deque, array, t, b, alloc);
+    }
+    atomic_store_explicit(&array->slots[b & (array->cap - 1)], task, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_release);
+}
+
+Task *TaskDeque_take(TaskDeque *deque)
+{
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    TaskArray *array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    if (t > b)
+    {
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+    Task *task = atomic_load_explicit(&array->slots[b & (array->cap - 1)], memory_order_relaxed);
+    if (t == b)
+    {
+        // Last element: race against thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+        {
+            task = NULL;
+        }
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+Task *TaskDeque_steal(TaskDeque *deque)
+{
+    int64_t t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (t >= b)
+    {
+        return NULL;
+    }
+    TaskArray *array = atomic_load_explicit(&deque->array, memory_order_acquire);
+    Task *task = atomic_load_explicit(&array->slots[t & (array->cap - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+    {
+        return NULL;
+    }
+    return task;
+}
+
+void TaskDeque_drop(TaskDeque *deque, Allocator alloc)
+{
+    TaskArray *array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+    while (array != NULL)
+    {
+        TaskArray *retired = array->retired;
+        alloc.deallocate(array);
+        array = retired;
+    }
+    atomic_store_explicit(&deque->array, NULL, memory_order_relaxed);
+}
+
+void TaskGroup_init(TaskGroup *group, TaskFunc cont, void *cont_arg)
+{
+    atomic_init(&group->pending, 1);
+    group->cont = cont;
+    group->cont_arg = cont_arg;
+}
+
+void TaskGroup_finish_one(TaskGroup *group)
+{
+    TaskFunc cont = group->cont;
+    void *cont_arg = group->cont_arg;
+    if (atomic_fetch_sub_explicit(&group->pending, 1, memory_order_acq_rel) == 1 && cont != NULL)
+    {
+        cont(cont_arg);
+    }
+}
+
+Task *Scheduler_task_alloc(Scheduler *sched)
+{
+    Worker *worker = Scheduler_current_worker_;
+    if (worker != NULL && worker->sched == sched && worker->free_list != NULL)
+    {
+        Task *task = worker->free_list;
+        worker->free_list = task->next;
+        return task;
+    }
+    Task *task = sched->alloc.allocate(sizeof(Task));
+    assert(task != NULL);
+    return task;
+}
+
+void Scheduler_task_free(Scheduler *sched, Task *task)
+{
+    Worker *worker = Scheduler_current_worker_;
+    if (worker != NULL && worker->sched == sched)
+    {
+        task->next = worker->free_list;
+        worker->free_list = task;
+        return;
+    }
+    sched->alloc.deallocate(task);
+}
+
+void Scheduler_notify(Scheduler *sched)
+{
+    // Pairs with the seq_cst increment of `sleeping` in Scheduler_park
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&sched->sleeping, memory_order_relaxed) > 0)
+    {
+        pthread_mutex_lock(&sched->park_lock);
+        pthread_cond_signal(&sched->park_cond);
+        pthread_mutex_unlock(&sched->park_lock);
+    }
+}
+
+void Scheduler_submit(Scheduler *sched, Task *task)
+{
+    if (task->group != NULL)
+    {
+        atomic_fetch_add_explicit(&task->group->pending, 1, memory_order_relaxed);
+    }
+    Worker *worker = Scheduler_current_worker_;
+    if (worker != NULL && worker->sched == sched)
+    {
+        TaskDeque_push(&worker->deque, task, sched->alloc);
+    }
+    else
+    {
+        task->next = NULL;
+        pthread_mutex_lock(&sched->inject_lock);
+        if (sched->inject_tail != NULL)
+        {
+            sched->inject_tail->next = task;
+        }
+        else
+        {
+            sched->inject_head = task;
+        }
+        sched->inject_tail = task;
+        atomic_fetch_add_explicit(&sched->inject_len, 1, memory_order_relaxed);
+        pthread_mutex_unlock(&sched->inject_lock);
+    }
+    Scheduler_notify(sched);
+}
+
+Task *Scheduler_take_injected(Scheduler *sched)
+{
+    if (atomic_load_explicit(&sched->inject_len, memory_order_relaxed) == 0)
+    {
+        return NULL;
+    }
+    pthread_mutex_lock(&sched->inject_lock);
+    Task *task = sched->inject_head;
+    if (task != NULL)
+    {
+        sched->inject_head = task->next;
+        if (sched->inject_head == NULL)
+        {
+            sched->inject_tail = NULL;
+        }
+        atomic_fetch_sub_explicit(&sched->inject_len, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&sched->inject_lock);
+    return task;
+}
+
+Task *Scheduler_steal(Scheduler *sched, Worker *self, uint64_t *rng)
+{
+    size_t n = sched->num_workers;
+    for (size_t attempt = 0; attempt < n * 2; attempt++)
+    {
+        Worker *victim = &sched->workers[Scheduler_next_random_(rng) % n];
+        if (victim == self)
+        {
+            continue;
+        }
+        Task *task = TaskDeque_steal(&victim->deque);
+        if (task != NULL)
+        {
+            return task;
+        }
+    }
+    return Scheduler_take_injected(sched);
+}
+
+Task *Scheduler_find_task(Scheduler *sched, Worker *worker)
+{
+    Task *task = TaskDeque_take(&worker->deque);
+    if (task != NULL)
+    {
+        return task;
+    }
+    return Scheduler_steal(sched, worker, &worker->rng);
+}
+
+void Scheduler_execute(Scheduler *sched, Task *task)
+{
+    TaskGroup *group = task->group;
+    task->run(sched, task);
+    Scheduler_task_free(sched, task);
+    if (group != NULL)
+    {
+        TaskGroup_finish_one(group);
+    }
+}
+
+bool Scheduler_has_work(Scheduler *sched)
+{
+    if (atomic_load_explicit(&sched->inject_len, memory_order_relaxed) > 0)
+    {
+        return true;
+    }
+    for (size_t i = 0; i < sched->num_workers; i++)
+    {
+        if (TaskDeque_len(&sched->workers[i].deque) > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scheduler_park(Scheduler *sched)
+{
+    pthread_mutex_lock(&sched->park_lock);
+    atomic_fetch_add_explicit(&sched->sleeping, 1, memory_order_seq_cst);
+    if (!atomic_load_explicit(&sched->stop, memory_order_relaxed) && !Scheduler_has_work(sched))
+    {
+        pthread_cond_wait(&sched->park_cond, &sched->park_lock);
+    }
+    atomic_fetch_sub_explicit(&sched->sleeping, 1, memory_order_relaxed);
+    pthread_mutex_unlock(&sched->park_lock);
+}
+
+void *Scheduler_worker_main(void *arg)
+{
+    Worker *worker = arg;
+    Scheduler *sched = worker->sched;
+    Scheduler_current_worker_ = worker;
+    size_t idle_rounds = 0;
+    while (!atomic_load_explicit(&sched->stop, memory_order_acquire))
+    {
+        Task *task = Scheduler_find_task(sched, worker);
+        if (task != NULL)
+        {
+            Scheduler_execute(sched, task);
+            idle_rounds = 0;
+        }
+        else if (++idle_rounds < SCHEDULER_SPIN_ROUNDS)
+        {
+            Scheduler_cpu_relax_();
+        }
+        else if (idle_rounds < SCHEDULER_SPIN_ROUNDS * 2)
+        {
+            sched_yield();
+        }
+        else
+        {
+            Scheduler_park(sched);
+            idle_rounds = 0;
+        }
+    }
+    Scheduler_current_worker_ = NULL;
+    return NULL;
+}
+
+Scheduler *Scheduler_new(size_t num_workers, Allocator alloc)
+{
+    if (num_workers == 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = cpus > 0 ? (size_t)cpus : 1;
+    }
+    Scheduler *sched = alloc.allocate(sizeof(Scheduler));
+    assert(sched != NULL);
+    sched->workers = alloc.allocate(num_workers * sizeof(Worker));
+    assert(sched->workers != NULL);
+    sched->num_workers = num_workers;
+    sched->alloc = alloc;
+    atomic_init(&sched->stop, false);
+    atomic_init(&sched->sleeping, 0);
+    atomic_init(&sched->inject_len, 0);
+    pthread_mutex_init(&sched->park_lock, NULL);
+    pthread_cond_init(&sched->park_cond, NULL);
+    pthread_mutex_init(&sched->inject_lock, NULL);
+    sched->inject_head = NULL;
+    sched->inject_tail = NULL;
+    for (size_t i = 0; i < num_workers; i++)
+    {
+        Worker *worker = &sched->workers[i];
+        TaskDeque_init(&worker->deque, alloc);
+        worker->sched = sched;
+        worker->index = i;
+        worker->rng = 0x9E3779B97F4A7C15ull * (i + 1);
+        worker->free_list = NULL;
+    }
+    for (size_t i = 0; i < num_workers; i++)
+    {
+        int err = pthread_create(&sched->workers[i].thread, NULL, Scheduler_worker_main, &sched->workers[i]);
+        assert(err == 0);
+        (void)err;
+    }
+    return sched;
+}
+
+void Scheduler_run_func_(Scheduler *sched, Task *task)
+{
+    (void)sched;
+    task->func(task->arg);
+}
+
+void Scheduler_spawn(Scheduler *sched, TaskGroup *group, TaskFunc func, void *arg)
+{
+    Task *task = Scheduler_task_alloc(sched);
+    task->run = Scheduler_run_func_;
+    task->func = func;
+    task->arg = arg;
+    task->group = group;
+    Scheduler_submit(sched, task);
+}
+
+void Scheduler_wait(Scheduler *sched, TaskGroup *group)
+{
+    TaskGroup_close(group);
+    Worker *worker = Scheduler_current_worker_;
+    bool helps = worker != NULL && worker->sched == sched;
+    size_t idle_rounds = 0;
+    while (!TaskGroup_is_done(group))
+    {
+        Task *task = helps ? Scheduler_find_task(sched, worker) : NULL;
+        if (task != NULL)
+        {
+            Scheduler_execute(sched, task);
+            idle_rounds = 0;
+        }
+        else if (++idle_rounds < SCHEDULER_SPIN_ROUNDS)
+        {
+            Scheduler_cpu_relax_();
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+}
+
+void Scheduler_spawn_range_(Scheduler *sched, ParallelFor *pf, size_t begin, size_t end);
+
+/**
+ * Lazy binary splitting: a range is only split while the local deque is
+ * nearly empty, i.e. while idle workers could be stealing. Otherwise the
+ * worker keeps chewing through grain-sized chunks without creating tasks.
+ */
+void Scheduler_run_range_(Scheduler *sched, Task *task)
+{
+    ParallelFor *pf = task->arg;
+    size_t begin = task->begin;
+    size_t end = task->end;
+    Worker *worker = Scheduler_current_worker_;
+    while (end - begin > pf->grain)
+    {
+        if (worker == NULL || worker->sched != sched || TaskDeque_len(&worker->deque) < 2)
+        {
+            size_t mid = begin + (end - begin) / 2;
+            Scheduler_spawn_range_(sched, pf, mid, end);
+            end = mid;
+        }
+        else
+        {
+            pf->body(begin, begin + pf->grain, pf->arg);
+            begin += pf->grain;
+        }
+    }
+    pf->body(begin, end, pf->arg);
+}
+
+void Scheduler_spawn_range_(Scheduler *sched, ParallelFor *pf, size_t begin, size_t end)
+{
+    Task *task = Scheduler_task_alloc(sched);
+    task->run = Scheduler_run_range_;
+    task->func = NULL;
+    task->arg = pf;
+    task->group = &pf->group;
+    task->begin = begin;
+    task->end = end;
+    Scheduler_submit(sched, task);
+}
+
+void Scheduler_parallel_for(Scheduler *sched, size_t begin, size_t end, size_t grain, RangeFunc body, void *arg)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    if (grain == 0)
+    {
+        grain = (end - begin) / (sched->num_workers * 8);
+        grain = grain == 0 ? 1 : grain;
+    }
+    ParallelFor pf = {.body = body, .arg = arg, .grain = grain};
+    TaskGroup_init(&pf.group, NULL, NULL);
+    Scheduler_spawn_range_(sched, &pf, begin, end);
+    Scheduler_wait(sched, &pf.group);
+}
+
+void Scheduler_drop(Scheduler *sched)
+{
+    Allocator alloc = sched->alloc;
+    atomic_store_explicit(&sched->stop, true, memory_order_release);
+    pthread_mutex_lock(&sched->park_lock);
+    pthread_cond_broadcast(&sched->park_cond);
+    pthread_mutex_unlock(&sched->park_lock);
+    for (size_t i = 0; i < sched->num_workers; i++)
+    {
+        pthread_join(sched->workers[i].thread, NULL);
+    }
+    for (size_t i = 0; i < sched->num_workers; i++)
+    {
+        Worker *worker = &sched->workers[i];
+        Task *task;
+        while ((task = TaskDeque_take(&worker->deque)) != NULL)
+        {
+            alloc.deallocate(task);
+        }
+        TaskDeque_drop(&worker->deque, alloc);
+        while (worker->free_list != NULL)
+        {
+            task = worker->free_list;
+            worker->free_list = task->next;
+            alloc.deallocate(task);
+        }
+    }
+    Task *task;
+    while ((task = Scheduler_take_injected(sched)) != NULL)
+    {
+        alloc.deallocate(task);
+    }
+    pthread_mutex_destroy(&sched->park_lock);
+    pthread_cond_destroy(&sched->park_cond);
+    pthread_mutex_destroy(&sched->inject_lock);
+    alloc.deallocate(sched->workers);
+    alloc.deallocate(sched);
+}
+
+#endif // SCHEDULER_IMPLEMENTATION
@@ -0,0 +1,354 @@
+#ifndef _SEARCH_H_INCLUDED_
+#define _SEARCH_H_INCLUDED_
+
+/**
+ * The single-key searches are static inline; construction and the
+ * batched searches are emitted where SEARCH_IMPLEMENTATION is defined.
+ * One unit also defines ALLOC_, RAWVEC_ and VEC_IMPLEMENTATION.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "alloc.h"
+#include "vec.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * Static search indexes over a sorted Vec of uint32_t keys. Both answer
+ * lower_bound queries: the index in the sorted Vec of the first key not
+ * less than the query, or the Vec's length when every key is smaller.
+ *
+ * Eytzinger stores the keys in breadth-first order of the implicit binary
+ * search tree, so the first levels share a few cache lines and each probe
+ * can prefetch the line holding its descendants four levels down. STree
+ * stores a static B-tree of 16-key nodes, one cache line each, searched
+ * with SSE2 compares. The indexes are built once and never modified.
+ */
+
+#define SEARCH_LINE 64
+// Queries interleaved by the batch lookups
+#define SEARCH_BATCH 16
+#define STREE_B 16
+#define STREE_NONE SIZE_MAX
+
+// Allocate `bytes` from `alloc` aligned to a cache line; `*raw` is what to free
+static inline void *Search_alloc_line_(Allocator alloc, size_t bytes, void **raw)
+{
+    *raw = alloc.allocate(bytes + SEARCH_LINE - 1);
+    assert(*raw != NULL);
+    return (void *)(((uintptr_t)*raw + SEARCH_LINE - 1) & ~(uintptr_t)(SEARCH_LINE - 1));
+}
+
+typedef struct
+{
+    // keys[1..len] in breadth-first order; keys[0] is a sentinel
+    uint32_t *keys;
+    // ranks[k] is the sorted index of keys[k]; ranks[0] is len
+    uint32_t *ranks;
+    void *keys_raw;
+    size_t len;
+    // Levels above the last, which may be partly filled
+    unsigned depth;
+    Allocator alloc;
+} Eytzinger;
+
+// Build an Eytzinger index over `sorted`, a Vec of ascending uint32_t
+Eytzinger Eytzinger_new(const Vec *sorted, Allocator alloc);
+
+/**
+ * Find the slot of the first key not less than `key`, or 0 if there is
+ * none. The descent is a fixed number of compare-and-shift steps with no
+ * data-dependent branches; a right turn appends a 1 bit to the slot, so
+ * stripping the trailing 1s and the 0 before them leaves the last node
+ * where the search went left.
+ */
+static inline size_t Eytzinger_search(const Eytzinger *e, uint32_t key)
+{
+    const uint32_t *b = e->keys;
+    size_t k = 1;
+    for (unsigned level = 0; level < e->depth; level++)
+    {
+        // 16 keys per line: the descendants four levels down are contiguous
+        __builtin_prefetch(b + k * 16);
+        k = 2 * k + (b[k] < key);
+    }
+    bool inside = k <= e->len;
+    size_t last = 2 * k + (b[inside ? k : 0] < key);
+    k = inside ? last : k;
+    return k >> __builtin_ffsll((long long)~k);
+}
+
+// Index in the sorted keys of the key at `slot`, or the key count for slot 0
+static inline size_t Eytzinger_rank(const Eytzinger *e, size_t slot)
+{
+    return e->ranks[slot];
+}
+
+static inline size_t Eytzinger_lower_bound(const Eytzinger *e, uint32_t key)
+{
+    return Eytzinger_rank(e, Eytzinger_search(e, key));
+}
+
+/**
+ * Answer `count` lower_bound queries into `out`. Queries go down the tree
+ * SEARCH_BATCH at a time, level by level, so the cache misses of one
+ * group overlap instead of waiting on each other.
+ */
+void Eytzinger_lower_bound_batch(const Eytzinger *e, const uint32_t *keys, size_t count, size_t *out);
+
+// Bytes used by the index
+static inline size_t Eytzinger_size_in_bytes(const Eytzinger *e)
+{
+    return 2 * (e->len + 1) * sizeof(uint32_t);
+}
+
+void Eytzinger_drop(Eytzinger *e);
+
+/**
+ * A static B-tree of STREE_B-key nodes. Node k's children are nodes
+ * k * (STREE_B + 1) + 1 + i, so no pointers are stored. Keys are kept with
+ * the sign bit flipped so SSE2's signed compare orders them as unsigned;
+ * slots past the last key hold UINT32_MAX and rank `len`.
+ */
+typedef struct
+{
+    uint32_t *keys;
+    uint32_t *ranks;
+    void *keys_raw;
+    size_t len;
+    size_t blocks;
+    Allocator alloc;
+} STree;
+
+static inline size_t STree_child_(size_t k, size_t i)
+{
+    return k * (STREE_B + 1) + i + 1;
+}
+
+// Build an S-tree over `sorted`, a Vec of ascending uint32_t
+STree STree_new(const Vec *sorted, Allocator alloc);
+
+// Number of keys in `node` less than the key whose sign-flipped form is `biased`
+static inline unsigned STree_node_rank_(const uint32_t *node, uint32_t biased)
+{
+#ifdef __SSE2__
+    __m128i x = _mm_set1_epi32((int)biased);
+    const __m128i *n = (const __m128i *)node;
+    __m128i c0 = _mm_cmpgt_epi32(x, _mm_load_si128(n));
+    __m128i c1 = _mm_cmpgt_epi32(x, _mm_load_si128(n + 1));
+    __m128i c2 = _mm_cmpgt_epi32(x, _mm_load_si128(n + 2));
+    __m128i c3 = _mm_cmpgt_epi32(x, _mm_load_si128(n + 3));
+    __m128i packed = _mm_packs_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3));
+    // The keys are sorted, so the matches are the low bits of the mask
+    return (unsigned)__builtin_ctz(~(unsigned)_mm_movemask_epi8(packed));
+#else
+    unsigned i = 0;
+    for (unsigned j = 0; j < STREE_B; j++)
+    {
+        i += (int32_t)node[j] < (int32_t)biased;
+    }
+    return i;
+#endif
+}
+
+// Find the slot of the first key not less than `key`. Past the last key this is
+// a padding slot, or STREE_NONE when there is none; STree_rank maps both to len
+static inline size_t STree_search(const STree *t, uint32_t key)
+{
+    uint32_t biased = key ^ 0x80000000u;
+    size_t k = 0, found = STREE_NONE;
+    while (k < t->blocks)
+    {
+        unsigned i = STree_node_rank_(t->keys + k * STREE_B, biased);
+        found = i < STREE_B ? k * STREE_B + i : found;
+        k = STree_child_(k, i);
+    }
+    return found;
+}
+
+static inline size_t STree_rank(const STree *t, size_t slot)
+{
+    return slot == STREE_NONE ? t->len : t->ranks[slot];
+}
+
+static inline size_t STree_lower_bound(const STree *t, uint32_t key)
+{
+    return STree_rank(t, STree_search(t, key));
+}
+
+// Answer `count` lower_bound queries into `out`, SEARCH_BATCH at a time
+void STree_lower_bound_batch(const STree *t, const uint32_t *keys, size_t count, size_t *out);
+
+static inline size_t STree_size_in_bytes(const STree *t)
+{
+    return 2 * t->blocks * STREE_B * sizeof(uint32_t);
+}
+
+void STree_drop(STree *t);
+
+#endif // _SEARCH_H_INCLUDED_
+
+#if defined(SEARCH_IMPLEMENTATION) && !defined(_SEARCH_IMPLEMENTATION_INCLUDED_)
+#define _SEARCH_IMPLEMENTATION_INCLUDED_
+
+// In-order walk of the implicit tree, handing out sorted keys
+void Eytzinger_fill_(Eytzinger *e, const uint32_t *sorted, size_t *next, size_t k)
+{
+    if (k > e->len)
+    {
+        return;
+    }
+    Eytzinger_fill_(e, sorted, next, 2 * k);
+    e->keys[k] = sorted[*next];
+    e->ranks[k] = (uint32_t)*next;
+    (*next)++;
+    Eytzinger_fill_(e, sorted, next, 2 * k + 1);
+}
+
+Eytzinger Eytzinger_new(const Vec *sorted, Allocator alloc)
+{
+    assert(sorted->len < UINT32_MAX);
+    Eytzinger e = {.len = sorted->len, .depth = 0, .alloc = alloc};
+    e.keys = Search_alloc_line_(alloc, (e.len + 1) * sizeof(uint32_t), &e.keys_raw);
+    e.ranks = alloc.allocate((e.len + 1) * sizeof(uint32_t));
+    assert(e.ranks != NULL);
+    e.keys[0] = 0;
+    e.ranks[0] = (uint32_t)e.len;
+    size_t next = 0;
+    Eytzinger_fill_(&e, sorted->buf.ptr, &next, 1);
+    while (((size_t)2 << e.depth) <= e.len)
+    {
+        e.depth++;
+    }
+    return e;
+}
+
+void Eytzinger_lower_bound_batch(const Eytzinger *e, const uint32_t *keys, size_t count, size_t *out)
+{
+    const uint32_t *b = e->keys;
+    for (size_t start = 0; start < count; start += SEARCH_BATCH)
+    {
+        size_t n = count - start < SEARCH_BATCH ? count - start : SEARCH_BATCH;
+        const uint32_t *q = keys + start;
+        size_t k[SEARCH_BATCH];
+        for (size_t j = 0; j < n; j++)
+        {
+            k[j] = 1;
+        }
+        for (unsigned level = 0; level < e->depth; level++)
+        {
+            for (size_t j = 0; j < n; j++)
+            {
+                __builtin_prefetch(b + k[j] * 16);
+                k[j] = 2 * k[j] + (b[k[j]] < q[j]);
+            }
+        }
+        for (size_t j = 0; j < n; j++)
+        {
+            bool inside = k[j] <= e->len;
+            size_t last = 2 * k[j] + (b[inside ? k[j] : 0] < q[j]);
+            k[j] = inside ? last : k[j];
+            k[j] >>= __builtin_ffsll((long long)~k[j]);
+            __builtin_prefetch(e->ranks + k[j]);
+        }
+        for (size_t j = 0; j < n; j++)
+        {
+            out[start + j] = e->ranks[k[j]];
+        }
+    }
+}
+
+void Eytzinger_drop(Eytzinger *e)
+{
+    e->alloc.deallocate(e->keys_raw);
+    e->alloc.deallocate(e->ranks);
+    e->keys = e->ranks = NULL;
+    e->keys_raw = NULL;
+    e->len = 0;
+}
+
+void STree_fill_(STree *t, const uint32_t *sorted, size_t *next, size_t k)
+{
+    if (k >= t->blocks)
+    {
+        return;
+    }
+    for (size_t i = 0; i < STREE_B; i++)
+    {
+        STree_fill_(t, sorted, next, STree_child_(k, i));
+        size_t slot = k * STREE_B + i;
+        bool real = *next < t->len;
+        t->keys[slot] = (real ? sorted[*next] : UINT32_MAX) ^ 0x80000000u;
+        t->ranks[slot] = (uint32_t)(real ? *next : t->len);
+        *next += real;
+    }
+    STree_fill_(t, sorted, next, STree_child_(k, STREE_B));
+}
+
+STree STree_new(const Vec *sorted, Allocator alloc)
+{
+    assert(sorted->len < UINT32_MAX);
+    STree t = {.len = sorted->len, .blocks = (sorted->len + STREE_B - 1) / STREE_B, .alloc = alloc};
+    size_t slots = t.blocks * STREE_B;
+    t.keys = Search_alloc_line_(alloc, (slots > 0 ? slots : 1) * sizeof(uint32_t), &t.keys_raw);
+    t.ranks = alloc.allocate((slots > 0 ? slots : 1) * sizeof(uint32_t));
+    assert(t.ranks != NULL);
+    size_t next = 0;
+    STree_fill_(&t, sorted->buf.ptr, &next, 0);
+    return t;
+}
+
+void STree_lower_bound_batch(const STree *t, const uint32_t *keys, size_t count, size_t *out)
+{
+    for (size_t start = 0; start < count; start += SEARCH_BATCH)
+    {
+        size_t n = count - start < SEARCH_BATCH ? count - start : SEARCH_BATCH;
+        size_t k[SEARCH_BATCH], found[SEARCH_BATCH];
+        uint32_t biased[SEARCH_BATCH];
+        for (size_t j = 0; j < n; j++)
+        {
+            k[j] = 0;
+            found[j] = STREE_NONE;
+            biased[j] = keys[start + j] ^ 0x80000000u;
+        }
+        // Paths differ in length by at most one level
+        for (bool active = t->blocks > 0; active;)
+        {
+            active = false;
+            for (size_t j = 0; j < n; j++)
+            {
+                if (k[j] < t->blocks)
+                {
+                    unsigned i = STree_node_rank_(t->keys + k[j] * STREE_B, biased[j]);
+                    found[j] = i < STREE_B ? k[j] * STREE_B + i : found[j];
+                    k[j] = STree_child_(k[j], i);
+                    __builtin_prefetch(t->keys + k[j] * STREE_B);
+                    active = true;
+                }
+            }
+        }
+        for (size_t j = 0; j < n; j++)
+        {
+            out[start + j] = STree_rank(t, found[j]);
+        }
+    }
+}
+
+void STree_drop(STree *t)
+{
+    t->alloc.deallocate(t->keys_raw);
+    t->alloc.deallocate(t->ranks);
+    t->keys = t->ranks = NULL;
+    t->keys_raw = NULL;
+    t->len = 0;
+    t->blocks = 0;
+}
+
+#endif // SEARCH_IMPLEMENTATION
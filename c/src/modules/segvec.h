@@ -0,0 +1,281 @@
+#ifndef _SEGVEC_H_INCLUDED_
+#define _SEGVEC_H_INCLUDED_
+
+/**
+ * Indexing and the push fast path are static inline; chunk allocation
+ * and the rest are emitted where SEGVEC_IMPLEMENTATION is defined, with
+ * ALLOC_IMPLEMENTATION in the same or another unit.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "alloc.h"
+
+// Elements in the first chunk; must be a power of two
+#define SEGVEC_FIRST_CHUNK_SHIFT 3
+#define SEGVEC_FIRST_CHUNK ((size_t)1 << SEGVEC_FIRST_CHUNK_SHIFT)
+// Chunk k holds SEGVEC_FIRST_CHUNK << k elements, so this many cover any index
+#define SEGVEC_MAX_CHUNKS (64 - SEGVEC_FIRST_CHUNK_SHIFT)
+
+/**
+ * A vector built from chunks that double in size, reached through a fixed
+ * directory. Growing allocates one new chunk and never moves the elements
+ * already stored, so pointers from SegVec_get and SegVec_push stay valid
+ * until the element is popped or the SegVec is dropped.
+ */
+typedef struct
+{
+    void *chunks[SEGVEC_MAX_CHUNKS];
+    size_t chunk_count;
+    size_t len;
+    // Where the next push goes, and the end of that chunk
+    char *cursor;
+    char *cursor_end;
+    size_t elem_size;
+    Allocator alloc;
+} SegVec;
+
+// A run of elements stored contiguously in one chunk
+typedef struct
+{
+    void *ptr;
+    size_t len;
+} SegVecChunk;
+
+// Create an empty SegVec of `elem_size`-byte elements
+static inline SegVec SegVec_new(size_t elem_size, Allocator alloc)
+{
+    SegVec vec = {.chunk_count = 0, .len = 0, .cursor = NULL, .cursor_end = NULL, .elem_size = elem_size, .alloc = alloc};
+    memset(vec.chunks, 0, sizeof(vec.chunks));
+    return vec;
+}
+
+// Number of elements chunk k holds
+static inline size_t SegVec_chunk_capacity_(size_t k)
+{
+    return SEGVEC_FIRST_CHUNK << k;
+}
+
+// Total capacity of the first `chunk_count` chunks
+static inline size_t SegVec_capacity_of_(size_t chunk_count)
+{
+    return SEGVEC_FIRST_CHUNK * (((size_t)1 << chunk_count) - 1);
+}
+
+/**
+ * Split an index into its chunk and the offset within it. Shifting by the
+ * first chunk size makes chunk k start at (1 << (k + shift)), so the chunk
+ * is the position of the highest set bit: one lzcnt, no loop or branch.
+ */
+static inline void SegVec_locate_(size_t index, size_t *chunk, size_t *offset)
+{
+    size_t biased = index + SEGVEC_FIRST_CHUNK;
+    unsigned high = 63 - (unsigned)__builtin_clzll(biased);
+    *chunk = high - SEGVEC_FIRST_CHUNK_SHIFT;
+    *offset = biased - ((size_t)1 << high);
+}
+
+static inline size_t SegVec_len(const SegVec *vec)
+{
+    return vec->len;
+}
+
+static inline bool SegVec_is_empty(const SegVec *vec)
+{
+    return vec->len == 0;
+}
+
+static inline size_t SegVec_capacity(const SegVec *vec)
+{
+    return SegVec_capacity_of_(vec->chunk_count);
+}
+
+// Get a pointer to the element at the given index
+static inline void *SegVec_get(const SegVec *vec, size_t index)
+{
+    assert(index < vec->len);
+    size_t chunk, offset;
+    SegVec_locate_(index, &chunk, &offset);
+    return (char *)vec->chunks[chunk] + offset * vec->elem_size;
+}
+
+static inline void SegVec_set(SegVec *vec, size_t index, const void *value)
+{
+    memcpy(SegVec_get(vec, index), value, vec->elem_size);
+}
+
+// Move the cursor to the next chunk, allocating it if needed
+__attribute__((noinline)) void SegVec_grow_(SegVec *vec);
+
+// Make room for at least `additional` more elements
+void SegVec_reserve(SegVec *vec, size_t additional);
+
+/**
+ * Append an uninitialised element and return a pointer to it, for callers
+ * that fill it in place; with a typed store this avoids the variable-size
+ * memcpy of SegVec_push.
+ */
+static inline void *SegVec_push_uninit(SegVec *vec)
+{
+    if (vec->cursor == vec->cursor_end)
+    {
+        SegVec_grow_(vec);
+    }
+    char *dst = vec->cursor;
+    vec->cursor += vec->elem_size;
+    vec->len++;
+    return dst;
+}
+
+// Append a copy of `value` and return a pointer to the stored element
+static inline void *SegVec_push(SegVec *vec, const void *value)
+{
+    void *dst = SegVec_push_uninit(vec);
+    memcpy(dst, value, vec->elem_size);
+    return dst;
+}
+
+// Pop the last element into `out`; chunks are kept for reuse
+bool SegVec_pop(SegVec *vec, void *out);
+
+void SegVec_truncate(SegVec *vec, size_t new_len);
+
+void SegVec_clear(SegVec *vec);
+
+// Number of chunks holding at least one element
+size_t SegVec_chunk_count(const SegVec *vec);
+
+/**
+ * The elements stored in chunk k, for bulk processing one contiguous run
+ * at a time:
+ *
+ *     for (size_t k = 0; k < SegVec_chunk_count(&v); k++)
+ *     {
+ *         SegVecChunk c = SegVec_chunk(&v, k);
+ *         // c.len elements at c.ptr
+ *     }
+ */
+SegVecChunk SegVec_chunk(const SegVec *vec, size_t k);
+
+// Free every chunk
+void SegVec_drop(SegVec *vec);
+
+#endif // _SEGVEC_H_INCLUDED_
+
+#if defined(SEGVEC_IMPLEMENTATION) && !defined(_SEGVEC_IMPLEMENTATION_INCLUDED_)
+#define _SEGVEC_IMPLEMENTATION_INCLUDED_
+
+// Add the next chunk; the existing ones are untouched
+void SegVec_add_chunk_(SegVec *vec)
+{
+    assert(vec->chunk_count < SEGVEC_MAX_CHUNKS);
+    size_t k = vec->chunk_count;
+    void *chunk = vec->alloc.allocate(SegVec_chunk_capacity_(k) * vec->elem_size);
+    assert(chunk != NULL);
+    vec->chunks[k] = chunk;
+    vec->chunk_count++;
+}
+
+// Point the push cursor at index `len`, or at nothing when every chunk is full
+void SegVec_seek_(SegVec *vec)
+{
+    if (vec->len == SegVec_capacity(vec))
+    {
+        vec->cursor = vec->cursor_end = NULL;
+        return;
+    }
+    size_t chunk, offset;
+    SegVec_locate_(vec->len, &chunk, &offset);
+    char *start = vec->chunks[chunk];
+    vec->cursor = start + offset * vec->elem_size;
+    vec->cursor_end = start + SegVec_chunk_capacity_(chunk) * vec->elem_size;
+}
+
+__attribute__((noinline)) void SegVec_grow_(SegVec *vec)
+{
+    if (vec->len == SegVec_capacity(vec))
+    {
+        SegVec_add_chunk_(vec);
+    }
+    SegVec_seek_(vec);
+}
+
+void SegVec_reserve(SegVec *vec, size_t additional)
+{
+    while (SegVec_capacity(vec) < vec->len + additional)
+    {
+        SegVec_add_chunk_(vec);
+    }
+    SegVec_seek_(vec);
+}
+
+bool SegVec_pop(SegVec *vec, void *out)
+{
+    if (vec->len == 0)
+    {
+        return false;
+    }
+    void *last = SegVec_get(vec, vec->len - 1);
+    if (out != NULL)
+    {
+        memcpy(out, last, vec->elem_size);
+    }
+    vec->len--;
+    SegVec_seek_(vec);
+    return true;
+}
+
+void SegVec_truncate(SegVec *vec, size_t new_len)
+{
+    if (new_len < vec->len)
+    {
+        vec->len = new_len;
+        SegVec_seek_(vec);
+    }
+}
+
+void SegVec_clear(SegVec *vec)
+{
+    SegVec_truncate(vec, 0);
+}
+
+size_t SegVec_chunk_count(const SegVec *vec)
+{
+    if (vec->len == 0)
+    {
+        return 0;
+    }
+    size_t chunk, offset;
+    SegVec_locate_(vec->len - 1, &chunk, &offset);
+    return chunk + 1;
+}
+
+SegVecChunk SegVec_chunk(const SegVec *vec, size_t k)
+{
+    assert(k < SegVec_chunk_count(vec));
+    size_t start = SegVec_capacity_of_(k);
+    size_t len = vec->len - start;
+    if (len > SegVec_chunk_capacity_(k))
+    {
+        len = SegVec_chunk_capacity_(k);
+    }
+    return (SegVecChunk){.ptr = vec->chunks[k], .len = len};
+}
+
+void SegVec_drop(SegVec *vec)
+{
+    for (size_t k = 0; k < vec->chunk_count; k++)
+    {
+        vec->alloc.deallocate(vec->chunks[k]);
+        vec->chunks[k] = NULL;
+    }
+    vec->chunk_count = 0;
+    vec->len = 0;
+    vec->cursor = vec->cursor_end = NULL;
+}
+
+#endif // SEGVEC_IMPLEMENTATION
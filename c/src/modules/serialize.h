@@ -0,0 +1,659 @@
+#ifndef _SERIALIZE_H_INCLUDED_
+#define _SERIALIZE_H_INCLUDED_
+
+/**
+ * The hash rounds and StringTable access are static inline; the rest is
+ * emitted where SERIALIZE_IMPLEMENTATION is defined. One unit also
+ * defines ALLOC_, RAWVEC_, VEC_ and STRING_IMPLEMENTATION.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+#include <errno.h>
+#include "vec.h"
+#include "string.h"
+
+/**
+ * Binary record format, native byte order:
+ *
+ *   [SerialHeader, 64 bytes][payload][zero padding to a multiple of 64]
+ *
+ * Every record is a multiple of SERIAL_ALIGN bytes, so records written back
+ * to back keep their payloads aligned and can be viewed in place from a
+ * malloc'd buffer or a mapping. A Vec of Strings is stored as a table of
+ * len + 1 uint64 offsets followed by the NUL-terminated string bytes.
+ */
+#define SERIAL_MAGIC 0x52455343u // "CSER"
+#define SERIAL_VERSION 1
+#define SERIAL_ALIGN 64
+// Alignment the loaders require of the start of a record
+#define SERIAL_VIEW_ALIGN 8
+
+// Largest payload the stream readers accept from a stream they cannot seek
+#ifndef SERIAL_MAX_STREAM_PAYLOAD
+#define SERIAL_MAX_STREAM_PAYLOAD (1ull << 30)
+#endif
+
+// Flag: store an XXH64 checksum of the payload and verify it on load
+#define SERIAL_CHECKSUM 1u
+
+typedef enum
+{
+    SERIAL_VEC = 1,
+    SERIAL_STRING = 2,
+    SERIAL_STRING_TABLE = 3,
+} SerialKind;
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t kind;
+    uint32_t elem_size;
+    uint32_t flags;
+    uint64_t len;
+    uint64_t payload_size;
+    uint64_t checksum;
+    uint64_t reserved[3];
+} SerialHeader;
+
+_Static_assert(sizeof(SerialHeader) == SERIAL_ALIGN, "SerialHeader must fill one alignment unit");
+
+// A borrowed view of a serialized Vec; `ptr` points into the source buffer
+typedef struct
+{
+    const void *ptr;
+    size_t len;
+} VecView;
+
+// A borrowed view of a serialized Vec of Strings
+typedef struct
+{
+    const uint64_t *offsets;
+    const char *bytes;
+    size_t len;
+} StringTable;
+
+#define SERIAL_P1 0x9E3779B185EBCA87ull
+#define SERIAL_P2 0xC2B2AE3D27D4EB4Full
+#define SERIAL_P3 0x165667B19E3779F9ull
+#define SERIAL_P4 0x85EBCA77C2B2AE63ull
+#define SERIAL_P5 0x27D4EB2F165667C5ull
+
+// Streaming XXH64 (seed 0), so payloads written in pieces can be checksummed
+typedef struct
+{
+    uint64_t acc[4];
+    unsigned char stripe[32];
+    size_t stripe_len;
+    uint64_t total;
+} SerialHasher;
+
+static inline uint64_t Serial_rotl_(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t Serial_round_(uint64_t acc, uint64_t input)
+{
+    acc += input * SERIAL_P2;
+    return Serial_rotl_(acc, 31) * SERIAL_P1;
+}
+
+static inline uint64_t Serial_load64_(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t Serial_load32_(const unsigned char *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+SerialHasher SerialHasher_new();
+
+// Consume whole 32-byte stripes; returns the number of bytes used
+static inline size_t SerialHasher_stripes_(SerialHasher *h, const unsigned char *p, size_t len)
+{
+    uint64_t a0 = h->acc[0], a1 = h->acc[1], a2 = h->acc[2], a3 = h->acc[3];
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        a0 = Serial_round_(a0, Serial_load64_(p + i));
+        a1 = Serial_round_(a1, Serial_load64_(p + i + 8));
+        a2 = Serial_round_(a2, Serial_load64_(p + i + 16));
+        a3 = Serial_round_(a3, Serial_load64_(p + i + 24));
+    }
+    h->acc[0] = a0, h->acc[1] = a1, h->acc[2] = a2, h->acc[3] = a3;
+    return i;
+}
+
+// Feed bytes to the hasher
+void SerialHasher_update(SerialHasher *h, const void *data, size_t len);
+
+// Finish the hash
+uint64_t SerialHasher_finish(const SerialHasher *h);
+
+// XXH64 of a contiguous buffer
+static inline uint64_t Serial_checksum(const void *data, size_t len)
+{
+    SerialHasher h = SerialHasher_new();
+    SerialHasher_update(&h, data, len);
+    return SerialHasher_finish(&h);
+}
+
+static inline size_t Serial_padding_(uint64_t payload_size)
+{
+    return (size_t)((SERIAL_ALIGN - payload_size % SERIAL_ALIGN) % SERIAL_ALIGN);
+}
+
+// Total size of a record with the given payload, header and padding included
+static inline size_t Serial_record_size(size_t payload_size)
+{
+    return sizeof(SerialHeader) + payload_size + Serial_padding_(payload_size);
+}
+
+/**
+ * Write a Vec as one record. The elements are written straight from the
+ * Vec's buffer with a single fwrite. Returns false and sets errno on a
+ * write error.
+ */
+bool Vec_serialize(const Vec *vec, size_t elem_size, FILE *out, uint32_t flags);
+
+// Write a String as one record; the payload keeps its NUL terminator
+bool String_serialize(const String *s, FILE *out, uint32_t flags);
+
+/**
+ * Write a Vec whose elements are Strings as an offset table followed by the
+ * concatenated, NUL-terminated strings. Load it back with
+ * StringTable_view_serialized to get every string without copying.
+ */
+bool Vec_serialize_strings(const Vec *strings, FILE *out, uint32_t flags);
+
+/**
+ * Borrow a serialized Vec in place. `data` must be aligned to
+ * SERIAL_VIEW_ALIGN (and to the element type's alignment, which malloc and
+ * mmap give). `*consumed` is set to the record size so several records can
+ * be read from one buffer. Returns false and sets errno (EINVAL for a bad
+ * or truncated record, EBADMSG for a checksum mismatch).
+ */
+bool Vec_view_serialized(const void *data, size_t size, size_t elem_size, VecView *out, size_t *consumed);
+
+// Borrow a serialized String in place; the view is also NUL-terminated
+bool String_view_serialized(const void *data, size_t size, StringView *out, size_t *consumed);
+
+// Borrow a serialized Vec of Strings in place
+bool StringTable_view_serialized(const void *data, size_t size, StringTable *out, size_t *consumed);
+
+// Get the number of strings in a StringTable
+static inline size_t StringTable_len(const StringTable *table)
+{
+    return table->len;
+}
+
+// Borrow one string of a StringTable; the view is also NUL-terminated
+static inline StringView StringTable_get(const StringTable *table, size_t index)
+{
+    assert(index < table->len);
+    uint64_t start = table->offsets[index];
+    return (StringView){
+        .ptr = table->bytes + start,
+        .len = (size_t)(table->offsets[index + 1] - start - 1)};
+}
+
+// Load a serialized Vec into a new Vec with a single copy of the payload
+bool Vec_deserialize(const void *data, size_t size, size_t elem_size, Vec *out, size_t *consumed);
+
+// Load a serialized String into a new String
+bool String_deserialize(const void *data, size_t size, String *out, size_t *consumed);
+
+/**
+ * Read one Vec record from a stream. The elements are read directly into
+ * the new Vec's buffer. On failure `out` is left empty.
+ */
+bool Vec_read_serialized(FILE *in, size_t elem_size, Vec *out);
+
+// Read one String record from a stream
+bool String_read_serialized(FILE *in, String *out);
+
+#endif // _SERIALIZE_H_INCLUDED_
+
+#if defined(SERIALIZE_IMPLEMENTATION) && !defined(_SERIALIZE_IMPLEMENTATION_INCLUDED_)
+#define _SERIALIZE_IMPLEMENTATION_INCLUDED_
+
+SerialHasher SerialHasher_new()
+{
+    return (SerialHasher){
+        .acc = {SERIAL_P1 + SERIAL_P2, SERIAL_P2, 0, -SERIAL_P1},
+        .stripe_len = 0,
+        .total = 0};
+}
+
+void SerialHasher_update(SerialHasher *h, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+    if (len == 0)
+    {
+        return;
+    }
+    h->total += len;
+    if (h->stripe_len > 0)
+    {
+        size_t take = 32 - h->stripe_len < len ? 32 - h->stripe_len : len;
+        memcpy(h->stripe + h->stripe_len, p, take);
+        h->stripe_len += take;
+        p += take;
+        len -= take;
+        if (h->stripe_len < 32)
+        {
+            return;
+        }
+        SerialHasher_stripes_(h, h->stripe, 32);
+        h->stripe_len = 0;
+    }
+    size_t used = SerialHasher_stripes_(h, p, len);
+    memcpy(h->stripe, p + used, len - used);
+    h->stripe_len = len - used;
+}
+
+uint64_t SerialHasher_finish(const SerialHasher *h)
+{
+    uint64_t hash;
+    if (h->total >= 32)
+    {
+        hash = Serial_rotl_(h->acc[0], 1) + Serial_rotl_(h->acc[1], 7) +
+               Serial_rotl_(h->acc[2], 12) + Serial_rotl_(h->acc[3], 18);
+        for (size_t i = 0; i < 4; i++)
+        {
+            hash ^= Serial_round_(0, h->acc[i]);
+            hash = hash * SERIAL_P1 + SERIAL_P4;
+        }
+    }
+    else
+    {
+        hash = SERIAL_P5;
+    }
+    hash += h->total;
+    const unsigned char *p = h->stripe;
+    size_t len = h->stripe_len;
+    for (; len >= 8; p += 8, len -= 8)
+    {
+        hash ^= Serial_round_(0, Serial_load64_(p));
+        hash = Serial_rotl_(hash, 27) * SERIAL_P1 + SERIAL_P4;
+    }
+    if (len >= 4)
+    {
+        hash ^= (uint64_t)Serial_load32_(p) * SERIAL_P1;
+        hash = Serial_rotl_(hash, 23) * SERIAL_P2 + SERIAL_P3;
+        p += 4;
+        len -= 4;
+    }
+    for (; len > 0; p++, len--)
+    {
+        hash ^= *p * SERIAL_P5;
+        hash = Serial_rotl_(hash, 11) * SERIAL_P1;
+    }
+    hash ^= hash >> 33;
+    hash *= SERIAL_P2;
+    hash ^= hash >> 29;
+    hash *= SERIAL_P3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+bool Serial_write_(FILE *out, const void *data, size_t len)
+{
+    if (len > 0 && fwrite(data, 1, len, out) != len)
+    {
+        errno = errno == 0 ? EIO : errno;
+        return false;
+    }
+    return true;
+}
+
+bool Serial_write_padding_(FILE *out, uint64_t payload_size)
+{
+    static const unsigned char zeros[SERIAL_ALIGN];
+    return Serial_write_(out, zeros, Serial_padding_(payload_size));
+}
+
+SerialHeader Serial_header_(SerialKind kind, size_t elem_size, uint32_t flags, size_t len, size_t payload_size)
+{
+    return (SerialHeader){
+        .magic = SERIAL_MAGIC,
+        .version = SERIAL_VERSION,
+        .kind = (uint16_t)kind,
+        .elem_size = (uint32_t)elem_size,
+        .flags = flags,
+        .len = len,
+        .payload_size = payload_size,
+        .checksum = 0};
+}
+
+bool Vec_serialize(const Vec *vec, size_t elem_size, FILE *out, uint32_t flags)
+{
+    size_t bytes = vec->len * elem_size;
+    SerialHeader header = Serial_header_(SERIAL_VEC, elem_size, flags, vec->len, bytes);
+    if (flags & SERIAL_CHECKSUM)
+    {
+        header.checksum = Serial_checksum(vec->buf.ptr, bytes);
+    }
+    return Serial_write_(out, &header, sizeof(header)) &&
+           Serial_write_(out, vec->buf.ptr, bytes) &&
+           Serial_write_padding_(out, bytes);
+}
+
+bool String_serialize(const String *s, FILE *out, uint32_t flags)
+{
+    StringView view = String_as_view(s);
+    SerialHeader header = Serial_header_(SERIAL_STRING, 1, flags, view.len, view.len + 1);
+    if (flags & SERIAL_CHECKSUM)
+    {
+        header.checksum = Serial_checksum(view.ptr, view.len + 1);
+    }
+    return Serial_write_(out, &header, sizeof(header)) &&
+           Serial_write_(out, view.ptr, view.len + 1) &&
+           Serial_write_padding_(out, view.len + 1);
+}
+
+bool Vec_serialize_strings(const Vec *strings, FILE *out, uint32_t flags)
+{
+    const String *items = Vec_as_slice(strings);
+    size_t count = strings->len;
+    Vec offsets = Vec_with_capacity(count + 1, sizeof(uint64_t));
+    uint64_t offset = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        Vec_push(&offsets, &offset, sizeof(uint64_t));
+        offset += String_len(&items[i]) + 1;
+    }
+    Vec_push(&offsets, &offset, sizeof(uint64_t));
+
+    size_t table_bytes = (count + 1) * sizeof(uint64_t);
+    size_t payload = table_bytes + offset;
+    SerialHeader header = Serial_header_(SERIAL_STRING_TABLE, sizeof(uint64_t), flags, count, payload);
+    if (flags & SERIAL_CHECKSUM)
+    {
+        SerialHasher h = SerialHasher_new();
+        SerialHasher_update(&h, offsets.buf.ptr, table_bytes);
+        for (size_t i = 0; i < count; i++)
+        {
+            StringView view = String_as_view(&items[i]);
+            SerialHasher_update(&h, view.ptr, view.len + 1);
+        }
+        header.checksum = SerialHasher_finish(&h);
+    }
+    bool ok = Serial_write_(out, &header, sizeof(header)) &&
+              Serial_write_(out, offsets.buf.ptr, table_bytes);
+    for (size_t i = 0; ok && i < count; i++)
+    {
+        StringView view = String_as_view(&items[i]);
+        ok = Serial_write_(out, view.ptr, view.len + 1);
+    }
+    Vec_drop(&offsets);
+    return ok && Serial_write_padding_(out, payload);
+}
+
+// Check a record's header and checksum; returns its payload
+const unsigned char *Serial_check_(const void *data, size_t size, SerialKind kind, size_t elem_size,
+                                   SerialHeader *header, size_t *consumed)
+{
+    if ((uintptr_t)data % SERIAL_VIEW_ALIGN != 0 || size < sizeof(SerialHeader))
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    memcpy(header, data, sizeof(SerialHeader));
+    if (header->magic != SERIAL_MAGIC || header->version != SERIAL_VERSION ||
+        header->kind != kind || header->elem_size != elem_size ||
+        header->payload_size > size - sizeof(SerialHeader))
+    {
+        errno = EINVAL;
+        return NULL;
+    }
+    const unsigned char *payload = (const unsigned char *)data + sizeof(SerialHeader);
+    if ((header->flags & SERIAL_CHECKSUM) &&
+        Serial_checksum(payload, header->payload_size) != header->checksum)
+    {
+        errno = EBADMSG;
+        return NULL;
+    }
+    if (consumed != NULL)
+    {
+        size_t record = Serial_record_size(header->payload_size);
+        *consumed = record < size ? record : size;
+    }
+    return payload;
+}
+
+bool Vec_view_serialized(const void *data, size_t size, size_t elem_size, VecView *out, size_t *consumed)
+{
+    SerialHeader header;
+    const unsigned char *payload = Serial_check_(data, size, SERIAL_VEC, elem_size, &header, consumed);
+    if (payload == NULL)
+    {
+        return false;
+    }
+    if (elem_size == 0 || header.len != header.payload_size / elem_size || header.payload_size % elem_size != 0)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    *out = (VecView){.ptr = payload, .len = header.len};
+    return true;
+}
+
+bool String_view_serialized(const void *data, size_t size, StringView *out, size_t *consumed)
+{
+    SerialHeader header;
+    const unsigned char *payload = Serial_check_(data, size, SERIAL_STRING, 1, &header, consumed);
+    if (payload == NULL)
+    {
+        return false;
+    }
+    // len comes from the input: len + 1 must not wrap
+    if (header.len == UINT64_MAX || header.payload_size != header.len + 1 || payload[header.len] != '\0')
+    {
+        errno = EINVAL;
+        return false;
+    }
+    *out = (StringView){.ptr = (const char *)payload, .len = header.len};
+    return true;
+}
+
+bool StringTable_view_serialized(const void *data, size_t size, StringTable *out, size_t *consumed)
+{
+    SerialHeader header;
+    const unsigned char *payload = Serial_check_(data, size, SERIAL_STRING_TABLE, sizeof(uint64_t), &header, consumed);
+    if (payload == NULL)
+    {
+        return false;
+    }
+    uint64_t table_bytes = (header.len + 1) * sizeof(uint64_t);
+    if (header.len >= header.payload_size / sizeof(uint64_t) || table_bytes > header.payload_size)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    const uint64_t *offsets = (const uint64_t *)payload;
+    const char *bytes = (const char *)payload + table_bytes;
+    uint64_t blob = header.payload_size - table_bytes;
+    if (offsets[0] != 0 || offsets[header.len] != blob)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    // Every string must end in a NUL inside its own slot
+    for (size_t i = 0; i < header.len; i++)
+    {
+        if (offsets[i] >= offsets[i + 1] || bytes[offsets[i + 1] - 1] != '\0')
+        {
+            errno = EINVAL;
+            return false;
+        }
+    }
+    *out = (StringTable){.offsets = offsets, .bytes = bytes, .len = header.len};
+    return true;
+}
+
+bool Vec_deserialize(const void *data, size_t size, size_t elem_size, Vec *out, size_t *consumed)
+{
+    VecView view;
+    if (!Vec_view_serialized(data, size, elem_size, &view, consumed))
+    {
+        return false;
+    }
+    *out = Vec_with_capacity(view.len, elem_size);
+    if (view.len > 0)
+    {
+        memcpy(out->buf.ptr, view.ptr, view.len * elem_size);
+    }
+    out->len = view.len;
+    return true;
+}
+
+bool String_deserialize(const void *data, size_t size, String *out, size_t *consumed)
+{
+    StringView view;
+    if (!String_view_serialized(data, size, &view, consumed))
+    {
+        return false;
+    }
+    *out = String_from_view(view);
+    return true;
+}
+
+// Bytes left in a seekable stream, or false if it cannot seek
+bool Serial_stream_remaining_(FILE *in, uint64_t *remaining)
+{
+    long pos = ftell(in);
+    if (pos < 0 || fseek(in, 0, SEEK_END) != 0)
+    {
+        return false;
+    }
+    long end = ftell(in);
+    if (end < 0 || fseek(in, pos, SEEK_SET) != 0)
+    {
+        return false;
+    }
+    *remaining = (uint64_t)(end - pos);
+    return true;
+}
+
+/**
+ * Read a header from a stream and check it against the expected kind. The
+ * payload size comes from the input, so it must fit in what is left of the
+ * stream (or under SERIAL_MAX_STREAM_PAYLOAD for pipes) before anything is
+ * allocated for it.
+ */
+bool Serial_read_header_(FILE *in, SerialKind kind, size_t elem_size, SerialHeader *header)
+{
+    if (fread(header, sizeof(SerialHeader), 1, in) != 1)
+    {
+        errno = ferror(in) ? EIO : EINVAL;
+        return false;
+    }
+    if (header->magic != SERIAL_MAGIC || header->version != SERIAL_VERSION ||
+        header->kind != kind || header->elem_size != elem_size)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    uint64_t remaining;
+    if (!Serial_stream_remaining_(in, &remaining))
+    {
+        remaining = SERIAL_MAX_STREAM_PAYLOAD;
+    }
+    if (header->payload_size > remaining)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    return true;
+}
+
+// Read a payload straight into `dst`, skip the padding and verify the checksum
+bool Serial_read_payload_(FILE *in, const SerialHeader *header, void *dst)
+{
+    unsigned char padding[SERIAL_ALIGN];
+    size_t pad = Serial_padding_(header->payload_size);
+    if ((header->payload_size > 0 && fread(dst, header->payload_size, 1, in) != 1) ||
+        (pad > 0 && fread(padding, pad, 1, in) != 1))
+    {
+        errno = ferror(in) ? EIO : EINVAL;
+        return false;
+    }
+    if ((header->flags & SERIAL_CHECKSUM) &&
+        Serial_checksum(dst, header->payload_size) != header->checksum)
+    {
+        errno = EBADMSG;
+        return false;
+    }
+    return true;
+}
+
+bool Vec_read_serialized(FILE *in, size_t elem_size, Vec *out)
+{
+    *out = Vec_new();
+    SerialHeader header;
+    if (!Serial_read_header_(in, SERIAL_VEC, elem_size, &header))
+    {
+        return false;
+    }
+    // Divide rather than multiply: len * elem_size can wrap
+    if (elem_size == 0 || header.len != header.payload_size / elem_size || header.payload_size % elem_size != 0)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    *out = Vec_with_capacity(header.len, elem_size);
+    if (!Serial_read_payload_(in, &header, out->buf.ptr))
+    {
+        Vec_drop(out);
+        *out = Vec_new();
+        return false;
+    }
+    out->len = header.len;
+    return true;
+}
+
+bool String_read_serialized(FILE *in, String *out)
+{
+    *out = String_new();
+    SerialHeader header;
+    if (!Serial_read_header_(in, SERIAL_STRING, 1, &header))
+    {
+        return false;
+    }
+    if (header.len == UINT64_MAX || header.payload_size != header.len + 1)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    *out = String_with_capacity(header.len + 1);
+    bool ok = Serial_read_payload_(in, &header, out->vec.buf.ptr);
+    if (ok && String_as_str(out)[header.len] != '\0')
+    {
+        errno = EINVAL;
+        ok = false;
+    }
+    if (!ok)
+    {
+        String_drop(out);
+        *out = String_new();
+        return false;
+    }
+    out->vec.len = header.len;
+    return true;
+}
+
+#endif // SERIALIZE_IMPLEMENTATION
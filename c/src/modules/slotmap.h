@@ -0,0 +1,213 @@
+#ifndef _SLOTMAP_H_INCLUDED_
+#define _SLOTMAP_H_INCLUDED_
+
+/**
+ * Lookups are static inline; insert, remove and drop are emitted by the
+ * unit that defines SLOTMAP_IMPLEMENTATION. The program also needs
+ * ALLOC_, RAWVEC_ and VEC_IMPLEMENTATION in one unit.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "vec.h"
+
+// A handle: the slot's generation in the high 32 bits, its index in the low 32
+typedef uint64_t SlotMapHandle;
+
+// Never returned by SlotMap_insert
+#define SLOTMAP_NULL ((SlotMapHandle)0)
+#define SLOTMAP_NO_SLOT UINT32_MAX
+
+/**
+ * A slot's generation is odd while it holds a value and even while it is
+ * free. `index` is the value's position in the dense array while occupied,
+ * and the next free slot while free.
+ */
+typedef struct
+{
+    uint32_t generation;
+    uint32_t index;
+} SlotMapSlot;
+
+/**
+ * Values packed densely in a Vec, addressed through stable 64-bit handles.
+ * Removal moves the last value into the hole, so iteration over the dense
+ * array stays contiguous; the sparse slot array maps a handle's index to
+ * the value's current position, and the generation in the handle catches
+ * handles to removed values. Freed slots are reused last-in first-out, so
+ * the most recently touched slot is the next one handed out.
+ */
+typedef struct
+{
+    Vec values;
+    Vec value_slots;
+    Vec slots;
+    uint32_t free_head;
+    size_t elem_size;
+} SlotMap;
+
+// Create an empty SlotMap of `elem_size`-byte values
+SlotMap SlotMap_new(size_t elem_size);
+
+static inline SlotMapHandle SlotMap_handle_(uint32_t generation, uint32_t slot)
+{
+    return ((uint64_t)generation << 32) | slot;
+}
+
+static inline SlotMapSlot *SlotMap_slots_(const SlotMap *map)
+{
+    return map->slots.buf.ptr;
+}
+
+// Number of values in the map
+static inline size_t SlotMap_len(const SlotMap *map)
+{
+    return map->values.len;
+}
+
+// Slot for a handle that is still live, or NULL
+static inline SlotMapSlot *SlotMap_live_slot_(const SlotMap *map, SlotMapHandle handle)
+{
+    uint32_t slot = (uint32_t)handle;
+    if (slot >= map->slots.len)
+    {
+        return NULL;
+    }
+    SlotMapSlot *s = &SlotMap_slots_(map)[slot];
+    return s->generation == (uint32_t)(handle >> 32) ? s : NULL;
+}
+
+// Insert a copy of `value` and return its handle
+SlotMapHandle SlotMap_insert(SlotMap *map, const void *value);
+
+// Get a pointer to the value for `handle`, or NULL if it was removed
+static inline void *SlotMap_get(const SlotMap *map, SlotMapHandle handle)
+{
+    SlotMapSlot *s = SlotMap_live_slot_(map, handle);
+    return s == NULL ? NULL : (char *)map->values.buf.ptr + (size_t)s->index * map->elem_size;
+}
+
+static inline bool SlotMap_contains(const SlotMap *map, SlotMapHandle handle)
+{
+    return SlotMap_live_slot_(map, handle) != NULL;
+}
+
+/**
+ * Remove the value for `handle`, copying it to `out` if that is not NULL.
+ * Returns false for a stale or unknown handle. The last value moves into
+ * the freed position, so pointers into the dense array are invalidated.
+ */
+bool SlotMap_remove(SlotMap *map, SlotMapHandle handle, void *out);
+
+// The dense array of values, SlotMap_len of them in no particular order
+static inline void *SlotMap_values(const SlotMap *map)
+{
+    return map->values.buf.ptr;
+}
+
+// Handle of the value at position `index` of the dense array
+static inline SlotMapHandle SlotMap_handle_at(const SlotMap *map, size_t index)
+{
+    assert(index < map->values.len);
+    uint32_t slot = ((const uint32_t *)map->value_slots.buf.ptr)[index];
+    return SlotMap_handle_(SlotMap_slots_(map)[slot].generation, slot);
+}
+
+// Remove every value; all existing handles become stale
+void SlotMap_clear(SlotMap *map);
+
+// Free the memory used by the SlotMap
+void SlotMap_drop(SlotMap *map);
+
+#endif // _SLOTMAP_H_INCLUDED_
+
+#if defined(SLOTMAP_IMPLEMENTATION) && !defined(_SLOTMAP_IMPLEMENTATION_INCLUDED_)
+#define _SLOTMAP_IMPLEMENTATION_INCLUDED_
+
+SlotMap SlotMap_new(size_t elem_size)
+{
+    return (SlotMap){
+        .values = Vec_new(),
+        .value_slots = Vec_new(),
+        .slots = Vec_new(),
+        .free_head = SLOTMAP_NO_SLOT,
+        .elem_size = elem_size};
+}
+
+SlotMapHandle SlotMap_insert(SlotMap *map, const void *value)
+{
+    assert(map->values.len < SLOTMAP_NO_SLOT);
+    uint32_t slot = map->free_head;
+    if (slot == SLOTMAP_NO_SLOT)
+    {
+        slot = (uint32_t)map->slots.len;
+        SlotMapSlot fresh = {.generation = 0, .index = 0};
+        Vec_push(&map->slots, &fresh, sizeof(fresh));
+    }
+    SlotMapSlot *s = &SlotMap_slots_(map)[slot];
+    if (map->free_head == slot)
+    {
+        map->free_head = s->index;
+    }
+    s->generation++;
+    s->index = (uint32_t)map->values.len;
+    Vec_push(&map->values, value, map->elem_size);
+    Vec_push(&map->value_slots, &slot, sizeof(slot));
+    return SlotMap_handle_(s->generation, slot);
+}
+
+bool SlotMap_remove(SlotMap *map, SlotMapHandle handle, void *out)
+{
+    SlotMapSlot *s = SlotMap_live_slot_(map, handle);
+    if (s == NULL)
+    {
+        return false;
+    }
+    size_t size = map->elem_size;
+    char *values = map->values.buf.ptr;
+    uint32_t *value_slots = map->value_slots.buf.ptr;
+    size_t index = s->index, last = map->values.len - 1;
+    if (out != NULL)
+    {
+        memcpy(out, values + index * size, size);
+    }
+    if (index != last)
+    {
+        memcpy(values + index * size, values + last * size, size);
+        value_slots[index] = value_slots[last];
+        SlotMap_slots_(map)[value_slots[index]].index = (uint32_t)index;
+    }
+    map->values.len--;
+    map->value_slots.len--;
+
+    s->generation++;
+    // A slot whose generation would wrap is retired instead of reused
+    if (s->generation != UINT32_MAX - 1)
+    {
+        s->index = map->free_head;
+        map->free_head = (uint32_t)handle;
+    }
+    return true;
+}
+
+void SlotMap_clear(SlotMap *map)
+{
+    while (map->values.len > 0)
+    {
+        SlotMap_remove(map, SlotMap_handle_at(map, map->values.len - 1), NULL);
+    }
+}
+
+void SlotMap_drop(SlotMap *map)
+{
+    Vec_drop(&map->values);
+    Vec_drop(&map->value_slots);
+    Vec_drop(&map->slots);
+    map->free_head = SLOTMAP_NO_SLOT;
+}
+
+#endif // SLOTMAP_IMPLEMENTATION
@@ -0,0 +1,174 @@
+#ifndef _SOA_H_INCLUDED_
+#define _SOA_H_INCLUDED_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "rawvec.h"
+
+// Pick apart a `(type, name)` field description
+#define SOA_TYPE_(type, name) type
+#define SOA_NAME_(type, name) name
+
+#define SOA_CAT_(a, b) SOA_CAT_I_(a, b)
+#define SOA_CAT_I_(a, b) a##b
+
+// Count up to 16 arguments
+#define SOA_NARGS_(...) SOA_NARGS_I_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+#define SOA_NARGS_I_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, n, ...) n
+
+// Expand m(S, field) for each field
+#define SOA_FOR_EACH_(m, S, ...) SOA_CAT_(SOA_FE_, SOA_NARGS_(__VA_ARGS__))(m, S, __VA_ARGS__)
+#define SOA_FE_1(m, S, x) m(S, x)
+#define SOA_FE_2(m, S, x, ...) m(S, x) SOA_FE_1(m, S, __VA_ARGS__)
+#define SOA_FE_3(m, S, x, ...) m(S, x) SOA_FE_2(m, S, __VA_ARGS__)
+#define SOA_FE_4(m, S, x, ...) m(S, x) SOA_FE_3(m, S, __VA_ARGS__)
+#define SOA_FE_5(m, S, x, ...) m(S, x) SOA_FE_4(m, S, __VA_ARGS__)
+#define SOA_FE_6(m, S, x, ...) m(S, x) SOA_FE_5(m, S, __VA_ARGS__)
+#define SOA_FE_7(m, S, x, ...) m(S, x) SOA_FE_6(m, S, __VA_ARGS__)
+#define SOA_FE_8(m, S, x, ...) m(S, x) SOA_FE_7(m, S, __VA_ARGS__)
+#define SOA_FE_9(m, S, x, ...) m(S, x) SOA_FE_8(m, S, __VA_ARGS__)
+#define SOA_FE_10(m, S, x, ...) m(S, x) SOA_FE_9(m, S, __VA_ARGS__)
+#define SOA_FE_11(m, S, x, ...) m(S, x) SOA_FE_10(m, S, __VA_ARGS__)
+#define SOA_FE_12(m, S, x, ...) m(S, x) SOA_FE_11(m, S, __VA_ARGS__)
+#define SOA_FE_13(m, S, x, ...) m(S, x) SOA_FE_12(m, S, __VA_ARGS__)
+#define SOA_FE_14(m, S, x, ...) m(S, x) SOA_FE_13(m, S, __VA_ARGS__)
+#define SOA_FE_15(m, S, x, ...) m(S, x) SOA_FE_14(m, S, __VA_ARGS__)
+#define SOA_FE_16(m, S, x, ...) m(S, x) SOA_FE_15(m, S, __VA_ARGS__)
+
+// Per-field pieces of the generated code; `S` is the SoA's name
+#define SOA_COLUMN_(S, f) RawVec SOA_NAME_ f;
+#define SOA_COLUMN_NEW_(S, f) s.SOA_NAME_ f = RawVec_new(alloc);
+#define SOA_COLUMN_GROW_(S, f) RawVec_grow(&s->SOA_NAME_ f, needed, sizeof(SOA_TYPE_ f));
+#define SOA_COLUMN_DROP_(S, f) RawVec_drop(&s->SOA_NAME_ f);
+#define SOA_COLUMN_STORE_(S, f)                                                            \
+    memcpy((SOA_TYPE_ f *)s->SOA_NAME_ f.ptr + index, &row->SOA_NAME_ f, sizeof(SOA_TYPE_ f));
+#define SOA_COLUMN_LOAD_(S, f)                                                             \
+    memcpy(&out->SOA_NAME_ f, (const SOA_TYPE_ f *)s->SOA_NAME_ f.ptr + index, sizeof(SOA_TYPE_ f));
+#define SOA_COLUMN_SCATTER_(S, f)                                                          \
+    {                                                                                      \
+        SOA_TYPE_ f *column = (SOA_TYPE_ f *)s->SOA_NAME_ f.ptr + s->len;                  \
+        for (size_t i = 0; i < count; i++)                                                 \
+        {                                                                                  \
+            memcpy(&column[i], &rows[i].SOA_NAME_ f, sizeof(SOA_TYPE_ f));                 \
+        }                                                                                  \
+    }
+#define SOA_COLUMN_GATHER_(S, f)                                                           \
+    {                                                                                      \
+        const SOA_TYPE_ f *column = (const SOA_TYPE_ f *)s->SOA_NAME_ f.ptr;               \
+        for (size_t i = 0; i < s->len; i++)                                                \
+        {                                                                                  \
+            memcpy(&rows[i].SOA_NAME_ f, &column[i], sizeof(SOA_TYPE_ f));                 \
+        }                                                                                  \
+    }
+#define SOA_COLUMN_ACCESSOR_(S, f)                                                         \
+    static inline SOA_TYPE_ f *SOA_CAT_(S##_column_, SOA_NAME_ f)(const S *s)              \
+    {                                                                                      \
+        return (SOA_TYPE_ f *)s->SOA_NAME_ f.ptr;                                          \
+    }
+
+/**
+ * Define a structure-of-arrays container `Name` for records of type `Row`.
+ * Each field is given as `(type, name)` and must match a member of `Row`;
+ * up to 16 fields. Every field gets its own RawVec column, and all columns
+ * share one `len` and `cap` and grow together through Name_grow_.
+ *
+ *     typedef struct { int id; double score; } Person;
+ *     define_SoA(People, Person, (int, id), (double, score));
+ *
+ *     People p = People_new(GLOBAL_ALLOCATOR);
+ *     People_push(&p, &(Person){1, 2.5});
+ *     double *scores = People_column_score(&p); // People_len(&p) contiguous doubles
+ *
+ * Generated: Name_new, Name_len, Name_capacity, Name_reserve, Name_push,
+ * Name_get, Name_set, Name_extend_from_rows (AoS to SoA), Name_to_rows
+ * (SoA to AoS), Name_clear, Name_drop and one Name_column_<field> per field.
+ * A field whose type is an array must be given through a typedef.
+ */
+#define define_SoA(Name, Row, ...)                                                                 \
+    typedef struct                                                                                 \
+    {                                                                                              \
+        SOA_FOR_EACH_(SOA_COLUMN_, Name, __VA_ARGS__)                                              \
+        size_t len;                                                                                \
+        size_t cap;                                                                                \
+    } Name;                                                                                        \
+    Name Name##_new(Allocator alloc)                                                               \
+    {                                                                                              \
+        Name s;                                                                                    \
+        SOA_FOR_EACH_(SOA_COLUMN_NEW_, Name, __VA_ARGS__)                                          \
+        s.len = 0;                                                                                 \
+        s.cap = 0;                                                                                 \
+        return s;                                                                                  \
+    }                                                                                              \
+    size_t Name##_len(const Name *s)                                                               \
+    {                                                                                              \
+        return s->len;                                                                             \
+    }                                                                                              \
+    size_t Name##_capacity(const Name *s)                                                          \
+    {                                                                                              \
+        return s->cap;                                                                             \
+    }                                                                                              \
+    /* The one grow path: every column is at the same capacity, so each RawVec_grow */             \
+    /* picks the same new capacity */                                                              \
+    __attribute__((noinline)) void Name##_grow_(Name *s, size_t needed)                            \
+    {                                                                                              \
+        SOA_FOR_EACH_(SOA_COLUMN_GROW_, Name, __VA_ARGS__)                                         \
+        s->cap = s->cap == 0 ? 1 : s->cap * 2;                                                     \
+        while (s->cap < needed)                                                                    \
+        {                                                                                          \
+            s->cap *= 2;                                                                           \
+        }                                                                                          \
+    }                                                                                              \
+    void Name##_reserve(Name *s, size_t additional)                                                \
+    {                                                                                              \
+        if (s->len + additional > s->cap)                                                          \
+        {                                                                                          \
+            Name##_grow_(s, s->len + additional);                                                  \
+        }                                                                                          \
+    }                                                                                              \
+    void Name##_set(Name *s, size_t index, const Row *row)                                         \
+    {                                                                                              \
+        assert(index < s->len);                                                                    \
+        SOA_FOR_EACH_(SOA_COLUMN_STORE_, Name, __VA_ARGS__)                                        \
+    }                                                                                              \
+    void Name##_push(Name *s, const Row *row)                                                      \
+    {                                                                                              \
+        if (s->len == s->cap)                                                                      \
+        {                                                                                          \
+            Name##_grow_(s, s->len + 1);                                                           \
+        }                                                                                          \
+        size_t index = s->len++;                                                                   \
+        SOA_FOR_EACH_(SOA_COLUMN_STORE_, Name, __VA_ARGS__)                                        \
+    }                                                                                              \
+    void Name##_get(const Name *s, size_t index, Row *out)                                         \
+    {                                                                                              \
+        assert(index < s->len);                                                                    \
+        SOA_FOR_EACH_(SOA_COLUMN_LOAD_, Name, __VA_ARGS__)                                         \
+    }                                                                                              \
+    /* Append `count` records, one column at a time */                                             \
+    void Name##_extend_from_rows(Name *s, const Row *rows, size_t count)                           \
+    {                                                                                              \
+        Name##_reserve(s, count);                                                                  \
+        SOA_FOR_EACH_(SOA_COLUMN_SCATTER_, Name, __VA_ARGS__)                                      \
+        s->len += count;                                                                           \
+    }                                                                                              \
+    /* Write every record into `rows`, which must have room for Name_len of them */                \
+    void Name##_to_rows(const Name *s, Row *rows)                                                  \
+    {                                                                                              \
+        SOA_FOR_EACH_(SOA_COLUMN_GATHER_, Name, __VA_ARGS__)                                       \
+    }                                                                                              \
+    void Name##_clear(Name *s)                                                                     \
+    {                                                                                              \
+        s->len = 0;                                                                                \
+    }                                                                                              \
+    void Name##_drop(Name *s)                                                                      \
+    {                                                                                              \
+        SOA_FOR_EACH_(SOA_COLUMN_DROP_, Name, __VA_ARGS__)                                         \
+        s->len = 0;                                                                                \
+        s->cap = 0;                                                                                \
+    }                                                                                              \
+    SOA_FOR_EACH_(SOA_COLUMN_ACCESSOR_, Name, __VA_ARGS__)
+
+#endif // _SOA_H_INCLUDED_
@@ -1,6 +1,11 @@
 #ifndef _STRING_H_INCLUDED_
 #define _STRING_H_INCLUDED_
 
+/**
+ * The out-of-line String functions are emitted where STRING_IMPLEMENTATION
+ * is defined. One unit also defines ALLOC_, RAWVEC_ and VEC_IMPLEMENTATION.
+ */
+
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -14,15 +19,22 @@ typedef struct
     Vec vec;
 } String;
 
+// A borrowed, not necessarily NUL-terminated, run of characters
+typedef struct
+{
+    const char *ptr;
+    size_t len;
+} StringView;
+
 // Initialize a new String
-String String_new()
+static inline String String_new()
 {
     return (String){
-        .vec = Vec_new(GLOBAL_ALLOCATOR)};
+        .vec = Vec_new()};
 }
 
 // Create a String with a given capacity
-String String_with_capacity(size_t capacity)
+static inline String String_with_capacity(size_t capacity)
 {
     return (String){
         .vec = Vec_with_capacity(capacity, sizeof(char)),
@@ -30,61 +42,46 @@ String String_with_capacity(size_t capacity)
 }
 
 // Create a String from a C string
-String String_from(const char *s)
-{
-    size_t len = strlen(s);
-    String str = String_with_capacity(len + 1);
-    memcpy(str.vec.buf.ptr, s, len + 1);
-    str.vec.len = len;
-    return str;
-}
+String String_from(const char *s);
 
 // Get the length of the String
-size_t String_len(const String *s)
+static inline size_t String_len(const String *s)
 {
     return s->vec.len;
 }
 
 // Get the capacity of the String
-size_t String_capacity(const String *s)
+static inline size_t String_capacity(const String *s)
 {
     return Vec_capacity(&s->vec);
 }
 
 // Check if the String is empty
-bool String_is_empty(const String *s)
+static inline bool String_is_empty(const String *s)
 {
     return s->vec.len == 0;
 }
 
 // Append a C string to the String
-void String_push_str(String *s, const char *str)
-{
-    size_t add_len = strlen(str);
-    size_t new_len = s->vec.len + add_len;
-    Vec_reserve(&s->vec, add_len, sizeof(char));
-    memcpy((char *)s->vec.buf.ptr + s->vec.len, str, add_len);
-    s->vec.len = new_len;
-    ((char *)s->vec.buf.ptr)[new_len] = '\0';
-}
+void String_push_str(String *s, const char *str);
 
 // Append a character to the String
-void String_push(String *s, char ch)
+static inline void String_push(String *s, char ch)
 {
-    Vec_reserve(&s->vec, 1, sizeof(char));
+    Vec_reserve(&s->vec, 2, sizeof(char));
     ((char *)s->vec.buf.ptr)[s->vec.len] = ch;
     s->vec.len++;
     ((char *)s->vec.buf.ptr)[s->vec.len] = '\0';
 }
 
 // Get a pointer to the underlying C string
-const char *String_as_str(const String *s)
+static inline const char *String_as_str(const String *s)
 {
     return (const char *)s->vec.buf.ptr;
 }
 
 // Clear the String
-void String_clear(String *s)
+static inline void String_clear(String *s)
 {
     s->vec.len = 0;
     if (s->vec.buf.ptr)
@@ -94,12 +91,87 @@ void String_clear(String *s)
 }
 
 // Free the memory used by the String
+void String_drop(String *s);
+
+// Truncate the String to a new length
+void String_truncate(String *s, size_t new_len);
+
+// Remove and return the last character from the String
+char String_pop(String *s);
+
+// Insert a character at a specific index
+void String_insert(String *s, size_t idx, char ch);
+
+// Insert a C string at a specific index
+void String_insert_str(String *s, size_t idx, const char *str);
+
+// Remove a character at a specific index
+char String_remove(String *s, size_t idx);
+
+// Create a new String from a substring
+String String_substring(const String *s, size_t start, size_t end);
+
+// Compare two Strings
+int String_compare(const String *s1, const String *s2);
+
+// Check if two Strings are equal
+bool String_equals(const String *s1, const String *s2);
+
+// Borrow the contents of a String as a StringView
+static inline StringView String_as_view(const String *s)
+{
+    return (StringView){
+        .ptr = s->vec.buf.ptr == NULL ? "" : (const char *)s->vec.buf.ptr,
+        .len = s->vec.len};
+}
+
+// Create a String by copying a StringView
+String String_from_view(StringView view);
+
+// Check if two StringViews hold the same characters
+static inline bool StringView_equals(StringView a, StringView b)
+{
+    return a.len == b.len && memcmp(a.ptr, b.ptr, a.len) == 0;
+}
+
+// Check if a StringView holds the same characters as a C string
+static inline bool StringView_equals_str(StringView view, const char *s)
+{
+    return StringView_equals(view, (StringView){s, strlen(s)});
+}
+
+void String_free(String *s);
+
+#endif // _STRING_H_INCLUDED_
+
+#if defined(STRING_IMPLEMENTATION) && !defined(_STRING_IMPLEMENTATION_INCLUDED_)
+#define _STRING_IMPLEMENTATION_INCLUDED_
+
+String String_from(const char *s)
+{
+    size_t len = strlen(s);
+    String str = String_with_capacity(len + 1);
+    memcpy(str.vec.buf.ptr, s, len + 1);
+    str.vec.len = len;
+    return str;
+}
+
+void String_push_str(String *s, const char *str)
+{
+    size_t add_len = strlen(str);
+    size_t new_len = s->vec.len + add_len;
+    // One more for the NUL terminator
+    Vec_reserve(&s->vec, add_len + 1, sizeof(char));
+    memcpy((char *)s->vec.buf.ptr + s->vec.len, str, add_len);
+    s->vec.len = new_len;
+    ((char *)s->vec.buf.ptr)[new_len] = '\0';
+}
+
 void String_drop(String *s)
 {
     Vec_drop(&s->vec);
 }
 
-// Truncate the String to a new length
 void String_truncate(String *s, size_t new_len)
 {
     if (new_len <= s->vec.len)
@@ -109,7 +181,6 @@ void String_truncate(String *s, size_t new_len)
     }
 }
 
-// Remove and return the last character from the String
 char String_pop(String *s)
 {
     if (s->vec.len == 0)
@@ -122,28 +193,25 @@ char String_pop(String *s)
     return ch;
 }
 
-// Insert a character at a specific index
 void String_insert(String *s, size_t idx, char ch)
 {
     assert(idx <= s->vec.len);
-    Vec_reserve(&s->vec, 1, sizeof(char));
+    Vec_reserve(&s->vec, 2, sizeof(char));
     memmove((char *)s->vec.buf.ptr + idx + 1, (char *)s->vec.buf.ptr + idx, s->vec.len - idx + 1);
     ((char *)s->vec.buf.ptr)[idx] = ch;
     s->vec.len++;
 }
 
-// Insert a C string at a specific index
 void String_insert_str(String *s, size_t idx, const char *str)
 {
     assert(idx <= s->vec.len);
     size_t insert_len = strlen(str);
-    Vec_reserve(&s->vec, insert_len, sizeof(char));
+    Vec_reserve(&s->vec, insert_len + 1, sizeof(char));
     memmove((char *)s->vec.buf.ptr + idx + insert_len, (char *)s->vec.buf.ptr + idx, s->vec.len - idx + 1);
     memcpy((char *)s->vec.buf.ptr + idx, str, insert_len);
     s->vec.len += insert_len;
 }
 
-// Remove a character at a specific index
 char String_remove(String *s, size_t idx)
 {
     assert(idx < s->vec.len);
@@ -153,7 +221,6 @@ char String_remove(String *s, size_t idx)
     return ch;
 }
 
-// Create a new String from a substring
 String String_substring(const String *s, size_t start, size_t end)
 {
     assert(start <= end && end <= s->vec.len);
@@ -165,21 +232,29 @@ String String_substring(const String *s, size_t start, size_t end)
     return result;
 }
 
-// Compare two Strings
 int String_compare(const String *s1, const String *s2)
 {
     return strcmp(String_as_str(s1), String_as_str(s2));
 }
 
-// Check if two Strings are equal
 bool String_equals(const String *s1, const String *s2)
 {
     return String_compare(s1, s2) == 0;
 }
 
+String String_from_view(StringView view)
+{
+    String str = String_with_capacity(view.len + 1);
+    memcpy(str.vec.buf.ptr, view.ptr, view.len);
+    ((char *)str.vec.buf.ptr)[view.len] = '\0';
+    str.vec.len = view.len;
+    return str;
+}
+
 void String_free(String *s)
 {
     Vec_drop(&s->vec);
 }
 
-#endif // _STRING_H_INCLUDED_
+#endif // STRING_IMPLEMENTATION
+
@@ -4,14 +4,192 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
 #include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <fnmatch.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
 
 #define ANSI_RED "\x1b[31m"
 #define ANSI_GREEN "\x1b[32m"
 #define ANSI_DIM "\x1b[2m"
 #define ANSI_RESET "\x1b[0m"
 
-#define MAX_TESTS 100
+/**
+ * Hardware counters through perf_event_open, opt-in with PERF_COUNTERS=1
+ * (or --perf for benchmarks). All events are opened as one group so they
+ * are scheduled together, and counts are scaled by enabled/running time
+ * when the kernel multiplexes them. Events that cannot be opened (no PMU
+ * in a VM, perf_event_paranoid, non-Linux) are left out; if none open,
+ * reporting is silently skipped.
+ */
+typedef enum
+{
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_PAGE_FAULTS,
+    PERF_EVENT_COUNT,
+} PerfEvent;
+
+const char *perf_event_names[PERF_EVENT_COUNT] = {"cycles", "instructions", "cache_misses", "branch_misses", "page_faults"};
+
+typedef struct
+{
+    bool valid[PERF_EVENT_COUNT];
+    double values[PERF_EVENT_COUNT];
+} PerfSample;
+
+typedef struct
+{
+    bool initialized;
+    bool enabled;
+    int leader;
+    int count;
+    // Position of each event in the group read, or -1 if it is not open
+    int slot[PERF_EVENT_COUNT];
+} PerfCounters;
+
+PerfCounters perf_counters = {.initialized = false};
+
+bool perf_requested(void)
+{
+    const char *value = getenv("PERF_COUNTERS");
+    return value != NULL && strcmp(value, "0") != 0 && value[0] != '\0';
+}
+
+// Open the counter group on first use; returns whether any counter is available
+bool perf_counters_init(void)
+{
+    PerfCounters *pc = &perf_counters;
+    if (pc->initialized)
+    {
+        return pc->enabled;
+    }
+    pc->initialized = true;
+    pc->enabled = false;
+    pc->leader = -1;
+    pc->count = 0;
+#ifdef __linux__
+    const uint32_t types[PERF_EVENT_COUNT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                              PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE};
+    const uint64_t configs[PERF_EVENT_COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES,
+                                                PERF_COUNT_SW_PAGE_FAULTS};
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = types[i];
+        attr.config = configs[i];
+        attr.disabled = pc->leader < 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, pc->leader, 0);
+        pc->slot[i] = fd < 0 ? -1 : pc->count;
+        if (fd >= 0)
+        {
+            pc->leader = pc->leader < 0 ? fd : pc->leader;
+            pc->count++;
+        }
+    }
+    pc->enabled = pc->count > 0;
+#else
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        pc->slot[i] = -1;
+    }
+#endif
+    return pc->enabled;
+}
+
+// Reset and start the group
+void perf_counters_start(void)
+{
+#ifdef __linux__
+    if (perf_counters.enabled)
+    {
+        ioctl(perf_counters.leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(perf_counters.leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+}
+
+// Pause or resume counting without resetting
+void perf_counters_enable(bool on)
+{
+#ifdef __linux__
+    if (perf_counters.enabled)
+    {
+        ioctl(perf_counters.leader, on ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+#else
+    (void)on;
+#endif
+}
+
+// Stop the group and read the scaled counts
+PerfSample perf_counters_stop(void)
+{
+    PerfSample sample;
+    memset(&sample, 0, sizeof(sample));
+#ifdef __linux__
+    PerfCounters *pc = &perf_counters;
+    if (!pc->enabled)
+    {
+        return sample;
+    }
+    ioctl(pc->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    // Layout: nr, time_enabled, time_running, then one value per event
+    uint64_t data[3 + PERF_EVENT_COUNT];
+    if (read(pc->leader, data, sizeof(data)) < (ssize_t)(3 * sizeof(uint64_t)) || data[2] == 0)
+    {
+        return sample;
+    }
+    double scale = (double)data[1] / (double)data[2];
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        if (pc->slot[i] >= 0 && (uint64_t)pc->slot[i] < data[0])
+        {
+            sample.valid[i] = true;
+            sample.values[i] = (double)data[3 + pc->slot[i]] * scale;
+        }
+    }
+#endif
+    return sample;
+}
+
+// Print counters divided by `ops` (1 for a whole test), with IPC when both counts exist
+void perf_print(FILE *out, const PerfSample *sample, double ops)
+{
+    fprintf(out, ANSI_DIM "   ");
+    for (int i = 0; i < PERF_EVENT_COUNT; i++)
+    {
+        if (sample->valid[i])
+        {
+            fprintf(out, " %s%s %.4g", perf_event_names[i], ops > 1 ? "/op" : "", sample->values[i] / ops);
+        }
+    }
+    if (sample->valid[PERF_CYCLES] && sample->valid[PERF_INSTRUCTIONS] && sample->values[PERF_CYCLES] > 0)
+    {
+        fprintf(out, " ipc %.2f", sample->values[PERF_INSTRUCTIONS] / sample->values[PERF_CYCLES]);
+    }
+    fprintf(out, ANSI_RESET "\n");
+}
+
 #define MAX_FILE_NAME 256
 
 typedef struct
@@ -21,10 +199,13 @@ typedef struct
     const char *file;
     int passed;
     double duration;
+    PerfSample perf;
 } Test;
 
-Test tests[MAX_TESTS];
+// Registered tests; grows as constructors register them
+Test *tests = NULL;
 int test_count = 0;
+int test_capacity = 0;
 int expect_count = 0;
 const char *current_file = "";
 Test *current_test = NULL;
@@ -38,6 +219,22 @@ typedef struct
     double total_duration;
 } Results;
 
+/**
+ * Runner options. run_tests() reads them from the environment
+ * (TEST_FILTER, TEST_JOBS, TEST_ISOLATE, TEST_JSON); run_tests_args()
+ * also accepts --filter PATTERN, -j N, --isolate and --json FILE. With
+ * more than one job, or with isolation, every test runs in its own forked
+ * process, so a crash fails only that test; output is captured and
+ * printed in registration order.
+ */
+typedef struct
+{
+    const char *filter;
+    int jobs;
+    bool isolate;
+    const char *json;
+} TestOptions;
+
 #define TEST(name)                                      \
     void test_##name(void);                             \
     __attribute__((constructor)) void register_##name() \
@@ -48,26 +245,53 @@ typedef struct
 
 #define EXPECT(condition) expect(condition, __FILE__, __LINE__)
 
+// Wall-clock time in nanoseconds
+static inline uint64_t now_monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
 void run_test(Test *test)
 {
     current_test = test;
-    clock_t start = clock();
+    bool perf = perf_requested() && perf_counters_init();
+    if (perf)
+    {
+        perf_counters_start();
+    }
+    uint64_t start = now_monotonic_ns();
     test->func();
-    clock_t end = clock();
-    test->duration = ((double)(end - start)) / CLOCKS_PER_SEC * 1000; // Convert to milliseconds
+    test->duration = (double)(now_monotonic_ns() - start) / 1e6; // Convert to milliseconds
+    if (perf)
+    {
+        test->perf = perf_counters_stop();
+    }
     current_test = NULL;
 }
 
 void add_test(const char *name, void (*func)(void), const char *file)
 {
-    if (test_count < MAX_TESTS)
+    if (test_count == test_capacity)
     {
-        tests[test_count].name = name;
-        tests[test_count].func = func;
-        tests[test_count].file = file;
-        tests[test_count].passed = 1; // Assume passed until proven otherwise
-        test_count++;
+        int capacity = test_capacity == 0 ? 64 : test_capacity * 2;
+        Test *grown = realloc(tests, (size_t)capacity * sizeof(Test));
+        if (grown == NULL)
+        {
+            fprintf(stderr, "Out of memory registering test %s\n", name);
+            exit(1);
+        }
+        tests = grown;
+        test_capacity = capacity;
     }
+    tests[test_count] = (Test){
+        .name = name,
+        .func = func,
+        .file = file,
+        .passed = 1, // Assume passed until proven otherwise
+        .duration = 0};
+    test_count++;
 }
 
 void expect(int condition, const char *file, int line)
@@ -80,37 +304,270 @@ void expect(int condition, const char *file, int line)
     }
 }
 
-int run_tests()
+// Match a name against a glob pattern, or a substring when it has no wildcards
+bool test_matches(const char *name, const char *filter)
+{
+    if (filter == NULL || filter[0] == '\0')
+    {
+        return true;
+    }
+    if (strpbrk(filter, "*?[") == NULL)
+    {
+        return strstr(name, filter) != NULL;
+    }
+    return fnmatch(filter, name, 0) == 0;
+}
+
+// getenv, with an empty value treated as unset
+const char *test_getenv_(const char *name)
+{
+    const char *value = getenv(name);
+    return value != NULL && value[0] != '\0' ? value : NULL;
+}
+
+TestOptions test_options_from_env(void)
+{
+    const char *jobs = test_getenv_("TEST_JOBS");
+    const char *isolate = test_getenv_("TEST_ISOLATE");
+    return (TestOptions){
+        .filter = test_getenv_("TEST_FILTER"),
+        .jobs = jobs != NULL && atoi(jobs) > 0 ? atoi(jobs) : 1,
+        .isolate = isolate != NULL && strcmp(isolate, "0") != 0,
+        .json = test_getenv_("TEST_JSON")};
+}
+
+// What happened to a test run in a child process, written to shared memory
+typedef struct
+{
+    int finished;
+    int passed;
+    int expect_count;
+    double duration;
+    PerfSample perf;
+} TestOutcome;
+
+// Print a test's result line (and its counters)
+void test_report(const Test *test, const char *crash)
+{
+    if (test->passed)
+    {
+        printf(ANSI_GREEN "✓" ANSI_RESET " %s " ANSI_DIM "[%.3fms]" ANSI_RESET "\n", test->name, test->duration);
+    }
+    else if (crash != NULL)
+    {
+        printf(ANSI_RED "✗" ANSI_RESET " %s " ANSI_DIM "[%s]" ANSI_RESET "\n", test->name, crash);
+    }
+    else
+    {
+        printf(ANSI_RED "✗" ANSI_RESET " %s " ANSI_DIM "[%.3fms]" ANSI_RESET "\n", test->name, test->duration);
+    }
+    bool has_perf = false;
+    for (int k = 0; k < PERF_EVENT_COUNT; k++)
+    {
+        has_perf = has_perf || test->perf.valid[k];
+    }
+    if (has_perf)
+    {
+        perf_print(stdout, &test->perf, 1);
+    }
+}
+
+// Print a file heading when the file changes
+void test_heading(const Test *test, int *file_count)
+{
+    if (strcmp(current_file, test->file) != 0)
+    {
+        printf("\n%s:\n", test->file);
+        current_file = test->file;
+        (*file_count)++;
+    }
+}
+
+// Run the selected tests in forked children, at most `jobs` at a time
+void run_tests_forked(const int *selected, int count, int jobs, int *file_count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    TestOutcome *outcomes = mmap(NULL, (size_t)count * sizeof(TestOutcome), PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    FILE **outputs = calloc((size_t)count, sizeof(FILE *));
+    pid_t *pids = calloc((size_t)count, sizeof(pid_t));
+    int *statuses = calloc((size_t)count, sizeof(int));
+    bool *done = calloc((size_t)count, sizeof(bool));
+    if (outcomes == MAP_FAILED || outputs == NULL || pids == NULL || statuses == NULL || done == NULL)
+    {
+        fprintf(stderr, "Could not set up forked test run\n");
+        exit(1);
+    }
+    memset(outcomes, 0, (size_t)count * sizeof(TestOutcome));
+
+    int started = 0, running = 0, printed = 0;
+    while (printed < count)
+    {
+        while (running < jobs && started < count)
+        {
+            int k = started++;
+            outputs[k] = tmpfile();
+            fflush(stdout);
+            fflush(stderr);
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                dup2(fileno(outputs[k]), STDOUT_FILENO);
+                dup2(fileno(outputs[k]), STDERR_FILENO);
+                // Counters opened by the parent would count the parent
+                perf_counters.initialized = false;
+                Test *test = &tests[selected[k]];
+                expect_count = 0;
+                run_test(test);
+                fflush(stdout);
+                outcomes[k] = (TestOutcome){1, test->passed, expect_count, test->duration, test->perf};
+                _exit(0);
+            }
+            pids[k] = pid;
+            running++;
+        }
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        for (int k = 0; pid > 0 && k < started; k++)
+        {
+            if (pids[k] == pid)
+            {
+                statuses[k] = status;
+                done[k] = true;
+                running--;
+            }
+        }
+        // Print finished tests in registration order
+        while (printed < count && done[printed])
+        {
+            int k = printed++;
+            Test *test = &tests[selected[k]];
+            test_heading(test, file_count);
+            char buf[4096];
+            size_t n;
+            rewind(outputs[k]);
+            while ((n = fread(buf, 1, sizeof(buf), outputs[k])) > 0)
+            {
+                fwrite(buf, 1, n, stdout);
+            }
+            fclose(outputs[k]);
+            char crash[64];
+            const char *reason = NULL;
+            if (!outcomes[k].finished)
+            {
+                if (WIFSIGNALED(statuses[k]))
+                {
+                    snprintf(crash, sizeof(crash), "crashed: %s", strsignal(WTERMSIG(statuses[k])));
+                }
+                else
+                {
+                    snprintf(crash, sizeof(crash), "exited with status %d", WEXITSTATUS(statuses[k]));
+                }
+                reason = crash;
+            }
+            test->passed = outcomes[k].finished && outcomes[k].passed;
+            test->duration = outcomes[k].duration;
+            test->perf = outcomes[k].perf;
+            expect_count += outcomes[k].expect_count;
+            test_report(test, reason);
+        }
+    }
+    munmap(outcomes, (size_t)count * sizeof(TestOutcome));
+    free(outputs);
+    free(pids);
+    free(statuses);
+    free(done);
+}
+
+// Write a JSON string with quotes, backslashes and control characters escaped
+void test_json_string(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s != '\0'; s++)
+    {
+        if (*s == '"' || *s == '\\')
+        {
+            fputc('\\', out);
+        }
+        else if ((unsigned char)*s < 0x20)
+        {
+            fprintf(out, "\\u%04x", (unsigned char)*s);
+            continue;
+        }
+        fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+void test_write_json(const char *path, const int *selected, int count, int pass_count, int fail_count,
+                     double duration)
+{
+    FILE *out = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (out == NULL)
+    {
+        perror(path);
+        return;
+    }
+    fprintf(out, "{\"pass\": %d, \"fail\": %d, \"expect_calls\": %d, \"duration_ms\": %.3f, \"tests\": [",
+            pass_count, fail_count, expect_count, duration);
+    for (int k = 0; k < count; k++)
+    {
+        const Test *test = &tests[selected[k]];
+        fprintf(out, "%s\n  {\"name\": ", k == 0 ? "" : ",");
+        test_json_string(out, test->name);
+        fprintf(out, ", \"file\": ");
+        test_json_string(out, test->file);
+        fprintf(out, ", \"passed\": %s, \"duration_ms\": %.3f}", test->passed ? "true" : "false", test->duration);
+    }
+    fprintf(out, "\n]}\n");
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+}
+
+int run_tests_with(TestOptions options)
 {
     int pass_count = 0;
     int fail_count = 0;
     int file_count = 0;
-    const char *last_file = "";
-
-    printf("Running tests...\n");
+    uint64_t start = now_monotonic_ns();
 
+    int *selected = malloc((size_t)(test_count > 0 ? test_count : 1) * sizeof(int));
+    int count = 0;
     for (int i = 0; i < test_count; i++)
     {
-        if (strcmp(current_file, tests[i].file) != 0)
+        if (test_matches(tests[i].name, options.filter))
         {
-            printf("\n%s:\n", tests[i].file);
-            current_file = tests[i].file;
-            file_count++;
+            selected[count++] = i;
         }
+    }
 
-        run_test(&tests[i]);
+    printf("Running tests...\n");
 
-        if (tests[i].passed)
-        {
-            printf(ANSI_GREEN "✓" ANSI_RESET " %s " ANSI_DIM "[%.3fms]" ANSI_RESET "\n", tests[i].name, tests[i].duration);
-            pass_count++;
-        }
-        else
+    if (options.jobs > 1 || options.isolate)
+    {
+        run_tests_forked(selected, count, options.jobs, &file_count);
+    }
+    else
+    {
+        for (int k = 0; k < count; k++)
         {
-            printf(ANSI_RED "✗" ANSI_RESET " %s " ANSI_DIM "[%.3fms]" ANSI_RESET "\n", tests[i].name, tests[i].duration);
-            fail_count++;
+            Test *test = &tests[selected[k]];
+            test_heading(test, &file_count);
+            run_test(test);
+            test_report(test, NULL);
         }
     }
+    for (int k = 0; k < count; k++)
+    {
+        pass_count += tests[selected[k]].passed ? 1 : 0;
+        fail_count += tests[selected[k]].passed ? 0 : 1;
+    }
+    double duration = (double)(now_monotonic_ns() - start) / 1e6;
 
     printf(ANSI_GREEN "\n %d pass" ANSI_RESET, pass_count);
     if (fail_count > 0)
@@ -122,22 +579,457 @@ int run_tests()
         printf(ANSI_DIM "\n 0 fail" ANSI_RESET);
     }
     printf("\n %d expect() calls\n\n", expect_count);
-    // printf("\nRan %d test%s across %d file%s.\n", test_count, test_count == 1
-    // ? "" : "s", file_count, file_count == 1 ? "" : "s");
-    
-    if (fail_count > 0)
+
+    if (options.json != NULL)
     {
-        return 1;
+        test_write_json(options.json, selected, count, pass_count, fail_count, duration);
     }
+    free(selected);
+    return fail_count > 0 ? 1 : 0;
+}
+
+int run_tests()
+{
+    return run_tests_with(test_options_from_env());
+}
+
+// Like run_tests, with command-line options taking precedence over the environment
+int run_tests_args(int argc, char **argv)
+{
+    TestOptions options = test_options_from_env();
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            options.jobs = atoi(argv[++i]) > 0 ? atoi(argv[i]) : 1;
+        }
+        else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0')
+        {
+            options.jobs = atoi(argv[i] + 2) > 0 ? atoi(argv[i] + 2) : 1;
+        }
+        else if (strcmp(argv[i], "--isolate") == 0)
+        {
+            options.isolate = true;
+        }
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            options.json = argv[++i];
+        }
+    }
+    return run_tests_with(options);
+}
 
+/**
+ * Benchmarks. A BENCH body runs its operation `b->iterations` times; the
+ * runner picks the count so one sample takes about BENCH_SAMPLE_MS, runs
+ * one untimed warmup sample, then times BENCH_SAMPLES samples and reports
+ * min/median/p99 time per operation and throughput. Setup that should not
+ * be timed goes between Bench_pause and Bench_resume.
+ *
+ *     BENCH(Vec_push)
+ *     {
+ *         Vec vec = Vec_new();
+ *         for (uint64_t i = 0; i < b->iterations; i++)
+ *         {
+ *             Vec_push(&vec, &i, sizeof(i));
+ *         }
+ *         DO_NOT_OPTIMIZE(vec.buf.ptr);
+ *         Bench_pause(b);
+ *         Vec_drop(&vec);
+ *         Bench_resume(b);
+ *     }
+ *
+ * BENCH_RANGE(name, lo, hi, mult) registers one bench per size lo,
+ * lo * mult, ... up to hi (capped by BENCH_MAX_ARG, default 10^6), named
+ * "name/size"; the body reads the size from `b->arg`. Bench_set_items
+ * says how many elements one operation touches, so results can also be
+ * compared per element across sizes.
+ *
+ * A bench program ends with `return run_benches(argc, argv);`. Pass
+ * `--json FILE` (or set BENCH_JSON) to also write the results as JSON,
+ * `-` meaning stdout, and `--filter PATTERN` to run only matching benches.
+ */
+#define BENCH_SAMPLE_MS 10
+#define BENCH_SAMPLES 30
+#define BENCH_MAX_ARG 1000000
+
+typedef struct
+{
+    uint64_t iterations;
+    uint64_t arg;
+    uint64_t bytes_per_op;
+    uint64_t items_per_op;
+    uint64_t paused_ns;
+    uint64_t pause_start;
+    uint64_t paused_cycles;
+    uint64_t pause_start_cycles;
+} Bench;
+
+typedef struct
+{
+    const char *name;
+    void (*func)(Bench *);
+    const char *file;
+    uint64_t arg;
+    uint64_t iterations;
+    int samples;
+    double min_ns;
+    double median_ns;
+    double p99_ns;
+    double mean_ns;
+    double cycles_per_op;
+    uint64_t bytes_per_op;
+    uint64_t items_per_op;
+    PerfSample perf;
+} BenchEntry;
+
+BenchEntry *benches = NULL;
+int bench_count = 0;
+// Counters run only during timed samples, and are paused with the clock
+bool bench_perf = false;
+bool bench_perf_active = false;
+
+#define BENCH(name)                                            \
+    void bench_##name(Bench *b);                               \
+    __attribute__((constructor)) void register_bench_##name()  \
+    {                                                          \
+        add_bench(#name, bench_##name, __FILE__);              \
+    }                                                          \
+    void bench_##name(Bench *b)
+
+#define BENCH_RANGE(name, lo, hi, mult)                                     \
+    void bench_##name(Bench *b);                                            \
+    __attribute__((constructor)) void register_bench_##name()               \
+    {                                                                       \
+        add_bench_range(#name, bench_##name, __FILE__, lo, hi, mult);       \
+    }                                                                       \
+    void bench_##name(Bench *b)
+
+// Keep `value` alive and opaque to the optimizer
+#define DO_NOT_OPTIMIZE(value) __asm__ volatile("" : : "g"(value) : "memory")
+// Force pending stores to memory to be treated as observed
+#define CLOBBER_MEMORY() __asm__ volatile("" : : : "memory")
+
+void add_bench_arg(const char *name, void (*func)(Bench *), const char *file, uint64_t arg)
+{
+    BenchEntry *grown = realloc(benches, (size_t)(bench_count + 1) * sizeof(BenchEntry));
+    if (grown == NULL)
+    {
+        return;
+    }
+    benches = grown;
+    benches[bench_count] = (BenchEntry){.name = name, .func = func, .file = file, .arg = arg};
+    bench_count++;
+}
+
+void add_bench(const char *name, void (*func)(Bench *), const char *file)
+{
+    add_bench_arg(name, func, file, 0);
+}
+
+long bench_env_long(const char *name, long fallback)
+{
+    const char *value = getenv(name);
+    return value != NULL && atol(value) > 0 ? atol(value) : fallback;
+}
+
+// Register `name/size` for each size in the geometric range [lo, hi]
+void add_bench_range(const char *name, void (*func)(Bench *), const char *file, uint64_t lo, uint64_t hi,
+                     uint64_t mult)
+{
+    uint64_t max = (uint64_t)bench_env_long("BENCH_MAX_ARG", BENCH_MAX_ARG);
+    for (uint64_t arg = lo; arg <= hi && arg <= max; arg *= mult)
+    {
+        char *full = malloc(strlen(name) + 24);
+        if (full == NULL)
+        {
+            return;
+        }
+        sprintf(full, "%s/%llu", name, (unsigned long long)arg);
+        add_bench_arg(full, func, file, arg);
+    }
+}
+
+// Reference cycles from the time-stamp counter, or 0 where there is none
+static inline uint64_t bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
     return 0;
+#endif
+}
+
+// Record the processed bytes per operation so bytes/s is reported
+void Bench_set_bytes(Bench *b, uint64_t bytes_per_op)
+{
+    b->bytes_per_op = bytes_per_op;
+}
+
+// Stop the clock for untimed setup or teardown
+void Bench_pause(Bench *b)
+{
+    if (bench_perf_active)
+    {
+        perf_counters_enable(false);
+    }
+    b->pause_start = now_monotonic_ns();
+    b->pause_start_cycles = bench_cycles();
+}
+
+// Number of elements one operation processes, for per-element results
+void Bench_set_items(Bench *b, uint64_t items_per_op)
+{
+    b->items_per_op = items_per_op;
+}
 
-    // return (Results){
-    //     .pass_count = pass_count,
-    //     .fail_count = fail_count,
-    //     .expect_count = expect_count,
-    //     .file_count = file_count,
-    //     .total_duration = 0,
-    // };
+// Restart the clock after Bench_pause
+void Bench_resume(Bench *b)
+{
+    b->paused_cycles += bench_cycles() - b->pause_start_cycles;
+    b->paused_ns += now_monotonic_ns() - b->pause_start;
+    if (bench_perf_active)
+    {
+        perf_counters_enable(true);
+    }
+}
+
+// Run one sample of `iterations`; returns its timed nanoseconds
+uint64_t bench_sample(BenchEntry *entry, Bench *b, uint64_t iterations, uint64_t *cycles)
+{
+    b->iterations = iterations;
+    b->arg = entry->arg;
+    b->paused_ns = 0;
+    b->paused_cycles = 0;
+    uint64_t start_cycles = bench_cycles();
+    uint64_t start = now_monotonic_ns();
+    entry->func(b);
+    uint64_t elapsed = now_monotonic_ns() - start;
+    uint64_t elapsed_cycles = bench_cycles() - start_cycles;
+    *cycles = elapsed_cycles - b->paused_cycles;
+    return elapsed > b->paused_ns ? elapsed - b->paused_ns : 0;
+}
+
+int bench_compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of sorted values
+double bench_percentile(const double *sorted, int count, double p)
+{
+    int rank = (int)(p / 100.0 * count + 0.999999);
+    rank = rank < 1 ? 1 : (rank > count ? count : rank);
+    return sorted[rank - 1];
+}
+
+void run_bench(BenchEntry *entry)
+{
+    uint64_t sample_ns = (uint64_t)bench_env_long("BENCH_SAMPLE_MS", BENCH_SAMPLE_MS) * 1000000u;
+    int samples = (int)bench_env_long("BENCH_SAMPLES", BENCH_SAMPLES);
+    Bench b = {0};
+    uint64_t cycles;
+
+    // Calibrate: grow the count until a sample is long enough, then aim for the target
+    uint64_t n = 1;
+    for (;;)
+    {
+        uint64_t elapsed = bench_sample(entry, &b, n, &cycles);
+        if (elapsed >= sample_ns || n >= (1ull << 40))
+        {
+            break;
+        }
+        uint64_t next = elapsed == 0 ? n * 100 : (uint64_t)((double)n * sample_ns / elapsed * 1.2);
+        next = next > n * 100 ? n * 100 : next;
+        n = next <= n ? n + 1 : next;
+    }
+    // Warmup at the chosen count
+    bench_sample(entry, &b, n, &cycles);
+
+    double *per_op = malloc((size_t)samples * sizeof(double));
+    double total = 0, total_cycles = 0;
+    bench_perf_active = (bench_perf || perf_requested()) && perf_counters_init();
+    if (bench_perf_active)
+    {
+        perf_counters_start();
+    }
+    for (int i = 0; i < samples; i++)
+    {
+        per_op[i] = (double)bench_sample(entry, &b, n, &cycles) / (double)n;
+        total += per_op[i];
+        total_cycles += (double)cycles / (double)n;
+    }
+    if (bench_perf_active)
+    {
+        entry->perf = perf_counters_stop();
+        bench_perf_active = false;
+    }
+    qsort(per_op, (size_t)samples, sizeof(double), bench_compare_double);
+    entry->iterations = n;
+    entry->samples = samples;
+    entry->min_ns = per_op[0];
+    entry->median_ns = bench_percentile(per_op, samples, 50);
+    entry->p99_ns = bench_percentile(per_op, samples, 99);
+    entry->mean_ns = total / samples;
+    entry->cycles_per_op = total_cycles / samples;
+    entry->bytes_per_op = b.bytes_per_op;
+    entry->items_per_op = b.items_per_op;
+    free(per_op);
+}
+
+// Print a duration per operation with a readable unit
+void bench_print_time(FILE *out, double ns)
+{
+    if (ns < 1e3)
+    {
+        fprintf(out, "%8.2f ns", ns);
+    }
+    else if (ns < 1e6)
+    {
+        fprintf(out, "%8.2f us", ns / 1e3);
+    }
+    else
+    {
+        fprintf(out, "%8.2f ms", ns / 1e6);
+    }
+}
+
+void bench_print(FILE *out, const BenchEntry *entry)
+{
+    fprintf(out, "%-32s", entry->name);
+    bench_print_time(out, entry->min_ns);
+    fprintf(out, " min");
+    bench_print_time(out, entry->median_ns);
+    fprintf(out, " med");
+    bench_print_time(out, entry->p99_ns);
+    fprintf(out, " p99  %10.3f M ops/s", 1e3 / entry->median_ns);
+    if (entry->bytes_per_op > 0)
+    {
+        fprintf(out, "  %8.3f GB/s", (double)entry->bytes_per_op / entry->median_ns);
+    }
+    if (entry->items_per_op > 0)
+    {
+        fprintf(out, "  %8.3f ns/item", entry->median_ns / (double)entry->items_per_op);
+    }
+    if (entry->cycles_per_op > 0)
+    {
+        fprintf(out, "  %8.1f cyc/op", entry->cycles_per_op);
+    }
+    fprintf(out, ANSI_DIM "  [%llu x %d]" ANSI_RESET "\n", (unsigned long long)entry->iterations, entry->samples);
+    if (perf_counters.enabled)
+    {
+        perf_print(out, &entry->perf, (double)entry->iterations * entry->samples);
+    }
+}
+
+void bench_write_json(FILE *out)
+{
+    fprintf(out, "{\"benchmarks\": [");
+    for (int i = 0; i < bench_count; i++)
+    {
+        const BenchEntry *e = &benches[i];
+        fprintf(out, "%s\n  {\"name\": ", i == 0 ? "" : ",");
+        test_json_string(out, e->name);
+        fprintf(out, ", \"file\": ");
+        test_json_string(out, e->file);
+        fprintf(out,
+                ", \"iterations\": %llu, \"samples\": %d, "
+                "\"min_ns\": %.4f, \"median_ns\": %.4f, \"p99_ns\": %.4f, \"mean_ns\": %.4f, "
+                "\"cycles_per_op\": %.4f, \"ops_per_sec\": %.1f, \"bytes_per_sec\": %.1f",
+                (unsigned long long)e->iterations, e->samples,
+                e->min_ns, e->median_ns, e->p99_ns, e->mean_ns, e->cycles_per_op,
+                1e9 / e->median_ns, (double)e->bytes_per_op * 1e9 / e->median_ns);
+        if (e->arg > 0)
+        {
+            fprintf(out, ", \"arg\": %llu", (unsigned long long)e->arg);
+        }
+        if (e->items_per_op > 0)
+        {
+            fprintf(out, ", \"ns_per_item\": %.6g", e->median_ns / (double)e->items_per_op);
+        }
+        double ops = (double)e->iterations * e->samples;
+        for (int k = 0; k < PERF_EVENT_COUNT; k++)
+        {
+            if (e->perf.valid[k])
+            {
+                fprintf(out, ", \"%s_per_op\": %.6g", perf_event_names[k], e->perf.values[k] / ops);
+            }
+        }
+        if (e->perf.valid[PERF_CYCLES] && e->perf.valid[PERF_INSTRUCTIONS] && e->perf.values[PERF_CYCLES] > 0)
+        {
+            fprintf(out, ", \"ipc\": %.4f", e->perf.values[PERF_INSTRUCTIONS] / e->perf.values[PERF_CYCLES]);
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n]}\n");
+}
+
+int run_benches(int argc, char **argv)
+{
+    const char *json = test_getenv_("BENCH_JSON");
+    const char *filter = test_getenv_("BENCH_FILTER");
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+        {
+            json = argv[++i];
+        }
+        else if (strcmp(argv[i], "--perf") == 0)
+        {
+            bench_perf = true;
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+    }
+    // Drop benches the filter excludes so the JSON only lists what ran
+    int kept = 0;
+    for (int i = 0; i < bench_count; i++)
+    {
+        if (test_matches(benches[i].name, filter))
+        {
+            benches[kept++] = benches[i];
+        }
+    }
+    bench_count = kept;
+    bool json_stdout = json != NULL && strcmp(json, "-") == 0;
+    // With JSON on stdout the human-readable table goes to stderr
+    FILE *table = json_stdout ? stderr : stdout;
+
+    fprintf(table, "Running benchmarks...\n");
+    for (int i = 0; i < bench_count; i++)
+    {
+        if (strcmp(current_file, benches[i].file) != 0)
+        {
+            fprintf(table, "\n%s:\n", benches[i].file);
+            current_file = benches[i].file;
+        }
+        run_bench(&benches[i]);
+        bench_print(table, &benches[i]);
+        fflush(table);
+    }
+    fprintf(table, "\n");
+
+    if (json != NULL)
+    {
+        FILE *out = json_stdout ? stdout : fopen(json, "w");
+        if (out == NULL)
+        {
+            perror(json);
+            return 1;
+        }
+        bench_write_json(out);
+        if (!json_stdout)
+        {
+            fclose(out);
+        }
+    }
+    return 0;
 }
 #endif // CTEST_H
\ No newline at end of file
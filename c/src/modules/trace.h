@@ -0,0 +1,455 @@
+#ifndef _TRACE_H_INCLUDED_
+#define _TRACE_H_INCLUDED_
+
+/**
+ * Declarations and the inline recording path. Exactly one translation unit
+ * of a program defines TRACE_IMPLEMENTATION before including this header,
+ * which emits the global buffer list, the thread-local buffer pointer and
+ * the exporters there:
+ *
+ *     #define TRACE_IMPLEMENTATION
+ *     #include "trace.h"
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// The allocation probes in alloc.h and rawvec.h only make sense with tracing on
+#if defined(TRACE_PROBES) && !defined(TRACE_ENABLED)
+#define TRACE_ENABLED
+#endif
+
+// Events kept per thread; older ones are overwritten. Must be a power of two.
+#ifndef TRACE_BUFFER_EVENTS
+#define TRACE_BUFFER_EVENTS (1 << 16)
+#endif
+#define TRACE_MAX_THREAD_NAME 32
+// Thread names remembered for export; the oldest is replaced when full
+#ifndef TRACE_MAX_THREAD_NAMES
+#define TRACE_MAX_THREAD_NAMES 256
+#endif
+
+typedef enum
+{
+    TRACE_BEGIN,
+    TRACE_END,
+    TRACE_COUNTER,
+    TRACE_INSTANT,
+} TraceEventType;
+
+/**
+ * One recorded event. `name` must point to a string that outlives the
+ * trace, normally a literal. Timestamps are raw ticks (the TSC on x86,
+ * nanoseconds elsewhere) and are converted when the trace is written.
+ * `tid` is the recording thread, since a buffer outlives its threads.
+ */
+typedef struct
+{
+    uint64_t ticks;
+    const char *name;
+    int64_t value;
+    uint32_t type;
+    uint32_t tid;
+} TraceEvent;
+
+/**
+ * A thread's event ring. Only the owning thread writes; it fills the slot
+ * and then publishes it by storing `head` with release order, so an
+ * exporter on another thread can read up to the last TRACE_BUFFER_EVENTS
+ * events without locking. Buffers are linked into a global list. When a
+ * thread exits its buffer is retired, and the next thread to start
+ * recording claims it and keeps appending to the same ring, so the exited
+ * thread's events age out like any others. Memory is bounded by the peak
+ * number of recording threads, not by how many have ever run.
+ */
+typedef struct TraceBuffer
+{
+    atomic_uint_fast64_t head;
+    atomic_bool retired;
+    uint32_t tid; // current owner, read only by the owner
+    struct TraceBuffer *next;
+    TraceEvent events[TRACE_BUFFER_EVENTS];
+} TraceBuffer;
+
+extern _Atomic(TraceBuffer *) Trace_buffers_;
+extern atomic_bool Trace_active_;
+// Tick and clock readings taken once, with the first event, for converting ticks to time
+extern uint64_t Trace_origin_ticks_;
+extern uint64_t Trace_origin_ns_;
+extern pthread_once_t Trace_init_once_;
+// Retires a thread's buffer when the thread exits
+extern pthread_key_t Trace_key_;
+// The calling thread's buffer; one per thread across all translation units
+extern _Thread_local TraceBuffer *Trace_local_;
+
+static inline uint64_t Trace_now_ns_(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t Trace_ticks_(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return Trace_now_ns_();
+#endif
+}
+
+// Claim a retired buffer for the calling thread, or allocate one and link it into the global list
+__attribute__((noinline)) TraceBuffer *Trace_register_(void);
+
+// Append an event to the calling thread's ring
+static inline void Trace_record(TraceEventType type, const char *name, int64_t value)
+{
+    if (!atomic_load_explicit(&Trace_active_, memory_order_relaxed))
+    {
+        return;
+    }
+    TraceBuffer *buffer = Trace_local_;
+    if (__builtin_expect(buffer == NULL, 0))
+    {
+        buffer = Trace_register_();
+    }
+    uint64_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    TraceEvent *event = &buffer->events[head & (TRACE_BUFFER_EVENTS - 1)];
+    event->ticks = Trace_ticks_();
+    event->name = name;
+    event->value = value;
+    event->type = type;
+    event->tid = buffer->tid;
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+// Turn recording on or off at run time for every thread
+void Trace_set_active(bool active);
+
+// Name the calling thread in exported traces; the name is kept after the thread exits
+void Trace_set_thread_name(const char *name);
+
+// Number of events currently held across all threads
+size_t Trace_event_count(void);
+
+/**
+ * Drop all recorded events. Threads must not be recording at the same
+ * time; buffers stay registered and are reused.
+ */
+void Trace_clear(void);
+
+typedef struct
+{
+    const char *name;
+} TraceScope_;
+
+static inline TraceScope_ Trace_scope_begin_(const char *name)
+{
+    Trace_record(TRACE_BEGIN, name, 0);
+    return (TraceScope_){name};
+}
+
+static inline void Trace_scope_end_(TraceScope_ *scope)
+{
+    Trace_record(TRACE_END, scope->name, 0);
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_UNIQUE_(prefix, line) TRACE_CONCAT_(prefix, line)
+
+/**
+ * Instrumentation macros. They compile to nothing unless TRACE_ENABLED is
+ * defined before this header is included (TRACE_PROBES also turns on the
+ * probes in alloc.h and rawvec.h). TRACE_SCOPE records a begin event and
+ * an end event when the enclosing block exits, by any path.
+ *
+ *     void handle_request(Request *r)
+ *     {
+ *         TRACE_SCOPE("handle_request");
+ *         ...
+ *         TRACE_COUNTER("queue_depth", depth);
+ *     }
+ */
+#ifdef TRACE_ENABLED
+#define TRACE_SCOPE(name)                                                                   \
+    TraceScope_ TRACE_UNIQUE_(trace_scope_, __LINE__) __attribute__((cleanup(Trace_scope_end_))) = \
+        Trace_scope_begin_(name)
+#define TRACE_BEGIN(name) Trace_record(TRACE_BEGIN, (name), 0)
+#define TRACE_END(name) Trace_record(TRACE_END, (name), 0)
+#define TRACE_COUNTER(name, value) Trace_record(TRACE_COUNTER, (name), (int64_t)(value))
+#define TRACE_INSTANT(name, value) Trace_record(TRACE_INSTANT, (name), (int64_t)(value))
+#else
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END(name) ((void)0)
+#define TRACE_COUNTER(name, value) ((void)0)
+#define TRACE_INSTANT(name, value) ((void)0)
+#endif
+
+/**
+ * Write every buffered event in the Chrome trace event format, which
+ * chrome://tracing and ui.perfetto.dev load directly. Threads may keep
+ * recording meanwhile: each ring is copied and then any slots overwritten
+ * during the copy are dropped. Returns false on a write error.
+ */
+bool Trace_write_chrome(FILE *out);
+
+// Write the trace to a file; returns false and sets errno on failure
+bool Trace_save(const char *path);
+
+#endif // _TRACE_H_INCLUDED_
+
+#if defined(TRACE_IMPLEMENTATION) && !defined(_TRACE_IMPLEMENTATION_INCLUDED_)
+#define _TRACE_IMPLEMENTATION_INCLUDED_
+
+_Atomic(TraceBuffer *) Trace_buffers_ = NULL;
+atomic_bool Trace_active_ = true;
+uint64_t Trace_origin_ticks_ = 0;
+uint64_t Trace_origin_ns_ = 0;
+pthread_once_t Trace_init_once_ = PTHREAD_ONCE_INIT;
+pthread_key_t Trace_key_;
+_Thread_local TraceBuffer *Trace_local_ = NULL;
+
+typedef struct
+{
+    uint32_t tid;
+    char name[TRACE_MAX_THREAD_NAME];
+} TraceThreadName_;
+
+pthread_mutex_t Trace_names_lock_ = PTHREAD_MUTEX_INITIALIZER;
+TraceThreadName_ Trace_names_[TRACE_MAX_THREAD_NAMES];
+size_t Trace_name_count_ = 0;
+
+int64_t Trace_thread_id_(void)
+{
+#if defined(__linux__) && defined(SYS_gettid)
+    return (int64_t)syscall(SYS_gettid);
+#else
+    static atomic_int_fast64_t next_tid = 1;
+    return atomic_fetch_add(&next_tid, 1);
+#endif
+}
+
+// Thread exit: hand the buffer back for a later thread to claim
+void Trace_retire_(void *arg)
+{
+    TraceBuffer *buffer = arg;
+    // Anything recorded by later destructors registers again instead of writing here
+    Trace_local_ = NULL;
+    atomic_store_explicit(&buffer->retired, true, memory_order_release);
+}
+
+void Trace_init_(void)
+{
+    Trace_origin_ticks_ = Trace_ticks_();
+    Trace_origin_ns_ = Trace_now_ns_();
+    int err = pthread_key_create(&Trace_key_, Trace_retire_);
+    assert(err == 0);
+    (void)err;
+}
+
+TraceBuffer *Trace_claim_retired_(void)
+{
+    for (TraceBuffer *b = atomic_load_explicit(&Trace_buffers_, memory_order_acquire); b != NULL; b = b->next)
+    {
+        bool retired = true;
+        if (atomic_load_explicit(&b->retired, memory_order_relaxed) &&
+            atomic_compare_exchange_strong_explicit(&b->retired, &retired, false, memory_order_acquire,
+                                                    memory_order_relaxed))
+        {
+            return b;
+        }
+    }
+    return NULL;
+}
+
+TraceBuffer *Trace_register_(void)
+{
+    // Every caller returns only after the origin is written, so no thread reads it half set
+    pthread_once(&Trace_init_once_, Trace_init_);
+    TraceBuffer *buffer = Trace_claim_retired_();
+    if (buffer == NULL)
+    {
+        // calloc, not an Allocator: the allocation probes record into this buffer
+        buffer = calloc(1, sizeof(TraceBuffer));
+        assert(buffer != NULL);
+        atomic_init(&buffer->head, 0);
+        atomic_init(&buffer->retired, false);
+        TraceBuffer *head = atomic_load_explicit(&Trace_buffers_, memory_order_relaxed);
+        do
+        {
+            buffer->next = head;
+        } while (!atomic_compare_exchange_weak_explicit(&Trace_buffers_, &head, buffer, memory_order_release,
+                                                        memory_order_relaxed));
+    }
+    buffer->tid = (uint32_t)Trace_thread_id_();
+    pthread_setspecific(Trace_key_, buffer);
+    Trace_local_ = buffer;
+    return buffer;
+}
+
+void Trace_set_active(bool active)
+{
+    atomic_store(&Trace_active_, active);
+}
+
+void Trace_set_thread_name(const char *name)
+{
+    TraceBuffer *buffer = Trace_local_ != NULL ? Trace_local_ : Trace_register_();
+    pthread_mutex_lock(&Trace_names_lock_);
+    size_t stored = Trace_name_count_ < TRACE_MAX_THREAD_NAMES ? Trace_name_count_ : TRACE_MAX_THREAD_NAMES;
+    size_t slot = stored;
+    for (size_t i = 0; i < stored; i++)
+    {
+        if (Trace_names_[i].tid == buffer->tid)
+        {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == stored)
+    {
+        // A new thread: take a free slot, or replace the oldest name
+        slot = Trace_name_count_++ % TRACE_MAX_THREAD_NAMES;
+    }
+    Trace_names_[slot].tid = buffer->tid;
+    memset(Trace_names_[slot].name, 0, TRACE_MAX_THREAD_NAME);
+    strncpy(Trace_names_[slot].name, name, TRACE_MAX_THREAD_NAME - 1);
+    pthread_mutex_unlock(&Trace_names_lock_);
+}
+
+size_t Trace_event_count(void)
+{
+    size_t count = 0;
+    for (TraceBuffer *b = atomic_load_explicit(&Trace_buffers_, memory_order_acquire); b != NULL; b = b->next)
+    {
+        uint64_t head = atomic_load_explicit(&b->head, memory_order_acquire);
+        count += head < TRACE_BUFFER_EVENTS ? head : TRACE_BUFFER_EVENTS;
+    }
+    return count;
+}
+
+void Trace_clear(void)
+{
+    for (TraceBuffer *b = atomic_load_explicit(&Trace_buffers_, memory_order_acquire); b != NULL; b = b->next)
+    {
+        atomic_store_explicit(&b->head, 0, memory_order_release);
+    }
+}
+
+// Write a JSON string with quotes, backslashes and control characters escaped
+void Trace_write_json_string_(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s != '\0'; s++)
+    {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\')
+        {
+            fprintf(out, "\\%c", c);
+        }
+        else if (c < 0x20)
+        {
+            fprintf(out, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+bool Trace_write_chrome(FILE *out)
+{
+    // Convert ticks using the rate observed since the first event
+    pthread_once(&Trace_init_once_, Trace_init_);
+    uint64_t now_ticks = Trace_ticks_();
+    uint64_t now_ns = Trace_now_ns_();
+    double ns_per_tick = now_ticks > Trace_origin_ticks_
+                             ? (double)(now_ns - Trace_origin_ns_) / (double)(now_ticks - Trace_origin_ticks_)
+                             : 1.0;
+    long pid = (long)getpid();
+    TraceEvent *copy = malloc(sizeof(TraceEvent) * TRACE_BUFFER_EVENTS);
+    assert(copy != NULL);
+
+    bool first = true;
+    fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+    pthread_mutex_lock(&Trace_names_lock_);
+    size_t names = Trace_name_count_ < TRACE_MAX_THREAD_NAMES ? Trace_name_count_ : TRACE_MAX_THREAD_NAMES;
+    for (size_t i = 0; i < names; i++)
+    {
+        fprintf(out, "%s\n{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": %ld, \"tid\": %u, \"args\": {\"name\": ",
+                first ? "" : ",", pid, Trace_names_[i].tid);
+        Trace_write_json_string_(out, Trace_names_[i].name);
+        fprintf(out, "}}");
+        first = false;
+    }
+    pthread_mutex_unlock(&Trace_names_lock_);
+    for (TraceBuffer *b = atomic_load_explicit(&Trace_buffers_, memory_order_acquire); b != NULL; b = b->next)
+    {
+        uint64_t head = atomic_load_explicit(&b->head, memory_order_acquire);
+        uint64_t start = head > TRACE_BUFFER_EVENTS ? head - TRACE_BUFFER_EVENTS : 0;
+        for (uint64_t i = start; i < head; i++)
+        {
+            copy[i - start] = b->events[i & (TRACE_BUFFER_EVENTS - 1)];
+        }
+        // Slots the writer reached during the copy may be torn
+        uint64_t after = atomic_load_explicit(&b->head, memory_order_acquire);
+        uint64_t valid = after > TRACE_BUFFER_EVENTS ? after - TRACE_BUFFER_EVENTS : 0;
+        for (uint64_t i = valid > start ? valid : start; i < head; i++)
+        {
+            const TraceEvent *e = &copy[i - start];
+            static const char phases[] = {'B', 'E', 'C', 'i'};
+            double ts = (double)(int64_t)(e->ticks - Trace_origin_ticks_) * ns_per_tick / 1e3;
+            fprintf(out, "%s\n{\"ph\": \"%c\", \"name\": ", first ? "" : ",", phases[e->type]);
+            Trace_write_json_string_(out, e->name);
+            fprintf(out, ", \"ts\": %.3f, \"pid\": %ld, \"tid\": %u", ts, pid, e->tid);
+            if (e->type == TRACE_COUNTER || e->type == TRACE_INSTANT)
+            {
+                fprintf(out, ", \"args\": {\"value\": %lld}", (long long)e->value);
+            }
+            if (e->type == TRACE_INSTANT)
+            {
+                fprintf(out, ", \"s\": \"t\"");
+            }
+            fprintf(out, "}");
+            first = false;
+        }
+    }
+    fprintf(out, "\n]}\n");
+    free(copy);
+    return !ferror(out);
+}
+
+bool Trace_save(const char *path)
+{
+    FILE *out = fopen(path, "w");
+    if (out == NULL)
+    {
+        return false;
+    }
+    bool ok = Trace_write_chrome(out);
+    return fclose(out) == 0 && ok;
+}
+
+#endif // TRACE_IMPLEMENTATION
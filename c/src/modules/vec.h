@@ -1,6 +1,12 @@
 #ifndef _VEC_H_INCLUDED_
 #define _VEC_H_INCLUDED_
 
+/**
+ * Element access, push and pop are static inline; Vec_resize and Vec_drop
+ * are emitted by the one translation unit that defines VEC_IMPLEMENTATION.
+ * One unit also defines ALLOC_ and RAWVEC_IMPLEMENTATION.
+ */
+
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdlib.h>
@@ -15,7 +21,7 @@ typedef struct
 } Vec;
 
 // Initialize a new Vec
-Vec Vec_new()
+static inline Vec Vec_new()
 {
     return (Vec){
         .buf = RawVec_new(GLOBAL_ALLOCATOR),
@@ -23,38 +29,46 @@ Vec Vec_new()
 }
 
 // Create a Vec with a given capacity
-Vec Vec_with_capacity(size_t capacity, size_t elem_size)
+static inline Vec Vec_with_capacity(size_t capacity, size_t elem_size)
 {
     return (Vec){
         .buf = RawVec_with_capacity(capacity, elem_size, GLOBAL_ALLOCATOR),
         .len = 0};
 }
 
+// Create a Vec whose buffer stays aligned to align (see RawVec_with_alignment)
+static inline Vec Vec_with_alignment(size_t capacity, size_t elem_size, size_t align, bool pad)
+{
+    return (Vec){
+        .buf = RawVec_with_alignment(capacity, elem_size, align, pad, GLOBAL_ALLOCATOR),
+        .len = 0};
+}
+
 // Get the capacity of the Vec
-size_t Vec_capacity(const Vec *vec)
+static inline size_t Vec_capacity(const Vec *vec)
 {
     return RawVec_capacity(&vec->buf);
 }
 
 // Reserve additional capacity
-void Vec_reserve(Vec *vec, size_t additional, size_t elem_size)
+static inline void Vec_reserve(Vec *vec, size_t additional, size_t elem_size)
 {
     RawVec_reserve(&vec->buf, vec->len, additional, elem_size);
 }
 
 // Push an element to the Vec
-void Vec_push(Vec *vec, const void *value, size_t elem_size)
+static inline void Vec_push(Vec *vec, const void *value, size_t elem_size)
 {
-    if (vec->len == Vec_capacity(vec))
+    if (__builtin_expect(vec->len == Vec_capacity(vec), 0))
     {
-        RawVec_reserve(&vec->buf, vec->len, 1, elem_size);
+        RawVec_grow(&vec->buf, vec->len + 1, elem_size);
     }
     memcpy((char *)vec->buf.ptr + vec->len * elem_size, value, elem_size);
     vec->len++;
 }
 
 // Pop an element from the Vec
-bool Vec_pop(Vec *vec, void *out, size_t elem_size)
+static inline bool Vec_pop(Vec *vec, void *out, size_t elem_size)
 {
     if (vec->len == 0)
     {
@@ -66,39 +80,39 @@ bool Vec_pop(Vec *vec, void *out, size_t elem_size)
 }
 
 // Get a pointer to the element at the given index
-void *Vec_get(const Vec *vec, size_t index, size_t elem_size)
+static inline void *Vec_get(const Vec *vec, size_t index, size_t elem_size)
 {
     assert(index < vec->len);
     return (char *)vec->buf.ptr + index * elem_size;
 }
 
 // Set the element at the given index
-void Vec_set(Vec *vec, size_t index, const void *value, size_t elem_size)
+static inline void Vec_set(Vec *vec, size_t index, const void *value, size_t elem_size)
 {
     assert(index < vec->len);
     memcpy((char *)vec->buf.ptr + index * elem_size, value, elem_size);
 }
 
 // Get the length of the Vec
-size_t Vec_len(const Vec *vec)
+static inline size_t Vec_len(const Vec *vec)
 {
     return vec->len;
 }
 
 // Check if the Vec is empty
-bool Vec_is_empty(const Vec *vec)
+static inline bool Vec_is_empty(const Vec *vec)
 {
     return vec->len == 0;
 }
 
 // Clear the Vec
-void Vec_clear(Vec *vec)
+static inline void Vec_clear(Vec *vec)
 {
     vec->len = 0;
 }
 
 // Truncate the Vec to a new length
-void Vec_truncate(Vec *vec, size_t new_len)
+static inline void Vec_truncate(Vec *vec, size_t new_len)
 {
     if (new_len < vec->len)
     {
@@ -107,6 +121,28 @@ void Vec_truncate(Vec *vec, size_t new_len)
 }
 
 // Resize the Vec
+void Vec_resize(Vec *vec, size_t new_len, const void *value, size_t elem_size);
+
+// Free the memory used by the Vec
+void Vec_drop(Vec *vec);
+
+// Create a slice from the Vec
+static inline void *Vec_as_slice(const Vec *vec)
+{
+    return vec->buf.ptr;
+}
+
+// Create a mutable slice from the Vec
+static inline void *Vec_as_mut_slice(Vec *vec)
+{
+    return vec->buf.ptr;
+}
+
+#endif // _VEC_H_INCLUDED_
+
+#if defined(VEC_IMPLEMENTATION) && !defined(_VEC_IMPLEMENTATION_INCLUDED_)
+#define _VEC_IMPLEMENTATION_INCLUDED_
+
 void Vec_resize(Vec *vec, size_t new_len, const void *value, size_t elem_size)
 {
     if (new_len > vec->len)
@@ -121,23 +157,11 @@ void Vec_resize(Vec *vec, size_t new_len, const void *value, size_t elem_size)
     vec->len = new_len;
 }
 
-// Free the memory used by the Vec
 void Vec_drop(Vec *vec)
 {
     RawVec_drop(&vec->buf);
     vec->len = 0;
 }
 
-// Create a slice from the Vec
-void *Vec_as_slice(const Vec *vec)
-{
-    return vec->buf.ptr;
-}
-
-// Create a mutable slice from the Vec
-void *Vec_as_mut_slice(Vec *vec)
-{
-    return vec->buf.ptr;
-}
+#endif // VEC_IMPLEMENTATION
 
-#endif // _VEC_H_INCLUDED_
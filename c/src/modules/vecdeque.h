@@ -0,0 +1,352 @@
+#ifndef _VECDEQUE_H_INCLUDED_
+#define _VECDEQUE_H_INCLUDED_
+
+/**
+ * Element access is static inline; push, pop and growth are emitted by
+ * the unit that defines VECDEQUE_IMPLEMENTATION. One unit also defines
+ * ALLOC_ and RAWVEC_IMPLEMENTATION.
+ */
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "rawvec.h"
+
+/**
+ * A growable ring buffer. The capacity is always a power of two so physical
+ * positions are computed with a mask instead of a modulo. Elements occupy
+ * [head, head + len) wrapping around the end of the buffer.
+ */
+typedef struct
+{
+    RawVec buf;
+    size_t head;
+    size_t len;
+} VecDeque;
+
+// Initialize a new VecDeque
+VecDeque VecDeque_new();
+
+// Create a VecDeque with at least the given capacity (rounded up to a power of two)
+VecDeque VecDeque_with_capacity(size_t capacity, size_t elem_size);
+
+// Get the capacity of the VecDeque
+static inline size_t VecDeque_capacity(const VecDeque *dq)
+{
+    return RawVec_capacity(&dq->buf);
+}
+
+// Get the length of the VecDeque
+static inline size_t VecDeque_len(const VecDeque *dq)
+{
+    return dq->len;
+}
+
+// Check if the VecDeque is empty
+static inline bool VecDeque_is_empty(const VecDeque *dq)
+{
+    return dq->len == 0;
+}
+
+// Physical slot of the logical index `index`
+static inline size_t VecDeque_wrap_(const VecDeque *dq, size_t index)
+{
+    return (dq->head + index) & (dq->buf.cap - 1);
+}
+
+static inline char *VecDeque_slot_(const VecDeque *dq, size_t slot, size_t elem_size)
+{
+    return (char *)dq->buf.ptr + slot * elem_size;
+}
+
+/**
+ * Reserve room for `additional` more elements. Growth goes through
+ * RawVec_grow, which doubles, so the capacity stays a power of two. If the
+ * contents wrapped around the old end, the shorter of the two runs is moved
+ * so the elements are again contiguous modulo the new capacity.
+ */
+void VecDeque_reserve(VecDeque *dq, size_t additional, size_t elem_size);
+
+// Push an element to the back
+void VecDeque_push_back(VecDeque *dq, const void *value, size_t elem_size);
+
+// Push an element to the front
+void VecDeque_push_front(VecDeque *dq, const void *value, size_t elem_size);
+
+// Pop an element from the back
+bool VecDeque_pop_back(VecDeque *dq, void *out, size_t elem_size);
+
+// Pop an element from the front
+bool VecDeque_pop_front(VecDeque *dq, void *out, size_t elem_size);
+
+// Get a pointer to the element at the given logical index
+static inline void *VecDeque_get(const VecDeque *dq, size_t index, size_t elem_size)
+{
+    assert(index < dq->len);
+    return VecDeque_slot_(dq, VecDeque_wrap_(dq, index), elem_size);
+}
+
+// Get a pointer to the first element, or NULL if empty
+static inline void *VecDeque_front(const VecDeque *dq, size_t elem_size)
+{
+    return dq->len == 0 ? NULL : VecDeque_get(dq, 0, elem_size);
+}
+
+// Get a pointer to the last element, or NULL if empty
+static inline void *VecDeque_back(const VecDeque *dq, size_t elem_size)
+{
+    return dq->len == 0 ? NULL : VecDeque_get(dq, dq->len - 1, elem_size);
+}
+
+/**
+ * Get the contents as two contiguous runs: the elements are `first` followed
+ * by `second`. `second_len` is 0 unless the contents wrap around.
+ */
+void VecDeque_as_slices(const VecDeque *dq, size_t elem_size, void **first, size_t *first_len, void **second, size_t *second_len);
+
+/**
+ * Rearrange the buffer so the elements form a single run starting at
+ * position 0 and return a pointer to it. Uses free capacity as scratch space
+ * when there is enough, otherwise a temporary copy of the shorter run.
+ */
+void *VecDeque_make_contiguous(VecDeque *dq, size_t elem_size);
+
+// Push `count` elements to the back with at most two copies
+void VecDeque_push_back_n(VecDeque *dq, const void *values, size_t count, size_t elem_size);
+
+// Pop up to `count` elements from the front into `out`, returning how many were popped
+size_t VecDeque_pop_front_n(VecDeque *dq, void *out, size_t count, size_t elem_size);
+
+// Drop up to `count` elements from the front without copying them out
+size_t VecDeque_drain_front(VecDeque *dq, size_t count);
+
+// Truncate the VecDeque to a new length, keeping the front elements
+void VecDeque_truncate(VecDeque *dq, size_t new_len);
+
+// Clear the VecDeque
+static inline void VecDeque_clear(VecDeque *dq)
+{
+    dq->head = 0;
+    dq->len = 0;
+}
+
+// Free the memory used by the VecDeque
+void VecDeque_drop(VecDeque *dq);
+
+#endif // _VECDEQUE_H_INCLUDED_
+
+#if defined(VECDEQUE_IMPLEMENTATION) && !defined(_VECDEQUE_IMPLEMENTATION_INCLUDED_)
+#define _VECDEQUE_IMPLEMENTATION_INCLUDED_
+
+VecDeque VecDeque_new()
+{
+    return (VecDeque){
+        .buf = RawVec_new(GLOBAL_ALLOCATOR),
+        .head = 0,
+        .len = 0};
+}
+
+VecDeque VecDeque_with_capacity(size_t capacity, size_t elem_size)
+{
+    size_t cap = capacity == 0 ? 0 : 1;
+    while (cap < capacity)
+    {
+        cap *= 2;
+    }
+    return (VecDeque){
+        .buf = RawVec_with_capacity(cap, elem_size, GLOBAL_ALLOCATOR),
+        .head = 0,
+        .len = 0};
+}
+
+void VecDeque_reserve(VecDeque *dq, size_t additional, size_t elem_size)
+{
+    size_t old_cap = dq->buf.cap;
+    if (dq->len + additional <= old_cap)
+    {
+        return;
+    }
+    RawVec_grow(&dq->buf, dq->len + additional, elem_size);
+    if (dq->head + dq->len <= old_cap)
+    {
+        return;
+    }
+    size_t head_len = old_cap - dq->head;
+    size_t tail_len = dq->len - head_len;
+    if (tail_len <= head_len)
+    {
+        // [.. tail ..  head ..] -> [  head .. tail ..  ]
+        memcpy(VecDeque_slot_(dq, old_cap, elem_size), dq->buf.ptr, tail_len * elem_size);
+    }
+    else
+    {
+        // Move the head run to the end of the new buffer
+        size_t new_head = dq->buf.cap - head_len;
+        memcpy(VecDeque_slot_(dq, new_head, elem_size), VecDeque_slot_(dq, dq->head, elem_size), head_len * elem_size);
+        dq->head = new_head;
+    }
+}
+
+void VecDeque_push_back(VecDeque *dq, const void *value, size_t elem_size)
+{
+    if (dq->len == dq->buf.cap)
+    {
+        VecDeque_reserve(dq, 1, elem_size);
+    }
+    memcpy(VecDeque_slot_(dq, VecDeque_wrap_(dq, dq->len), elem_size), value, elem_size);
+    dq->len++;
+}
+
+void VecDeque_push_front(VecDeque *dq, const void *value, size_t elem_size)
+{
+    if (dq->len == dq->buf.cap)
+    {
+        VecDeque_reserve(dq, 1, elem_size);
+    }
+    dq->head = (dq->head - 1) & (dq->buf.cap - 1);
+    memcpy(VecDeque_slot_(dq, dq->head, elem_size), value, elem_size);
+    dq->len++;
+}
+
+bool VecDeque_pop_back(VecDeque *dq, void *out, size_t elem_size)
+{
+    if (dq->len == 0)
+    {
+        return false;
+    }
+    dq->len--;
+    memcpy(out, VecDeque_slot_(dq, VecDeque_wrap_(dq, dq->len), elem_size), elem_size);
+    return true;
+}
+
+bool VecDeque_pop_front(VecDeque *dq, void *out, size_t elem_size)
+{
+    if (dq->len == 0)
+    {
+        return false;
+    }
+    memcpy(out, VecDeque_slot_(dq, dq->head, elem_size), elem_size);
+    dq->head = (dq->head + 1) & (dq->buf.cap - 1);
+    dq->len--;
+    return true;
+}
+
+void VecDeque_as_slices(const VecDeque *dq, size_t elem_size, void **first, size_t *first_len, void **second, size_t *second_len)
+{
+    size_t head_len = dq->buf.cap - dq->head;
+    *first = dq->len == 0 ? dq->buf.ptr : VecDeque_slot_(dq, dq->head, elem_size);
+    if (dq->len <= head_len)
+    {
+        *first_len = dq->len;
+        *second = dq->buf.ptr;
+        *second_len = 0;
+    }
+    else
+    {
+        *first_len = head_len;
+        *second = dq->buf.ptr;
+        *second_len = dq->len - head_len;
+    }
+}
+
+void *VecDeque_make_contiguous(VecDeque *dq, size_t elem_size)
+{
+    size_t cap = dq->buf.cap;
+    if (dq->head + dq->len <= cap)
+    {
+        if (dq->head != 0)
+        {
+            memmove(dq->buf.ptr, VecDeque_slot_(dq, dq->head, elem_size), dq->len * elem_size);
+            dq->head = 0;
+        }
+        return dq->buf.ptr;
+    }
+    size_t head_len = cap - dq->head;
+    size_t tail_len = dq->len - head_len;
+    char *base = dq->buf.ptr;
+    if (cap - dq->len >= head_len)
+    {
+        // Slide the tail run right, then drop the head run in front of it
+        memmove(base + head_len * elem_size, base, tail_len * elem_size);
+        memcpy(base, base + dq->head * elem_size, head_len * elem_size);
+    }
+    else if (tail_len <= head_len)
+    {
+        void *tmp = dq->buf.alloc.allocate(tail_len * elem_size);
+        assert(tmp != NULL);
+        memcpy(tmp, base, tail_len * elem_size);
+        memmove(base, base + dq->head * elem_size, head_len * elem_size);
+        memcpy(base + head_len * elem_size, tmp, tail_len * elem_size);
+        dq->buf.alloc.deallocate(tmp);
+    }
+    else
+    {
+        void *tmp = dq->buf.alloc.allocate(head_len * elem_size);
+        assert(tmp != NULL);
+        memcpy(tmp, base + dq->head * elem_size, head_len * elem_size);
+        memmove(base + head_len * elem_size, base, tail_len * elem_size);
+        memcpy(base, tmp, head_len * elem_size);
+        dq->buf.alloc.deallocate(tmp);
+    }
+    dq->head = 0;
+    return dq->buf.ptr;
+}
+
+void VecDeque_push_back_n(VecDeque *dq, const void *values, size_t count, size_t elem_size)
+{
+    VecDeque_reserve(dq, count, elem_size);
+    if (count == 0)
+    {
+        return;
+    }
+    size_t start = VecDeque_wrap_(dq, dq->len);
+    size_t first = dq->buf.cap - start < count ? dq->buf.cap - start : count;
+    memcpy(VecDeque_slot_(dq, start, elem_size), values, first * elem_size);
+    memcpy(dq->buf.ptr, (const char *)values + first * elem_size, (count - first) * elem_size);
+    dq->len += count;
+}
+
+size_t VecDeque_pop_front_n(VecDeque *dq, void *out, size_t count, size_t elem_size)
+{
+    size_t n = count < dq->len ? count : dq->len;
+    if (n == 0)
+    {
+        return 0;
+    }
+    size_t first = dq->buf.cap - dq->head < n ? dq->buf.cap - dq->head : n;
+    memcpy(out, VecDeque_slot_(dq, dq->head, elem_size), first * elem_size);
+    memcpy((char *)out + first * elem_size, dq->buf.ptr, (n - first) * elem_size);
+    dq->head = (dq->head + n) & (dq->buf.cap - 1);
+    dq->len -= n;
+    return n;
+}
+
+size_t VecDeque_drain_front(VecDeque *dq, size_t count)
+{
+    size_t n = count < dq->len ? count : dq->len;
+    if (n > 0)
+    {
+        dq->head = (dq->head + n) & (dq->buf.cap - 1);
+        dq->len -= n;
+    }
+    return n;
+}
+
+void VecDeque_truncate(VecDeque *dq, size_t new_len)
+{
+    if (new_len < dq->len)
+    {
+        dq->len = new_len;
+    }
+}
+
+void VecDeque_drop(VecDeque *dq)
+{
+    RawVec_drop(&dq->buf);
+    dq->head = 0;
+    dq->len = 0;
+}
+
+#endif // VECDEQUE_IMPLEMENTATION
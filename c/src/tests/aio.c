@@ -0,0 +1,249 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define VECDEQUE_IMPLEMENTATION
+#define AIO_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "../modules/aio.h"
+#include "../modules/test.h"
+
+#define FILE_SIZE (1 << 16)
+
+int temp_file(void)
+{
+    char path[] = "/tmp/aio_test_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    unlink(path);
+    return fd;
+}
+
+void count_callback(AioRequest *req, void *arg)
+{
+    (void)req;
+    (*(size_t *)arg)++;
+}
+
+// Write a known pattern through the executor, then read it back in random chunks
+void exercise(AioBackend backend)
+{
+    Aio *aio = Aio_new(8, backend, GLOBAL_ALLOCATOR);
+    if (aio == NULL)
+    {
+        // io_uring is not available on this kernel
+        return;
+    }
+    EXPECT(Aio_backend(aio) == (backend == AIO_THREADS ? AIO_THREADS : AIO_URING));
+    int fd = temp_file();
+
+    // 16 writes of 4 KiB, more than the depth limit, in one batch
+    Vec chunks[16];
+    AioRequest writes[16];
+    AioRequest *batch[16];
+    size_t callbacks = 0;
+    for (size_t i = 0; i < 16; i++)
+    {
+        chunks[i] = Vec_with_capacity(4096, sizeof(char));
+        for (size_t j = 0; j < 4096; j++)
+        {
+            ((unsigned char *)chunks[i].buf.ptr)[j] = (unsigned char)((i * 4096 + j) * 31);
+        }
+        chunks[i].len = 4096;
+        AioRequest_write(&writes[i], fd, (off_t)(i * 4096), &chunks[i], count_callback, &callbacks);
+        batch[i] = &writes[i];
+    }
+    Aio_submit(aio, batch, 16);
+    Aio_wait_all(aio);
+    EXPECT(callbacks == 16);
+    bool ok = true;
+    for (size_t i = 0; i < 16; i++)
+    {
+        ok = ok && writes[i].result == 4096;
+        Vec_drop(&chunks[i]);
+    }
+    EXPECT(ok);
+
+    // Reads append to the caller's Vec
+    Vec out = Vec_new();
+    AioRequest reads[100];
+    size_t offsets[100];
+    Vec buffers[100];
+    for (size_t i = 0; i < 100; i++)
+    {
+        offsets[i] = (i * 7919) % (FILE_SIZE - 100);
+        buffers[i] = Vec_new();
+        AioRequest_read(&reads[i], fd, (off_t)offsets[i], &buffers[i], 100, NULL, NULL);
+        Aio_submit_one(aio, &reads[i]);
+    }
+    size_t delivered = 0;
+    while (delivered < 100)
+    {
+        delivered += Aio_poll(aio, 1);
+    }
+    EXPECT(Aio_pending(aio) == 0);
+    ok = true;
+    for (size_t i = 0; i < 100; i++)
+    {
+        ok = ok && reads[i].result == 100 && buffers[i].len == 100;
+        for (size_t j = 0; ok && j < 100; j++)
+        {
+            ok = ((unsigned char *)buffers[i].buf.ptr)[j] == (unsigned char)((offsets[i] + j) * 31);
+        }
+        Vec_drop(&buffers[i]);
+    }
+    EXPECT(ok);
+
+    // A short read at end of file, then an append onto existing contents
+    AioRequest tail;
+    AioRequest_read(&tail, fd, FILE_SIZE - 10, &out, 100, NULL, NULL);
+    Aio_submit_one(aio, &tail);
+    Aio_wait_all(aio);
+    EXPECT(tail.result == 10 && out.len == 10);
+    AioRequest_read(&tail, fd, 0, &out, 5, NULL, NULL);
+    Aio_submit_one(aio, &tail);
+    Aio_wait_all(aio);
+    EXPECT(out.len == 15);
+
+    // Errors come back as -errno
+    AioRequest bad;
+    AioRequest_read(&bad, -1, 0, &out, 10, NULL, NULL);
+    Aio_submit_one(aio, &bad);
+    Aio_wait_all(aio);
+    EXPECT(bad.result == -EBADF);
+    EXPECT(out.len == 15);
+
+    Vec_drop(&out);
+    close(fd);
+    Aio_drop(aio);
+}
+
+TEST(Aio_thread_pool)
+{
+    exercise(AIO_THREADS);
+}
+
+TEST(Aio_uring)
+{
+    exercise(AIO_URING);
+}
+
+void *delayed_write(void *arg)
+{
+    int fd = *(int *)arg;
+    usleep(20000);
+    EXPECT(write(fd, "klmnopqrst", 10) == 10);
+    close(fd);
+    return NULL;
+}
+
+// A pipe hands io_uring a short read; the rest must be read before completion
+TEST(Aio_uring_retries_short_reads)
+{
+    Aio *aio = Aio_new(4, AIO_URING, GLOBAL_ALLOCATOR);
+    if (aio == NULL)
+    {
+        return;
+    }
+    int fds[2];
+    EXPECT(pipe(fds) == 0);
+    EXPECT(write(fds[1], "abcdefghij", 10) == 10);
+    Vec buf = Vec_new();
+    AioRequest req;
+    AioRequest_read(&req, fds[0], 0, &buf, 20, NULL, NULL);
+    Aio_submit_one(aio, &req);
+    pthread_t writer;
+    pthread_create(&writer, NULL, delayed_write, &fds[1]);
+    Aio_wait_all(aio);
+    pthread_join(writer, NULL);
+    EXPECT(req.result == 20 && buf.len == 20);
+    EXPECT(memcmp(buf.buf.ptr, "abcdefghijklmnopqrst", 20) == 0);
+
+    // The writer has closed the pipe: end of file completes with what was read
+    AioRequest_read(&req, fds[0], 0, &buf, 5, NULL, NULL);
+    Aio_submit_one(aio, &req);
+    Aio_wait_all(aio);
+    EXPECT(req.result == 0 && buf.len == 20);
+    close(fds[0]);
+    Vec_drop(&buf);
+    Aio_drop(aio);
+}
+
+// If io_uring_enter fails, queued requests complete with the error instead of hanging
+TEST(Aio_uring_fails_unsubmitted_requests)
+{
+    Aio *aio = Aio_new(4, AIO_URING, GLOBAL_ALLOCATOR);
+    if (aio == NULL)
+    {
+        return;
+    }
+    int fd = temp_file();
+    // Put a file that is not a ring behind the ring's descriptor for the submission
+    int ring_fd = dup(aio->uring.fd);
+    int null_fd = open("/dev/null", O_RDONLY);
+    EXPECT(dup2(null_fd, aio->uring.fd) == aio->uring.fd);
+    Vec bufs[3] = {Vec_new(), Vec_new(), Vec_new()};
+    AioRequest reqs[3];
+    AioRequest *batch[3];
+    for (int i = 0; i < 3; i++)
+    {
+        AioRequest_read(&reqs[i], fd, 0, &bufs[i], 16, NULL, NULL);
+        batch[i] = &reqs[i];
+    }
+    Aio_submit(aio, batch, 3);
+    EXPECT(Aio_poll(aio, 3) == 3);
+    EXPECT(Aio_pending(aio) == 0);
+    EXPECT(dup2(ring_fd, aio->uring.fd) == aio->uring.fd);
+    close(ring_fd);
+    close(null_fd);
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT(reqs[i].result < 0 && bufs[i].len == 0);
+        Vec_drop(&bufs[i]);
+    }
+
+    // The ring still works afterwards; the file is empty, so the read hits end of file
+    Vec buf = Vec_new();
+    AioRequest_read(&reqs[0], fd, 0, &buf, 16, NULL, NULL);
+    Aio_submit_one(aio, &reqs[0]);
+    Aio_wait_all(aio);
+    EXPECT(reqs[0].result == 0);
+    Vec_drop(&buf);
+    close(fd);
+    Aio_drop(aio);
+}
+
+// Every allocation of the executor goes through its Allocator
+size_t counted_allocations = 0;
+
+void *counting_allocate(size_t size)
+{
+    counted_allocations++;
+    return malloc(size);
+}
+
+TEST(Aio_uses_its_allocator)
+{
+    Allocator alloc = GLOBAL_ALLOCATOR;
+    alloc.allocate = counting_allocate;
+    Aio *aio = Aio_new(2, AIO_THREADS, alloc);
+    EXPECT(counted_allocations >= 2);
+    Aio_drop(aio);
+}
+
+TEST(Aio_auto_picks_a_backend)
+{
+    Aio *aio = Aio_new(0, AIO_AUTO, GLOBAL_ALLOCATOR);
+    EXPECT(Aio_backend(aio) == AIO_URING || Aio_backend(aio) == AIO_THREADS);
+    EXPECT(Aio_poll(aio, 0) == 0);
+    Aio_drop(aio);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../modules/test.h"
+
+uint64_t bench_calls = 0;
+uint64_t last_iterations = 0;
+uint64_t last_arg = 0;
+
+void bench_sum(Bench *b)
+{
+    bench_calls++;
+    last_iterations = b->iterations;
+    last_arg = b->arg;
+    Bench_set_bytes(b, sizeof(uint64_t));
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < b->iterations; i++)
+    {
+        sum += i;
+        DO_NOT_OPTIMIZE(sum);
+    }
+}
+
+TEST(bench_percentile_nearest_rank)
+{
+    double sorted[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    EXPECT(bench_percentile(sorted, 10, 50) == 5);
+    EXPECT(bench_percentile(sorted, 10, 99) == 10);
+    EXPECT(bench_percentile(sorted, 10, 0) == 1);
+    EXPECT(bench_percentile(sorted, 1, 99) == 1);
+}
+
+TEST(run_bench_calibrates_and_collects_samples)
+{
+    setenv("BENCH_SAMPLE_MS", "1", 1);
+    setenv("BENCH_SAMPLES", "5", 1);
+    BenchEntry entry = {.name = "sum", .func = bench_sum, .file = __FILE__};
+    run_bench(&entry);
+    // Calibration, warmup and the timed samples all ran at the chosen count
+    EXPECT(entry.samples == 5);
+    EXPECT(entry.iterations > 1 && last_iterations == entry.iterations);
+    EXPECT(bench_calls >= 7);
+    EXPECT(entry.min_ns > 0 && entry.min_ns <= entry.median_ns && entry.median_ns <= entry.p99_ns);
+    EXPECT(entry.bytes_per_op == sizeof(uint64_t));
+}
+
+TEST(bench_range_registers_each_size)
+{
+    int before = bench_count;
+    add_bench_range("sum", bench_sum, __FILE__, 8, 1000, 10);
+    EXPECT(bench_count == before + 3);
+    EXPECT(strcmp(benches[before].name, "sum/8") == 0);
+    EXPECT(benches[before + 2].arg == 800);
+
+    setenv("BENCH_SAMPLE_MS", "1", 1);
+    setenv("BENCH_SAMPLES", "3", 1);
+    run_bench(&benches[before + 1]);
+    EXPECT(last_arg == 80);
+    for (int i = before; i < bench_count; i++)
+    {
+        free((char *)benches[i].name);
+    }
+    bench_count = before;
+}
+
+TEST(bench_json_escapes_names)
+{
+    BenchEntry *saved = benches;
+    int saved_count = bench_count;
+    BenchEntry entry = {.name = "quote\"back\\slash", .file = "dir\\file.c", .samples = 1, .median_ns = 1};
+    benches = &entry;
+    bench_count = 1;
+    FILE *out = tmpfile();
+    bench_write_json(out);
+    benches = saved;
+    bench_count = saved_count;
+    char json[1024] = {0};
+    rewind(out);
+    EXPECT(fread(json, 1, sizeof(json) - 1, out) > 0);
+    fclose(out);
+    EXPECT(strstr(json, "\"name\": \"quote\\\"back\\\\slash\"") != NULL);
+    EXPECT(strstr(json, "\"file\": \"dir\\\\file.c\"") != NULL);
+}
+
+TEST(paused_time_is_excluded)
+{
+    Bench b = {0};
+    Bench_pause(&b);
+    while (now_monotonic_ns() - b.pause_start < 2000000)
+    {
+    }
+    Bench_resume(&b);
+    EXPECT(b.paused_ns >= 2000000);
+}
+
+TEST(perf_counters_count_or_fall_back)
+{
+    bool available = perf_counters_init();
+    perf_counters_start();
+    size_t size = 8 << 20;
+    char *memory = malloc(size);
+    memset(memory, 1, size);
+    DO_NOT_OPTIMIZE(memory);
+    PerfSample sample = perf_counters_stop();
+    free(memory);
+    if (!available)
+    {
+        // Unavailable counters report nothing rather than zeros
+        for (int i = 0; i < PERF_EVENT_COUNT; i++)
+        {
+            EXPECT(!sample.valid[i]);
+        }
+        return;
+    }
+    if (sample.valid[PERF_PAGE_FAULTS])
+    {
+        EXPECT(sample.values[PERF_PAGE_FAULTS] >= 1);
+    }
+    if (sample.valid[PERF_INSTRUCTIONS])
+    {
+        EXPECT(sample.values[PERF_INSTRUCTIONS] > (double)size / 64);
+    }
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,251 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define BITSET_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/bitset.h"
+#include "../modules/test.h"
+
+// Deterministic pseudo-random numbers for the reference comparisons
+uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+TEST(set_test_clear_and_push)
+{
+    Bitset b = Bitset_with_len(130);
+    EXPECT(Bitset_len(&b) == 130 && Bitset_count(&b) == 0);
+    Bitset_set(&b, 0);
+    Bitset_set(&b, 64);
+    Bitset_set(&b, 129);
+    EXPECT(Bitset_test(&b, 0) && Bitset_test(&b, 64) && Bitset_test(&b, 129));
+    EXPECT(!Bitset_test(&b, 1) && !Bitset_test(&b, 128));
+    Bitset_clear(&b, 64);
+    Bitset_assign(&b, 5, true);
+    EXPECT(!Bitset_test(&b, 64) && Bitset_test(&b, 5));
+    EXPECT(Bitset_count(&b) == 3);
+
+    Bitset_push(&b, true);
+    Bitset_push(&b, false);
+    EXPECT(Bitset_len(&b) == 132 && Bitset_test(&b, 130) && !Bitset_test(&b, 131));
+    Bitset_drop(&b);
+}
+
+TEST(resize_keeps_unused_bits_clear)
+{
+    Bitset b = Bitset_new();
+    Bitset_resize(&b, 70, true);
+    EXPECT(Bitset_count(&b) == 70);
+    Bitset_resize(&b, 10, true);
+    EXPECT(Bitset_count(&b) == 10);
+    // Growing again must not resurrect the bits cut off above
+    Bitset_resize(&b, 100, false);
+    EXPECT(Bitset_count(&b) == 10);
+    Bitset_fill(&b, true);
+    EXPECT(Bitset_count(&b) == 100);
+    Bitset_drop(&b);
+}
+
+TEST(next_iterates_set_bits_in_order)
+{
+    Bitset b = Bitset_with_len(1000);
+    size_t positions[] = {3, 63, 64, 200, 999};
+    for (size_t i = 0; i < 5; i++)
+    {
+        Bitset_set(&b, positions[i]);
+    }
+    size_t seen = 0;
+    for (size_t i = Bitset_next(&b, 0); i != BITSET_NONE; i = Bitset_next(&b, i + 1))
+    {
+        EXPECT(seen < 5 && i == positions[seen]);
+        seen++;
+    }
+    EXPECT(seen == 5);
+    EXPECT(Bitset_next(&b, 1000) == BITSET_NONE);
+    Bitset_drop(&b);
+}
+
+TEST(bulk_operations_match_bitwise_reference)
+{
+    uint64_t state = 42;
+    Bitset a = Bitset_with_len(1000), b = Bitset_with_len(700);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        Bitset_assign(&a, i, next_random(&state) & 1);
+        if (i < 700)
+        {
+            Bitset_assign(&b, i, next_random(&state) & 1);
+        }
+    }
+    BitsetOp ops[] = {BITSET_AND, BITSET_OR, BITSET_XOR, BITSET_ANDNOT};
+    for (size_t k = 0; k < 4; k++)
+    {
+        Bitset d = Bitset_clone(&a);
+        Bitset_combine(&d, &b, ops[k]);
+        bool ok = Bitset_len(&d) == 1000;
+        for (size_t i = 0; i < 1000; i++)
+        {
+            bool x = Bitset_test(&a, i), y = i < 700 && Bitset_test(&b, i), want = false;
+            switch (ops[k])
+            {
+            case BITSET_AND:
+                want = x && y;
+                break;
+            case BITSET_OR:
+                want = x || y;
+                break;
+            case BITSET_XOR:
+                want = x != y;
+                break;
+            case BITSET_ANDNOT:
+                want = x && !y;
+                break;
+            }
+            ok = ok && Bitset_test(&d, i) == want;
+        }
+        EXPECT(ok);
+        Bitset_drop(&d);
+    }
+    // OR into a shorter set grows it
+    Bitset_or(&b, &a);
+    EXPECT(Bitset_len(&b) == 1000);
+    Bitset_drop(&a);
+    Bitset_drop(&b);
+}
+
+TEST(rank_and_select_agree_with_scanning)
+{
+    uint64_t state = 7;
+    Bitset b = Bitset_with_len(5000);
+    for (size_t i = 0; i < 5000; i++)
+    {
+        if (next_random(&state) % 3 == 0)
+        {
+            Bitset_set(&b, i);
+        }
+    }
+    BitsetRank r = BitsetRank_new(&b);
+    size_t rank = 0;
+    bool ok = true;
+    for (size_t i = 0; i < 5000; i++)
+    {
+        ok = ok && BitsetRank_rank(&r, i) == rank;
+        if (Bitset_test(&b, i))
+        {
+            ok = ok && BitsetRank_select(&r, rank) == i;
+            rank++;
+        }
+    }
+    EXPECT(ok);
+    EXPECT(BitsetRank_rank(&r, 5000) == Bitset_count(&b));
+    EXPECT(BitsetRank_select(&r, rank) == BITSET_NONE);
+    BitsetRank_drop(&r);
+    Bitset_drop(&b);
+}
+
+TEST(roaring_add_remove_contains)
+{
+    Roaring r = Roaring_new();
+    EXPECT(Roaring_add(&r, 5));
+    EXPECT(!Roaring_add(&r, 5));
+    EXPECT(Roaring_add(&r, 70000));
+    EXPECT(Roaring_add(&r, UINT32_MAX));
+    EXPECT(Roaring_contains(&r, 5) && Roaring_contains(&r, 70000) && Roaring_contains(&r, UINT32_MAX));
+    EXPECT(!Roaring_contains(&r, 6) && Roaring_count(&r) == 3);
+    EXPECT(Roaring_remove(&r, 70000) && !Roaring_remove(&r, 70000));
+    EXPECT(!Roaring_contains(&r, 70000) && Roaring_count(&r) == 2);
+    uint32_t v;
+    EXPECT(Roaring_next(&r, 6, &v) && v == UINT32_MAX);
+    EXPECT(!Roaring_next(&r, (uint64_t)UINT32_MAX + 1, &v));
+    Roaring_drop(&r);
+}
+
+TEST(roaring_switches_container_kinds)
+{
+    Roaring r = Roaring_new();
+    // Dense: every other value in one container
+    for (uint32_t i = 0; i < 20000; i += 2)
+    {
+        Roaring_add(&r, i);
+    }
+    EXPECT(Roaring_count(&r) == 10000);
+    EXPECT(Roaring_size_in_bytes(&r) < 10000 * sizeof(uint16_t));
+    bool ok = true;
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        ok = ok && Roaring_contains(&r, i) == (i % 2 == 0);
+    }
+    EXPECT(ok);
+    // Back down to sparse
+    for (uint32_t i = 0; i < 20000; i += 4)
+    {
+        Roaring_remove(&r, i);
+    }
+    for (uint32_t i = 2; i < 18000; i += 4)
+    {
+        Roaring_remove(&r, i);
+    }
+    EXPECT(Roaring_count(&r) == 500);
+    uint32_t v = 0;
+    size_t seen = 0;
+    for (uint64_t from = 0; Roaring_next(&r, from, &v); from = (uint64_t)v + 1)
+    {
+        ok = ok && v >= 18000 && v % 4 == 2;
+        seen++;
+    }
+    EXPECT(ok && seen == 500);
+    Roaring_drop(&r);
+}
+
+TEST(roaring_and_or_match_a_bitset)
+{
+    uint64_t state = 99;
+    Roaring a = Roaring_new(), b = Roaring_new();
+    Bitset ra = Bitset_with_len(300000), rb = Bitset_with_len(300000);
+    for (int i = 0; i < 40000; i++)
+    {
+        // a is dense in its first container, b spread out
+        uint32_t x = (uint32_t)(next_random(&state) % 70000);
+        uint32_t y = (uint32_t)(next_random(&state) % 300000);
+        Roaring_add(&a, x);
+        Bitset_set(&ra, x);
+        if (i % 4 == 0)
+        {
+            Roaring_add(&b, y);
+            Bitset_set(&rb, y);
+        }
+    }
+    Roaring u = Roaring_new();
+    Roaring_or(&u, &a);
+    Roaring_or(&u, &b);
+    Roaring_and(&a, &b);
+    Bitset ru = Bitset_clone(&ra);
+    Bitset_or(&ru, &rb);
+    Bitset_and(&ra, &rb);
+    EXPECT(Roaring_count(&u) == Bitset_count(&ru));
+    EXPECT(Roaring_count(&a) == Bitset_count(&ra));
+    bool ok = true;
+    for (uint32_t i = 0; i < 300000; i++)
+    {
+        ok = ok && Roaring_contains(&u, i) == Bitset_test(&ru, i);
+        ok = ok && Roaring_contains(&a, i) == Bitset_test(&ra, i);
+    }
+    EXPECT(ok);
+    Roaring_drop(&a);
+    Roaring_drop(&b);
+    Roaring_drop(&u);
+    Bitset_drop(&ra);
+    Bitset_drop(&rb);
+    Bitset_drop(&ru);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,120 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define STRING_IMPLEMENTATION
+#define BUFIO_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include "../modules/bufio.h"
+#include "../modules/test.h"
+
+// Create an empty temporary file and return a descriptor open for reading and writing
+int temp_file(void)
+{
+    char path[] = "/tmp/bufio_test_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    unlink(path);
+    return fd;
+}
+
+void write_all(int fd, const char *text)
+{
+    size_t len = strlen(text);
+    ssize_t written = write(fd, text, len);
+    assert(written == (ssize_t)len);
+    (void)written;
+    lseek(fd, 0, SEEK_SET);
+}
+
+TEST(BufReader_splits_lines_across_blocks)
+{
+    int fd = temp_file();
+    write_all(fd, "first\nsecond line\n\nthird without newline");
+    // A tiny buffer forces partial lines to be carried between reads
+    BufReader r = BufReader_new(fd, 4);
+    StringView line;
+    EXPECT(BufReader_next(&r, &line) && StringView_equals_str(line, "first"));
+    EXPECT(BufReader_next(&r, &line) && StringView_equals_str(line, "second line"));
+    EXPECT(BufReader_next(&r, &line) && line.len == 0);
+    EXPECT(BufReader_next(&r, &line) && StringView_equals_str(line, "third without newline"));
+    EXPECT(!BufReader_next(&r, &line));
+    EXPECT(r.error == 0);
+    BufReader_drop(&r);
+    close(fd);
+}
+
+TEST(BufReader_delimiter_sets)
+{
+    int fd = temp_file();
+    write_all(fd, "a,b;c\tdddddddddddddddddddddddddddddddd,e\n");
+    BufReader r = BufReader_new(fd, 0);
+    BufReader_set_delimiters(&r, ",;\t\n");
+    const char *expected[] = {"a", "b", "c", "dddddddddddddddddddddddddddddddd", "e"};
+    StringView field;
+    for (size_t i = 0; i < 5; i++)
+    {
+        EXPECT(BufReader_next(&r, &field) && StringView_equals_str(field, expected[i]));
+    }
+    EXPECT(!BufReader_next(&r, &field));
+    BufReader_drop(&r);
+    close(fd);
+}
+
+TEST(BufReader_pread_and_raw_reads)
+{
+    int fd = temp_file();
+    write_all(fd, "header\nbody one\nbody two\n");
+    BufReader r = BufReader_at(fd, 8, 7);
+    StringView line;
+    EXPECT(BufReader_next(&r, &line) && StringView_equals_str(line, "body one"));
+    char raw[16] = {0};
+    EXPECT(BufReader_read(&r, raw, 4) > 0);
+    EXPECT(strncmp(raw, "body", strlen(raw)) == 0);
+    // pread leaves the file position alone
+    EXPECT(lseek(fd, 0, SEEK_CUR) == 0);
+    BufReader_drop(&r);
+    close(fd);
+}
+
+TEST(BufWriter_round_trip)
+{
+    int fd = temp_file();
+    BufWriter w = BufWriter_new(fd, 16);
+    char chars[101];
+    memset(chars, 'x', 100);
+    chars[100] = '\0';
+    String big = String_from(chars);
+    EXPECT(BufWriter_write_line(&w, (StringView){"short", 5}));
+    EXPECT(BufWriter_write_string(&w, &big));
+    EXPECT(BufWriter_write(&w, "\n", 1));
+    for (int i = 0; i < 50; i++)
+    {
+        EXPECT(BufWriter_write_line(&w, (StringView){"0123456789", 10}));
+    }
+    EXPECT(BufWriter_drop(&w));
+    EXPECT(lseek(fd, 0, SEEK_CUR) == 6 + 101 + 50 * 11);
+
+    lseek(fd, 0, SEEK_SET);
+    BufReader r = BufReader_new(fd, 32);
+    StringView line;
+    EXPECT(BufReader_next(&r, &line) && StringView_equals_str(line, "short"));
+    EXPECT(BufReader_next(&r, &line) && StringView_equals(line, String_as_view(&big)));
+    size_t count = 0;
+    while (BufReader_next(&r, &line))
+    {
+        count += StringView_equals_str(line, "0123456789");
+    }
+    EXPECT(count == 50);
+    BufReader_drop(&r);
+    String_drop(&big);
+    close(fd);
+}
+
+int main()
+{
+    return run_tests();
+}
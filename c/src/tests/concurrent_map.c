@@ -0,0 +1,173 @@
+#define ALLOC_IMPLEMENTATION
+#define CONCURRENT_MAP_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../modules/concurrent_map.h"
+#include "../modules/test.h"
+
+TEST(ConcurrentMap_new)
+{
+    ConcurrentMap map = ConcurrentMap_new(5, sizeof(int), sizeof(double), GLOBAL_ALLOCATOR);
+    EXPECT(map.shard_mask == 7);
+    EXPECT(ConcurrentMap_len(&map) == 0);
+    int key = 1;
+    EXPECT(!ConcurrentMap_contains(&map, &key));
+    ConcurrentMap_drop(&map);
+    EXPECT(map.shards == NULL);
+}
+
+TEST(insert_get_and_remove)
+{
+    ConcurrentMap map = ConcurrentMap_new(4, sizeof(int), sizeof(int), GLOBAL_ALLOCATOR);
+    for (int i = 0; i < 1000; i++)
+    {
+        int value = i * 10;
+        EXPECT(ConcurrentMap_insert(&map, &i, &value));
+    }
+    EXPECT(ConcurrentMap_len(&map) == 1000);
+
+    int key = 500;
+    int value = -1;
+    EXPECT(!ConcurrentMap_insert(&map, &key, &value));
+    EXPECT(ConcurrentMap_len(&map) == 1000);
+
+    bool all_found = true;
+    for (int i = 0; i < 1000; i++)
+    {
+        int out = 0;
+        all_found = all_found && ConcurrentMap_get(&map, &i, &out) && out == (i == 500 ? -1 : i * 10);
+    }
+    EXPECT(all_found);
+
+    int out;
+    for (int i = 0; i < 1000; i += 2)
+    {
+        EXPECT(ConcurrentMap_remove(&map, &i, &out));
+    }
+    EXPECT(!ConcurrentMap_remove(&map, &key, &out));
+    EXPECT(ConcurrentMap_len(&map) == 500);
+    bool odd_only = true;
+    for (int i = 0; i < 1000; i++)
+    {
+        odd_only = odd_only && ConcurrentMap_contains(&map, &i) == (i % 2 == 1);
+    }
+    EXPECT(odd_only);
+    ConcurrentMap_drop(&map);
+}
+
+TEST(home_slots_cover_the_table)
+{
+    // One shard, so all keys land in its initial table
+    ConcurrentMap map = ConcurrentMap_new(1, sizeof(int), sizeof(int), GLOBAL_ALLOCATOR);
+    MapTable *table = atomic_load(&map.shards[0].table);
+    size_t cap = table->cap;
+    for (int i = 0; i < (int)cap / 2; i++)
+    {
+        EXPECT(ConcurrentMap_insert(&map, &i, &i));
+    }
+    EXPECT(atomic_load(&map.shards[0].table) == table);
+    size_t even_homes = 0;
+    for (size_t i = 0; i < cap; i += 2)
+    {
+        uint64_t hash = atomic_load(MapTable_slot_(&map, table, i));
+        even_homes += hash != 0 && (hash & (cap - 1)) == i;
+    }
+    EXPECT(even_homes > 0);
+    ConcurrentMap_drop(&map);
+}
+
+TEST(ConcurrentMap_get_many)
+{
+    ConcurrentMap map = ConcurrentMap_new(0, sizeof(long), sizeof(long), GLOBAL_ALLOCATOR);
+    for (long i = 0; i < 100; i++)
+    {
+        long value = i * i;
+        ConcurrentMap_insert(&map, &i, &value);
+    }
+    long keys[40];
+    long values[40];
+    bool found[40];
+    for (long i = 0; i < 40; i++)
+    {
+        keys[i] = i * 5;
+    }
+    EXPECT(ConcurrentMap_get_many(&map, keys, 40, values, found) == 20);
+    for (long i = 0; i < 40; i++)
+    {
+        EXPECT(found[i] == (keys[i] < 100));
+        if (found[i])
+        {
+            EXPECT(values[i] == keys[i] * keys[i]);
+        }
+    }
+    ConcurrentMap_drop(&map);
+}
+
+typedef struct
+{
+    ConcurrentMap *map;
+    long first;
+    long count;
+    bool ok;
+} Worker;
+
+void *writer(void *arg)
+{
+    Worker *w = arg;
+    for (long i = w->first; i < w->first + w->count; i++)
+    {
+        long value = i + 1;
+        ConcurrentMap_insert(w->map, &i, &value);
+    }
+    return NULL;
+}
+
+void *reader(void *arg)
+{
+    Worker *w = arg;
+    w->ok = true;
+    for (int round = 0; round < 5; round++)
+    {
+        for (long i = w->first; i < w->first + w->count; i++)
+        {
+            long value;
+            if (ConcurrentMap_get(w->map, &i, &value) && value != i + 1)
+            {
+                w->ok = false;
+            }
+        }
+    }
+    return NULL;
+}
+
+TEST(concurrent_readers_and_writers)
+{
+    ConcurrentMap map = ConcurrentMap_new(8, sizeof(long), sizeof(long), GLOBAL_ALLOCATOR);
+    pthread_t threads[8];
+    Worker workers[8];
+    for (int i = 0; i < 4; i++)
+    {
+        workers[i] = (Worker){&map, i * 5000, 5000, true};
+        workers[4 + i] = (Worker){&map, i * 5000, 5000, true};
+        pthread_create(&threads[i], NULL, writer, &workers[i]);
+        pthread_create(&threads[4 + i], NULL, reader, &workers[4 + i]);
+    }
+    for (int i = 0; i < 8; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    EXPECT(ConcurrentMap_len(&map) == 20000);
+    for (int i = 4; i < 8; i++)
+    {
+        EXPECT(workers[i].ok);
+    }
+    ConcurrentMap_drop(&map);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,153 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define STRING_IMPLEMENTATION
+#define CSV_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../modules/csv.h"
+#include "../modules/test.h"
+
+// Tokenize `text` in one go and check field `index` of `row`
+bool field_is(const CsvTokenizer *t, const char *text, size_t row, size_t index, const char *expected)
+{
+    const CsvField *fields;
+    size_t count = CsvTokenizer_row(t, row, &fields);
+    return index < count && StringView_equals_str(Csv_field_view(text, 0, fields[index]), expected);
+}
+
+TEST(CsvTokenizer_quotes_and_crlf)
+{
+    const char *text =
+        "id,name,comment\r\n"
+        "1,\"Smith, John\",\"said \"\"hi\"\"\"\r\n"
+        "\r\n"
+        "2,,\"multi\nline, with a long tail that crosses a block boundary ..........\"\n"
+        "3,last,no newline";
+    CsvTokenizer t = CsvTokenizer_new(',');
+    CsvTokenizer_feed(&t, text, strlen(text));
+    CsvTokenizer_finish(&t);
+
+    EXPECT(CsvTokenizer_row_count(&t) == 4);
+    EXPECT(field_is(&t, text, 0, 2, "comment"));
+    EXPECT(field_is(&t, text, 1, 1, "Smith, John"));
+    EXPECT(field_is(&t, text, 1, 2, "said \"\"hi\"\""));
+    EXPECT(field_is(&t, text, 2, 1, ""));
+    EXPECT(field_is(&t, text, 2, 2, "multi\nline, with a long tail that crosses a block boundary .........."));
+    EXPECT(field_is(&t, text, 3, 2, "no newline"));
+    for (size_t r = 0; r < 4; r++)
+    {
+        const CsvField *fields;
+        EXPECT(CsvTokenizer_row(&t, r, &fields) == 3);
+    }
+
+    const CsvField *fields;
+    CsvTokenizer_row(&t, 1, &fields);
+    String unescaped = String_new();
+    Csv_unescape(Csv_field_view(text, 0, fields[2]), &unescaped);
+    EXPECT(strcmp(String_as_str(&unescaped), "said \"hi\"") == 0);
+    String_drop(&unescaped);
+    CsvTokenizer_drop(&t);
+}
+
+TEST(CsvTokenizer_chunked_feed_matches_single_feed)
+{
+    static char data[200 * 32];
+    size_t len = 0;
+    for (int i = 0; i < 200; i++)
+    {
+        len += (size_t)snprintf(data + len, sizeof(data) - len, "%d\t\"q\t%d\"\t%s\r\n", i, i * 7, i % 3 ? "x" : "");
+    }
+
+    CsvTokenizer whole = CsvTokenizer_new('\t');
+    CsvTokenizer_feed(&whole, data, len);
+    CsvTokenizer_finish(&whole);
+    EXPECT(CsvTokenizer_row_count(&whole) == 200);
+
+    size_t chunks[] = {1, 7, 63, 64, 65, 1000};
+    for (size_t c = 0; c < 6; c++)
+    {
+        CsvTokenizer t = CsvTokenizer_new('\t');
+        for (size_t i = 0; i < len; i += chunks[c])
+        {
+            CsvTokenizer_feed(&t, data + i, len - i < chunks[c] ? len - i : chunks[c]);
+        }
+        CsvTokenizer_finish(&t);
+        EXPECT(t.fields.len == whole.fields.len);
+        EXPECT(memcmp(t.fields.buf.ptr, whole.fields.buf.ptr, t.fields.len * sizeof(CsvField)) == 0);
+        CsvTokenizer_drop(&t);
+    }
+    EXPECT(field_is(&whole, data, 5, 1, "q\t35"));
+    EXPECT(field_is(&whole, data, 5, 2, "x"));
+    EXPECT(field_is(&whole, data, 6, 2, ""));
+    CsvTokenizer_drop(&whole);
+}
+
+TEST(CsvTokenizer_clear_rows_keeps_partial_row)
+{
+    const char *text = "a,b\nc,d\ne,";
+    CsvTokenizer t = CsvTokenizer_new(',');
+    CsvTokenizer_feed(&t, text, strlen(text));
+    EXPECT(CsvTokenizer_row_count(&t) == 2);
+    CsvTokenizer_clear_rows(&t);
+    EXPECT(CsvTokenizer_row_count(&t) == 0);
+    CsvTokenizer_feed(&t, "f\n", 2);
+    EXPECT(CsvTokenizer_row_count(&t) == 1);
+    // Offsets keep counting from the start of the stream
+    const char *stream = "a,b\nc,d\ne,f\n";
+    EXPECT(field_is(&t, stream, 0, 0, "e"));
+    EXPECT(field_is(&t, stream, 0, 1, "f"));
+    CsvTokenizer_drop(&t);
+}
+
+TEST(Csv_parse_columns_typed)
+{
+    const char *text = "1,2.5,apple,ignored\n-42,1e3,\"banana, ripe\",x\nnope,,cherry\n";
+    CsvTokenizer t = CsvTokenizer_new(',');
+    CsvTokenizer_feed(&t, text, strlen(text));
+    CsvTokenizer_finish(&t);
+
+    CsvColumnType types[] = {CSV_INT64, CSV_DOUBLE, CSV_STRING, CSV_SKIP};
+    Vec columns[4] = {Vec_new(), Vec_new(), Vec_new(), Vec_new()};
+    size_t bad = Csv_parse_columns(&t, text, 0, types, 4, columns);
+    // "nope" and the empty double are unparsable
+    EXPECT(bad == 2);
+    int64_t *ints = Vec_as_mut_slice(&columns[0]);
+    double *doubles = Vec_as_mut_slice(&columns[1]);
+    StringView *names = Vec_as_mut_slice(&columns[2]);
+    EXPECT(columns[0].len == 3 && ints[0] == 1 && ints[1] == -42 && ints[2] == 0);
+    EXPECT(doubles[0] == 2.5 && doubles[1] == 1000.0);
+    EXPECT(StringView_equals_str(names[1], "banana, ripe"));
+    EXPECT(columns[3].len == 0);
+    for (size_t c = 0; c < 4; c++)
+    {
+        Vec_drop(&columns[c]);
+    }
+    CsvTokenizer_drop(&t);
+}
+
+StringView view_of(const char *s)
+{
+    return (StringView){.ptr = s, .len = strlen(s)};
+}
+
+TEST(Csv_parse_int64_range)
+{
+    int64_t value = 0;
+    EXPECT(Csv_parse_int64_(view_of("9223372036854775807"), &value));
+    EXPECT(value == INT64_MAX);
+    EXPECT(Csv_parse_int64_(view_of("-9223372036854775808"), &value));
+    EXPECT(value == INT64_MIN);
+    EXPECT(!Csv_parse_int64_(view_of("9223372036854775808"), &value));
+    EXPECT(!Csv_parse_int64_(view_of("-9223372036854775809"), &value));
+    EXPECT(!Csv_parse_int64_(view_of("9999999999999999999"), &value));
+    EXPECT(!Csv_parse_int64_(view_of("+10000000000000000000"), &value));
+    EXPECT(Csv_parse_int64_(view_of("+17"), &value) && value == 17);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,178 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define EBR_IMPLEMENTATION
+#define CONCURRENT_VEC_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../modules/ebr.h"
+#include "../modules/concurrent_vec.h"
+#include "../modules/test.h"
+
+atomic_size_t live_allocations = 0;
+
+void *counting_allocate(size_t size)
+{
+    atomic_fetch_add(&live_allocations, 1);
+    return malloc(size);
+}
+
+void counting_deallocate(void *ptr)
+{
+    atomic_fetch_sub(&live_allocations, 1);
+    free(ptr);
+}
+
+void *counting_reallocate(void *ptr, size_t old_size, size_t new_size)
+{
+    (void)old_size; // unused parameter
+    return realloc(ptr, new_size);
+}
+
+Allocator counting_allocator = {
+    .allocate = counting_allocate,
+    .deallocate = counting_deallocate,
+    .reallocate = counting_reallocate};
+
+TEST(Ebr_pin_and_unpin)
+{
+    Ebr *ebr = Ebr_new(GLOBAL_ALLOCATOR);
+    EbrThread *t = Ebr_register(ebr);
+    EXPECT(!Ebr_is_pinned(t));
+    Ebr_pin(t);
+    Ebr_pin(t);
+    EXPECT(Ebr_is_pinned(t));
+    Ebr_unpin(t);
+    EXPECT(Ebr_is_pinned(t));
+    Ebr_unpin(t);
+    EXPECT(!Ebr_is_pinned(t));
+    Ebr_unregister(t);
+    // The released slot is reused
+    EXPECT(Ebr_register(ebr) == t);
+    Ebr_drop(ebr);
+}
+
+TEST(pinned_thread_blocks_reclamation)
+{
+    Ebr *ebr = Ebr_new(counting_allocator);
+    size_t baseline = atomic_load(&live_allocations);
+    EbrThread *writer = Ebr_register(ebr);
+    EbrThread *reader = Ebr_register(ebr);
+    size_t after_register = atomic_load(&live_allocations);
+
+    Ebr_pin(reader);
+    uint64_t start = Ebr_epoch(ebr);
+    Ebr_retire(writer, counting_allocate(16));
+    // The reader pinned at `start` lets the epoch move only one step
+    EXPECT(Ebr_try_advance(ebr));
+    EXPECT(!Ebr_try_advance(ebr));
+    EXPECT(Ebr_epoch(ebr) == start + 1);
+    Ebr_collect(writer);
+    EXPECT(atomic_load(&live_allocations) == after_register + 1);
+
+    Ebr_unpin(reader);
+    EXPECT(Ebr_try_advance(ebr));
+    Ebr_collect(writer);
+    EXPECT(atomic_load(&live_allocations) == after_register);
+
+    Ebr_drop(ebr);
+    EXPECT(atomic_load(&live_allocations) == baseline - 1);
+}
+
+TEST(batched_frees)
+{
+    Ebr *ebr = Ebr_new(counting_allocator);
+    EbrThread *t = Ebr_register(ebr);
+    size_t after_register = atomic_load(&live_allocations);
+    for (size_t i = 0; i < 10 * EBR_RETIRE_BATCH; i++)
+    {
+        Ebr_pin(t);
+        Ebr_retire(t, counting_allocate(32));
+        Ebr_unpin(t);
+    }
+    // Reclamation keeps up: at most a few batches are outstanding
+    EXPECT(atomic_load(&live_allocations) - after_register <= 3 * EBR_RETIRE_BATCH);
+    Ebr_unregister(t);
+    Ebr_drop(ebr);
+}
+
+typedef struct
+{
+    ConcurrentVec *vec;
+    Ebr *ebr;
+    atomic_bool *done;
+    bool ok;
+} Reader;
+
+void *reader_main(void *arg)
+{
+    Reader *r = arg;
+    EbrThread *t = Ebr_register(r->ebr);
+    r->ok = true;
+    while (!atomic_load(r->done))
+    {
+        size_t len = ConcurrentVec_len(r->vec);
+        for (size_t i = 0; i < len; i += 7)
+        {
+            long value;
+            if (!ConcurrentVec_get(r->vec, t, i, &value) || value != (long)i * 3)
+            {
+                r->ok = false;
+            }
+        }
+    }
+    Ebr_unregister(t);
+    return NULL;
+}
+
+TEST(ConcurrentVec_readers_during_growth)
+{
+    Ebr *ebr = Ebr_new(GLOBAL_ALLOCATOR);
+    EbrThread *t = Ebr_register(ebr);
+    ConcurrentVec vec;
+    ConcurrentVec_init(&vec, sizeof(long), ebr);
+    atomic_bool done = false;
+    Reader readers[3];
+    pthread_t threads[3];
+    for (int i = 0; i < 3; i++)
+    {
+        readers[i] = (Reader){&vec, ebr, &done, true};
+        pthread_create(&threads[i], NULL, reader_main, &readers[i]);
+    }
+    for (long i = 0; i < 50000; i++)
+    {
+        long value = i * 3;
+        ConcurrentVec_push(&vec, t, &value);
+    }
+    atomic_store(&done, true);
+    for (int i = 0; i < 3; i++)
+    {
+        pthread_join(threads[i], NULL);
+        EXPECT(readers[i].ok);
+    }
+    EXPECT(ConcurrentVec_len(&vec) == 50000);
+    EXPECT(ConcurrentVec_capacity(&vec) >= 50000);
+
+    long value;
+    EXPECT(ConcurrentVec_get(&vec, t, 49999, &value));
+    EXPECT(value == 49999 * 3);
+    EXPECT(!ConcurrentVec_get(&vec, t, 50000, &value));
+
+    size_t len;
+    Ebr_pin(t);
+    const long *items = ConcurrentVec_as_slice(&vec, t, &len);
+    EXPECT(len == 50000 && items[100] == 300);
+    Ebr_unpin(t);
+
+    ConcurrentVec_drop(&vec);
+    Ebr_unregister(t);
+    Ebr_drop(ebr);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,181 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define HEAP_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../modules/heap.h"
+#include "../modules/test.h"
+
+int compare_int(const void *a, const void *b)
+{
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+#define INT_GREATER(a, b) ((a) > (b))
+define_Heap(MaxHeap4, int, 4, INT_GREATER);
+
+// Pseudo-random values with duplicates
+void fill_values(int *values, size_t count)
+{
+    unsigned seed = 12345;
+    for (size_t i = 0; i < count; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        values[i] = (int)((seed >> 16) % 1000);
+    }
+}
+
+bool drains_sorted(Heap *heap, size_t expected_len)
+{
+    int prev;
+    int value;
+    size_t popped = 0;
+    bool ok = true;
+    while (Heap_pop(heap, &value))
+    {
+        if (popped > 0 && value > prev)
+        {
+            ok = false;
+        }
+        prev = value;
+        popped++;
+    }
+    return ok && popped == expected_len;
+}
+
+TEST(Heap_new)
+{
+    Heap heap = Heap_new(sizeof(int), 2, compare_int);
+    EXPECT(Heap_len(&heap) == 0);
+    EXPECT(Heap_is_empty(&heap));
+    EXPECT(Heap_peek(&heap) == NULL);
+    int value;
+    EXPECT(!Heap_pop(&heap, &value));
+    Heap_drop(&heap);
+}
+
+TEST(push_and_pop)
+{
+    int values[200];
+    fill_values(values, 200);
+    for (size_t arity = 2; arity <= 8; arity *= 2)
+    {
+        Heap heap = Heap_new(sizeof(int), arity, compare_int);
+        for (size_t i = 0; i < 200; i++)
+        {
+            Heap_push(&heap, &values[i]);
+        }
+        EXPECT(Heap_len(&heap) == 200);
+        EXPECT(drains_sorted(&heap, 200));
+        Heap_drop(&heap);
+    }
+}
+
+TEST(Heap_from_slice)
+{
+    int values[301];
+    fill_values(values, 301);
+    Heap binary = Heap_from_slice(values, 301, sizeof(int), 2, compare_int);
+    Heap quad = Heap_from_slice(values, 301, sizeof(int), 4, compare_int);
+    EXPECT(*(int *)Heap_peek(&binary) == *(int *)Heap_peek(&quad));
+    EXPECT(drains_sorted(&binary, 301));
+    EXPECT(drains_sorted(&quad, 301));
+    Heap_drop(&binary);
+    Heap_drop(&quad);
+}
+
+TEST(Heap_new_min)
+{
+    int values[] = {5, 1, 4, 2, 3};
+    Heap heap = Heap_new_min(sizeof(int), 4, compare_int);
+    for (size_t i = 0; i < 5; i++)
+    {
+        Heap_push(&heap, &values[i]);
+    }
+    for (int expected = 1; expected <= 5; expected++)
+    {
+        int value;
+        EXPECT(Heap_pop(&heap, &value));
+        EXPECT(value == expected);
+    }
+    Heap_drop(&heap);
+}
+
+TEST(push_pop_and_replace_top)
+{
+    int values[] = {10, 20, 30};
+    Heap heap = Heap_from_slice(values, 3, sizeof(int), 2, compare_int);
+    int out;
+    int value = 50;
+    Heap_push_pop(&heap, &value, &out);
+    EXPECT(out == 50);
+    EXPECT(Heap_len(&heap) == 3);
+    value = 15;
+    Heap_push_pop(&heap, &value, &out);
+    EXPECT(out == 30);
+    EXPECT(*(int *)Heap_peek(&heap) == 20);
+    value = 5;
+    Heap_replace_top(&heap, &value, &out);
+    EXPECT(out == 20);
+    EXPECT(*(int *)Heap_peek(&heap) == 15);
+    EXPECT(drains_sorted(&heap, 3));
+    Heap_drop(&heap);
+}
+
+TEST(Heap_top_k)
+{
+    int values[1000];
+    fill_values(values, 1000);
+    Vec src = Vec_new();
+    for (size_t i = 0; i < 1000; i++)
+    {
+        Vec_push(&src, &values[i], sizeof(int));
+    }
+    Vec top = Vec_new();
+    Heap_top_k(&src, 10, sizeof(int), compare_int, &top);
+    EXPECT(Vec_len(&top) == 10);
+
+    qsort(values, 1000, sizeof(int), compare_int);
+    for (size_t i = 0; i < 10; i++)
+    {
+        EXPECT(*(int *)Vec_get(&top, i, sizeof(int)) == values[999 - i]);
+    }
+
+    Heap_top_k(&src, 5000, sizeof(int), compare_int, &top);
+    EXPECT(Vec_len(&top) == 1000);
+    Vec_drop(&top);
+    Vec_drop(&src);
+}
+
+TEST(typed_heap)
+{
+    int values[257];
+    fill_values(values, 257);
+    MaxHeap4 heap = MaxHeap4_from_slice(values, 257);
+    MaxHeap4_push(&heap, 5000);
+    EXPECT(*MaxHeap4_peek(&heap) == 5000);
+    EXPECT(MaxHeap4_push_pop(&heap, 6000) == 6000);
+    EXPECT(MaxHeap4_replace_top(&heap, -1) == 5000);
+    EXPECT(MaxHeap4_len(&heap) == 258);
+    int prev = 1 << 30;
+    int value;
+    bool ordered = true;
+    while (MaxHeap4_pop(&heap, &value))
+    {
+        ordered = ordered && value <= prev;
+        prev = value;
+    }
+    EXPECT(ordered);
+    EXPECT(prev == -1);
+    MaxHeap4_drop(&heap);
+}
+
+int main()
+{
+    return run_tests();
+}
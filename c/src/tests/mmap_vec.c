@@ -0,0 +1,138 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define MMAP_VEC_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "../modules/mmap_vec.h"
+#include "../modules/test.h"
+
+// Create a unique, empty temporary file path
+void temp_path(char *path, size_t size)
+{
+    snprintf(path, size, "/tmp/mmap_vec_test_XXXXXX");
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+}
+
+TEST(MmapVec_persists_across_reopen)
+{
+    char path[64];
+    temp_path(path, sizeof(path));
+
+    MmapVec m;
+    EXPECT(MmapVec_open(&m, path, sizeof(long)));
+    EXPECT(MmapVec_len(&m) == 0);
+    size_t initial_cap = MmapVec_capacity(&m);
+    for (long i = 0; i < 10000; i++)
+    {
+        EXPECT(MmapVec_push(&m, &i));
+    }
+    EXPECT(MmapVec_capacity(&m) > initial_cap);
+    // The embedded Vec is usable with the regular Vec functions
+    long value = -1;
+    Vec_set(&m.vec, 5, &value, sizeof(long));
+    EXPECT(*(long *)Vec_get(&m.vec, 9999, sizeof(long)) == 9999);
+    EXPECT(MmapVec_close(&m));
+
+    EXPECT(MmapVec_open(&m, path, sizeof(long)));
+    EXPECT(MmapVec_len(&m) == 10000);
+    EXPECT(*(long *)Vec_get(&m.vec, 5, sizeof(long)) == -1);
+    EXPECT(*(long *)Vec_get(&m.vec, 1234, sizeof(long)) == 1234);
+    long more[3] = {1, 2, 3};
+    EXPECT(MmapVec_extend(&m, more, 3));
+    EXPECT(MmapVec_len(&m) == 10003);
+    EXPECT(MmapVec_close(&m));
+
+    unlink(path);
+}
+
+TEST(MmapVec_rejects_mismatched_files)
+{
+    char path[64];
+    temp_path(path, sizeof(path));
+
+    MmapVec m;
+    EXPECT(MmapVec_open(&m, path, sizeof(int)));
+    int value = 7;
+    EXPECT(MmapVec_push(&m, &value));
+    EXPECT(MmapVec_close(&m));
+
+    EXPECT(!MmapVec_open(&m, path, sizeof(double)));
+    EXPECT(errno == EINVAL);
+    EXPECT(!MmapVec_open_read_only(&m, "/tmp/mmap_vec_test_missing", sizeof(int)));
+
+    unlink(path);
+}
+
+// A capacity that overflows cap * elem_size must not pass as fitting the file
+TEST(MmapVec_rejects_oversized_capacity)
+{
+    char path[64];
+    temp_path(path, sizeof(path));
+
+    MmapVec m;
+    EXPECT(MmapVec_open(&m, path, sizeof(long)));
+    EXPECT(MmapVec_close(&m));
+    int fd = open(path, O_RDWR);
+    uint64_t cap = 1ull << 61;
+    EXPECT(pwrite(fd, &cap, sizeof(cap), offsetof(MmapVecHeader, cap)) == sizeof(cap));
+    close(fd);
+
+    EXPECT(!MmapVec_open(&m, path, sizeof(long)));
+    EXPECT(errno == EINVAL);
+    EXPECT(!MmapVec_open_read_only(&m, path, sizeof(long)));
+
+    unlink(path);
+}
+
+TEST(MmapVec_reader_sees_appends)
+{
+    char path[64];
+    temp_path(path, sizeof(path));
+
+    MmapVec writer;
+    EXPECT(MmapVec_open(&writer, path, sizeof(int)));
+    for (int i = 0; i < 10; i++)
+    {
+        EXPECT(MmapVec_push(&writer, &i));
+    }
+    EXPECT(MmapVec_sync(&writer, false));
+
+    MmapVec reader;
+    EXPECT(MmapVec_open_read_only(&reader, path, sizeof(int)));
+    EXPECT(MmapVec_advise(&reader, MMAP_VEC_SEQUENTIAL));
+    EXPECT(MmapVec_len(&reader) == 10);
+    EXPECT(MmapVec_capacity(&reader) == 10);
+
+    // Appends past the initial capacity grow and remap the writer's file
+    for (int i = 10; i < 5000; i++)
+    {
+        EXPECT(MmapVec_push(&writer, &i));
+    }
+    EXPECT(MmapVec_len(&reader) == 10);
+    EXPECT(MmapVec_refresh(&reader));
+    EXPECT(MmapVec_len(&reader) == 5000);
+    const int *items = Vec_as_slice(&reader.vec);
+    bool ok = true;
+    for (int i = 0; i < 5000; i++)
+    {
+        ok = ok && items[i] == i;
+    }
+    EXPECT(ok);
+
+    EXPECT(MmapVec_close(&reader));
+    EXPECT(MmapVec_close(&writer));
+    unlink(path);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,82 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define STRING_IMPLEMENTATION
+#define BITSET_IMPLEMENTATION
+#define QUEUE_IMPLEMENTATION
+#include <stdio.h>
+#include <stdint.h>
+#include "../modules/vec.h"
+#include "../modules/string.h"
+#include "../modules/bitset.h"
+#include "../modules/queue.h"
+#include "../modules/test.h"
+
+// Defined in multi_unit/second.c
+Vec second_unit_squares(size_t count);
+String second_unit_greeting(const char *name);
+Bitset second_unit_multiples(size_t len, size_t step);
+void second_unit_produce(SpscQueue *q, uint64_t count);
+
+TEST(vec_crosses_translation_units)
+{
+    Vec vec = second_unit_squares(1000);
+    EXPECT(Vec_len(&vec) == 1000);
+    EXPECT(*(uint64_t *)Vec_get(&vec, 999, sizeof(uint64_t)) == 999 * 999);
+    // Grown in one unit, grown further and freed in this one
+    uint64_t value = 7;
+    Vec_push(&vec, &value, sizeof(value));
+    Vec_resize(&vec, 2000, &value, sizeof(value));
+    EXPECT(*(uint64_t *)Vec_get(&vec, 1999, sizeof(uint64_t)) == 7);
+    Vec_drop(&vec);
+}
+
+TEST(string_crosses_translation_units)
+{
+    String s = second_unit_greeting("world");
+    EXPECT(strcmp(String_as_str(&s), "hello, world!") == 0);
+    EXPECT(String_len(&s) == 13);
+    String_drop(&s);
+}
+
+TEST(bitset_crosses_translation_units)
+{
+    Bitset b = second_unit_multiples(1000, 3);
+    EXPECT(Bitset_len(&b) == 1000);
+    EXPECT(Bitset_count(&b) == 334);
+    EXPECT(Bitset_test(&b, 999) && !Bitset_test(&b, 998));
+    EXPECT(Bitset_next(&b, 1) == 3);
+    Bitset_drop(&b);
+}
+
+TEST(queue_crosses_translation_units)
+{
+    // Created and drained here, filled by the other unit
+    SpscQueue q = SpscQueue_new(64, sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    second_unit_produce(&q, 40);
+    EXPECT(SpscQueue_len(&q) == 40);
+    uint64_t sum = 0;
+    uint64_t value;
+    while (SpscQueue_try_pop(&q, &value))
+    {
+        sum += value;
+    }
+    EXPECT(sum == 40 * 39 / 2);
+    SpscQueue_drop(&q);
+}
+
+TEST(both_units_share_one_global_allocator)
+{
+    // Both units reference the single GLOBAL_ALLOCATOR emitted here
+    Vec mine = Vec_new();
+    Vec theirs = second_unit_squares(0);
+    EXPECT(mine.buf.alloc.allocate == theirs.buf.alloc.allocate);
+    EXPECT(mine.buf.alloc.allocate == GLOBAL_ALLOCATOR.allocate);
+    Vec_drop(&mine);
+    Vec_drop(&theirs);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,46 @@
+// A second translation unit: it includes the same headers without any
+// *_IMPLEMENTATION macro and uses the out-of-line functions from the first.
+#include <stdint.h>
+#include "../../modules/vec.h"
+#include "../../modules/string.h"
+#include "../../modules/bitset.h"
+#include "../../modules/queue.h"
+
+Vec second_unit_squares(size_t count)
+{
+    Vec vec = Vec_new();
+    for (uint64_t i = 0; i < count; i++)
+    {
+        uint64_t square = i * i;
+        Vec_push(&vec, &square, sizeof(square));
+    }
+    return vec;
+}
+
+String second_unit_greeting(const char *name)
+{
+    String s = String_from("hello, ");
+    String_push_str(&s, name);
+    String_push(&s, '!');
+    return s;
+}
+
+Bitset second_unit_multiples(size_t len, size_t step)
+{
+    Bitset b = Bitset_with_len(len);
+    for (size_t i = 0; i < len; i += step)
+    {
+        Bitset_set(&b, i);
+    }
+    return b;
+}
+
+void second_unit_produce(SpscQueue *q, uint64_t count)
+{
+    uint64_t values[64];
+    for (uint64_t i = 0; i < count; i++)
+    {
+        values[i] = i;
+    }
+    SpscQueue_push_batch(q, values, count);
+}
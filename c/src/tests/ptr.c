@@ -0,0 +1,220 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define PTR_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../modules/vec.h"
+#include "../modules/ptr.h"
+#include "../modules/test.h"
+
+atomic_int allocations = 0;
+atomic_int deallocations = 0;
+atomic_int vec_drops = 0;
+atomic_int vec_clones = 0;
+
+void *counting_allocate(size_t size)
+{
+    allocations++;
+    return malloc(size);
+}
+
+void counting_deallocate(void *ptr)
+{
+    deallocations++;
+    free(ptr);
+}
+
+Allocator COUNTING_ALLOCATOR = {
+    .allocate = counting_allocate,
+    .deallocate = counting_deallocate,
+    .reallocate = realloc_wrapper};
+
+// Drop and deep-copy a Vec of uint64_t
+void u64_vec_drop(void *value)
+{
+    vec_drops++;
+    Vec_drop(value);
+}
+
+void u64_vec_clone(void *dst, const void *src)
+{
+    vec_clones++;
+    const Vec *from = src;
+    Vec *to = dst;
+    *to = Vec_with_capacity(from->len, sizeof(uint64_t));
+    memcpy(to->buf.ptr, from->buf.ptr, from->len * sizeof(uint64_t));
+    to->len = from->len;
+}
+
+const PtrOps U64_VEC_OPS = {.drop = u64_vec_drop, .clone = u64_vec_clone};
+
+Vec make_vec(size_t len)
+{
+    Vec vec = Vec_new();
+    for (uint64_t i = 0; i < len; i++)
+    {
+        Vec_push(&vec, &i, sizeof(i));
+    }
+    return vec;
+}
+
+void reset_counts(void)
+{
+    allocations = deallocations = vec_drops = vec_clones = 0;
+}
+
+TEST(box_owns_and_clones)
+{
+    reset_counts();
+    Vec vec = make_vec(10);
+    Box box = Box_new(&vec, sizeof(vec), &U64_VEC_OPS, COUNTING_ALLOCATOR);
+    Box copy = Box_clone(&box);
+    EXPECT(((Vec *)Box_get(&copy))->len == 10);
+    EXPECT(Box_get(&copy) != Box_get(&box));
+    Box_drop(&box);
+    Box_drop(&copy);
+    EXPECT(box.ptr == NULL);
+    EXPECT(vec_clones == 1 && vec_drops == 2);
+    EXPECT(allocations == 2 && deallocations == 2);
+}
+
+TEST(rc_counts_and_drops_once)
+{
+    reset_counts();
+    int value = 42;
+    Rc a = Rc_new(&value, sizeof(value), NULL, COUNTING_ALLOCATOR);
+    // Counts and value share one allocation, with the value aligned
+    EXPECT(allocations == 1);
+    EXPECT((uintptr_t)Rc_get(&a) % alignof(max_align_t) == 0);
+    Rc b = Rc_clone(&a);
+    EXPECT(Rc_strong_count(&a) == 2);
+    EXPECT(Rc_get(&b) == Rc_get(&a) && *(int *)Rc_get(&b) == 42);
+    Rc_drop(&a);
+    EXPECT(a.inner == NULL && deallocations == 0);
+    Rc_drop(&b);
+    EXPECT(deallocations == 1);
+}
+
+TEST(rc_weak_upgrades_only_while_alive)
+{
+    reset_counts();
+    Vec vec = make_vec(3);
+    Rc rc = Rc_new(&vec, sizeof(vec), &U64_VEC_OPS, COUNTING_ALLOCATOR);
+    RcWeak weak = Rc_downgrade(&rc);
+    EXPECT(Rc_weak_count(&rc) == 1);
+    Rc up;
+    EXPECT(RcWeak_upgrade(&weak, &up));
+    EXPECT(Rc_strong_count(&rc) == 2);
+    Rc_drop(&up);
+    Rc_drop(&rc);
+    // The value is gone but the allocation waits for the weak reference
+    EXPECT(vec_drops == 1 && deallocations == 0);
+    EXPECT(!RcWeak_upgrade(&weak, &up));
+    RcWeak_drop(&weak);
+    EXPECT(deallocations == 1);
+}
+
+TEST(rc_make_mut_clones_only_when_shared)
+{
+    reset_counts();
+    Vec vec = make_vec(4);
+    Rc a = Rc_new(&vec, sizeof(vec), &U64_VEC_OPS, GLOBAL_ALLOCATOR);
+    Vec *unique = Rc_make_mut(&a);
+    EXPECT(vec_clones == 0 && unique == Rc_get(&a));
+
+    Rc b = Rc_clone(&a);
+    Vec *mine = Rc_make_mut(&a);
+    EXPECT(vec_clones == 1);
+    *(uint64_t *)Vec_get(mine, 0, sizeof(uint64_t)) = 100;
+    EXPECT(*(uint64_t *)Vec_get(Rc_get(&b), 0, sizeof(uint64_t)) == 0);
+    EXPECT(Rc_strong_count(&a) == 1 && Rc_strong_count(&b) == 1);
+
+    // Only a weak reference left: moved rather than cloned, and the weak one dies
+    RcWeak weak = Rc_downgrade(&b);
+    Rc_make_mut(&b);
+    EXPECT(vec_clones == 1);
+    Rc up;
+    EXPECT(!RcWeak_upgrade(&weak, &up));
+    RcWeak_drop(&weak);
+    Rc_drop(&a);
+    Rc_drop(&b);
+    EXPECT(vec_drops == 2);
+}
+
+typedef struct
+{
+    Arc arc;
+    uint64_t sum;
+} ArcReader;
+
+void *arc_reader(void *arg)
+{
+    ArcReader *reader = arg;
+    for (int round = 0; round < 1000; round++)
+    {
+        Arc local = Arc_clone(&reader->arc);
+        const Vec *vec = Arc_get(&local);
+        reader->sum += *(uint64_t *)Vec_get(vec, vec->len - 1, sizeof(uint64_t));
+        Arc_drop(&local);
+    }
+    Arc_drop(&reader->arc);
+    return NULL;
+}
+
+TEST(arc_shares_a_vec_across_threads)
+{
+    reset_counts();
+    Vec vec = make_vec(1000);
+    Arc arc = Arc_new(&vec, sizeof(vec), &U64_VEC_OPS, COUNTING_ALLOCATOR);
+    pthread_t threads[4];
+    ArcReader readers[4];
+    for (int i = 0; i < 4; i++)
+    {
+        readers[i] = (ArcReader){.arc = Arc_clone(&arc), .sum = 0};
+        pthread_create(&threads[i], NULL, arc_reader, &readers[i]);
+    }
+    Arc_drop(&arc);
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_join(threads[i], NULL);
+        EXPECT(readers[i].sum == 999 * 1000);
+    }
+    // No copies, one drop, one free
+    EXPECT(vec_clones == 0 && vec_drops == 1);
+    EXPECT(allocations == 1 && deallocations == 1);
+}
+
+TEST(arc_weak_and_make_mut)
+{
+    reset_counts();
+    Vec vec = make_vec(8);
+    Arc a = Arc_new(&vec, sizeof(vec), &U64_VEC_OPS, GLOBAL_ALLOCATOR);
+    ArcWeak weak = Arc_downgrade(&a);
+    EXPECT(Arc_weak_count(&a) == 1);
+    Arc b;
+    EXPECT(ArcWeak_upgrade(&weak, &b));
+    EXPECT(Arc_strong_count(&a) == 2);
+
+    Vec *mine = Arc_make_mut(&a);
+    EXPECT(vec_clones == 1);
+    Vec_push(mine, &(uint64_t){8}, sizeof(uint64_t));
+    EXPECT(((Vec *)Arc_get(&b))->len == 8 && mine->len == 9);
+
+    Arc_make_mut(&a);
+    EXPECT(vec_clones == 1);
+
+    Arc_drop(&b);
+    EXPECT(!ArcWeak_upgrade(&weak, &b));
+    ArcWeak_drop(&weak);
+    Arc_drop(&a);
+    EXPECT(vec_drops == 2);
+}
+
+int main()
+{
+    return run_tests();
+}
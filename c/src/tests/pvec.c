@@ -0,0 +1,217 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define PVEC_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/pvec.h"
+#include "../modules/test.h"
+
+// Build a version holding 0..n-1 through persistent pushes, dropping the intermediates
+PVec pvec_of_range(size_t n)
+{
+    PVec v = PVec_new(sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    for (uint64_t i = 0; i < n; i++)
+    {
+        PVec next = PVec_push(&v, &i);
+        PVec_drop(&v);
+        v = next;
+    }
+    return v;
+}
+
+bool pvec_matches(const PVec *v, const uint64_t *expected, size_t len)
+{
+    if (PVec_len(v) != len)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        if (*(const uint64_t *)PVec_get(v, i) != expected[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(push_and_get_across_levels)
+{
+    // 32 * 32 * 32 + 33 elements need a three-level trie
+    size_t n = 32 * 32 * 32 + 33;
+    PVec v = pvec_of_range(n);
+    EXPECT(PVec_len(&v) == n);
+    EXPECT(v.shift == 3 * PVEC_BITS);
+    bool ok = true;
+    for (size_t i = 0; i < n; i++)
+    {
+        ok = ok && *(const uint64_t *)PVec_get(&v, i) == i;
+    }
+    EXPECT(ok);
+    PVec_drop(&v);
+    EXPECT(PVec_is_empty(&v));
+}
+
+TEST(old_versions_are_unchanged)
+{
+    PVec a = pvec_of_range(100);
+    uint64_t x = 1000;
+    PVec b = PVec_set(&a, 5, &x);
+    PVec c = PVec_push(&b, &x);
+    uint64_t last = 0;
+    PVec d = PVec_pop(&a, &last);
+    EXPECT(last == 99);
+
+    EXPECT(*(const uint64_t *)PVec_get(&a, 5) == 5 && PVec_len(&a) == 100);
+    EXPECT(*(const uint64_t *)PVec_get(&b, 5) == 1000 && PVec_len(&b) == 100);
+    EXPECT(PVec_len(&c) == 101 && *(const uint64_t *)PVec_get(&c, 100) == 1000);
+    EXPECT(PVec_len(&d) == 99 && *(const uint64_t *)PVec_get(&d, 98) == 98);
+
+    // Dropping the original leaves the others intact
+    PVec_drop(&a);
+    EXPECT(*(const uint64_t *)PVec_get(&b, 99) == 99);
+    EXPECT(*(const uint64_t *)PVec_get(&d, 5) == 5);
+    PVec_drop(&b);
+    PVec_drop(&c);
+    PVec_drop(&d);
+}
+
+TEST(pop_shrinks_back_to_empty)
+{
+    size_t n = 32 * 32 + 65;
+    PVec v = pvec_of_range(n);
+    bool ok = true;
+    for (size_t i = n; i > 0; i--)
+    {
+        uint64_t out;
+        PVec next = PVec_pop(&v, &out);
+        ok = ok && out == i - 1 && PVec_len(&next) == i - 1;
+        ok = ok && (i - 1 == 0 || *(const uint64_t *)PVec_get(&next, i - 2) == i - 2);
+        PVec_drop(&v);
+        v = next;
+    }
+    EXPECT(ok);
+    EXPECT(v.root == NULL && v.tail == NULL && v.shift == PVEC_BITS);
+    uint64_t out;
+    PVec empty = PVec_pop(&v, &out);
+    EXPECT(PVec_is_empty(&empty));
+    PVec_drop(&empty);
+    PVec_drop(&v);
+}
+
+TEST(transient_edits_in_place)
+{
+    PVec base = pvec_of_range(2000);
+    PVec t = PVec_transient(&base);
+    for (uint64_t i = 0; i < 2000; i += 2)
+    {
+        uint64_t x = i * 10;
+        PVec_transient_set(&t, i, &x);
+    }
+    for (uint64_t i = 2000; i < 3000; i++)
+    {
+        PVec_transient_push(&t, &i);
+    }
+    uint64_t out;
+    EXPECT(PVec_transient_pop(&t, &out) && out == 2999);
+    PVec after = PVec_persistent(&t);
+
+    EXPECT(PVec_len(&base) == 2000 && *(const uint64_t *)PVec_get(&base, 10) == 10);
+    EXPECT(PVec_len(&after) == 2999);
+    EXPECT(*(const uint64_t *)PVec_get(&after, 10) == 100 && *(const uint64_t *)PVec_get(&after, 11) == 11);
+    EXPECT(*(const uint64_t *)PVec_get(&after, 2500) == 2500);
+
+    // A second write to the same leaf within the batch reuses the copy made by the first
+    PVec t2 = PVec_transient(&after);
+    uint64_t x = 7;
+    PVec_transient_set(&t2, 40, &x);
+    const void *leaf = PVec_get(&t2, 40);
+    PVec_transient_set(&t2, 41, &x);
+    EXPECT(PVec_get(&t2, 40) == leaf && PVec_get(&after, 40) != leaf);
+    PVec_drop(&t2);
+
+    PVec_drop(&base);
+    PVec_drop(&after);
+}
+
+TEST(memory_is_shared_between_versions)
+{
+    PVec a = pvec_of_range(32 * 32 * 4);
+    uint64_t x = 0;
+    PVec b = PVec_set(&a, 0, &x);
+    PVecMemory alone = PVec_memory(&a, NULL);
+    PVecMemory m = PVec_memory(&b, &a);
+    EXPECT(alone.shared_nodes == 0 && alone.bytes > 32 * 32 * 4 * sizeof(uint64_t));
+    EXPECT(m.nodes == alone.nodes);
+    // Only the root, the internal node and the leaf on index 0's path were copied
+    EXPECT(m.nodes - m.shared_nodes == 3);
+    EXPECT(m.bytes - m.shared_bytes < m.bytes / 40);
+    PVec_drop(&a);
+    PVec_drop(&b);
+}
+
+TEST(random_versions_match_a_reference)
+{
+    enum { VERSIONS = 8, STEPS = 4000 };
+    PVec versions[VERSIONS];
+    Vec expected[VERSIONS];
+    for (int i = 0; i < VERSIONS; i++)
+    {
+        versions[i] = PVec_new(sizeof(uint64_t), GLOBAL_ALLOCATOR);
+        expected[i] = Vec_new();
+    }
+    uint64_t seed = 17;
+    bool ok = true;
+    for (int step = 0; step < STEPS; step++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        int from = (int)((seed >> 40) % VERSIONS), to = (int)((seed >> 50) % VERSIONS);
+        uint64_t op = (seed >> 20) % 10;
+        PVec next;
+        Vec reference = Vec_with_capacity(expected[from].len + 1, sizeof(uint64_t));
+        if (expected[from].len > 0)
+        {
+            memcpy(reference.buf.ptr, expected[from].buf.ptr, expected[from].len * sizeof(uint64_t));
+        }
+        reference.len = expected[from].len;
+        if (op < 6)
+        {
+            next = PVec_push(&versions[from], &seed);
+            Vec_push(&reference, &seed, sizeof(seed));
+        }
+        else if (op < 9 && reference.len > 0)
+        {
+            size_t index = (seed >> 8) % reference.len;
+            next = PVec_set(&versions[from], index, &seed);
+            Vec_set(&reference, index, &seed, sizeof(seed));
+        }
+        else
+        {
+            uint64_t a = 0, b = 0;
+            next = PVec_pop(&versions[from], &a);
+            ok = ok && Vec_pop(&reference, &b, sizeof(b)) == (PVec_len(&versions[from]) > 0) && a == b;
+        }
+        PVec_drop(&versions[to]);
+        Vec_drop(&expected[to]);
+        versions[to] = next;
+        expected[to] = reference;
+    }
+    for (int i = 0; i < VERSIONS; i++)
+    {
+        ok = ok && pvec_matches(&versions[i], expected[i].buf.ptr, expected[i].len);
+        Vec to_vec = PVec_to_vec(&versions[i]);
+        ok = ok && to_vec.len == expected[i].len &&
+             (to_vec.len == 0 || memcmp(to_vec.buf.ptr, expected[i].buf.ptr, to_vec.len * sizeof(uint64_t)) == 0);
+        Vec_drop(&to_vec);
+        PVec_drop(&versions[i]);
+        Vec_drop(&expected[i]);
+    }
+    EXPECT(ok);
+}
+
+int main()
+{
+    return run_tests();
+}
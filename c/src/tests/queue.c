@@ -0,0 +1,200 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define QUEUE_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include "../modules/queue.h"
+#include "../modules/test.h"
+
+define_SpscQueue_of(int);
+define_MpmcQueue_of(long);
+
+TEST(SpscQueue_new)
+{
+    SpscQueue q = SpscQueue_new(5, sizeof(int), GLOBAL_ALLOCATOR);
+    EXPECT(SpscQueue_capacity(&q) == 8);
+    EXPECT(SpscQueue_len(&q) == 0);
+    SpscQueue_drop(&q);
+    EXPECT(q.buf.ptr == NULL);
+}
+
+// Each side and the read-only fields start a cache line of their own
+TEST(queues_are_cache_line_aligned)
+{
+    EXPECT(_Alignof(SpscQueue) == QUEUE_CACHE_LINE);
+    EXPECT(offsetof(SpscQueue, head) == QUEUE_CACHE_LINE);
+    EXPECT(offsetof(SpscQueue, buf) == 2 * QUEUE_CACHE_LINE);
+    EXPECT(_Alignof(MpmcQueue) == QUEUE_CACHE_LINE);
+    EXPECT(offsetof(MpmcQueue, dequeue_pos) == QUEUE_CACHE_LINE);
+    EXPECT(offsetof(MpmcQueue, buf) == 2 * QUEUE_CACHE_LINE);
+    SpscQueue_of_int typed[2];
+    EXPECT((uintptr_t)&typed[1].inner % QUEUE_CACHE_LINE == 0);
+}
+
+TEST(SpscQueue_push_and_pop)
+{
+    SpscQueue q = SpscQueue_new(4, sizeof(int), GLOBAL_ALLOCATOR);
+    int value;
+    EXPECT(!SpscQueue_try_pop(&q, &value));
+    for (int round = 0; round < 3; round++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            EXPECT(SpscQueue_try_push(&q, &i));
+        }
+        int extra = 99;
+        EXPECT(!SpscQueue_try_push(&q, &extra));
+        EXPECT(SpscQueue_len(&q) == 4);
+        for (int i = 0; i < 4; i++)
+        {
+            EXPECT(SpscQueue_try_pop(&q, &value));
+            EXPECT(value == i);
+        }
+        EXPECT(!SpscQueue_try_pop(&q, &value));
+    }
+    SpscQueue_drop(&q);
+}
+
+TEST(SpscQueue_batch)
+{
+    SpscQueue q = SpscQueue_new(8, sizeof(int), GLOBAL_ALLOCATOR);
+    int values[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    int out[11] = {0};
+    EXPECT(SpscQueue_push_batch(&q, values, 5) == 5);
+    EXPECT(SpscQueue_pop_batch(&q, out, 3) == 3);
+    // Wraps around the end of the ring
+    EXPECT(SpscQueue_push_batch(&q, values + 5, 5) == 5);
+    EXPECT(SpscQueue_push_batch(&q, values, 10) == 1);
+    EXPECT(SpscQueue_pop_batch(&q, out + 3, 10) == 8);
+    for (int i = 0; i < 10; i++)
+    {
+        EXPECT(out[i] == i);
+    }
+    EXPECT(out[10] == 0);
+    EXPECT(SpscQueue_len(&q) == 0);
+    SpscQueue_drop(&q);
+}
+
+TEST(MpmcQueue_push_and_pop)
+{
+    MpmcQueue q = MpmcQueue_new(3, sizeof(long), GLOBAL_ALLOCATOR);
+    EXPECT(MpmcQueue_capacity(&q) == 4);
+    long value;
+    EXPECT(!MpmcQueue_try_pop(&q, &value));
+    for (int round = 0; round < 3; round++)
+    {
+        for (long i = 0; i < 4; i++)
+        {
+            EXPECT(MpmcQueue_try_push(&q, &i));
+        }
+        EXPECT(!MpmcQueue_try_push(&q, &value));
+        EXPECT(MpmcQueue_len(&q) == 4);
+        for (long i = 0; i < 4; i++)
+        {
+            EXPECT(MpmcQueue_try_pop(&q, &value));
+            EXPECT(value == i);
+        }
+    }
+    MpmcQueue_drop(&q);
+}
+
+TEST(typed_queues)
+{
+    SpscQueue_of_int spsc = SpscQueue_of_int_new(4, GLOBAL_ALLOCATOR);
+    EXPECT(SpscQueue_of_int_try_push(&spsc, 7));
+    SpscQueue_of_int_push(&spsc, 8);
+    EXPECT(SpscQueue_of_int_pop(&spsc) == 7);
+    int out = 0;
+    EXPECT(SpscQueue_of_int_try_pop(&spsc, &out));
+    EXPECT(out == 8);
+    SpscQueue_of_int_drop(&spsc);
+
+    MpmcQueue_of_long mpmc = MpmcQueue_of_long_new(4, GLOBAL_ALLOCATOR);
+    MpmcQueue_of_long_push(&mpmc, 42);
+    EXPECT(MpmcQueue_of_long_pop(&mpmc) == 42);
+    MpmcQueue_of_long_drop(&mpmc);
+}
+
+#define ITEMS 100000
+
+void *spsc_producer(void *arg)
+{
+    SpscQueue *q = arg;
+    for (int i = 0; i < ITEMS; i++)
+    {
+        SpscQueue_push(q, &i);
+    }
+    return NULL;
+}
+
+TEST(SpscQueue_threads)
+{
+    SpscQueue q = SpscQueue_new(64, sizeof(int), GLOBAL_ALLOCATOR);
+    pthread_t producer;
+    pthread_create(&producer, NULL, spsc_producer, &q);
+    bool in_order = true;
+    for (int i = 0; i < ITEMS; i++)
+    {
+        int value;
+        SpscQueue_pop(&q, &value);
+        in_order = in_order && value == i;
+    }
+    pthread_join(producer, NULL);
+    EXPECT(in_order);
+    SpscQueue_drop(&q);
+}
+
+void *mpmc_producer(void *arg)
+{
+    MpmcQueue *q = arg;
+    for (long i = 1; i <= ITEMS; i++)
+    {
+        MpmcQueue_push(q, &i);
+    }
+    return NULL;
+}
+
+void *mpmc_consumer(void *arg)
+{
+    MpmcQueue *q = arg;
+    long sum = 0;
+    for (long i = 0; i < ITEMS; i++)
+    {
+        long value;
+        MpmcQueue_pop(q, &value);
+        sum += value;
+    }
+    return (void *)sum;
+}
+
+TEST(MpmcQueue_threads)
+{
+    MpmcQueue q = MpmcQueue_new(64, sizeof(long), GLOBAL_ALLOCATOR);
+    pthread_t producers[3];
+    pthread_t consumers[3];
+    for (int i = 0; i < 3; i++)
+    {
+        pthread_create(&producers[i], NULL, mpmc_producer, &q);
+        pthread_create(&consumers[i], NULL, mpmc_consumer, &q);
+    }
+    long total = 0;
+    for (int i = 0; i < 3; i++)
+    {
+        void *sum;
+        pthread_join(producers[i], NULL);
+        pthread_join(consumers[i], &sum);
+        total += (long)sum;
+    }
+    EXPECT(total == 3L * ITEMS * (ITEMS + 1) / 2);
+    EXPECT(MpmcQueue_len(&q) == 0);
+    MpmcQueue_drop(&q);
+}
+
+int main()
+{
+    return run_tests();
+}
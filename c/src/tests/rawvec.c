@@ -1,7 +1,10 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <stdint.h>
 #include "../modules/rawvec.h"
 #include "../modules/test.h"
 
@@ -95,6 +98,90 @@ TEST(RawVec_shrink_to_fit)
     EXPECT(vec.ptr == NULL);
 }
 
+void *mock_allocate_aligned(size_t size, size_t align)
+{
+    return aligned_alloc_wrapper(size, align);
+}
+
+// No reallocate_aligned: growth goes through the allocate/copy/free fallback
+Allocator mock_aligned_allocator = {
+    .allocate = mock_allocate,
+    .deallocate = mock_deallocate,
+    .reallocate = mock_reallocate,
+    .allocate_aligned = mock_allocate_aligned};
+
+static bool is_aligned(const void *ptr, size_t align)
+{
+    return ((uintptr_t)ptr & (align - 1)) == 0;
+}
+
+TEST(RawVec_with_alignment)
+{
+    RawVec vec = RawVec_with_alignment(3, sizeof(int), 64, false, GLOBAL_ALLOCATOR);
+    EXPECT(vec.cap == 3);
+    EXPECT(is_aligned(vec.ptr, 64));
+    RawVec_drop(&vec);
+
+    vec = RawVec_with_alignment(0, sizeof(int), 64, false, GLOBAL_ALLOCATOR);
+    EXPECT(vec.ptr == NULL);
+    EXPECT(vec.align == 64);
+    RawVec_drop(&vec);
+}
+
+TEST(RawVec_alignment_survives_growth)
+{
+    Allocator allocators[] = {GLOBAL_ALLOCATOR, mock_aligned_allocator};
+    for (size_t a = 0; a < 2; a++)
+    {
+        RawVec vec = RawVec_with_alignment(1, sizeof(int), 128, false, allocators[a]);
+        ((int *)vec.ptr)[0] = 0;
+        for (size_t len = 1; len < 5000; len++)
+        {
+            RawVec_reserve(&vec, len, 1, sizeof(int));
+            EXPECT(is_aligned(vec.ptr, 128));
+            ((int *)vec.ptr)[len] = (int)len;
+        }
+        bool intact = true;
+        for (size_t i = 0; i < 5000; i++)
+        {
+            intact &= ((int *)vec.ptr)[i] == (int)i;
+        }
+        EXPECT(intact);
+
+        RawVec_shrink_to_fit(&vec, 100, sizeof(int));
+        EXPECT(vec.cap == 100);
+        EXPECT(is_aligned(vec.ptr, 128));
+        EXPECT(((int *)vec.ptr)[99] == 99);
+        RawVec_drop(&vec);
+    }
+}
+
+TEST(RawVec_padded_capacity)
+{
+    // 64-byte vectors of 4-byte elements: capacity is a multiple of 16
+    RawVec vec = RawVec_with_alignment(5, sizeof(float), 64, true, GLOBAL_ALLOCATOR);
+    EXPECT(vec.cap == 16);
+    RawVec_reserve(&vec, 16, 1, sizeof(float));
+    EXPECT(vec.cap % 16 == 0);
+    EXPECT(vec.cap >= 17);
+    RawVec_shrink_to_fit(&vec, 17, sizeof(float));
+    EXPECT(vec.cap == 32);
+    EXPECT(is_aligned(vec.ptr, 64));
+    RawVec_shrink_to_fit(&vec, 0, sizeof(float));
+    EXPECT(vec.ptr == NULL);
+    RawVec_drop(&vec);
+
+    // 12-byte elements need 16 of them for a whole number of 64-byte vectors
+    vec = RawVec_with_alignment(1, 12, 64, true, GLOBAL_ALLOCATOR);
+    EXPECT(vec.cap == 16);
+    RawVec_drop(&vec);
+
+    // Elements wider than the alignment need no padding
+    vec = RawVec_with_alignment(3, 128, 64, true, GLOBAL_ALLOCATOR);
+    EXPECT(vec.cap == 3);
+    RawVec_drop(&vec);
+}
+
 TEST(RawVec_ptr)
 {
     RawVec vec = RawVec_with_capacity(5, sizeof(int), mock_allocator);
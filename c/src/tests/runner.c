@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include "../modules/test.h"
+
+#define EXTRA_TESTS 120
+
+int extra_runs = 0;
+
+void extra_test(void)
+{
+    extra_runs++;
+}
+
+// Register more tests than the old fixed table held
+__attribute__((constructor)) void register_extra_tests()
+{
+    for (int i = 0; i < EXTRA_TESTS; i++)
+    {
+        add_test("extra", extra_test, __FILE__);
+    }
+}
+
+void crashing_test(void)
+{
+    raise(SIGKILL);
+}
+
+void failing_test(void)
+{
+    expect(0, __FILE__, __LINE__);
+}
+
+TEST(registration_has_no_fixed_cap)
+{
+    EXPECT(test_count > EXTRA_TESTS);
+    EXPECT(test_capacity >= test_count);
+}
+
+TEST(filter_matches_substrings_and_globs)
+{
+    EXPECT(test_matches("push_and_pop", NULL));
+    EXPECT(test_matches("push_and_pop", ""));
+    EXPECT(test_matches("push_and_pop", "and"));
+    EXPECT(!test_matches("push_and_pop", "insert"));
+    EXPECT(test_matches("push_and_pop", "push_*"));
+    EXPECT(!test_matches("push_and_pop", "pop_*"));
+    EXPECT(test_matches("vec_get", "vec_[gs]et"));
+}
+
+TEST(forked_run_survives_a_crash)
+{
+    // Run a private table so the crash stays out of this file's results
+    Test *saved = tests;
+    int saved_count = test_count;
+    int saved_expects = expect_count;
+    const char *saved_file = current_file;
+    Test table[3] = {
+        {.name = "crashes", .func = crashing_test, .file = "forked", .passed = 1},
+        {.name = "fails", .func = failing_test, .file = "forked", .passed = 1},
+        {.name = "passes", .func = extra_test, .file = "forked", .passed = 1},
+    };
+    tests = table;
+    test_count = 3;
+    int selected[3] = {0, 1, 2};
+    int file_count = 0;
+    int runs = extra_runs;
+    run_tests_forked(selected, 3, 2, &file_count);
+    tests = saved;
+    test_count = saved_count;
+    expect_count = saved_expects;
+    current_file = saved_file;
+
+    EXPECT(table[0].passed == 0);
+    EXPECT(table[1].passed == 0);
+    EXPECT(table[2].passed == 1);
+    EXPECT(file_count == 1);
+    // Each test ran in a child, so the parent's state is untouched
+    EXPECT(extra_runs == runs);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,130 @@
+#define ALLOC_IMPLEMENTATION
+#define SCHEDULER_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../modules/scheduler.h"
+#include "../modules/test.h"
+
+void increment(void *arg)
+{
+    atomic_fetch_add((atomic_size_t *)arg, 1);
+}
+
+TEST(Scheduler_new)
+{
+    Scheduler *sched = Scheduler_new(4, GLOBAL_ALLOCATOR);
+    EXPECT(sched != NULL);
+    EXPECT(Scheduler_num_workers(sched) == 4);
+    Scheduler_drop(sched);
+}
+
+TEST(spawn_and_wait)
+{
+    Scheduler *sched = Scheduler_new(4, GLOBAL_ALLOCATOR);
+    atomic_size_t counter = 0;
+    TaskGroup group;
+    TaskGroup_init(&group, NULL, NULL);
+    for (size_t i = 0; i < 1000; i++)
+    {
+        Scheduler_spawn(sched, &group, increment, &counter);
+    }
+    Scheduler_wait(sched, &group);
+    EXPECT(TaskGroup_is_done(&group));
+    EXPECT(atomic_load(&counter) == 1000);
+    Scheduler_drop(sched);
+}
+
+TEST(continuation)
+{
+    Scheduler *sched = Scheduler_new(2, GLOBAL_ALLOCATOR);
+    atomic_size_t counter = 0;
+    atomic_size_t cont_runs = 0;
+    TaskGroup group;
+    TaskGroup_init(&group, increment, &cont_runs);
+    for (size_t i = 0; i < 100; i++)
+    {
+        Scheduler_spawn(sched, &group, increment, &counter);
+    }
+    Scheduler_wait(sched, &group);
+    EXPECT(atomic_load(&counter) == 100);
+    EXPECT(atomic_load(&cont_runs) == 1);
+    Scheduler_drop(sched);
+}
+
+typedef struct
+{
+    Scheduler *sched;
+    unsigned n;
+    unsigned long result;
+} Fib;
+
+void fib_task(void *arg)
+{
+    Fib *fib = arg;
+    if (fib->n < 2)
+    {
+        fib->result = fib->n;
+        return;
+    }
+    Fib a = {fib->sched, fib->n - 1, 0};
+    Fib b = {fib->sched, fib->n - 2, 0};
+    TaskGroup group;
+    TaskGroup_init(&group, NULL, NULL);
+    Scheduler_spawn(fib->sched, &group, fib_task, &a);
+    fib_task(&b);
+    Scheduler_wait(fib->sched, &group);
+    fib->result = a.result + b.result;
+}
+
+TEST(nested_fork_join)
+{
+    Scheduler *sched = Scheduler_new(4, GLOBAL_ALLOCATOR);
+    Fib fib = {sched, 20, 0};
+    TaskGroup group;
+    TaskGroup_init(&group, NULL, NULL);
+    Scheduler_spawn(sched, &group, fib_task, &fib);
+    Scheduler_wait(sched, &group);
+    EXPECT(fib.result == 6765);
+    Scheduler_drop(sched);
+}
+
+void square_range(size_t begin, size_t end, void *arg)
+{
+    unsigned long *values = arg;
+    for (size_t i = begin; i < end; i++)
+    {
+        values[i] = (unsigned long)i * i;
+    }
+}
+
+TEST(parallel_for)
+{
+    Scheduler *sched = Scheduler_new(4, GLOBAL_ALLOCATOR);
+    size_t n = 100000;
+    unsigned long *values = calloc(n, sizeof(unsigned long));
+    Scheduler_parallel_for(sched, 0, n, 0, square_range, values);
+    bool ok = true;
+    for (size_t i = 0; i < n; i++)
+    {
+        ok = ok && values[i] == (unsigned long)i * i;
+    }
+    EXPECT(ok);
+
+    memset(values, 0, n * sizeof(unsigned long));
+    Scheduler_parallel_for(sched, 10, 20, 1, square_range, values);
+    EXPECT(values[9] == 0);
+    EXPECT(values[10] == 100);
+    EXPECT(values[19] == 361);
+    EXPECT(values[20] == 0);
+
+    Scheduler_parallel_for(sched, 5, 5, 0, square_range, values);
+    free(values);
+    Scheduler_drop(sched);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,140 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define SEARCH_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/search.h"
+#include "../modules/test.h"
+
+size_t reference_lower_bound(const Vec *sorted, uint32_t key)
+{
+    const uint32_t *keys = sorted->buf.ptr;
+    size_t lo = 0, hi = sorted->len;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (keys[mid] < key)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// `len` ascending keys with gaps, runs of duplicates and both extremes
+Vec sorted_keys(size_t len, uint64_t seed)
+{
+    Vec keys = Vec_with_capacity(len, sizeof(uint32_t));
+    uint32_t key = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        uint32_t step = (uint32_t)(seed >> 60);
+        key = step > UINT32_MAX - key ? UINT32_MAX : key + (step > 10 ? step * 1000 : step % 2);
+        Vec_push(&keys, &key, sizeof(key));
+    }
+    if (len > 2)
+    {
+        ((uint32_t *)keys.buf.ptr)[len - 1] = UINT32_MAX;
+    }
+    return keys;
+}
+
+// Every key, its neighbours and a spread of random values
+bool check_all_queries(const Vec *sorted, uint64_t seed)
+{
+    Eytzinger e = Eytzinger_new(sorted, GLOBAL_ALLOCATOR);
+    STree t = STree_new(sorted, GLOBAL_ALLOCATOR);
+    Vec queries = Vec_new();
+    uint32_t edge[] = {0, 1, UINT32_MAX - 1, UINT32_MAX};
+    for (size_t i = 0; i < 4; i++)
+    {
+        Vec_push(&queries, &edge[i], sizeof(uint32_t));
+    }
+    for (size_t i = 0; i < sorted->len; i++)
+    {
+        uint32_t key = ((const uint32_t *)sorted->buf.ptr)[i];
+        uint32_t around[] = {key - 1, key, key + 1};
+        for (size_t j = 0; j < 3; j++)
+        {
+            Vec_push(&queries, &around[j], sizeof(uint32_t));
+        }
+    }
+    for (size_t i = 0; i < 200; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        uint32_t key = (uint32_t)(seed >> 32);
+        Vec_push(&queries, &key, sizeof(uint32_t));
+    }
+    size_t *batch_e = malloc(queries.len * sizeof(size_t));
+    size_t *batch_t = malloc(queries.len * sizeof(size_t));
+    Eytzinger_lower_bound_batch(&e, queries.buf.ptr, queries.len, batch_e);
+    STree_lower_bound_batch(&t, queries.buf.ptr, queries.len, batch_t);
+    bool ok = true;
+    for (size_t i = 0; i < queries.len; i++)
+    {
+        uint32_t key = ((const uint32_t *)queries.buf.ptr)[i];
+        size_t want = reference_lower_bound(sorted, key);
+        ok = ok && Eytzinger_lower_bound(&e, key) == want && STree_lower_bound(&t, key) == want;
+        ok = ok && batch_e[i] == want && batch_t[i] == want;
+    }
+    free(batch_e);
+    free(batch_t);
+    Vec_drop(&queries);
+    Eytzinger_drop(&e);
+    STree_drop(&t);
+    return ok;
+}
+
+TEST(small_sizes_match_binary_search)
+{
+    bool ok = true;
+    for (size_t len = 0; len <= 300; len++)
+    {
+        Vec keys = sorted_keys(len, len);
+        ok = ok && check_all_queries(&keys, len + 1);
+        Vec_drop(&keys);
+    }
+    EXPECT(ok);
+}
+
+TEST(large_index_matches_binary_search)
+{
+    Vec keys = sorted_keys(100000, 7);
+    EXPECT(check_all_queries(&keys, 8));
+    Vec_drop(&keys);
+}
+
+TEST(search_slots_hold_the_found_key)
+{
+    Vec keys = Vec_new();
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        uint32_t key = i * 10;
+        Vec_push(&keys, &key, sizeof(key));
+    }
+    Eytzinger e = Eytzinger_new(&keys, GLOBAL_ALLOCATOR);
+    STree t = STree_new(&keys, GLOBAL_ALLOCATOR);
+    size_t slot = Eytzinger_search(&e, 55);
+    EXPECT(e.keys[slot] == 60 && Eytzinger_rank(&e, slot) == 6);
+    EXPECT(Eytzinger_search(&e, 9991) == 0 && Eytzinger_lower_bound(&e, 9991) == 1000);
+    slot = STree_search(&t, 55);
+    EXPECT((t.keys[slot] ^ 0x80000000u) == 60 && STree_rank(&t, slot) == 6);
+    EXPECT(STree_rank(&t, STree_search(&t, 9991)) == 1000 && STree_lower_bound(&t, 9991) == 1000);
+    // Both layouts keep their hot data on cache-line boundaries
+    EXPECT((uintptr_t)e.keys % SEARCH_LINE == 0 && (uintptr_t)t.keys % SEARCH_LINE == 0);
+    Eytzinger_drop(&e);
+    STree_drop(&t);
+    Vec_drop(&keys);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,129 @@
+#define ALLOC_IMPLEMENTATION
+#define SEGVEC_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/segvec.h"
+#include "../modules/test.h"
+
+TEST(push_and_get)
+{
+    SegVec vec = SegVec_new(sizeof(int), GLOBAL_ALLOCATOR);
+    EXPECT(SegVec_is_empty(&vec) && SegVec_capacity(&vec) == 0);
+    for (int i = 0; i < 1000; i++)
+    {
+        SegVec_push(&vec, &i);
+    }
+    EXPECT(SegVec_len(&vec) == 1000);
+    bool ok = true;
+    for (int i = 0; i < 1000; i++)
+    {
+        ok = ok && *(int *)SegVec_get(&vec, (size_t)i) == i;
+    }
+    EXPECT(ok);
+    int v = -1;
+    SegVec_set(&vec, 500, &v);
+    EXPECT(*(int *)SegVec_get(&vec, 500) == -1);
+    SegVec_drop(&vec);
+    EXPECT(SegVec_len(&vec) == 0 && SegVec_capacity(&vec) == 0);
+}
+
+TEST(chunks_double_in_size)
+{
+    SegVec vec = SegVec_new(sizeof(int), GLOBAL_ALLOCATOR);
+    int v = 0;
+    SegVec_push(&vec, &v);
+    EXPECT(SegVec_capacity(&vec) == SEGVEC_FIRST_CHUNK);
+    SegVec_reserve(&vec, SEGVEC_FIRST_CHUNK);
+    EXPECT(SegVec_capacity(&vec) == 3 * SEGVEC_FIRST_CHUNK);
+    EXPECT(vec.chunk_count == 2);
+    SegVec_drop(&vec);
+}
+
+TEST(elements_never_move)
+{
+    SegVec vec = SegVec_new(sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    uint64_t *first = NULL, *middle = NULL;
+    for (uint64_t i = 0; i < 100000; i++)
+    {
+        uint64_t *stored = SegVec_push(&vec, &i);
+        if (i == 0)
+        {
+            first = stored;
+        }
+        if (i == 777)
+        {
+            middle = stored;
+        }
+    }
+    EXPECT(first == SegVec_get(&vec, 0) && *first == 0);
+    EXPECT(middle == SegVec_get(&vec, 777) && *middle == 777);
+    SegVec_drop(&vec);
+}
+
+TEST(push_uninit_fills_in_place)
+{
+    SegVec vec = SegVec_new(sizeof(uint64_t), GLOBAL_ALLOCATOR);
+    SegVec_reserve(&vec, 20);
+    for (uint64_t i = 0; i < 50; i++)
+    {
+        *(uint64_t *)SegVec_push_uninit(&vec) = i * i;
+    }
+    EXPECT(SegVec_len(&vec) == 50 && *(uint64_t *)SegVec_get(&vec, 49) == 49 * 49);
+    // Pushing after a truncate continues from the new end
+    SegVec_truncate(&vec, 5);
+    uint64_t v = 1000;
+    EXPECT(SegVec_push(&vec, &v) == SegVec_get(&vec, 5));
+    EXPECT(*(uint64_t *)SegVec_get(&vec, 4) == 16 && *(uint64_t *)SegVec_get(&vec, 5) == 1000);
+    SegVec_drop(&vec);
+}
+
+TEST(pop_and_truncate_keep_chunks)
+{
+    SegVec vec = SegVec_new(sizeof(int), GLOBAL_ALLOCATOR);
+    for (int i = 0; i < 100; i++)
+    {
+        SegVec_push(&vec, &i);
+    }
+    size_t cap = SegVec_capacity(&vec);
+    int out = 0;
+    EXPECT(SegVec_pop(&vec, &out) && out == 99);
+    SegVec_truncate(&vec, 10);
+    EXPECT(SegVec_len(&vec) == 10 && SegVec_capacity(&vec) == cap);
+    SegVec_clear(&vec);
+    EXPECT(!SegVec_pop(&vec, &out));
+    SegVec_drop(&vec);
+}
+
+TEST(chunk_iteration_covers_every_element)
+{
+    SegVec vec = SegVec_new(sizeof(int), GLOBAL_ALLOCATOR);
+    EXPECT(SegVec_chunk_count(&vec) == 0);
+    for (int i = 0; i < 1234; i++)
+    {
+        SegVec_push(&vec, &i);
+    }
+    size_t seen = 0;
+    bool ok = true;
+    for (size_t k = 0; k < SegVec_chunk_count(&vec); k++)
+    {
+        SegVecChunk c = SegVec_chunk(&vec, k);
+        const int *values = c.ptr;
+        for (size_t i = 0; i < c.len; i++)
+        {
+            ok = ok && values[i] == (int)(seen + i);
+        }
+        seen += c.len;
+    }
+    EXPECT(ok && seen == 1234);
+    // Exactly full chunks: the last one is complete and nothing past it is visited
+    SegVec_truncate(&vec, 3 * SEGVEC_FIRST_CHUNK);
+    EXPECT(SegVec_chunk_count(&vec) == 2);
+    EXPECT(SegVec_chunk(&vec, 1).len == 2 * SEGVEC_FIRST_CHUNK);
+    SegVec_drop(&vec);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,232 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define STRING_IMPLEMENTATION
+#define SERIALIZE_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../modules/serialize.h"
+#include "../modules/test.h"
+
+// Write records into a growable in-memory buffer
+FILE *memory_stream(char **data, size_t *size)
+{
+    FILE *f = open_memstream(data, size);
+    assert(f != NULL);
+    return f;
+}
+
+TEST(checksum_matches_xxh64)
+{
+    EXPECT(Serial_checksum("", 0) == 0xEF46DB3751D8E999ull);
+    EXPECT(Serial_checksum("a", 1) == 0xD24EC4F1A98C6E5Bull);
+    const char *text = "Nobody inspects the spammish repetition";
+    uint64_t whole = Serial_checksum(text, strlen(text));
+    // Feeding the same bytes in pieces gives the same hash
+    SerialHasher h = SerialHasher_new();
+    SerialHasher_update(&h, text, 5);
+    SerialHasher_update(&h, text + 5, 30);
+    SerialHasher_update(&h, text + 35, strlen(text) - 35);
+    EXPECT(SerialHasher_finish(&h) == whole);
+}
+
+TEST(Vec_round_trip)
+{
+    Vec vec = Vec_new();
+    for (double x = 0; x < 1000; x++)
+    {
+        Vec_push(&vec, &x, sizeof(double));
+    }
+    char *data = NULL;
+    size_t size = 0;
+    FILE *f = memory_stream(&data, &size);
+    EXPECT(Vec_serialize(&vec, sizeof(double), f, SERIAL_CHECKSUM));
+    EXPECT(Vec_serialize(&vec, sizeof(double), f, 0));
+    fclose(f);
+    EXPECT(size == 2 * Serial_record_size(1000 * sizeof(double)));
+    EXPECT(size % SERIAL_ALIGN == 0);
+
+    VecView view;
+    size_t consumed;
+    EXPECT(Vec_view_serialized(data, size, sizeof(double), &view, &consumed));
+    EXPECT(view.len == 1000);
+    EXPECT((const char *)view.ptr == data + sizeof(SerialHeader));
+    EXPECT(((const double *)view.ptr)[999] == 999.0);
+
+    Vec copy;
+    EXPECT(Vec_deserialize(data + consumed, size - consumed, sizeof(double), &copy, NULL));
+    EXPECT(copy.len == 1000);
+    EXPECT(memcmp(copy.buf.ptr, vec.buf.ptr, 1000 * sizeof(double)) == 0);
+    Vec_drop(&copy);
+
+    // Wrong element size and corrupted payloads are rejected
+    EXPECT(!Vec_view_serialized(data, size, sizeof(float), &view, NULL));
+    EXPECT(errno == EINVAL);
+    data[sizeof(SerialHeader) + 3] ^= 1;
+    EXPECT(!Vec_view_serialized(data, size, sizeof(double), &view, NULL));
+    EXPECT(errno == EBADMSG);
+    // Truncated record
+    EXPECT(!Vec_view_serialized(data, 100, sizeof(double), &view, NULL));
+
+    free(data);
+    Vec_drop(&vec);
+}
+
+TEST(String_round_trip)
+{
+    String s = String_from("hello, world");
+    String empty = String_new();
+    char *data = NULL;
+    size_t size = 0;
+    FILE *f = memory_stream(&data, &size);
+    EXPECT(String_serialize(&s, f, SERIAL_CHECKSUM));
+    EXPECT(String_serialize(&empty, f, 0));
+    fclose(f);
+
+    StringView view;
+    size_t consumed;
+    EXPECT(String_view_serialized(data, size, &view, &consumed));
+    EXPECT(StringView_equals_str(view, "hello, world"));
+    EXPECT(view.ptr[view.len] == '\0');
+
+    String copy;
+    EXPECT(String_deserialize(data + consumed, size - consumed, &copy, NULL));
+    EXPECT(String_len(&copy) == 0);
+    String_drop(&copy);
+
+    free(data);
+    String_drop(&s);
+    String_drop(&empty);
+}
+
+TEST(String_table_round_trip)
+{
+    const char *words[] = {"alpha", "", "gamma delta", "epsilon"};
+    Vec strings = Vec_new();
+    for (size_t i = 0; i < 4; i++)
+    {
+        String s = String_from(words[i]);
+        Vec_push(&strings, &s, sizeof(String));
+    }
+    char *data = NULL;
+    size_t size = 0;
+    FILE *f = memory_stream(&data, &size);
+    EXPECT(Vec_serialize_strings(&strings, f, SERIAL_CHECKSUM));
+    fclose(f);
+
+    StringTable table;
+    EXPECT(StringTable_view_serialized(data, size, &table, NULL));
+    EXPECT(StringTable_len(&table) == 4);
+    for (size_t i = 0; i < 4; i++)
+    {
+        StringView view = StringTable_get(&table, i);
+        EXPECT(StringView_equals_str(view, words[i]));
+        EXPECT(strcmp(view.ptr, words[i]) == 0);
+    }
+    // A table is not a plain Vec record
+    VecView vec_view;
+    EXPECT(!Vec_view_serialized(data, size, sizeof(uint64_t), &vec_view, NULL));
+
+    free(data);
+    String *items = Vec_as_mut_slice(&strings);
+    for (size_t i = 0; i < 4; i++)
+    {
+        String_drop(&items[i]);
+    }
+    Vec_drop(&strings);
+}
+
+TEST(stream_reads)
+{
+    Vec vec = Vec_new();
+    for (int i = 0; i < 77; i++)
+    {
+        Vec_push(&vec, &i, sizeof(int));
+    }
+    String s = String_from("tail");
+    FILE *f = tmpfile();
+    EXPECT(Vec_serialize(&vec, sizeof(int), f, SERIAL_CHECKSUM));
+    EXPECT(String_serialize(&s, f, 0));
+    rewind(f);
+
+    Vec loaded;
+    EXPECT(Vec_read_serialized(f, sizeof(int), &loaded));
+    EXPECT(loaded.len == 77 && ((int *)loaded.buf.ptr)[76] == 76);
+    String loaded_s;
+    EXPECT(String_read_serialized(f, &loaded_s));
+    EXPECT(String_equals(&s, &loaded_s));
+    // End of stream
+    Vec none;
+    EXPECT(!Vec_read_serialized(f, sizeof(int), &none));
+    EXPECT(none.len == 0);
+    fclose(f);
+
+    Vec_drop(&loaded);
+    String_drop(&loaded_s);
+    String_drop(&s);
+    Vec_drop(&vec);
+}
+
+// A 64-byte aligned record holding just a header with the given fields
+void *crafted_record(SerialKind kind, uint32_t elem_size, uint64_t len, uint64_t payload_size)
+{
+    SerialHeader *header = aligned_alloc(SERIAL_ALIGN, 2 * SERIAL_ALIGN);
+    memset(header, 0, 2 * SERIAL_ALIGN);
+    header->magic = SERIAL_MAGIC;
+    header->version = SERIAL_VERSION;
+    header->kind = kind;
+    header->elem_size = elem_size;
+    header->len = len;
+    header->payload_size = payload_size;
+    return header;
+}
+
+TEST(crafted_lengths_rejected)
+{
+    // len + 1 wraps to payload_size 0; payload[len] would be the header's last byte
+    SerialHeader *header = crafted_record(SERIAL_STRING, 1, UINT64_MAX, 0);
+    StringView view;
+    EXPECT(!String_view_serialized(header, sizeof(SerialHeader), &view, NULL));
+    EXPECT(errno == EINVAL);
+    free(header);
+
+    // len * elem_size wraps to 0
+    header = crafted_record(SERIAL_VEC, 8, 1ull << 61, 0);
+    VecView vec_view;
+    EXPECT(!Vec_view_serialized(header, sizeof(SerialHeader), 8, &vec_view, NULL));
+    FILE *f = tmpfile();
+    fwrite(header, sizeof(SerialHeader), 1, f);
+    rewind(f);
+    Vec vec;
+    EXPECT(!Vec_read_serialized(f, 8, &vec));
+    EXPECT(errno == EINVAL && vec.len == 0);
+    fclose(f);
+    free(header);
+
+    header = crafted_record(SERIAL_STRING, 1, UINT64_MAX, 0);
+    f = tmpfile();
+    fwrite(header, sizeof(SerialHeader), 1, f);
+    rewind(f);
+    String s;
+    EXPECT(!String_read_serialized(f, &s));
+    EXPECT(errno == EINVAL && String_len(&s) == 0);
+    fclose(f);
+    free(header);
+
+    // A payload larger than the rest of the file is refused before allocating
+    header = crafted_record(SERIAL_VEC, 1, 1ull << 40, 1ull << 40);
+    f = tmpfile();
+    fwrite(header, 2 * SERIAL_ALIGN, 1, f);
+    rewind(f);
+    EXPECT(!Vec_read_serialized(f, 1, &vec));
+    EXPECT(errno == EINVAL && vec.len == 0);
+    fclose(f);
+    free(header);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,145 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define SLOTMAP_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "../modules/slotmap.h"
+#include "../modules/test.h"
+
+TEST(insert_get_remove)
+{
+    SlotMap map = SlotMap_new(sizeof(int));
+    int a = 10, b = 20, c = 30;
+    SlotMapHandle ha = SlotMap_insert(&map, &a);
+    SlotMapHandle hb = SlotMap_insert(&map, &b);
+    SlotMapHandle hc = SlotMap_insert(&map, &c);
+    EXPECT(SlotMap_len(&map) == 3);
+    EXPECT(ha != SLOTMAP_NULL && ha != hb && hb != hc);
+    EXPECT(*(int *)SlotMap_get(&map, hb) == 20);
+
+    int out = 0;
+    EXPECT(SlotMap_remove(&map, ha, &out) && out == 10);
+    EXPECT(SlotMap_len(&map) == 2);
+    // The last value moved into the hole but its handle still finds it
+    EXPECT(*(int *)SlotMap_get(&map, hc) == 30);
+    EXPECT(*(int *)SlotMap_get(&map, hb) == 20);
+    SlotMap_drop(&map);
+}
+
+TEST(stale_handles_are_rejected)
+{
+    SlotMap map = SlotMap_new(sizeof(int));
+    int v = 1;
+    SlotMapHandle h = SlotMap_insert(&map, &v);
+    EXPECT(SlotMap_remove(&map, h, NULL));
+    EXPECT(!SlotMap_contains(&map, h) && SlotMap_get(&map, h) == NULL);
+    EXPECT(!SlotMap_remove(&map, h, NULL));
+
+    // The slot is reused with a new generation
+    v = 2;
+    SlotMapHandle again = SlotMap_insert(&map, &v);
+    EXPECT((uint32_t)again == (uint32_t)h && again != h);
+    EXPECT(SlotMap_get(&map, h) == NULL);
+    EXPECT(*(int *)SlotMap_get(&map, again) == 2);
+
+    EXPECT(SlotMap_get(&map, SLOTMAP_NULL) == NULL);
+    EXPECT(SlotMap_get(&map, (SlotMapHandle)1 << 32 | 1000) == NULL);
+    SlotMap_drop(&map);
+}
+
+TEST(free_slots_are_reused_lifo)
+{
+    SlotMap map = SlotMap_new(sizeof(int));
+    SlotMapHandle h[4];
+    for (int i = 0; i < 4; i++)
+    {
+        h[i] = SlotMap_insert(&map, &i);
+    }
+    SlotMap_remove(&map, h[1], NULL);
+    SlotMap_remove(&map, h[3], NULL);
+    int v = 7;
+    EXPECT((uint32_t)SlotMap_insert(&map, &v) == (uint32_t)h[3]);
+    EXPECT((uint32_t)SlotMap_insert(&map, &v) == (uint32_t)h[1]);
+    EXPECT(map.slots.len == 4);
+    SlotMap_drop(&map);
+}
+
+TEST(dense_values_iterate_with_handles)
+{
+    SlotMap map = SlotMap_new(sizeof(int));
+    SlotMapHandle h[100];
+    for (int i = 0; i < 100; i++)
+    {
+        h[i] = SlotMap_insert(&map, &i);
+    }
+    for (int i = 0; i < 100; i += 3)
+    {
+        SlotMap_remove(&map, h[i], NULL);
+    }
+    EXPECT(SlotMap_len(&map) == 66);
+    const int *values = SlotMap_values(&map);
+    bool ok = true;
+    int sum = 0;
+    for (size_t i = 0; i < SlotMap_len(&map); i++)
+    {
+        SlotMapHandle handle = SlotMap_handle_at(&map, i);
+        ok = ok && SlotMap_get(&map, handle) == &values[i] && h[values[i]] == handle;
+        ok = ok && values[i] % 3 != 0;
+        sum += values[i];
+    }
+    EXPECT(ok);
+    EXPECT(sum == 4950 - 3 * (33 * 34 / 2));
+    SlotMap_clear(&map);
+    EXPECT(SlotMap_len(&map) == 0 && !SlotMap_contains(&map, h[1]));
+    SlotMap_drop(&map);
+}
+
+TEST(random_operations_match_a_reference)
+{
+    enum { N = 512 };
+    SlotMap map = SlotMap_new(sizeof(uint64_t));
+    SlotMapHandle handles[N];
+    uint64_t expected[N];
+    bool live[N] = {false};
+    uint64_t seed = 42;
+    bool ok = true;
+    for (int step = 0; step < 20000; step++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        size_t k = (seed >> 33) % N;
+        if (live[k])
+        {
+            uint64_t out;
+            ok = ok && SlotMap_remove(&map, handles[k], &out) && out == expected[k];
+            ok = ok && SlotMap_get(&map, handles[k]) == NULL;
+            live[k] = false;
+        }
+        else
+        {
+            expected[k] = seed;
+            handles[k] = SlotMap_insert(&map, &seed);
+            live[k] = true;
+        }
+    }
+    size_t count = 0;
+    for (int k = 0; k < N; k++)
+    {
+        if (live[k])
+        {
+            count++;
+            uint64_t *value = SlotMap_get(&map, handles[k]);
+            ok = ok && value != NULL && *value == expected[k];
+        }
+    }
+    EXPECT(ok);
+    EXPECT(SlotMap_len(&map) == count);
+    EXPECT(map.slots.len <= N);
+    SlotMap_drop(&map);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,122 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "../modules/soa.h"
+#include "../modules/test.h"
+
+typedef char PersonName[50];
+
+typedef struct
+{
+    int id;
+    PersonName name;
+    double score;
+} Person;
+
+define_SoA(People, Person, (int, id), (PersonName, name), (double, score));
+
+Person make_person(int id)
+{
+    Person p = {.id = id, .score = id * 1.5};
+    snprintf(p.name, sizeof(p.name), "person-%d", id);
+    return p;
+}
+
+TEST(push_and_get_round_trip)
+{
+    People people = People_new(GLOBAL_ALLOCATOR);
+    EXPECT(People_len(&people) == 0 && People_capacity(&people) == 0);
+    for (int i = 0; i < 100; i++)
+    {
+        Person p = make_person(i);
+        People_push(&people, &p);
+    }
+    EXPECT(People_len(&people) == 100 && People_capacity(&people) >= 100);
+    bool ok = true;
+    for (int i = 0; i < 100; i++)
+    {
+        Person p;
+        People_get(&people, (size_t)i, &p);
+        Person want = make_person(i);
+        ok = ok && p.id == want.id && p.score == want.score && strcmp(p.name, want.name) == 0;
+    }
+    EXPECT(ok);
+    People_drop(&people);
+    EXPECT(People_capacity(&people) == 0);
+}
+
+TEST(columns_are_contiguous_and_share_capacity)
+{
+    People people = People_new(GLOBAL_ALLOCATOR);
+    People_reserve(&people, 10);
+    EXPECT(People_capacity(&people) >= 10);
+    // Every column was grown to the shared capacity
+    EXPECT(people.id.cap == People_capacity(&people));
+    EXPECT(people.name.cap == People_capacity(&people));
+    EXPECT(people.score.cap == People_capacity(&people));
+    for (int i = 0; i < 10; i++)
+    {
+        Person p = make_person(i);
+        People_push(&people, &p);
+    }
+    int *ids = People_column_id(&people);
+    double *scores = People_column_score(&people);
+    PersonName *names = People_column_name(&people);
+    double total = 0;
+    for (size_t i = 0; i < People_len(&people); i++)
+    {
+        total += scores[i];
+    }
+    EXPECT(total == 1.5 * 45);
+    EXPECT(ids[9] == 9 && strcmp(names[3], "person-3") == 0);
+    People_drop(&people);
+}
+
+TEST(set_overwrites_a_row)
+{
+    People people = People_new(GLOBAL_ALLOCATOR);
+    Person a = make_person(1), b = make_person(2);
+    People_push(&people, &a);
+    People_set(&people, 0, &b);
+    Person out;
+    People_get(&people, 0, &out);
+    EXPECT(out.id == 2 && strcmp(out.name, "person-2") == 0);
+    People_clear(&people);
+    EXPECT(People_len(&people) == 0);
+    People_drop(&people);
+}
+
+TEST(aos_soa_conversion)
+{
+    Person rows[37];
+    for (int i = 0; i < 37; i++)
+    {
+        rows[i] = make_person(i * 3);
+    }
+    People people = People_new(GLOBAL_ALLOCATOR);
+    Person first = make_person(-1);
+    People_push(&people, &first);
+    People_extend_from_rows(&people, rows, 37);
+    EXPECT(People_len(&people) == 38);
+    EXPECT(People_column_id(&people)[0] == -1 && People_column_id(&people)[37] == 36 * 3);
+
+    Person back[38];
+    People_to_rows(&people, back);
+    EXPECT(back[0].id == -1);
+    bool ok = true;
+    for (int i = 0; i < 37; i++)
+    {
+        ok = ok && back[i + 1].id == rows[i].id && back[i + 1].score == rows[i].score &&
+             strcmp(back[i + 1].name, rows[i].name) == 0;
+    }
+    EXPECT(ok);
+    People_drop(&people);
+}
+
+int main()
+{
+    return run_tests();
+}
@@ -0,0 +1,72 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#define STRING_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../modules/string.h"
+#include "../modules/test.h"
+
+// A String whose contents and terminator fill its buffer exactly
+String full_string(const char *contents)
+{
+    String s = String_with_capacity(strlen(contents) + 1);
+    String_push_str(&s, contents);
+    return s;
+}
+
+// The terminator must land inside the buffer when a full String grows by one
+TEST(push_into_a_full_string)
+{
+    String s = full_string("abc");
+    EXPECT(String_capacity(&s) == 4);
+    String_push(&s, 'd');
+    EXPECT(strcmp(String_as_str(&s), "abcd") == 0);
+    EXPECT(String_capacity(&s) > 4);
+    String_drop(&s);
+}
+
+TEST(push_str_into_a_full_string)
+{
+    String s = full_string("abc");
+    String_push_str(&s, "d");
+    EXPECT(strcmp(String_as_str(&s), "abcd") == 0);
+    String_drop(&s);
+}
+
+TEST(insert_into_a_full_string)
+{
+    String s = full_string("abc");
+    String_insert(&s, 1, 'x');
+    EXPECT(strcmp(String_as_str(&s), "axbc") == 0);
+    EXPECT(String_len(&s) == 4);
+    String_drop(&s);
+}
+
+TEST(insert_str_into_a_full_string)
+{
+    String s = full_string("abc");
+    String_insert_str(&s, 3, "d");
+    EXPECT(strcmp(String_as_str(&s), "abcd") == 0);
+    String_drop(&s);
+}
+
+TEST(pushes_keep_the_string_terminated)
+{
+    String s = String_new();
+    bool terminated = true;
+    for (int i = 0; i < 100; i++)
+    {
+        String_push(&s, (char)('a' + i % 26));
+        terminated &= strlen(String_as_str(&s)) == String_len(&s);
+        EXPECT(String_capacity(&s) > String_len(&s));
+    }
+    EXPECT(terminated);
+    String_drop(&s);
+}
+
+int main()
+{
+    return run_tests();
+}
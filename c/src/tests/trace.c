@@ -0,0 +1,213 @@
+#define TRACE_PROBES
+#define TRACE_IMPLEMENTATION
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../modules/vec.h"
+#include "../modules/trace.h"
+#include "../modules/test.h"
+
+// Write the trace to memory and return it as a C string
+char *trace_to_string(void)
+{
+    FILE *out = tmpfile();
+    Trace_write_chrome(out);
+    long size = ftell(out);
+    rewind(out);
+    char *data = malloc((size_t)size + 1);
+    size_t read = fread(data, 1, (size_t)size, out);
+    data[read] = '\0';
+    fclose(out);
+    return data;
+}
+
+size_t count_occurrences(const char *haystack, const char *needle)
+{
+    size_t count = 0;
+    size_t offset = 0;
+    const char *match;
+    while ((match = strstr(haystack + offset, needle)) != NULL)
+    {
+        count++;
+        offset = (size_t)(match - haystack) + 1;
+    }
+    return count;
+}
+
+void traced_work(int depth)
+{
+    TRACE_SCOPE("traced_work");
+    if (depth > 0)
+    {
+        traced_work(depth - 1);
+    }
+}
+
+TEST(scope_records_begin_and_end)
+{
+    Trace_clear();
+    traced_work(2);
+    TRACE_COUNTER("depth", 3);
+    EXPECT(Trace_event_count() == 7);
+    char *json = trace_to_string();
+    EXPECT(count_occurrences(json, "\"ph\": \"B\", \"name\": \"traced_work\"") == 3);
+    EXPECT(count_occurrences(json, "\"ph\": \"E\", \"name\": \"traced_work\"") == 3);
+    EXPECT(strstr(json, "\"name\": \"depth\"") != NULL);
+    EXPECT(strstr(json, "\"args\": {\"value\": 3}") != NULL);
+    free(json);
+}
+
+TEST(ring_keeps_the_newest_events)
+{
+    Trace_clear();
+    for (int i = 0; i < TRACE_BUFFER_EVENTS + 100; i++)
+    {
+        TRACE_COUNTER("tick", i);
+    }
+    EXPECT(Trace_event_count() == TRACE_BUFFER_EVENTS);
+    char *json = trace_to_string();
+    EXPECT(strstr(json, "{\"value\": 99}") == NULL);
+    EXPECT(strstr(json, "{\"value\": 100}") != NULL);
+    free(json);
+    Trace_clear();
+}
+
+TEST(inactive_tracing_records_nothing)
+{
+    Trace_clear();
+    Trace_set_active(false);
+    traced_work(3);
+    Trace_set_active(true);
+    EXPECT(Trace_event_count() == 0);
+}
+
+TEST(probes_trace_vec_growth)
+{
+    Trace_clear();
+    Vec vec = Vec_new();
+    for (int i = 0; i < 100; i++)
+    {
+        Vec_push(&vec, &i, sizeof(i));
+    }
+    Vec_drop(&vec);
+    char *json = trace_to_string();
+    // Capacity goes 1, 2, 4, ..., 128
+    EXPECT(count_occurrences(json, "\"ph\": \"B\", \"name\": \"RawVec_grow\"") == 8);
+    EXPECT(count_occurrences(json, "\"name\": \"RawVec_grow bytes\"") == 8);
+    EXPECT(count_occurrences(json, "\"name\": \"allocate\"") == 1);
+    EXPECT(count_occurrences(json, "\"name\": \"reallocate\"") == 7);
+    EXPECT(count_occurrences(json, "\"name\": \"deallocate\"") == 1);
+    free(json);
+}
+
+void second_unit_traced_pushes(int count);
+TraceBuffer *second_unit_buffer(void);
+
+TEST(units_share_one_buffer_per_thread)
+{
+    Trace_clear();
+    TRACE_INSTANT("first_unit", 0);
+    second_unit_traced_pushes(4);
+    EXPECT(second_unit_buffer() == Trace_local_);
+    char *json = trace_to_string();
+    EXPECT(count_occurrences(json, "\"name\": \"second_unit\"") == 2);
+    // Capacity goes 1, 2, 4
+    EXPECT(count_occurrences(json, "\"ph\": \"B\", \"name\": \"RawVec_grow\"") == 3);
+    EXPECT(strstr(json, "\"name\": \"first_unit\"") != NULL);
+    free(json);
+}
+
+void *trace_thread(void *arg)
+{
+    Trace_set_thread_name((const char *)arg);
+    for (int i = 0; i < 1000; i++)
+    {
+        TRACE_SCOPE("thread_work");
+    }
+    return NULL;
+}
+
+TEST(threads_record_into_their_own_buffers)
+{
+    Trace_clear();
+    pthread_t threads[4];
+    const char *names[4] = {"worker-0", "worker-1", "worker-2", "worker \"3\""};
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_create(&threads[i], NULL, trace_thread, (void *)names[i]);
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    EXPECT(Trace_event_count() == 4 * 2000);
+    char *json = trace_to_string();
+    EXPECT(count_occurrences(json, "\"name\": \"thread_name\"") >= 4);
+    EXPECT(strstr(json, "\"worker \\\"3\\\"\"") != NULL);
+    free(json);
+}
+
+size_t buffer_count(void)
+{
+    size_t count = 0;
+    for (TraceBuffer *b = atomic_load(&Trace_buffers_); b != NULL; b = b->next)
+    {
+        count++;
+    }
+    return count;
+}
+
+void *short_lived_thread(void *arg)
+{
+    Trace_set_thread_name((const char *)arg);
+    TRACE_INSTANT("short_lived", 1);
+    return NULL;
+}
+
+// Threads that come and go one after another keep reusing the same buffer
+TEST(exited_threads_buffers_are_reused)
+{
+    Trace_clear();
+    pthread_t thread;
+    pthread_create(&thread, NULL, short_lived_thread, "first");
+    pthread_join(thread, NULL);
+    size_t before = buffer_count();
+    for (int i = 0; i < 32; i++)
+    {
+        pthread_create(&thread, NULL, short_lived_thread, "later");
+        pthread_join(thread, NULL);
+    }
+    EXPECT(buffer_count() == before);
+    // Earlier owners' events and names survive the reuse
+    EXPECT(Trace_event_count() == 33);
+    char *json = trace_to_string();
+    EXPECT(count_occurrences(json, "\"name\": \"short_lived\"") == 33);
+    EXPECT(strstr(json, "\"first\"") != NULL);
+    EXPECT(strstr(json, "\"later\"") != NULL);
+    free(json);
+}
+
+TEST(save_writes_a_file)
+{
+    Trace_clear();
+    traced_work(0);
+    char path[] = "/tmp/trace_test_XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    EXPECT(Trace_save(path));
+    FILE *in = fopen(path, "r");
+    char head[32] = {0};
+    EXPECT(fread(head, 1, sizeof(head) - 1, in) > 0);
+    fclose(in);
+    EXPECT(strncmp(head, "{\"displayTimeUnit\"", 18) == 0);
+    unlink(path);
+}
+
+int main()
+{
+    return run_tests();
+}
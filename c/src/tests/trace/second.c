@@ -0,0 +1,22 @@
+// A second translation unit built with the allocation probes. It records
+// into the same per-thread buffer as the first unit.
+#define TRACE_PROBES
+#include <stdint.h>
+#include "../../modules/vec.h"
+#include "../../modules/trace.h"
+
+void second_unit_traced_pushes(int count)
+{
+    TRACE_SCOPE("second_unit");
+    Vec vec = Vec_new();
+    for (int i = 0; i < count; i++)
+    {
+        Vec_push(&vec, &i, sizeof(i));
+    }
+    Vec_drop(&vec);
+}
+
+TraceBuffer *second_unit_buffer(void)
+{
+    return Trace_local_;
+}
@@ -1,7 +1,11 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VEC_IMPLEMENTATION
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <stdint.h>
 #include "../modules/vec.h"
 #include "../modules/test.h"
 
@@ -32,6 +36,21 @@ TEST(Vec_with_capacity)
     Vec_drop(&vec);
 }
 
+TEST(Vec_with_alignment)
+{
+    Vec vec = Vec_with_alignment(3, sizeof(float), 64, true);
+    EXPECT(Vec_capacity(&vec) == 16);
+    for (int i = 0; i < 1000; i++)
+    {
+        float value = (float)i;
+        Vec_push(&vec, &value, sizeof(float));
+        EXPECT(((uintptr_t)Vec_as_slice(&vec) & 63) == 0);
+    }
+    EXPECT(Vec_capacity(&vec) % 16 == 0);
+    EXPECT(*(float *)Vec_get(&vec, 999, sizeof(float)) == 999.0f);
+    Vec_drop(&vec);
+}
+
 TEST(push_and_pop)
 {
     Vec vec = Vec_new();
@@ -42,7 +61,7 @@ TEST(push_and_pop)
     }
     EXPECT(Vec_len(&vec) == 5);
 
-    int popped;
+    int popped = 0;
     for (int i = 4; i >= 0; i--)
     {
         EXPECT(Vec_pop(&vec, &popped, sizeof(int)));
@@ -0,0 +1,183 @@
+#define ALLOC_IMPLEMENTATION
+#define RAWVEC_IMPLEMENTATION
+#define VECDEQUE_IMPLEMENTATION
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "../modules/vecdeque.h"
+#include "../modules/test.h"
+
+// Fill a deque so that its contents wrap around the end of the buffer
+VecDeque wrapped_deque(void)
+{
+    VecDeque dq = VecDeque_with_capacity(8, sizeof(int));
+    int value = 0;
+    for (int i = 0; i < 6; i++)
+    {
+        VecDeque_push_back(&dq, &i, sizeof(int));
+    }
+    for (int i = 0; i < 4; i++)
+    {
+        VecDeque_pop_front(&dq, &value, sizeof(int));
+    }
+    for (int i = 6; i < 12; i++)
+    {
+        VecDeque_push_back(&dq, &i, sizeof(int));
+    }
+    // Holds 4..11 with head at physical slot 4
+    return dq;
+}
+
+TEST(VecDeque_new)
+{
+    VecDeque dq = VecDeque_new();
+    EXPECT(VecDeque_capacity(&dq) == 0);
+    EXPECT(VecDeque_len(&dq) == 0);
+    EXPECT(VecDeque_is_empty(&dq));
+    EXPECT(VecDeque_front(&dq, sizeof(int)) == NULL);
+    VecDeque_drop(&dq);
+}
+
+TEST(VecDeque_with_capacity)
+{
+    VecDeque dq = VecDeque_with_capacity(5, sizeof(int));
+    EXPECT(VecDeque_capacity(&dq) == 8);
+    VecDeque_drop(&dq);
+}
+
+TEST(push_and_pop_both_ends)
+{
+    VecDeque dq = VecDeque_new();
+    for (int i = 0; i < 50; i++)
+    {
+        VecDeque_push_back(&dq, &i, sizeof(int));
+        int neg = -i - 1;
+        VecDeque_push_front(&dq, &neg, sizeof(int));
+    }
+    EXPECT(VecDeque_len(&dq) == 100);
+    EXPECT((VecDeque_capacity(&dq) & (VecDeque_capacity(&dq) - 1)) == 0);
+    EXPECT(*(int *)VecDeque_front(&dq, sizeof(int)) == -50);
+    EXPECT(*(int *)VecDeque_back(&dq, sizeof(int)) == 49);
+    bool ordered = true;
+    for (size_t i = 0; i < 100; i++)
+    {
+        ordered = ordered && *(int *)VecDeque_get(&dq, i, sizeof(int)) == (int)i - 50;
+    }
+    EXPECT(ordered);
+
+    int value = 0;
+    EXPECT(VecDeque_pop_front(&dq, &value, sizeof(int)));
+    EXPECT(value == -50);
+    EXPECT(VecDeque_pop_back(&dq, &value, sizeof(int)));
+    EXPECT(value == 49);
+    EXPECT(VecDeque_len(&dq) == 98);
+    VecDeque_clear(&dq);
+    EXPECT(!VecDeque_pop_back(&dq, &value, sizeof(int)));
+    EXPECT(!VecDeque_pop_front(&dq, &value, sizeof(int)));
+    VecDeque_drop(&dq);
+}
+
+TEST(grow_while_wrapped)
+{
+    VecDeque dq = wrapped_deque();
+    EXPECT(VecDeque_capacity(&dq) == 8);
+    int value = 12;
+    VecDeque_push_back(&dq, &value, sizeof(int));
+    EXPECT(VecDeque_capacity(&dq) == 16);
+    bool ordered = true;
+    for (size_t i = 0; i < VecDeque_len(&dq); i++)
+    {
+        ordered = ordered && *(int *)VecDeque_get(&dq, i, sizeof(int)) == (int)i + 4;
+    }
+    EXPECT(ordered);
+    VecDeque_drop(&dq);
+}
+
+TEST(VecDeque_as_slices)
+{
+    VecDeque dq = wrapped_deque();
+    void *first;
+    void *second;
+    size_t first_len;
+    size_t second_len;
+    VecDeque_as_slices(&dq, sizeof(int), &first, &first_len, &second, &second_len);
+    EXPECT(first_len == 4);
+    EXPECT(second_len == 4);
+    EXPECT(((int *)first)[0] == 4);
+    EXPECT(((int *)first)[3] == 7);
+    EXPECT(((int *)second)[0] == 8);
+    EXPECT(((int *)second)[3] == 11);
+    VecDeque_drop(&dq);
+}
+
+TEST(VecDeque_make_contiguous)
+{
+    VecDeque dq = wrapped_deque();
+    int *items = VecDeque_make_contiguous(&dq, sizeof(int));
+    for (int i = 0; i < 8; i++)
+    {
+        EXPECT(items[i] == i + 4);
+    }
+    void *first;
+    void *second;
+    size_t first_len;
+    size_t second_len;
+    VecDeque_as_slices(&dq, sizeof(int), &first, &first_len, &second, &second_len);
+    EXPECT(first_len == 8);
+    EXPECT(second_len == 0);
+
+    // With spare capacity the fast path is taken
+    VecDeque sparse = VecDeque_with_capacity(8, sizeof(int));
+    for (int i = 0; i < 7; i++)
+    {
+        VecDeque_push_back(&sparse, &i, sizeof(int));
+    }
+    int value = 0;
+    for (int i = 0; i < 6; i++)
+    {
+        VecDeque_pop_front(&sparse, &value, sizeof(int));
+    }
+    value = 7;
+    VecDeque_push_back(&sparse, &value, sizeof(int));
+    value = 8;
+    VecDeque_push_back(&sparse, &value, sizeof(int));
+    items = VecDeque_make_contiguous(&sparse, sizeof(int));
+    EXPECT(items[0] == 6 && items[1] == 7 && items[2] == 8);
+
+    VecDeque_drop(&sparse);
+    VecDeque_drop(&dq);
+}
+
+TEST(batch_push_and_pop)
+{
+    VecDeque dq = VecDeque_with_capacity(8, sizeof(int));
+    int values[20];
+    int out[20];
+    for (int i = 0; i < 20; i++)
+    {
+        values[i] = i;
+    }
+    VecDeque_push_back_n(&dq, values, 6, sizeof(int));
+    EXPECT(VecDeque_pop_front_n(&dq, out, 5, sizeof(int)) == 5);
+    VecDeque_push_back_n(&dq, values + 6, 14, sizeof(int));
+    EXPECT(VecDeque_len(&dq) == 15);
+    EXPECT(VecDeque_pop_front_n(&dq, out + 5, 100, sizeof(int)) == 15);
+    for (int i = 0; i < 20; i++)
+    {
+        EXPECT(out[i] == i);
+    }
+    EXPECT(VecDeque_is_empty(&dq));
+
+    VecDeque_push_back_n(&dq, values, 10, sizeof(int));
+    EXPECT(VecDeque_drain_front(&dq, 4) == 4);
+    EXPECT(*(int *)VecDeque_front(&dq, sizeof(int)) == 4);
+    VecDeque_truncate(&dq, 2);
+    EXPECT(*(int *)VecDeque_back(&dq, sizeof(int)) == 5);
+    VecDeque_drop(&dq);
+}
+
+int main()
+{
+    return run_tests();
+}